@@ -0,0 +1,199 @@
+#include "allocstats.h"
+
+#include <QApplication>
+#include <QWidget>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// --- 各操作的计数 (只在 Scope 中的线程上更新，查询可以在任意线程) ---
+namespace {
+struct AtomicCounters {
+    std::atomic<quint64> operations{0};
+    std::atomic<quint64> allocations{0};
+    std::atomic<quint64> bytes{0};
+    std::atomic<quint64> frees{0};
+};
+
+AtomicCounters operationCounters[int(AllocOperation::Count)];
+
+const char* const OPERATION_NAMES[int(AllocOperation::Count)] = {
+    "none", "press", "release", "repeat", "modifierVisuals", "opacity", "resize", "layoutSwitch",
+    "geometrySwitch"
+};
+
+#ifdef VK_ALLOC_ACCOUNTING
+thread_local AllocOperation currentOperation = AllocOperation::None;
+
+inline void countAllocation(std::size_t size) {
+    const AllocOperation operation = currentOperation;
+    if (operation == AllocOperation::None) return;
+    AtomicCounters& counters = operationCounters[int(operation)];
+    counters.allocations.fetch_add(1, std::memory_order_relaxed);
+    counters.bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+inline void countFree(void* pointer) {
+    const AllocOperation operation = currentOperation;
+    if (!pointer || operation == AllocOperation::None) return;
+    operationCounters[int(operation)].frees.fetch_add(1, std::memory_order_relaxed);
+}
+#endif
+} // namespace
+
+// --- name / counters / reset ---
+const char* AllocStats::name(AllocOperation operation) {
+    return OPERATION_NAMES[qBound(0, int(operation), int(AllocOperation::Count) - 1)];
+}
+
+AllocCounters AllocStats::counters(AllocOperation operation) {
+    const AtomicCounters& source = operationCounters[int(operation)];
+    AllocCounters result;
+    result.operations = source.operations.load(std::memory_order_relaxed);
+    result.allocations = source.allocations.load(std::memory_order_relaxed);
+    result.bytes = source.bytes.load(std::memory_order_relaxed);
+    result.frees = source.frees.load(std::memory_order_relaxed);
+    return result;
+}
+
+void AllocStats::reset() {
+    for (AtomicCounters& counters : operationCounters) {
+        counters.operations.store(0, std::memory_order_relaxed);
+        counters.allocations.store(0, std::memory_order_relaxed);
+        counters.bytes.store(0, std::memory_order_relaxed);
+        counters.frees.store(0, std::memory_order_relaxed);
+    }
+}
+
+// --- liveObjects / liveWidgets: 存活的 Qt 对象 (只应在 UI 线程调用) ---
+int AllocStats::liveObjects() {
+    if (!qApp) return 0;
+    int count = 1 + int(qApp->findChildren<QObject*>().size());
+    for (QWidget* window : QApplication::topLevelWidgets()) count += 1 + int(window->findChildren<QObject*>().size());
+    return count;
+}
+
+int AllocStats::liveWidgets() {
+    return qApp ? int(QApplication::allWidgets().size()) : 0;
+}
+
+// --- summary: 每个操作一行 ---
+QString AllocStats::summary() {
+    QString text;
+    if (!enabled()) {
+        text = QStringLiteral("分配统计未编译 (cmake -DVK_ALLOC_ACCOUNTING=ON)\n");
+    } else {
+        for (int i = int(AllocOperation::Press); i < int(AllocOperation::Count); ++i) {
+            const AllocCounters c = counters(AllocOperation(i));
+            if (c.operations == 0) continue;
+            text += QStringLiteral("%1: %2 次, 每次分配 %3 次 / %4 字节, 释放 %5 次\n")
+                    .arg(QLatin1String(name(AllocOperation(i))), -16).arg(c.operations)
+                    .arg(c.allocationsPerOperation(), 0, 'f', 2).arg(c.bytesPerOperation(), 0, 'f', 1)
+                    .arg(c.operations ? double(c.frees) / double(c.operations) : 0.0, 0, 'f', 2);
+        }
+    }
+    text += QStringLiteral("存活对象: %1 个 QObject, %2 个 QWidget").arg(liveObjects()).arg(liveWidgets());
+    return text;
+}
+
+#ifdef VK_ALLOC_ACCOUNTING
+// --- Scope ---
+AllocStats::Scope::Scope(AllocOperation operation) : previous(currentOperation) {
+    currentOperation = operation;
+    // 同一操作的嵌套 Scope (positionWindow 中的 resize 触发 resizeEvent) 只算一次
+    if (previous != operation) operationCounters[int(operation)].operations.fetch_add(1, std::memory_order_relaxed);
+}
+
+AllocStats::Scope::~Scope() {
+    currentOperation = previous;
+}
+
+// --- 底层分配: glibc 下接管 malloc 系列，operator new 直接调用 glibc 的实现以免重复计数 ---
+#if defined(__GLIBC__)
+extern "C" {
+void* __libc_malloc(std::size_t size);
+void* __libc_calloc(std::size_t count, std::size_t size);
+void* __libc_realloc(void* pointer, std::size_t size);
+void __libc_free(void* pointer);
+
+void* malloc(std::size_t size) {
+    countAllocation(size);
+    return __libc_malloc(size);
+}
+
+void* calloc(std::size_t count, std::size_t size) {
+    countAllocation(count * size);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* pointer, std::size_t size) {
+    countAllocation(size);
+    return __libc_realloc(pointer, size);
+}
+
+void free(void* pointer) {
+    countFree(pointer);
+    __libc_free(pointer);
+}
+}
+
+static inline void* rawAllocate(std::size_t size) { return __libc_malloc(size ? size : 1); }
+static inline void rawFree(void* pointer) { __libc_free(pointer); }
+#else
+static inline void* rawAllocate(std::size_t size) { return std::malloc(size ? size : 1); }
+static inline void rawFree(void* pointer) { std::free(pointer); }
+#endif
+
+// --- 全局 operator new/delete (对齐版本不替换，使用标准库的实现且不计数) ---
+void* operator new(std::size_t size) {
+    countAllocation(size);
+    if (void* pointer = rawAllocate(size)) return pointer;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    countAllocation(size);
+    if (void* pointer = rawAllocate(size)) return pointer;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    countAllocation(size);
+    return rawAllocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    countAllocation(size);
+    return rawAllocate(size);
+}
+
+void operator delete(void* pointer) noexcept {
+    countFree(pointer);
+    rawFree(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    countFree(pointer);
+    rawFree(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+    countFree(pointer);
+    rawFree(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept {
+    countFree(pointer);
+    rawFree(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept {
+    countFree(pointer);
+    rawFree(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept {
+    countFree(pointer);
+    rawFree(pointer);
+}
+#endif // VK_ALLOC_ACCOUNTING
@@ -0,0 +1,73 @@
+#ifndef VIRTUALKEYBOARD_ALLOCSTATS_H
+#define VIRTUALKEYBOARD_ALLOCSTATS_H
+
+#include <QString>
+
+// 按操作分类的堆分配统计 (编译选项 VK_ALLOC_ACCOUNTING 打开时有效，否则 Scope 为空操作)
+// 替换全局 operator new/delete；glibc 下同时接管 malloc/calloc/realloc/free
+// (Qt 的 QString/QVector 等容器直接使用 malloc，不经过 operator new)。
+// 只统计处于 Scope 中的线程上的分配 (注入线程、日志线程不计入)；
+// Scope 嵌套时分配计入最内层的操作，例如按下 Shift 时视觉更新的分配不计入 Press。
+enum class AllocOperation : int {
+    None,
+    Press,           // onKeyPressed
+    Release,         // onKeyReleased
+    Repeat,          // onKeyRepeat
+    ModifierVisuals, // updateModifierKeysVisuals
+    Opacity,         // changeOpacity / applyPendingOpacity
+    Resize,          // resizeEvent / positionWindow (含按钮的重新布局)
+    LayoutSwitch,    // switchLayout
+    GeometrySwitch,  // setGeometryMode (不含窗口重新定位，计入 Resize)
+    Count
+};
+
+// 某个操作的累计计数
+struct AllocCounters {
+    quint64 operations = 0;  // 进入 Scope 的次数
+    quint64 allocations = 0; // 分配次数 (new、malloc、calloc、realloc)
+    quint64 bytes = 0;       // 请求的字节数
+    quint64 frees = 0;       // 释放次数
+
+    double allocationsPerOperation() const { return operations ? double(allocations) / double(operations) : 0.0; }
+    double bytesPerOperation() const { return operations ? double(bytes) / double(operations) : 0.0; }
+};
+
+namespace AllocStats {
+    // 是否编译了分配统计
+    constexpr bool enabled() {
+#ifdef VK_ALLOC_ACCOUNTING
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    const char* name(AllocOperation operation);
+    AllocCounters counters(AllocOperation operation);
+    void reset();
+    // 存活的 QObject 数 (从 qApp 和所有顶层窗口可达的对象树) 和 QWidget 数 (QApplication::allWidgets)
+    int liveObjects();
+    int liveWidgets();
+    // 多行文本: 每个操作的次数、每次的分配数和字节数，以及存活的对象数
+    QString summary();
+
+    // 把当前线程上的分配计入 operation (析构时恢复外层的操作)
+#ifdef VK_ALLOC_ACCOUNTING
+    class Scope {
+    public:
+        explicit Scope(AllocOperation operation);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        AllocOperation previous;
+    };
+#else
+    class Scope {
+    public:
+        explicit Scope(AllocOperation) {}
+    };
+#endif
+}
+
+#endif // VIRTUALKEYBOARD_ALLOCSTATS_H
@@ -0,0 +1,350 @@
+#include "asynclogger.h"
+
+#include <QByteArray>
+#include <QFile> // QFile::encodeName
+#include <QVector>
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "spscqueue.h"
+
+std::atomic<int> AsyncLogger::runtimeMinLevel{ VK_LOG_LEVEL_TRACE };
+
+namespace {
+
+// 格式化线程的唤醒周期: 记录最多在缓冲区中停留这么久
+const int FLUSH_INTERVAL_MS = 20;
+
+// 每个写日志线程一个环形缓冲区 (该线程生产，格式化线程消费)
+struct LogRing {
+    SpscQueue<LogRecord, AsyncLogger::RING_CAPACITY> queue;
+    std::atomic<quint64> dropped{0};
+    quint64 droppedReported = 0; // 格式化线程已报告的丢弃数
+    int index = 0;
+};
+
+// 所有缓冲区和格式化线程的状态
+// 缓冲区在进程生命周期内不释放: 线程退出后格式化线程仍可能在读取
+struct LoggerState {
+    std::mutex registryMutex;
+    std::vector<std::unique_ptr<LogRing>> rings;
+
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+    bool stopRequested = false;
+    std::thread formatter;
+    bool running = false;
+
+    FILE* output = stderr; // stderr 或日志文件
+    qint64 startNs = 0;
+};
+
+LoggerState& state() {
+    static LoggerState loggerState;
+    return loggerState;
+}
+
+thread_local LogRing* currentRing = nullptr;
+
+FILE* openLogFile(const QString& path) {
+#ifdef _WIN32
+    return _wfopen(reinterpret_cast<const wchar_t*>(path.utf16()), L"a");
+#else
+    return std::fopen(QFile::encodeName(path).constData(), "a");
+#endif
+}
+
+LogRing* ringForCurrentThread() {
+    if (currentRing) return currentRing;
+    LoggerState& s = state();
+    std::lock_guard<std::mutex> lock(s.registryMutex);
+    s.rings.push_back(std::make_unique<LogRing>());
+    currentRing = s.rings.back().get();
+    currentRing->index = int(s.rings.size()) - 1;
+    return currentRing;
+}
+
+char levelLetter(LogLevel level) {
+    switch (level) {
+        case LogLevel::Trace: return 'T';
+        case LogLevel::Debug: return 'D';
+        case LogLevel::Info: return 'I';
+        case LogLevel::Warning: return 'W';
+        case LogLevel::Error: return 'E';
+    }
+    return '?';
+}
+
+const char* baseName(const char* path) {
+    const char* name = path;
+    for (const char* p = path; *p; ++p) {
+        if (*p == '/' || *p == '\\') name = p + 1;
+    }
+    return name;
+}
+
+// --- appendArg: 按类型输出一个参数，返回下一个参数的槽位 ---
+int appendArg(QByteArray& line, const LogRecord& record, int slot, bool hex) {
+    while (slot < record.slotCount && record.types[slot] == LogArgType::TextContinue) ++slot;
+    if (slot >= record.slotCount) {
+        line += "{?}";
+        return slot;
+    }
+    const LogRecord::Value& value = record.values[slot];
+    switch (record.types[slot]) {
+        case LogArgType::Int:
+            if (hex) line += "0x" + QByteArray::number(value.i, 16);
+            else line += QByteArray::number(value.i);
+            break;
+        case LogArgType::UInt:
+            if (hex) line += "0x" + QByteArray::number(value.u, 16);
+            else line += QByteArray::number(value.u);
+            break;
+        case LogArgType::Double:
+            line += QByteArray::number(value.d, 'g', 6);
+            break;
+        case LogArgType::Bool:
+            line += value.u ? "true" : "false";
+            break;
+        case LogArgType::Text: {
+            // 文本连续存放在后续槽中，以 '\0' 结束
+            int slots = 1;
+            while (slot + slots < record.slotCount && record.types[slot + slots] == LogArgType::TextContinue) ++slots;
+            const char* text = reinterpret_cast<const char*>(&value);
+            line += QByteArray(text, int(qstrnlen(text, uint(slots * 8))));
+            break;
+        }
+        case LogArgType::None:
+        case LogArgType::TextContinue:
+            break;
+    }
+    return slot + 1;
+}
+
+// --- formatRecord: 把一条记录格式化为一行文本 ---
+void formatRecord(QByteArray& line, const LogRecord& record, int threadIndex, qint64 startNs) {
+    const qint64 sinceStartUs = (record.timeNs - startNs) / 1000;
+    char prefix[48];
+    std::snprintf(prefix, sizeof(prefix), "[%6lld.%06lld] %c t%d ",
+                  static_cast<long long>(sinceStartUs / 1000000), static_cast<long long>(qAbs(sinceStartUs % 1000000)),
+                  levelLetter(record.site->level), threadIndex);
+    line += prefix;
+
+    int slot = 0;
+    for (const char* p = record.format; *p; ++p) {
+        if (p[0] == '{' && p[1] == '}') {
+            slot = appendArg(line, record, slot, false);
+            ++p;
+        } else if (p[0] == '{' && p[1] == 'x' && p[2] == '}') {
+            slot = appendArg(line, record, slot, true);
+            p += 2;
+        } else {
+            line += *p;
+        }
+    }
+    line += " (";
+    line += baseName(record.site->file);
+    line += ':';
+    line += QByteArray::number(record.site->line);
+    line += ")\n";
+}
+
+struct PendingRecord {
+    LogRecord record;
+    int threadIndex;
+};
+
+// --- drain: 取出所有缓冲区中的记录并按时间顺序输出，然后报告新增的丢弃数 ---
+void drain(QVector<PendingRecord>& pending, QByteArray& text) {
+    LoggerState& s = state();
+    QVector<LogRing*> rings;
+    {
+        std::lock_guard<std::mutex> lock(s.registryMutex);
+        rings.reserve(int(s.rings.size()));
+        for (const auto& ring : s.rings) rings.append(ring.get());
+    }
+
+    pending.clear();
+    PendingRecord item;
+    for (LogRing* ring : rings) {
+        item.threadIndex = ring->index;
+        while (ring->queue.pop(item.record)) pending.append(item);
+    }
+    std::stable_sort(pending.begin(), pending.end(), [](const PendingRecord& a, const PendingRecord& b) {
+        return a.record.timeNs < b.record.timeNs;
+    });
+
+    text.clear();
+    for (const PendingRecord& p : pending) formatRecord(text, p.record, p.threadIndex, s.startNs);
+
+    // 丢弃的记录必须可见: 每次发现新的丢弃都输出一行警告
+    for (LogRing* ring : rings) {
+        const quint64 dropped = ring->dropped.load(std::memory_order_relaxed);
+        if (dropped == ring->droppedReported) continue;
+        char warning[160];
+        std::snprintf(warning, sizeof(warning), "[日志] W t%d 环形缓冲区已满，丢弃了 %llu 条记录 (该线程累计 %llu 条)\n",
+                      ring->index, static_cast<unsigned long long>(dropped - ring->droppedReported),
+                      static_cast<unsigned long long>(dropped));
+        text += warning;
+        ring->droppedReported = dropped;
+    }
+
+    if (!text.isEmpty()) {
+        std::fwrite(text.constData(), 1, size_t(text.size()), s.output);
+        std::fflush(s.output);
+    }
+}
+
+void formatterLoop() {
+    LoggerState& s = state();
+    QVector<PendingRecord> pending;
+    pending.reserve(AsyncLogger::RING_CAPACITY);
+    QByteArray text;
+    for (;;) {
+        bool stopping;
+        {
+            std::unique_lock<std::mutex> lock(s.wakeMutex);
+            s.wakeCondition.wait_for(lock, std::chrono::milliseconds(FLUSH_INTERVAL_MS),
+                                     [&s]() { return s.stopRequested; });
+            stopping = s.stopRequested;
+        }
+        drain(pending, text);
+        if (stopping) break;
+    }
+}
+
+} // namespace
+
+// --- addText: UTF-8 文本按字节截断，不拆开多字节字符 ---
+void LogRecord::addText(const char* utf8, int length) {
+    const int availableSlots = qMin(TEXT_SLOTS, MAX_SLOTS - int(slotCount));
+    if (availableSlots <= 0) return;
+    const int maxBytes = availableSlots * 8 - 1;
+    if (length > maxBytes) {
+        length = maxBytes;
+        while (length > 0 && (static_cast<uchar>(utf8[length]) & 0xC0) == 0x80) --length; // 回退到字符边界
+    }
+    const int slots = (length + 8) / 8; // 含结尾的 '\0'
+    char* out = reinterpret_cast<char*>(&values[slotCount]); // 槽在内存中连续，文本可以跨越多个槽
+    std::memcpy(out, utf8, size_t(length));
+    std::memset(out + length, 0, size_t(slots * 8 - length));
+    types[slotCount] = LogArgType::Text;
+    for (int i = 1; i < slots; ++i) types[slotCount + i] = LogArgType::TextContinue;
+    slotCount = quint8(slotCount + slots);
+}
+
+void LogRecord::addText(QStringView text) {
+    char buffer[MAX_TEXT_BYTES + 1];
+    int length = 0;
+    for (qsizetype i = 0; i < text.size(); ++i) {
+        char32_t c = text[i].unicode();
+        if (QChar::isHighSurrogate(c) && i + 1 < text.size() && text[i + 1].isLowSurrogate()) {
+            c = QChar::surrogateToUcs4(char16_t(c), text[i + 1].unicode());
+            ++i;
+        }
+        char encoded[4];
+        int n;
+        if (c < 0x80) {
+            encoded[0] = char(c);
+            n = 1;
+        } else if (c < 0x800) {
+            encoded[0] = char(0xC0 | (c >> 6));
+            encoded[1] = char(0x80 | (c & 0x3F));
+            n = 2;
+        } else if (c < 0x10000) {
+            encoded[0] = char(0xE0 | (c >> 12));
+            encoded[1] = char(0x80 | ((c >> 6) & 0x3F));
+            encoded[2] = char(0x80 | (c & 0x3F));
+            n = 3;
+        } else {
+            encoded[0] = char(0xF0 | (c >> 18));
+            encoded[1] = char(0x80 | ((c >> 12) & 0x3F));
+            encoded[2] = char(0x80 | ((c >> 6) & 0x3F));
+            encoded[3] = char(0x80 | (c & 0x3F));
+            n = 4;
+        }
+        if (length + n > MAX_TEXT_BYTES) break;
+        std::memcpy(buffer + length, encoded, size_t(n));
+        length += n;
+    }
+    addText(buffer, length);
+}
+
+// --- start: 打开输出并启动格式化线程 ---
+bool AsyncLogger::start(const QString& filePath) {
+    LoggerState& s = state();
+    if (s.running) return true;
+
+    bool ok = true;
+    s.output = stderr;
+    if (!filePath.isEmpty()) {
+        if (FILE* file = openLogFile(filePath)) {
+            s.output = file;
+        } else {
+            std::fprintf(stderr, "无法打开日志文件 %s，日志输出到 stderr\n", qPrintable(filePath));
+            ok = false;
+        }
+    }
+
+    s.startNs = now();
+    s.stopRequested = false;
+    s.formatter = std::thread(formatterLoop);
+    s.running = true;
+    return ok;
+}
+
+// --- stop: 输出剩余记录并停止格式化线程 ---
+void AsyncLogger::stop() {
+    LoggerState& s = state();
+    if (!s.running) return;
+    {
+        std::lock_guard<std::mutex> lock(s.wakeMutex);
+        s.stopRequested = true;
+    }
+    s.wakeCondition.notify_one();
+    s.formatter.join();
+    s.running = false;
+
+    const quint64 dropped = droppedCount();
+    if (dropped > 0) {
+        std::fprintf(s.output, "[日志] 共丢弃 %llu 条记录\n", static_cast<unsigned long long>(dropped));
+    }
+    if (s.output != stderr) {
+        std::fclose(s.output);
+        s.output = stderr;
+    }
+}
+
+// --- setMinLevel: 按名称设置运行期级别 ---
+bool AsyncLogger::setMinLevel(const QString& name) {
+    static const struct { const char* name; LogLevel level; } levels[] = {
+        { "trace", LogLevel::Trace }, { "debug", LogLevel::Debug }, { "info", LogLevel::Info },
+        { "warning", LogLevel::Warning }, { "error", LogLevel::Error },
+    };
+    for (const auto& entry : levels) {
+        if (name.compare(QLatin1String(entry.name), Qt::CaseInsensitive) == 0) {
+            setMinLevel(entry.level);
+            return true;
+        }
+    }
+    return false;
+}
+
+quint64 AsyncLogger::droppedCount() {
+    LoggerState& s = state();
+    std::lock_guard<std::mutex> lock(s.registryMutex);
+    quint64 total = 0;
+    for (const auto& ring : s.rings) total += ring->dropped.load(std::memory_order_relaxed);
+    return total;
+}
+
+// --- submit: 写入当前线程的缓冲区，满时丢弃并计数 (不阻塞调用线程) ---
+void AsyncLogger::submit(const LogRecord& record) {
+    LogRing* ring = ringForCurrentThread();
+    if (!ring->queue.push(record)) ring->dropped.fetch_add(1, std::memory_order_relaxed);
+}
@@ -0,0 +1,212 @@
+#ifndef VIRTUALKEYBOARD_ASYNCLOGGER_H
+#define VIRTUALKEYBOARD_ASYNCLOGGER_H
+
+#include <QString>
+#include <QStringView>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <type_traits>
+
+// 异步结构化日志
+// 调用线程只把固定大小的二进制记录 (时间戳、调用点、格式串指针和最多 6 个参数槽) 写入本线程的
+// 无锁环形缓冲区，不分配内存、不格式化、不加锁；后台格式化线程定期取出所有线程的记录，
+// 按时间排序后格式化输出到 stderr 或日志文件。
+// 缓冲区满时丢弃新记录并计数，丢弃数由格式化线程以警告输出，也可以通过 droppedCount() 读取。
+//
+// 用法: VK_LOG_DEBUG("按下: 键 {} VK {x}", keyId, vkCode);
+//   - 格式串必须是字符串字面量 (记录中只保存指针)
+//   - {} 按参数类型输出，{x} 以十六进制输出整数
+//   - 参数可以是整数、枚举、bool、浮点数、const char* 和 QString (文本最多保留 15 个 UTF-8 字节)
+
+// --- 日志级别 (预处理器可比较的数值) ---
+#define VK_LOG_LEVEL_TRACE   0
+#define VK_LOG_LEVEL_DEBUG   1
+#define VK_LOG_LEVEL_INFO    2
+#define VK_LOG_LEVEL_WARNING 3
+#define VK_LOG_LEVEL_ERROR   4
+
+// 编译期最低级别: 低于它的日志调用在预处理阶段就被移除 (参数也不会求值)
+// 默认 Debug 构建保留 Debug，Release (QT_NO_DEBUG) 只保留 Info 及以上；可由 CMake 的 VK_LOG_MIN_LEVEL 覆盖
+#ifndef VK_LOG_MIN_LEVEL
+#ifdef QT_NO_DEBUG
+#define VK_LOG_MIN_LEVEL VK_LOG_LEVEL_INFO
+#else
+#define VK_LOG_MIN_LEVEL VK_LOG_LEVEL_DEBUG
+#endif
+#endif
+
+enum class LogLevel : quint8 {
+    Trace = VK_LOG_LEVEL_TRACE,
+    Debug = VK_LOG_LEVEL_DEBUG,
+    Info = VK_LOG_LEVEL_INFO,
+    Warning = VK_LOG_LEVEL_WARNING,
+    Error = VK_LOG_LEVEL_ERROR
+};
+
+// 日志调用点 (每个调用点一个静态对象)
+struct LogSite {
+    LogLevel level;
+    const char* file;
+    int line;
+};
+
+enum class LogArgType : quint8 {
+    None,
+    Int,
+    UInt,
+    Double,
+    Bool,
+    Text,        // 文本的第一个槽
+    TextContinue // 文本占用的后续槽
+};
+
+// 一条日志记录 (定长，可以直接放进环形缓冲区)
+struct LogRecord {
+    static constexpr int MAX_SLOTS = 6;       // 参数槽数
+    static constexpr int TEXT_SLOTS = 2;      // 一个文本参数最多占用的槽数
+    static constexpr int MAX_TEXT_BYTES = TEXT_SLOTS * 8 - 1;
+
+    union Value {
+        qint64 i;
+        quint64 u;
+        double d;
+        char text[8];
+    };
+
+    qint64 timeNs;      // steady_clock 时间戳
+    const LogSite* site;
+    const char* format; // 格式串 (字符串字面量)
+    quint8 slotCount = 0;
+    LogArgType types[MAX_SLOTS];
+    Value values[MAX_SLOTS];
+
+    // --- 参数打包: 超出槽数的参数被忽略 (格式化时输出 {?}) ---
+    template <typename T>
+    void add(const T& value) {
+        if constexpr (std::is_same_v<T, bool>) {
+            if (slotCount >= MAX_SLOTS) return;
+            types[slotCount] = LogArgType::Bool;
+            values[slotCount++].u = value ? 1 : 0;
+        } else if constexpr (std::is_enum_v<T>) {
+            add(static_cast<std::underlying_type_t<T>>(value));
+        } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+            if (slotCount >= MAX_SLOTS) return;
+            types[slotCount] = LogArgType::Int;
+            values[slotCount++].i = static_cast<qint64>(value);
+        } else if constexpr (std::is_integral_v<T>) {
+            if (slotCount >= MAX_SLOTS) return;
+            types[slotCount] = LogArgType::UInt;
+            values[slotCount++].u = static_cast<quint64>(value);
+        } else if constexpr (std::is_floating_point_v<T>) {
+            if (slotCount >= MAX_SLOTS) return;
+            types[slotCount] = LogArgType::Double;
+            values[slotCount++].d = static_cast<double>(value);
+        } else if constexpr (std::is_convertible_v<const T&, const char*>) {
+            const char* text = value;
+            addText(text, text ? int(std::strlen(text)) : 0);
+        } else {
+            static_assert(std::is_convertible_v<const T&, QStringView>, "不支持的日志参数类型");
+            addText(QStringView(value));
+        }
+    }
+
+    void addText(const char* utf8, int length); // 截断到 MAX_TEXT_BYTES (不拆开多字节字符)
+    void addText(QStringView text);             // 就地编码为 UTF-8，不分配内存
+};
+
+// 异步日志 (进程内唯一，静态接口)
+class AsyncLogger {
+public:
+    // 每个线程的环形缓冲区容量 (记录数)
+    static constexpr int RING_CAPACITY = 1024;
+
+    // 启动格式化线程；filePath 为空时输出到 stderr。start 之前写入的记录会保留在缓冲区中 (满了则丢弃并计数)
+    static bool start(const QString& filePath = QString());
+    // 取出并输出剩余记录，报告丢弃数，停止格式化线程
+    static void stop();
+
+    // 在作用域内启动日志 (main 中先于其他对象构造，最后析构，保证析构期间的日志也能输出)
+    class Scope {
+    public:
+        explicit Scope(const QString& filePath = QString()) { start(filePath); }
+        ~Scope() { stop(); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    // 运行期最低级别 (只能比编译期级别更严格)
+    static void setMinLevel(LogLevel level) { runtimeMinLevel.store(int(level), std::memory_order_relaxed); }
+    static bool setMinLevel(const QString& name); // trace/debug/info/warning/error，无法识别时返回 false
+    static bool isEnabled(LogLevel level) {
+        return int(level) >= VK_LOG_MIN_LEVEL && int(level) >= runtimeMinLevel.load(std::memory_order_relaxed);
+    }
+
+    // 所有线程累计丢弃的记录数
+    static quint64 droppedCount();
+
+    static qint64 now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // 写入一条记录 (由 VK_LOG_* 宏调用)
+    template <typename... Args>
+    static void write(const LogSite* site, const char* format, const Args&... args) {
+        LogRecord record;
+        record.timeNs = now();
+        record.site = site;
+        record.format = format;
+        (record.add(args), ...);
+        submit(record);
+    }
+
+private:
+    static void submit(const LogRecord& record); // 写入当前线程的环形缓冲区
+
+    static std::atomic<int> runtimeMinLevel;
+};
+
+// --- 日志宏 ---
+#define VK_LOG_AT(logLevel, ...)                                              \
+    do {                                                                      \
+        if (AsyncLogger::isEnabled(logLevel)) {                               \
+            static const LogSite vkLogSite{ logLevel, __FILE__, __LINE__ };   \
+            AsyncLogger::write(&vkLogSite, __VA_ARGS__);                      \
+        }                                                                     \
+    } while (false)
+
+#define VK_LOG_DISABLED() do {} while (false)
+
+// VK_LOG_*_ENABLED() 用于跳过只为日志准备参数的代码 (编译期禁用时为常量 false)
+#if VK_LOG_MIN_LEVEL <= VK_LOG_LEVEL_TRACE
+#define VK_LOG_TRACE(...) VK_LOG_AT(LogLevel::Trace, __VA_ARGS__)
+#define VK_LOG_TRACE_ENABLED() AsyncLogger::isEnabled(LogLevel::Trace)
+#else
+#define VK_LOG_TRACE(...) VK_LOG_DISABLED()
+#define VK_LOG_TRACE_ENABLED() false
+#endif
+
+#if VK_LOG_MIN_LEVEL <= VK_LOG_LEVEL_DEBUG
+#define VK_LOG_DEBUG(...) VK_LOG_AT(LogLevel::Debug, __VA_ARGS__)
+#define VK_LOG_DEBUG_ENABLED() AsyncLogger::isEnabled(LogLevel::Debug)
+#else
+#define VK_LOG_DEBUG(...) VK_LOG_DISABLED()
+#define VK_LOG_DEBUG_ENABLED() false
+#endif
+
+#if VK_LOG_MIN_LEVEL <= VK_LOG_LEVEL_INFO
+#define VK_LOG_INFO(...) VK_LOG_AT(LogLevel::Info, __VA_ARGS__)
+#else
+#define VK_LOG_INFO(...) VK_LOG_DISABLED()
+#endif
+
+#if VK_LOG_MIN_LEVEL <= VK_LOG_LEVEL_WARNING
+#define VK_LOG_WARNING(...) VK_LOG_AT(LogLevel::Warning, __VA_ARGS__)
+#else
+#define VK_LOG_WARNING(...) VK_LOG_DISABLED()
+#endif
+
+#define VK_LOG_ERROR(...) VK_LOG_AT(LogLevel::Error, __VA_ARGS__)
+
+#endif // VIRTUALKEYBOARD_ASYNCLOGGER_H
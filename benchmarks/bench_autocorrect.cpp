@@ -0,0 +1,211 @@
+// 自动纠错基准
+// 从词典 (文本或 .vkdt) 编译 SymSpell 纠错索引，然后:
+// - 报告编译耗时、索引文件大小和删除串数量
+// - 用拼写错误语料 (每行 "错误 正确"，# 开头为注释) 或从词典按词频抽取单词合成的 1~2 次编辑错误
+//   (删除、插入、替换、相邻交换) 测量每次 lookup() 的耗时和纠正准确率
+// - 用词典中的正确单词测量误纠率 (正确单词被改成其他单词)
+// - 在少量样本上与逐词计算编辑距离的暴力扫描比较耗时和结果
+// 用法: bench_autocorrect <词典> [拼写错误语料|查询次数]
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QVector>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+
+#include "latencystats.h"
+#include "spellindex.h"
+#include "wordtrie.h"
+
+const int BENCH_SHORT_WORD = 4;     // 与 VirtualKeyboardWidget 一致: 不超过 4 个字母的单词只允许编辑距离 1
+const int BENCH_SCAN_SAMPLES = 200; // 暴力扫描比较的样本数
+
+struct Query {
+    QString typed;    // 输入 (可能拼错)
+    QString intended; // 想要输入的单词
+};
+
+// 已排序样本的百分位数 (最近秩)
+static double percentile(const QVector<double>& sorted, double p) {
+    if (sorted.isEmpty()) return 0.0;
+    int index = int(p * sorted.size() + 0.999999) - 1;
+    return sorted[qBound(0, index, int(sorted.size()) - 1)];
+}
+
+static int maxDistanceFor(const QString& typed) {
+    return typed.size() <= BENCH_SHORT_WORD ? 1 : SpellIndex::MAX_DISTANCE;
+}
+
+// 对单词做一次随机编辑
+static QString mutate(const QString& word, QRandomGenerator& random) {
+    QString result = word;
+    const QChar letter = QLatin1Char(char('a' + random.bounded(26)));
+    switch (random.bounded(4)) {
+        case 0: if (result.size() > 1) result.remove(random.bounded(int(result.size())), 1); break;
+        case 1: result.insert(random.bounded(int(result.size()) + 1), letter); break;
+        case 2: result[random.bounded(int(result.size()))] = letter; break;
+        default:
+            if (result.size() > 1) {
+                const int i = random.bounded(int(result.size()) - 1);
+                std::swap(result[i], result[i + 1]);
+            }
+            break;
+    }
+    return result;
+}
+
+// 读取拼写错误语料
+static bool readCorpus(const QString& path, QVector<Query>& queries) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        std::fprintf(stderr, "无法打开语料 %s: %s\n", qPrintable(path), qPrintable(file.errorString()));
+        return false;
+    }
+    QTextStream in(&file);
+    while (!in.atEnd()) {
+        const QString line = in.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith(QLatin1Char('#'))) continue;
+        const QStringList fields = line.split(QLatin1Char(' '), Qt::SkipEmptyParts);
+        if (fields.size() >= 2) queries.append({fields[0].toLower(), fields[1].toLower()});
+    }
+    return true;
+}
+
+// 暴力扫描: 逐词计算编辑距离 (与 lookup() 相同的选择规则)
+static bool scanLookup(const QVector<WordTrie::Completion>& words, const QString& typed, int maxDistance, SpellIndex::Suggestion& out) {
+    bool found = false;
+    for (const WordTrie::Completion& word : words) {
+        const int distance = SpellIndex::editDistance(typed, word.word, maxDistance);
+        if (distance > maxDistance) continue;
+        if (!found || distance < out.distance || (distance == out.distance && word.score > out.score)) {
+            out = {word.word, distance, word.score};
+            found = true;
+        }
+    }
+    return found;
+}
+
+static void printTiming(const char* label, QVector<double>& ns) {
+    if (ns.isEmpty()) return;
+    std::sort(ns.begin(), ns.end());
+    std::printf("%s: 中位数 %8.2f us   p99 %8.2f us   最大 %8.2f us\n", label,
+                percentile(ns, 0.5) / 1000.0, percentile(ns, 0.99) / 1000.0, ns.last() / 1000.0);
+}
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    const QStringList arguments = QCoreApplication::arguments();
+    if (arguments.size() < 2) {
+        std::fprintf(stderr, "用法: bench_autocorrect <词典> [拼写错误语料|查询次数]\n");
+        return 2;
+    }
+
+    // --- 词典 ---
+    QString error;
+    std::unique_ptr<WordTrie> trie = WordTrie::open(arguments[1], &error);
+    if (!trie) {
+        std::fprintf(stderr, "无法打开词典 %s: %s\n", qPrintable(arguments[1]), qPrintable(error));
+        return 1;
+    }
+    QVector<WordTrie::Completion> words;
+    trie->complete(WordTrie::ROOT, QStringView(), int(trie->wordCount()), words);
+
+    // --- 编译索引 (计时用，写到临时目录)；查询使用 CacheLocation 中的缓存 (与键盘相同) ---
+    QTemporaryDir tempDir;
+    const QString indexPath = QDir(tempDir.path()).filePath(QStringLiteral("bench.vksc"));
+    const qint64 compileStartNs = LatencyStats::now();
+    if (!SpellIndex::compile(*trie, arguments[1], indexPath, &error)) {
+        std::fprintf(stderr, "编译失败: %s\n", qPrintable(error));
+        return 1;
+    }
+    const double compileMs = (LatencyStats::now() - compileStartNs) / 1e6;
+    const qint64 openStartNs = LatencyStats::now();
+    std::unique_ptr<SpellIndex> index = SpellIndex::open(arguments[1], *trie, &error);
+    if (!index) {
+        std::fprintf(stderr, "无法打开索引: %s\n", qPrintable(error));
+        return 1;
+    }
+    std::printf("索引: %u 个单词, %u 个删除串, %.1f MB, 编译 %.1f ms, 打开 %.2f ms%s\n",
+                index->wordCount(), index->entryCount(), index->fileSize() / 1048576.0, compileMs,
+                (LatencyStats::now() - openStartNs) / 1e6, index->compiledOnOpen() ? " (缓存过期，重新编译)" : "");
+
+    // --- 查询: 语料或合成的拼写错误 ---
+    QVector<Query> queries;
+    QRandomGenerator random(42);
+    if (arguments.size() > 2 && QFileInfo::exists(arguments[2])) {
+        if (!readCorpus(arguments[2], queries)) return 1;
+    } else {
+        const int queryCount = arguments.size() > 2 ? qMax(1, arguments[2].toInt()) : 100000;
+        QVector<double> cumulative;
+        cumulative.reserve(words.size());
+        double total = 0;
+        for (const WordTrie::Completion& word : std::as_const(words)) {
+            total += std::exp2(word.score / 1024.0);
+            cumulative.append(total);
+        }
+        while (queries.size() < queryCount) {
+            const double pick = random.generateDouble() * total;
+            const int wordIndex = int(std::upper_bound(cumulative.cbegin(), cumulative.cend(), pick) - cumulative.cbegin());
+            const QString& word = words[qMin(wordIndex, int(words.size()) - 1)].word;
+            if (word.size() < 3) continue; // 与键盘一致: 短单词不纠正
+            QString typed = mutate(word, random);
+            if (word.size() > BENCH_SHORT_WORD && random.bounded(2)) typed = mutate(typed, random);
+            queries.append({typed, word});
+        }
+    }
+    if (queries.isEmpty()) {
+        std::fprintf(stderr, "没有查询\n");
+        return 1;
+    }
+
+    QVector<double> lookupNs;
+    lookupNs.reserve(queries.size());
+    int corrected = 0, unchanged = 0;
+    SpellIndex::Suggestion suggestion;
+    for (const Query& query : std::as_const(queries)) {
+        const qint64 startNs = LatencyStats::now();
+        const bool found = index->lookup(query.typed, maxDistanceFor(query.typed), suggestion);
+        lookupNs.append(double(LatencyStats::now() - startNs));
+        if (!found) ++unchanged;
+        else if (suggestion.word == query.intended) ++corrected;
+    }
+    std::printf("拼写错误 %d 个: 纠正为目标单词 %.2f%%   未找到候选 %.2f%%\n", int(queries.size()),
+                100.0 * corrected / queries.size(), 100.0 * unchanged / queries.size());
+    printTiming("每次 lookup", lookupNs);
+
+    // --- 误纠率: 词典中的正确单词应保持不变 ---
+    int checkedWords = 0, miscorrected = 0;
+    for (const WordTrie::Completion& word : std::as_const(words)) {
+        if (word.word.size() < 3) continue;
+        ++checkedWords;
+        if (index->lookup(word.word, maxDistanceFor(word.word), suggestion) && suggestion.distance > 0) ++miscorrected;
+    }
+    if (checkedWords > 0) {
+        std::printf("正确单词 %d 个: 误纠率 %.3f%%\n", checkedWords, 100.0 * miscorrected / checkedWords);
+    }
+
+    // --- 与暴力扫描比较 ---
+    QVector<double> scanNs;
+    int mismatches = 0;
+    const int samples = qMin(BENCH_SCAN_SAMPLES, int(queries.size()));
+    for (int i = 0; i < samples; ++i) {
+        const Query& query = queries[i];
+        SpellIndex::Suggestion scanned;
+        const qint64 startNs = LatencyStats::now();
+        const bool scanFound = scanLookup(words, query.typed, maxDistanceFor(query.typed), scanned);
+        scanNs.append(double(LatencyStats::now() - startNs));
+        const bool found = index->lookup(query.typed, maxDistanceFor(query.typed), suggestion);
+        // 距离相同、得分相同的单词可能有多个: 只比较距离和得分
+        if (found != scanFound || (found && (suggestion.distance != scanned.distance || suggestion.score != scanned.score))) ++mismatches;
+    }
+    printTiming("暴力扫描", scanNs);
+    std::printf("暴力扫描样本 %d 个, 结果不同 %d 个\n", samples, mismatches);
+    return 0;
+}
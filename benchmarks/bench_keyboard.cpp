@@ -0,0 +1,211 @@
+// 键盘热路径的 QtTest 基准 (QBENCHMARK)
+// 链接 VirtualKeyboardCore，在 offscreen 平台 (未设置 QT_QPA_PLATFORM 时) 下用按钮模式和内存记录后端构造键盘，
+// 测量布局生成、按钮创建、修饰键视觉更新、透明度变化、布局切换、几何模式切换和完整的按下/释放处理。
+// 结果可以用 QtTest 的输出选项写为机器可读的格式，例如:
+//   bench_keyboard -o result.xml,xml -o -,txt      (XML 供比较不同构建，同时在终端显示)
+//   bench_keyboard -csv                            (每个用例一行 CSV)
+// 只运行一个用例: bench_keyboard pressReleaseCycle
+// 用 -DVK_ALLOC_ACCOUNTING=ON 构建时，每个用例还会输出每次迭代的堆分配次数和字节数。
+
+#include <QApplication>
+#include <QGridLayout>
+#include <QPushButton>
+#include <QtTest>
+
+#include "virtualkeyboardwidget.h"
+#include "keyboardpanel.h"
+#include "layouttable.h"
+#include "recordingbackend.h"
+#include "allocstats.h"
+
+class KeyboardBenchmark : public QObject {
+Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void getFullKeyboardLayout();
+    void splitLayout();
+    void createKeyboardLayout();
+    void updateModifierKeysVisuals();
+    void changeOpacity();
+    void switchLayout();
+    void switchGeometryMode();
+    void pressReleaseCycle_data();
+    void pressReleaseCycle();
+    void cleanupTestCase();
+
+private:
+    void clearRecording(); // 丢弃记录后端中累积的事件 (长时间运行时不占用内存)
+    // 输出 operation 在 iterations 次迭代中每次的分配 (只在编译了分配统计时)
+    static void reportAllocations(AllocOperation operation, int iterations);
+
+    std::unique_ptr<VirtualKeyboardWidget> keyboard;
+};
+
+// --- initTestCase: 构造键盘 (与正常启动相同的路径，不显示窗口) ---
+void KeyboardBenchmark::initTestCase() {
+    KeyboardOptions options;
+    options.renderMode = RenderMode::Buttons;
+    options.injectionBackend = QStringLiteral("recording");
+    keyboard = std::make_unique<VirtualKeyboardWidget>(options);
+    QVERIFY(dynamic_cast<RecordingBackend*>(keyboard->injectionBackend()));
+    qInfo("存活对象: %d 个 QObject, %d 个 QWidget", AllocStats::liveObjects(), AllocStats::liveWidgets());
+}
+
+void KeyboardBenchmark::cleanupTestCase() {
+    keyboard.reset();
+}
+
+void KeyboardBenchmark::clearRecording() {
+    static_cast<RecordingBackend*>(keyboard->injectionBackend())->clear();
+}
+
+void KeyboardBenchmark::reportAllocations(AllocOperation operation, int iterations) {
+    if (!AllocStats::enabled() || iterations <= 0) return;
+    const AllocCounters c = AllocStats::counters(operation);
+    qInfo("%s: 每次迭代分配 %.2f 次 / %.1f 字节 (%d 次迭代)", AllocStats::name(operation),
+          double(c.allocations) / iterations, double(c.bytes) / iterations, iterations);
+}
+
+// --- getFullKeyboardLayout: 由编译期布局表生成完整布局 ---
+void KeyboardBenchmark::getFullKeyboardLayout() {
+    KeyboardLayout layout;
+    QBENCHMARK {
+        layout = ::getFullKeyboardLayout();
+    }
+    QVERIFY(!layout.isEmpty());
+}
+
+// --- splitLayout: 拆分为左右两半 ---
+void KeyboardBenchmark::splitLayout() {
+    const KeyboardLayout full = ::getFullKeyboardLayout();
+    KeyboardLayout left, right;
+    QBENCHMARK {
+        left.clear();
+        right.clear();
+        ::splitLayout(full, left, right);
+    }
+    QVERIFY(!left.isEmpty() && !right.isEmpty());
+}
+
+// --- createKeyboardLayout: 为左半区创建按钮 (每次一个新的容器，结束后恢复键盘的按钮索引) ---
+void KeyboardBenchmark::createKeyboardLayout() {
+    VirtualKeyboardWidget& widget = *keyboard;
+    const QList<QPushButton*> savedButtons = widget.keyButtons;
+    const QVector<QList<QPushButton*>> savedButtonsById = widget.keyButtonsById;
+    QList<KeyboardPanel*> panels;
+    QBENCHMARK {
+        KeyboardPanel* panel = new KeyboardPanel();
+        QGridLayout* grid = new QGridLayout(panel);
+        widget.createKeyboardLayout(panel, grid, widget.leftLayoutData);
+        panels.append(panel);
+    }
+    widget.keyButtons = savedButtons;
+    widget.keyButtonsById = savedButtonsById;
+    qDeleteAll(panels);
+}
+
+// --- updateModifierKeysVisuals: 每次翻转 Shift 状态 (字母/符号键文本和 Shift 键样式都要更新) ---
+void KeyboardBenchmark::updateModifierKeysVisuals() {
+    VirtualKeyboardWidget& widget = *keyboard;
+    int iterations = 0;
+    AllocStats::reset();
+    QBENCHMARK {
+        widget.shiftActive = !widget.shiftActive;
+        widget.updateModifierKeysVisuals();
+        ++iterations;
+    }
+    reportAllocations(AllocOperation::ModifierVisuals, iterations);
+    widget.shiftActive = false;
+    widget.updateModifierKeysVisuals();
+}
+
+// --- changeOpacity: 滑块变化 + 下一帧应用 (两个不同的值交替) ---
+void KeyboardBenchmark::changeOpacity() {
+    VirtualKeyboardWidget& widget = *keyboard;
+    int value = 40;
+    int iterations = 0;
+    AllocStats::reset();
+    QBENCHMARK {
+        value = value == 40 ? 90 : 40;
+        widget.changeOpacity(value);
+        widget.applyPendingOpacity();
+        ++iterations;
+    }
+    reportAllocations(AllocOperation::Opacity, iterations);
+    widget.opacityTimer.stop();
+}
+
+// --- switchLayout: 在布局组中循环切换 (原地更新所有按键的文本，不创建控件) ---
+void KeyboardBenchmark::switchLayout() {
+    VirtualKeyboardWidget& widget = *keyboard;
+    if (widget.layoutCount() < 2) QSKIP("只加载了一个布局");
+    const int widgetsBefore = AllocStats::liveWidgets();
+    int iterations = 0;
+    AllocStats::reset();
+    QBENCHMARK {
+        widget.switchLayout((widget.activeLayoutIndex() + 1) % widget.layoutCount());
+        ++iterations;
+    }
+    reportAllocations(AllocOperation::LayoutSwitch, iterations);
+    widget.switchLayout(0);
+    QCOMPARE(AllocStats::liveWidgets(), widgetsBefore);
+}
+
+// --- switchGeometryMode: 在完整、拆分、紧凑和小键盘之间循环 (只重新排布现有按钮，不创建控件) ---
+void KeyboardBenchmark::switchGeometryMode() {
+    VirtualKeyboardWidget& widget = *keyboard;
+    const GeometryMode initialMode = widget.activeGeometryMode();
+    const int widgetsBefore = AllocStats::liveWidgets();
+    int iterations = 0;
+    AllocStats::reset();
+    QBENCHMARK {
+        widget.cycleGeometryMode();
+        ++iterations;
+    }
+    reportAllocations(AllocOperation::GeometrySwitch, iterations);
+    widget.setGeometryMode(initialMode);
+    QCOMPARE(widget.activeGeometryMode(), initialMode);
+    QCOMPARE(AllocStats::liveWidgets(), widgetsBefore);
+}
+
+// --- pressReleaseCycle: 一次完整的按下 + 释放 (处理函数、入队和视觉更新，不含注入线程) ---
+void KeyboardBenchmark::pressReleaseCycle_data() {
+    QTest::addColumn<int>("keyId");
+    const KeyTable& table = keyboard->layoutKeys();
+    QTest::newRow("letter") << table.keyForChar(QLatin1Char('a')).keyId;
+    QTest::newRow("space") << table.keyForChar(QLatin1Char(' ')).keyId;
+    int shiftId = -1;
+    for (int keyId = 0; keyId < table.size() && shiftId < 0; ++keyId) {
+        if (table.entry(keyId).modifier == ModifierGroup::Shift) shiftId = keyId;
+    }
+    QTest::newRow("shift") << shiftId;
+}
+
+void KeyboardBenchmark::pressReleaseCycle() {
+    QFETCH(int, keyId);
+    QVERIFY(keyId >= 0);
+    VirtualKeyboardWidget& widget = *keyboard;
+    int cycles = 0;
+    AllocStats::reset();
+    QBENCHMARK {
+        widget.onKeyPressed(keyId);
+        widget.onKeyReleased(keyId);
+        if (++cycles % 4096 == 0) clearRecording();
+    }
+    reportAllocations(AllocOperation::Press, cycles);
+    reportAllocations(AllocOperation::Release, cycles);
+    widget.keyRepeater.cancel();
+    while (!widget.isInjectionIdle()) QThread::yieldCurrentThread();
+    clearRecording();
+}
+
+int main(int argc, char *argv[]) {
+    // 不需要真实的显示 (已设置 QT_QPA_PLATFORM 时不覆盖)
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication app(argc, argv);
+    KeyboardBenchmark benchmark;
+    return QTest::qExec(&benchmark, argc, argv);
+}
+
+#include "bench_keyboard.moc"
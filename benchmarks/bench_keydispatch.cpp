@@ -0,0 +1,74 @@
+// 按键分发微基准
+// 比较两种从按钮取得按键数据的方式的单次事件开销:
+//   旧路径: qobject_cast + property("keyInfo") + canConvert + value<KeyInfo>() (复制两个 QString)
+//   新路径: 按钮只携带整数 id，直接索引 KeyTable
+// 用法: bench_keydispatch [迭代轮数]
+
+#include <QApplication>
+#include <QPushButton>
+#include <QElapsedTimer>
+#include <QVariant>
+#include <cstdio>
+
+#include "layouttable.h"
+#include "keytable.h"
+
+int main(int argc, char *argv[]) {
+    // 基准不需要真正显示窗口
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication app(argc, argv);
+
+    const int rounds = argc > 1 ? QString::fromLocal8Bit(argv[1]).toInt() : 20000;
+
+    // --- 准备数据 ---
+    KeyboardLayout layout = getFullKeyboardLayout();
+    KeyTable table;
+    table.build(layout);
+
+    QList<QObject*> senders;   // 旧路径: 槽函数中 sender() 返回的对象
+    QVector<int> keyIds;       // 新路径: 按钮携带的 id
+    for (const auto& row : layout) {
+        for (const auto& keyInfo : row) {
+            if (keyInfo.keyId < 0) continue;
+            QPushButton *button = new QPushButton(keyInfo.text);
+            button->setProperty("keyInfo", QVariant::fromValue(keyInfo));
+            senders.append(button);
+            keyIds.append(keyInfo.keyId);
+        }
+    }
+    const qint64 events = qint64(rounds) * senders.size();
+    volatile int sink = 0; // 防止编译器优化掉循环
+
+    // --- 旧路径 ---
+    QElapsedTimer timer;
+    timer.start();
+    for (int r = 0; r < rounds; ++r) {
+        for (QObject *sender : senders) {
+            QPushButton *button = qobject_cast<QPushButton*>(sender);
+            if (!button) continue;
+            QVariant variant = button->property("keyInfo");
+            if (!variant.isValid() || !variant.canConvert<KeyInfo>()) continue;
+            KeyInfo keyInfo = variant.value<KeyInfo>();
+            sink = sink + keyInfo.vkCode + int(keyInfo.type);
+        }
+    }
+    const qint64 variantNs = timer.nsecsElapsed();
+
+    // --- 新路径 ---
+    timer.restart();
+    for (int r = 0; r < rounds; ++r) {
+        for (int keyId : keyIds) {
+            const KeyEntry& key = table.entry(keyId);
+            sink = sink + key.vkCode + int(key.type);
+        }
+    }
+    const qint64 tableNs = timer.nsecsElapsed();
+
+    std::printf("keys=%d rounds=%d events=%lld\n", int(senders.size()), rounds, static_cast<long long>(events));
+    std::printf("variant_property: %.2f ns/event\n", double(variantNs) / events);
+    std::printf("key_table:        %.2f ns/event\n", double(tableNs) / events);
+    std::printf("speedup:          %.1fx\n", tableNs > 0 ? double(variantNs) / tableNs : 0.0);
+
+    qDeleteAll(senders);
+    return 0;
+}
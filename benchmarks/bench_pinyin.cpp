@@ -0,0 +1,131 @@
+// 拼音输入基准
+// 生成一个合成词库 (每个音节若干单字，加上随机组合的 2-4 音节词和二元语法，频率按排名递减)，
+// 编译为二进制词库并映射，然后逐字输入由 20 个音节组成的缓冲区，
+// 报告每次按键 (appendChar + candidates) 的耗时中位数、p99 和最大值。
+// 用法: bench_pinyin [多音节词数] [输入的缓冲区数]
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+#include <QVector>
+#include <algorithm>
+#include <cstdio>
+
+#include "pinyinengine.h"
+#include "latencystats.h"
+
+const int SYLLABLES_PER_BUFFER = 20; // 每个缓冲区的音节数
+const int CHARACTERS_PER_SYLLABLE = 8; // 每个音节的单字数
+
+// 已排序样本的百分位数 (最近秩)
+static double percentile(const QVector<double>& sorted, double p) {
+    if (sorted.isEmpty()) return 0.0;
+    int index = int(p * sorted.size() + 0.999999) - 1;
+    return sorted[qBound(0, index, int(sorted.size()) - 1)];
+}
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    const QStringList arguments = QCoreApplication::arguments();
+    const int phraseCount = arguments.size() > 1 ? qMax(0, arguments[1].toInt()) : 200000;
+    const int bufferCount = arguments.size() > 2 ? qMax(1, arguments[2].toInt()) : 500;
+
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        std::fprintf(stderr, "无法创建临时目录\n");
+        return 1;
+    }
+
+    // --- 生成词库: 单字取自 CJK 统一汉字区，多音节词由随机单字组成 ---
+    QRandomGenerator random(42);
+    const int syllableCount = PinyinLexicon::syllableCount();
+    QVector<QVector<QString>> characters(syllableCount); // 每个音节的单字
+    char16_t nextCharacter = 0x4E00;
+    for (int s = 0; s < syllableCount; ++s) {
+        for (int c = 0; c < CHARACTERS_PER_SYLLABLE; ++c) characters[s].append(QString(QChar(nextCharacter++)));
+    }
+    const QString sourcePath = dir.filePath(QStringLiteral("synthetic.txt"));
+    QVector<QString> phrases;
+    {
+        QFile source(sourcePath);
+        if (!source.open(QIODevice::WriteOnly)) {
+            std::fprintf(stderr, "无法写入合成词库\n");
+            return 1;
+        }
+        source.write("[words]\n");
+        for (int s = 0; s < syllableCount; ++s) {
+            for (int c = 0; c < CHARACTERS_PER_SYLLABLE; ++c) {
+                source.write(characters[s][c].toUtf8() + ' ' + PinyinLexicon::syllableText(quint16(s)) + ' ' +
+                             QByteArray::number(quint64(1e6 / (c + 1))) + '\n');
+            }
+        }
+        for (int rank = 0; rank < phraseCount; ++rank) {
+            const int length = 2 + int(random.bounded(3));
+            QString text;
+            QByteArray pinyin;
+            for (int i = 0; i < length; ++i) {
+                const int s = int(random.bounded(syllableCount));
+                text += characters[s][random.bounded(CHARACTERS_PER_SYLLABLE)];
+                if (i) pinyin += '\'';
+                pinyin += PinyinLexicon::syllableText(quint16(s));
+            }
+            phrases.append(text);
+            source.write(text.toUtf8() + ' ' + pinyin + ' ' + QByteArray::number(quint64(1e8 / (rank + 1)) + 1) + '\n');
+        }
+        source.write("[bigrams]\n");
+        for (int i = 0; i + 1 < phrases.size(); i += 2) {
+            source.write(phrases[i].toUtf8() + ' ' + phrases[i + 1].toUtf8() + ' ' + QByteArray::number(1 + random.bounded(1000)) + '\n');
+        }
+    }
+
+    // --- 编译和映射 ---
+    const QString compiledPath = dir.filePath(QStringLiteral("synthetic.vkpy"));
+    QElapsedTimer timer;
+    timer.start();
+    QString error;
+    if (!PinyinLexicon::compile(sourcePath, compiledPath, &error)) {
+        std::fprintf(stderr, "编译失败: %s\n", qPrintable(error));
+        return 1;
+    }
+    const double compileMs = timer.nsecsElapsed() / 1e6;
+    timer.restart();
+    PinyinEngine engine;
+    if (!engine.load(compiledPath, &error)) {
+        std::fprintf(stderr, "加载失败: %s\n", qPrintable(error));
+        return 1;
+    }
+    const double loadMs = timer.nsecsElapsed() / 1e6;
+    std::printf("词库: %u 个词条, %u 个二元语法, %.1f MB\n", engine.dictionary()->entryCount(), engine.dictionary()->bigramCount(),
+                QFileInfo(compiledPath).size() / (1024.0 * 1024.0));
+    std::printf("编译: %8.1f ms   映射: %8.3f ms\n", compileMs, loadMs);
+
+    // --- 逐字输入 20 个随机音节组成的缓冲区 ---
+    QVector<double> keystrokeUs;
+    QVector<double> lastKeystrokeUs; // 缓冲区满 20 个音节时最后一次按键的耗时
+    for (int b = 0; b < bufferCount; ++b) {
+        engine.reset();
+        QByteArray letters;
+        for (int s = 0; s < SYLLABLES_PER_BUFFER; ++s) letters += PinyinLexicon::syllableText(quint16(random.bounded(syllableCount)));
+        double lastUs = 0.0;
+        for (char ch : letters) {
+            const qint64 startNs = LatencyStats::now();
+            engine.appendChar(QLatin1Char(ch));
+            engine.candidates();
+            lastUs = (LatencyStats::now() - startNs) / 1000.0;
+            keystrokeUs.append(lastUs);
+        }
+        lastKeystrokeUs.append(lastUs);
+    }
+
+    std::sort(keystrokeUs.begin(), keystrokeUs.end());
+    std::sort(lastKeystrokeUs.begin(), lastKeystrokeUs.end());
+    std::printf("按键次数: %d\n", int(keystrokeUs.size()));
+    std::printf("每次按键:   中位数 %8.2f us   p99 %8.2f us   最大 %8.2f us\n",
+                percentile(keystrokeUs, 0.5), percentile(keystrokeUs, 0.99), keystrokeUs.last());
+    std::printf("20 音节时:  中位数 %8.2f us   p99 %8.2f us   最大 %8.2f us\n",
+                percentile(lastKeystrokeUs, 0.5), percentile(lastKeystrokeUs, 0.99), lastKeystrokeUs.last());
+    return 0;
+}
@@ -0,0 +1,123 @@
+// 单词预测基准
+// 生成一个按频率排名的合成词典 (默认 50 万词，词长和频率分布接近自然语言)，
+// 编译为二进制前缀树并映射，然后模拟逐字输入按 Zipf 分布抽取的单词，
+// 报告每次按键 (appendChar + suggestions) 的耗时中位数、p99 和最大值。
+// 用法: bench_prediction [词典单词数] [模拟输入的单词数]
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QRandomGenerator>
+#include <QSet>
+#include <QTemporaryDir>
+#include <QVector>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include "predictionengine.h"
+#include "latencystats.h"
+
+// 已排序样本的百分位数 (最近秩)
+static double percentile(const QVector<double>& sorted, double p) {
+    if (sorted.isEmpty()) return 0.0;
+    int index = int(p * sorted.size() + 0.999999) - 1;
+    return sorted[qBound(0, index, int(sorted.size()) - 1)];
+}
+
+// 由常见音节拼成的伪单词 (2-6 个音节)
+static QString makeWord(QRandomGenerator& random) {
+    static const char* const syllables[] = {
+        "a", "e", "i", "o", "u", "ba", "be", "ca", "co", "de", "di", "en", "er", "es", "fa", "ga", "ha", "he",
+        "in", "is", "la", "le", "li", "ma", "me", "mo", "na", "ne", "no", "on", "or", "pa", "pe", "ra", "re",
+        "ri", "ro", "sa", "se", "si", "st", "ta", "te", "th", "ti", "to", "tr", "un", "ve", "wa", "ing", "tion",
+    };
+    const int syllableCount = int(sizeof(syllables) / sizeof(syllables[0]));
+    QString word;
+    const int parts = 2 + int(random.bounded(5));
+    for (int i = 0; i < parts; ++i) word += QLatin1String(syllables[random.bounded(syllableCount)]);
+    return word;
+}
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    const QStringList arguments = QCoreApplication::arguments();
+    const int wordCount = arguments.size() > 1 ? qMax(100, arguments[1].toInt()) : 500000;
+    const int typedWords = arguments.size() > 2 ? qMax(1, arguments[2].toInt()) : 5000;
+
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        std::fprintf(stderr, "无法创建临时目录\n");
+        return 1;
+    }
+
+    // --- 生成词典 (按频率排名，频率 ~ 1/排名) ---
+    QRandomGenerator random(42);
+    QVector<QString> words;
+    words.reserve(wordCount);
+    QSet<QString> seen;
+    while (words.size() < wordCount) {
+        const QString word = makeWord(random);
+        if (word.size() > WordTrie::MAX_WORD_LENGTH || seen.contains(word)) continue;
+        seen.insert(word);
+        words.append(word);
+    }
+    const QString sourcePath = dir.filePath(QStringLiteral("synthetic.txt"));
+    {
+        QFile source(sourcePath);
+        if (!source.open(QIODevice::WriteOnly)) {
+            std::fprintf(stderr, "无法写入合成词典\n");
+            return 1;
+        }
+        for (int rank = 0; rank < words.size(); ++rank) {
+            source.write(words[rank].toUtf8() + ' ' + QByteArray::number(quint64(1e9 / (rank + 1))) + '\n');
+        }
+    }
+
+    // --- 编译和映射 ---
+    const QString compiledPath = dir.filePath(QStringLiteral("synthetic.vkdt"));
+    QElapsedTimer timer;
+    timer.start();
+    QString error;
+    if (!WordTrie::compile(sourcePath, compiledPath, &error)) {
+        std::fprintf(stderr, "编译失败: %s\n", qPrintable(error));
+        return 1;
+    }
+    const double compileMs = timer.nsecsElapsed() / 1e6;
+    timer.restart();
+    PredictionEngine engine;
+    if (!engine.load(compiledPath, &error)) {
+        std::fprintf(stderr, "加载失败: %s\n", qPrintable(error));
+        return 1;
+    }
+    const double loadMs = timer.nsecsElapsed() / 1e6;
+
+    std::printf("词典: %u 个单词, %u 个节点, %.1f MB\n", engine.dictionary()->wordCount(), engine.dictionary()->nodeCount(),
+                QFileInfo(compiledPath).size() / (1024.0 * 1024.0));
+    std::printf("编译: %8.1f ms   映射: %8.3f ms\n", compileMs, loadMs);
+
+    // --- 模拟输入: 按 Zipf 分布抽取单词，逐字输入 ---
+    QVector<double> keystrokeUs;
+    const double harmonic = std::log(double(words.size())) + 0.5772;
+    int suggestionsShown = 0;
+    for (int w = 0; w < typedWords; ++w) {
+        // 按 1/排名 抽样: 排名 = exp(u * H) 的近似
+        const int rank = qBound(0, int(std::exp(random.generateDouble() * harmonic)) - 1, int(words.size()) - 1);
+        const QString& word = words[rank];
+        for (QChar ch : word) {
+            const qint64 startNs = LatencyStats::now();
+            engine.appendChar(ch);
+            suggestionsShown += engine.suggestions().size();
+            keystrokeUs.append((LatencyStats::now() - startNs) / 1000.0);
+        }
+        engine.commitWord();
+        engine.suggestions(); // 下一个词的候选 (词典中最常用的单词)
+    }
+
+    std::sort(keystrokeUs.begin(), keystrokeUs.end());
+    std::printf("按键次数: %d (平均每次 %.1f 个建议)\n", int(keystrokeUs.size()), double(suggestionsShown) / keystrokeUs.size());
+    std::printf("每次按键: 中位数 %8.2f us   p99 %8.2f us   最大 %8.2f us\n",
+                percentile(keystrokeUs, 0.5), percentile(keystrokeUs, 0.99), keystrokeUs.last());
+    return 0;
+}
@@ -0,0 +1,95 @@
+// 启动时间基准
+// 在 offscreen QPA 平台下反复启动 VirtualKeyboard (每次一个新进程)，
+// 进程在首帧绘制完成后退出，并通过 --startup-trace 写出各阶段计时。
+// 报告首帧时间 (相对于 main 入口) 和进程总耗时 (包括加载和退出) 的中位数和 p95，以及各阶段的中位数。
+// 用法: bench_startup [启动次数] [传给 VirtualKeyboard 的其他参数...]
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMap>
+#include <QProcess>
+#include <QTemporaryDir>
+#include <QVector>
+#include <algorithm>
+#include <cstdio>
+
+#ifndef VK_APP_PATH
+#error "VK_APP_PATH 应由 CMake 定义为 VirtualKeyboard 可执行文件的路径"
+#endif
+
+// 已排序样本的百分位数 (最近秩)
+static double percentile(const QVector<double>& sorted, double p) {
+    if (sorted.isEmpty()) return 0.0;
+    int index = int(p * sorted.size() + 0.999999) - 1;
+    return sorted[qBound(0, index, int(sorted.size()) - 1)];
+}
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    const QStringList arguments = QCoreApplication::arguments();
+    const int runs = arguments.size() > 1 ? qMax(1, arguments[1].toInt()) : 20;
+    const QStringList extraArguments = arguments.mid(2);
+
+    QTemporaryDir traceDir;
+    if (!traceDir.isValid()) {
+        std::fprintf(stderr, "无法创建临时目录\n");
+        return 1;
+    }
+
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    environment.insert(QStringLiteral("QT_QPA_PLATFORM"), QStringLiteral("offscreen"));
+    environment.insert(QStringLiteral("VK_INJECT_BACKEND"), QStringLiteral("recording")); // 不向系统注入按键
+    environment.insert(QStringLiteral("QT_LOGGING_RULES"), QStringLiteral("*.debug=false"));
+
+    QVector<double> firstFrameMs, wallMs;
+    QMap<QString, QVector<double>> phaseMs; // 每个阶段每次启动的总耗时
+    for (int run = 0; run < runs; ++run) {
+        const QString tracePath = traceDir.filePath(QStringLiteral("startup-%1.json").arg(run));
+        QProcess process;
+        process.setProcessEnvironment(environment);
+        process.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+
+        QElapsedTimer wallClock;
+        wallClock.start();
+        process.start(QStringLiteral(VK_APP_PATH),
+                      QStringList() << QStringLiteral("--startup-trace") << tracePath
+                                    << QStringLiteral("--quit-after-first-frame") << extraArguments);
+        if (!process.waitForFinished(30000) || process.exitStatus() != QProcess::NormalExit || process.exitCode() != 0) {
+            std::fprintf(stderr, "第 %d 次启动失败: %s\n", run, qPrintable(process.errorString()));
+            process.kill();
+            return 1;
+        }
+        wallMs.append(wallClock.nsecsElapsed() / 1e6);
+
+        QFile traceFile(tracePath);
+        if (!traceFile.open(QIODevice::ReadOnly)) {
+            std::fprintf(stderr, "第 %d 次启动没有写出计时文件\n", run);
+            return 1;
+        }
+        const QJsonObject trace = QJsonDocument::fromJson(traceFile.readAll()).object();
+        firstFrameMs.append(trace.value(QStringLiteral("firstFrameUs")).toDouble() / 1000.0);
+
+        QMap<QString, double> runTotals; // 同名阶段 (如两次 createKeyboardLayout) 累加
+        for (const QJsonValue& value : trace.value(QStringLiteral("phases")).toArray()) {
+            const QJsonObject phase = value.toObject();
+            runTotals[phase.value(QStringLiteral("name")).toString()] += phase.value(QStringLiteral("durationUs")).toDouble() / 1000.0;
+        }
+        for (auto it = runTotals.constBegin(); it != runTotals.constEnd(); ++it) phaseMs[it.key()].append(it.value());
+    }
+
+    std::sort(firstFrameMs.begin(), firstFrameMs.end());
+    std::sort(wallMs.begin(), wallMs.end());
+    std::printf("启动次数: %d\n", runs);
+    std::printf("首帧 (自 main 起):   中位数 %8.2f ms   p95 %8.2f ms\n", percentile(firstFrameMs, 0.5), percentile(firstFrameMs, 0.95));
+    std::printf("进程总耗时:          中位数 %8.2f ms   p95 %8.2f ms\n", percentile(wallMs, 0.5), percentile(wallMs, 0.95));
+    std::printf("各阶段中位数:\n");
+    for (auto it = phaseMs.begin(); it != phaseMs.end(); ++it) {
+        std::sort(it.value().begin(), it.value().end());
+        std::printf("  %-22s %8.3f ms\n", qPrintable(it.key()), percentile(it.value(), 0.5));
+    }
+    return 0;
+}
@@ -0,0 +1,145 @@
+// 滑行输入基准
+// 在 QWERTY 按键几何上为合成词典 (默认 10 万词) 构建模板，然后为按 Zipf 分布抽取的单词生成合成路径:
+// 依次经过各字母按键中心 (每个按键处加高斯偏移，模拟手指没有划过中心)，线段之间按鼠标事件的间距插值并加抖动。
+// 报告每条路径 decode() 的耗时中位数、p99、最大值以及前 1/前 5 命中率。
+// 用法: bench_swipe [词典单词数] [路径数] [偏移标准差 (按键宽度)]
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QRandomGenerator>
+#include <QSet>
+#include <QVector>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include "swipedecoder.h"
+#include "latencystats.h"
+
+const double BENCH_KEY_WIDTH = 40.0;  // 按键宽度 (像素)
+const double BENCH_KEY_HEIGHT = 48.0;
+const double BENCH_KEY_SPACING = 4.0;
+
+// 已排序样本的百分位数 (最近秩)
+static double percentile(const QVector<double>& sorted, double p) {
+    if (sorted.isEmpty()) return 0.0;
+    int index = int(p * sorted.size() + 0.999999) - 1;
+    return sorted[qBound(0, index, int(sorted.size()) - 1)];
+}
+
+// 由常见音节拼成的伪单词 (2-6 个音节，与 bench_prediction 相同)
+static QString makeWord(QRandomGenerator& random) {
+    static const char* const syllables[] = {
+        "a", "e", "i", "o", "u", "ba", "be", "ca", "co", "de", "di", "en", "er", "es", "fa", "ga", "ha", "he",
+        "in", "is", "la", "le", "li", "ma", "me", "mo", "na", "ne", "no", "on", "or", "pa", "pe", "ra", "re",
+        "ri", "ro", "sa", "se", "si", "st", "ta", "te", "th", "ti", "to", "tr", "un", "ve", "wa", "ing", "tion",
+    };
+    const int syllableCount = int(sizeof(syllables) / sizeof(syllables[0]));
+    QString word;
+    const int parts = 2 + int(random.bounded(5));
+    for (int i = 0; i < parts; ++i) word += QLatin1String(syllables[random.bounded(syllableCount)]);
+    return word;
+}
+
+// 标准正态分布 (Box-Muller)
+static double gaussian(QRandomGenerator& random) {
+    const double u = qMax(1e-12, random.generateDouble());
+    const double v = random.generateDouble();
+    return std::sqrt(-2.0 * std::log(u)) * std::cos(6.283185307179586 * v);
+}
+
+// QWERTY 三行字母键的中心 (第二、三行依次右移半个和一个按键)
+static QVector<SwipeDecoder::Key> qwertyKeys() {
+    static const char* const rows[] = {"qwertyuiop", "asdfghjkl", "zxcvbnm"};
+    QVector<SwipeDecoder::Key> keys;
+    for (int row = 0; row < 3; ++row) {
+        const double offset = row * 0.5 * (BENCH_KEY_WIDTH + BENCH_KEY_SPACING);
+        for (int column = 0; rows[row][column]; ++column) {
+            const double x = offset + column * (BENCH_KEY_WIDTH + BENCH_KEY_SPACING) + BENCH_KEY_WIDTH / 2;
+            const double y = row * (BENCH_KEY_HEIGHT + BENCH_KEY_SPACING) + BENCH_KEY_HEIGHT / 2;
+            keys.append({QLatin1Char(rows[row][column]), QPointF(x, y)});
+        }
+    }
+    return keys;
+}
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    const QStringList arguments = QCoreApplication::arguments();
+    const int wordCount = arguments.size() > 1 ? qMax(100, arguments[1].toInt()) : 100000;
+    const int pathCount = arguments.size() > 2 ? qMax(1, arguments[2].toInt()) : 5000;
+    const double sigma = arguments.size() > 3 ? arguments[3].toDouble() : 0.25;
+
+    // --- 生成词典 (按频率排名，得分与 WordTrie 相同: log2(频率) * 1024) ---
+    QRandomGenerator random(42);
+    QVector<SwipeDecoder::Word> words;
+    words.reserve(wordCount);
+    QSet<QString> seen;
+    while (words.size() < wordCount) {
+        const QString word = makeWord(random);
+        if (seen.contains(word)) continue;
+        seen.insert(word);
+        words.append({word, int(std::log2(1e9 / (words.size() + 1)) * 1024.0)});
+    }
+
+    // --- 构建模板 ---
+    const QVector<SwipeDecoder::Key> keys = qwertyKeys();
+    QHash<QChar, QPointF> centers;
+    for (const SwipeDecoder::Key& key : keys) centers.insert(key.ch, key.center);
+    SwipeDecoder decoder;
+    QElapsedTimer timer;
+    timer.start();
+    decoder.setKeys(keys, BENCH_KEY_WIDTH);
+    decoder.setWords(words);
+    decoder.build();
+    const double buildMs = timer.nsecsElapsed() / 1e6;
+    std::printf("词典: %d 个单词, %d 个模板 (%d 点), %.1f MB\n", int(words.size()), decoder.templateCount(),
+                SwipeDecoder::SAMPLE_POINTS, decoder.templateCount() * SwipeDecoder::SAMPLE_POINTS * 8.0 / (1024.0 * 1024.0));
+    std::printf("构建: %8.1f ms\n", buildMs);
+
+    // --- 合成路径并解码 ---
+    QVector<double> decodeUs;
+    QVector<SwipeDecoder::Candidate> candidates;
+    const double harmonic = std::log(double(words.size())) + 0.5772;
+    int top1 = 0;
+    int top5 = 0;
+    for (int p = 0; p < pathCount; ++p) {
+        const int rank = qBound(0, int(std::exp(random.generateDouble() * harmonic)) - 1, int(words.size()) - 1);
+        const QString& word = words[rank].text;
+
+        QVector<QPointF> path;
+        QPointF previous;
+        for (int i = 0; i < word.size(); ++i) {
+            const QPointF target = centers.value(word[i])
+                                   + QPointF(gaussian(random), gaussian(random)) * (sigma * BENCH_KEY_WIDTH);
+            if (i > 0) {
+                // 约每 8 像素一个鼠标事件
+                const QPointF delta = target - previous;
+                const int steps = qMax(1, int(std::hypot(delta.x(), delta.y()) / 8.0));
+                for (int s = 1; s < steps; ++s) {
+                    path.append(previous + delta * (double(s) / steps) + QPointF(gaussian(random), gaussian(random)) * 1.5);
+                }
+            }
+            path.append(target);
+            previous = target;
+        }
+
+        const qint64 startNs = LatencyStats::now();
+        decoder.decode(path, 5, candidates);
+        decodeUs.append((LatencyStats::now() - startNs) / 1000.0);
+        for (int i = 0; i < candidates.size(); ++i) {
+            if (candidates[i].word != word) continue;
+            if (i == 0) ++top1;
+            ++top5;
+            break;
+        }
+    }
+
+    std::sort(decodeUs.begin(), decodeUs.end());
+    std::printf("路径数: %d (偏移标准差 %.2f 按键)   前 1 命中 %.1f%%   前 5 命中 %.1f%%\n", pathCount, sigma,
+                100.0 * top1 / pathCount, 100.0 * top5 / pathCount);
+    std::printf("每条路径: 中位数 %8.2f us   p99 %8.2f us   最大 %8.2f us\n",
+                percentile(decodeUs, 0.5), percentile(decodeUs, 0.99), decodeUs.last());
+    return 0;
+}
@@ -0,0 +1,221 @@
+// 概率触摸定位基准
+// 用词典训练字符语言模型，然后:
+// - 合成模式: 在 QWERTY 按键几何上按词频抽取单词逐字母"按下"，按下点为按键中心加高斯偏移
+//   (标准差以按键宽/高为单位)，单词之间按空格键。报告严格命中、只按几何和语言模型加权三种方式的字母准确率
+//   以及每次 decode() 的耗时；可以同时把合成的按下写为轨迹文件 (带目标列)。
+// - 回放模式: 读取 --touch-trace 记录 (或本程序写出) 的轨迹文件，用当前参数重新解码，
+//   报告与记录时选择的差异，带目标列的按下还报告准确率。
+// 用法: bench_touch <词典|-> [按下次数|轨迹文件] [偏移标准差] [写出的轨迹文件]
+
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QRandomGenerator>
+#include <QVector>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+
+#include "keyhitgrid.h"
+#include "latencystats.h"
+#include "touchdecoder.h"
+#include "touchtrace.h"
+#include "wordtrie.h"
+
+const double BENCH_KEY_WIDTH = 40.0;  // 按键宽度 (像素)
+const double BENCH_KEY_HEIGHT = 48.0;
+const double BENCH_KEY_SPACING = 4.0;
+
+// 已排序样本的百分位数 (最近秩)
+static double percentile(const QVector<double>& sorted, double p) {
+    if (sorted.isEmpty()) return 0.0;
+    int index = int(p * sorted.size() + 0.999999) - 1;
+    return sorted[qBound(0, index, int(sorted.size()) - 1)];
+}
+
+// 标准正态分布 (Box-Muller)
+static double gaussian(QRandomGenerator& random) {
+    const double u = qMax(1e-12, random.generateDouble());
+    const double v = random.generateDouble();
+    return std::sqrt(-2.0 * std::log(u)) * std::cos(6.283185307179586 * v);
+}
+
+// QWERTY 三行字母键 (第二、三行依次右移半个和一个按键) 和下方的空格键
+static QVector<TouchDecoder::Key> qwertyKeys() {
+    static const char* const rows[] = {"qwertyuiop", "asdfghjkl", "zxcvbnm"};
+    const double pitchX = BENCH_KEY_WIDTH + BENCH_KEY_SPACING;
+    const double pitchY = BENCH_KEY_HEIGHT + BENCH_KEY_SPACING;
+    QVector<TouchDecoder::Key> keys;
+    for (int row = 0; row < 3; ++row) {
+        const double offset = row * 0.5 * pitchX;
+        for (int column = 0; rows[row][column]; ++column) {
+            keys.append({QRectF(offset + column * pitchX, row * pitchY, BENCH_KEY_WIDTH, BENCH_KEY_HEIGHT), QLatin1Char(rows[row][column])});
+        }
+    }
+    keys.append({QRectF(2 * pitchX, 3 * pitchY, 6 * pitchX - BENCH_KEY_SPACING, BENCH_KEY_HEIGHT), QChar()}); // 空格
+    return keys;
+}
+
+// 用词典 (文本或 .vkdt) 的全部单词训练语言模型，返回单词列表
+static QVector<TouchLanguageModel::Word> loadWords(const QString& path) {
+    QVector<TouchLanguageModel::Word> words;
+    QString error;
+    std::unique_ptr<WordTrie> trie = WordTrie::open(path, &error);
+    if (!trie) {
+        std::fprintf(stderr, "无法打开词典 %s: %s\n", qPrintable(path), qPrintable(error));
+        return words;
+    }
+    QVector<WordTrie::Completion> completions;
+    trie->complete(WordTrie::ROOT, QStringView(), int(trie->wordCount()), completions);
+    for (const WordTrie::Completion& completion : std::as_const(completions)) words.append({completion.word, completion.score});
+    return words;
+}
+
+// 解码耗时统计
+static void printTiming(QVector<double>& decodeNs) {
+    if (decodeNs.isEmpty()) return;
+    std::sort(decodeNs.begin(), decodeNs.end());
+    std::printf("每次 decode: 中位数 %8.0f ns   p99 %8.0f ns   最大 %8.0f ns\n",
+                percentile(decodeNs, 0.5), percentile(decodeNs, 0.99), decodeNs.last());
+}
+
+// --- 回放轨迹文件 ---
+static int replay(const QString& tracePath, const TouchLanguageModel& model) {
+    QVector<TouchTrace::Surface> surfaces;
+    QVector<TouchTrace::Touch> touches;
+    QString error;
+    if (!TouchTrace::read(tracePath, surfaces, touches, &error)) {
+        std::fprintf(stderr, "无法读取轨迹: %s\n", qPrintable(error));
+        return 1;
+    }
+    QVector<TouchDecoder> decoders(surfaces.size());
+    for (int s = 0; s < surfaces.size(); ++s) {
+        decoders[s].setKeys(surfaces[s].keys);
+        decoders[s].setModel(&model);
+    }
+
+    QVector<double> decodeNs;
+    decodeNs.reserve(touches.size());
+    int changed = 0, targeted = 0, strictCorrect = 0, decodedCorrect = 0;
+    for (const TouchTrace::Touch& touch : std::as_const(touches)) {
+        const float* logProbs = touch.contextFirst >= 0 ? model.logProbsFor(touch.contextFirst, touch.contextSecond) : nullptr;
+        const qint64 startNs = LatencyStats::now();
+        const int decoded = decoders[touch.surface].decode(touch.pos, touch.strictIndex, logProbs);
+        decodeNs.append(double(LatencyStats::now() - startNs));
+        if (decoded != touch.decodedIndex) ++changed;
+        if (touch.targetIndex < 0) continue;
+        ++targeted;
+        if (touch.strictIndex == touch.targetIndex) ++strictCorrect;
+        if (decoded == touch.targetIndex) ++decodedCorrect;
+    }
+
+    std::printf("轨迹: %d 个表面几何, %d 次按下, 与记录时选择不同 %d 次\n", int(surfaces.size()), int(touches.size()), changed);
+    if (targeted > 0) {
+        std::printf("带目标的按下 %d 次: 严格命中 %.2f%%   概率定位 %.2f%%\n", targeted,
+                    100.0 * strictCorrect / targeted, 100.0 * decodedCorrect / targeted);
+    }
+    printTiming(decodeNs);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    const QStringList arguments = QCoreApplication::arguments();
+    if (arguments.size() < 2) {
+        std::fprintf(stderr, "用法: bench_touch <词典|-> [按下次数|轨迹文件] [偏移标准差] [写出的轨迹文件]\n");
+        return 2;
+    }
+
+    // --- 训练语言模型 ---
+    QVector<TouchLanguageModel::Word> words;
+    if (arguments[1] != QLatin1String("-")) words = loadWords(arguments[1]);
+    TouchLanguageModel model;
+    const qint64 trainStartNs = LatencyStats::now();
+    model.train(words);
+    std::printf("语言模型: %d 个单词, 训练 %.1f ms%s\n", int(words.size()), (LatencyStats::now() - trainStartNs) / 1e6,
+                model.isTrained() ? "" : " (未训练，只按几何定位)");
+
+    if (arguments.size() > 2 && QFileInfo::exists(arguments[2])) return replay(arguments[2], model);
+    if (words.isEmpty()) {
+        std::fprintf(stderr, "合成模式需要词典\n");
+        return 1;
+    }
+    const int touchCount = arguments.size() > 2 ? qMax(1, arguments[2].toInt()) : 200000;
+    const double sigma = arguments.size() > 3 ? arguments[3].toDouble() : 0.3;
+
+    // --- 按键几何 ---
+    const QVector<TouchDecoder::Key> keys = qwertyKeys();
+    QVector<QRectF> rects;
+    QVector<int> keyForSymbol(TouchLanguageModel::SYMBOLS, -1);
+    for (int i = 0; i < keys.size(); ++i) {
+        rects.append(keys[i].rect);
+        keyForSymbol[keys[i].ch.isNull() ? TouchLanguageModel::BOUNDARY : TouchLanguageModel::symbolFor(keys[i].ch)] = i;
+    }
+    KeyHitGrid grid;
+    grid.build(rects);
+    TouchDecoder decoder;
+    decoder.setKeys(keys);
+
+    TouchTrace trace;
+    if (arguments.size() > 4) {
+        QString error;
+        if (!trace.open(arguments[4], &error)) {
+            std::fprintf(stderr, "无法创建轨迹文件: %s\n", qPrintable(error));
+            return 1;
+        }
+        trace.writeKeys(QStringLiteral("bench"), keys);
+    }
+
+    // --- 按词频抽取单词 (累积分布) ---
+    QVector<double> cumulative;
+    cumulative.reserve(words.size());
+    double total = 0;
+    for (const TouchLanguageModel::Word& word : std::as_const(words)) {
+        total += std::exp2(word.score / 1024.0);
+        cumulative.append(total);
+    }
+
+    // --- 逐字母按下: 上下文跟随想要输入的文本 (假设用户纠正了错误) ---
+    QRandomGenerator random(42);
+    TouchLanguageModel context = model;
+    context.appendChar(QLatin1Char(' '));
+    QVector<double> decodeNs;
+    decodeNs.reserve(touchCount);
+    int letters = 0, strictCorrect = 0, geometryCorrect = 0, modelCorrect = 0;
+    while (letters < touchCount) {
+        const double pick = random.generateDouble() * total;
+        const int wordIndex = int(std::upper_bound(cumulative.cbegin(), cumulative.cend(), pick) - cumulative.cbegin());
+        const QString& word = words[qMin(wordIndex, int(words.size()) - 1)].text;
+        for (int i = 0; i <= word.size() && letters < touchCount; ++i) {
+            const QChar ch = i < word.size() ? word[i] : QLatin1Char(' ');
+            const int symbol = TouchLanguageModel::symbolFor(ch);
+            const int target = keyForSymbol[symbol];
+            if (target < 0) break; // 按键中没有的字符
+            const QRectF& rect = keys[target].rect;
+            const QPointF pos = rect.center() + QPointF(gaussian(random) * sigma * rect.width(), gaussian(random) * sigma * rect.height());
+            const int strict = grid.indexAt(pos);
+
+            int first = -1, second = -1;
+            context.context(first, second);
+            const float* logProbs = context.nextLogProbs();
+            const qint64 startNs = LatencyStats::now();
+            const int decoded = decoder.decode(pos, strict, logProbs);
+            const qint64 elapsedNs = LatencyStats::now() - startNs;
+            if (trace.isOpen()) trace.writeTouch(QStringLiteral("bench"), pos, first, second, strict, decoded, target);
+            context.appendChar(ch);
+            if (symbol == TouchLanguageModel::BOUNDARY) continue; // 只统计字母
+
+            decodeNs.append(double(elapsedNs));
+            ++letters;
+            if (strict == target) ++strictCorrect;
+            if (decoder.decode(pos, strict, nullptr) == target) ++geometryCorrect;
+            if (decoded == target) ++modelCorrect;
+        }
+    }
+
+    std::printf("字母按下: %d 次 (偏移标准差 %.2f 按键)\n", letters, sigma);
+    std::printf("准确率: 严格命中 %.2f%%   只按几何 %.2f%%   语言模型加权 %.2f%%\n",
+                100.0 * strictCorrect / letters, 100.0 * geometryCorrect / letters, 100.0 * modelCorrect / letters);
+    printTiming(decodeNs);
+    return 0;
+}
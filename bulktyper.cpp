@@ -0,0 +1,84 @@
+#include "bulktyper.h"
+#include "keyinjector.h"
+#include "latencystats.h"
+
+#include <utility>
+
+// --- 常量定义 ---
+const int BULK_MAX_IN_FLIGHT = 768;  // 间隔为 0 时注入队列中最多的未注入事件数 (队列容量为 1024)
+const int BULK_POLL_INTERVAL_MS = 1; // 间隔为 0 (或等待最后一批注入) 时检查注入进度的周期
+
+// --- 构造函数 ---
+BulkTyper::BulkTyper(KeyInjector& injector, QObject *parent)
+        : QObject(parent), keyInjector(injector)
+{
+    tickTimer.setTimerType(Qt::PreciseTimer);
+    connect(&tickTimer, &QTimer::timeout, this, &BulkTyper::onTick);
+}
+
+// --- start: 开始按批发送 (第一批立即发送) ---
+bool BulkTyper::start(QVector<KeyEvent> events, QVector<Batch> batches, const BulkTypingOptions& options) {
+    if (running) return false;
+    pendingEvents = std::move(events);
+    pendingBatches = std::move(batches);
+    nextBatch = 0;
+    burst = options.intervalMs <= 0;
+    running = true;
+    draining = false;
+    cancelRequested = false;
+    droppedAtStart = keyInjector.droppedEvents();
+    startNs = LatencyStats::now();
+    tickTimer.start(burst ? BULK_POLL_INTERVAL_MS : options.intervalMs);
+    onTick();
+    return true;
+}
+
+// --- cancel: 不再发送剩余批次，等已发送的事件注入完成后结束 ---
+void BulkTyper::cancel() {
+    if (!running || draining) return;
+    cancelRequested = true;
+    draining = true;
+    finalPosted = keyInjector.postedEvents();
+    tickTimer.setInterval(BULK_POLL_INTERVAL_MS);
+}
+
+// --- onTick: 发送下一批 (间隔为 0 时发送到队列容量上限)，全部发送后等待注入完成 ---
+void BulkTyper::onTick() {
+    if (!running) return;
+    if (!draining) {
+        do {
+            if (nextBatch >= pendingBatches.size()) break;
+            const int begin = nextBatch > 0 ? pendingBatches[nextBatch - 1].endEvent : 0;
+            const int count = pendingBatches[nextBatch].endEvent - begin;
+            // 注入线程还没跟上时等待下一个周期，不让 UI 线程阻塞在满队列上
+            const quint64 inFlight = keyInjector.postedEvents() - keyInjector.injectedEvents();
+            if (inFlight > 0 && inFlight + quint64(count) > quint64(BULK_MAX_IN_FLIGHT)) break;
+            keyInjector.postBatch(pendingEvents.constData() + begin, count);
+            ++nextBatch;
+        } while (burst);
+
+        if (nextBatch >= pendingBatches.size()) {
+            draining = true;
+            finalPosted = keyInjector.postedEvents();
+            tickTimer.setInterval(BULK_POLL_INTERVAL_MS);
+        }
+    }
+    if (draining && keyInjector.injectedEvents() >= finalPosted) finish(cancelRequested);
+}
+
+// --- finish: 汇总并发出结果 ---
+void BulkTyper::finish(bool cancelled) {
+    tickTimer.stop();
+    running = false;
+    BulkTypingReport report;
+    if (nextBatch > 0) {
+        report.characters = pendingBatches[nextBatch - 1].characters;
+        report.events = quint64(pendingBatches[nextBatch - 1].endEvent);
+    }
+    report.droppedEvents = keyInjector.droppedEvents() - droppedAtStart;
+    report.elapsedNs = LatencyStats::now() - startNs;
+    report.cancelled = cancelled;
+    pendingEvents.clear();
+    pendingBatches.clear();
+    emit finished(report);
+}
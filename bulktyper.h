@@ -0,0 +1,76 @@
+#ifndef VIRTUALKEYBOARD_BULKTYPER_H
+#define VIRTUALKEYBOARD_BULKTYPER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QVector>
+
+#include "keyevent.h"
+
+class KeyInjector;
+
+// 批量输入的节奏
+struct BulkTypingOptions {
+    int batchEvents = 256; // 每批最多的事件数 (一批由后端一次提交)
+    int intervalMs = 0;    // 两批之间的间隔 (毫秒)；0 表示只受注入队列的容量限制，尽快发送
+};
+
+// 一次批量输入的结果
+struct BulkTypingReport {
+    int characters = 0;         // 已发送的字符数 (取消时少于文本长度)
+    quint64 events = 0;         // 已发送的事件数
+    quint64 droppedEvents = 0;  // 后端报告未被系统接受的事件数 (例如 UIPI 拒绝)
+    qint64 elapsedNs = 0;       // 从开始到最后一批注入完成的时间
+    bool cancelled = false;
+
+    double charactersPerSecond() const { return elapsedNs > 0 ? characters * 1e9 / double(elapsedNs) : 0.0; }
+};
+
+// 批量输入: 把预先编码好的事件按批次交给注入线程
+// 每批以 Shift 回到初始状态结束，可以在任意两批之间取消而不会留下按住的键。
+// 间隔为 0 时每个定时周期把注入队列补满到 BULK_MAX_IN_FLIGHT 个事件，不会让 UI 线程阻塞在满队列上；
+// 否则每个周期发送一批。最后一批注入完成后发出 finished。
+class BulkTyper : public QObject {
+Q_OBJECT
+
+public:
+    static constexpr int MAX_BATCH_EVENTS = 512; // 一批最多的事件数 (不超过队列中允许的未注入事件数)
+
+    // 一批事件的结束位置和到此为止的字符数
+    struct Batch {
+        int endEvent = 0;
+        int characters = 0;
+    };
+
+    explicit BulkTyper(KeyInjector& injector, QObject *parent = nullptr);
+
+    // 开始发送 events (batches 为各批的结束位置，按顺序)；已在运行时返回 false
+    bool start(QVector<KeyEvent> events, QVector<Batch> batches, const BulkTypingOptions& options);
+    // 停止发送剩余的批次 (已发送的批次照常注入)，随后发出 finished
+    void cancel();
+    bool isRunning() const { return running; }
+
+signals:
+    void finished(const BulkTypingReport& report);
+
+private slots:
+    void onTick();
+
+private:
+    void finish(bool cancelled);
+
+    KeyInjector& keyInjector;
+    QTimer tickTimer;
+    QVector<KeyEvent> pendingEvents;
+    QVector<Batch> pendingBatches;
+    int nextBatch = 0;            // 下一批的下标
+    bool burst = false;           // 间隔为 0: 按队列容量发送
+    bool running = false;
+    bool draining = false;        // 已不再发送，等待已发送的事件注入完成
+    bool cancelRequested = false;
+    quint64 finalPosted = 0;      // 最后一批入队后的 postedEvents
+    quint64 droppedAtStart = 0;
+    qint64 startNs = 0;
+};
+
+#endif // VIRTUALKEYBOARD_BULKTYPER_H
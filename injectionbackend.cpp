@@ -0,0 +1,68 @@
+#include "injectionbackend.h"
+#include "recordingbackend.h"
+#include "keyboardlayout.h" // VK_* 常量
+
+#include <QDebug>
+
+#ifdef _WIN32
+#include "sendinputbackend.h"
+#endif
+#ifdef VK_HAVE_XTEST
+#include "xtestbackend.h"
+#endif
+
+// --- 常量定义 ---
+// 美式布局中数字键按住 Shift 时的字符 ('0' ~ '9')
+const char US_SHIFTED_DIGITS[] = ")!@#$%^&*(";
+// 美式布局中 OEM 键的字符
+struct UsOemKey {
+    int vkCode;
+    char normal;
+    char shifted;
+};
+const UsOemKey US_OEM_KEYS[] = {
+    { VK_OEM_3, '`', '~' }, { VK_OEM_MINUS, '-', '_' }, { VK_OEM_PLUS, '=', '+' },
+    { VK_OEM_4, '[', '{' }, { VK_OEM_6, ']', '}' }, { VK_OEM_5, '\\', '|' },
+    { VK_OEM_1, ';', ':' }, { VK_OEM_7, '\'', '"' }, { VK_OEM_COMMA, ',', '<' },
+    { VK_OEM_PERIOD, '.', '>' }, { VK_OEM_2, '/', '?' }, { VK_SPACE, ' ', ' ' }
+};
+
+// --- keyText: 默认按美式布局 ---
+QString InjectionBackend::keyText(quintptr layout, int vkCode, bool shifted) const {
+    Q_UNUSED(layout);
+    if (vkCode >= 'A' && vkCode <= 'Z') return QString(QLatin1Char(char(shifted ? vkCode : vkCode - 'A' + 'a')));
+    if (vkCode >= '0' && vkCode <= '9') return QString(QLatin1Char(shifted ? US_SHIFTED_DIGITS[vkCode - '0'] : char(vkCode)));
+    for (const UsOemKey& key : US_OEM_KEYS) {
+        if (key.vkCode == vkCode) return QString(QLatin1Char(shifted ? key.shifted : key.normal));
+    }
+    return QString();
+}
+
+// --- createInjectionBackend: 按名称创建后端 ---
+std::unique_ptr<InjectionBackend> createInjectionBackend(const QString& name) {
+    const QString requested = name.trimmed().toLower();
+
+#ifdef _WIN32
+    if (requested.isEmpty() || requested == QLatin1String("sendinput")) {
+        return std::unique_ptr<InjectionBackend>(new SendInputBackend);
+    }
+#endif
+#ifdef VK_HAVE_XTEST
+    if (requested.isEmpty() || requested == QLatin1String("xtest")) {
+        std::unique_ptr<XTestBackend> backend(new XTestBackend);
+        if (backend->isValid()) return backend;
+        qWarning() << "XTest 后端不可用，回退到内存记录后端";
+        return std::unique_ptr<InjectionBackend>(new RecordingBackend);
+    }
+#endif
+    if (requested == QLatin1String("recording")) {
+        return std::unique_ptr<InjectionBackend>(new RecordingBackend);
+    }
+
+    if (requested.isEmpty()) {
+        qWarning("当前平台没有可用的按键注入后端，按键事件只会被记录，不会发送到系统。");
+    } else {
+        qWarning() << "未知或当前平台不支持的注入后端:" << requested << "，回退到内存记录后端";
+    }
+    return std::unique_ptr<InjectionBackend>(new RecordingBackend);
+}
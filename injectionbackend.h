@@ -0,0 +1,37 @@
+#ifndef VIRTUALKEYBOARD_INJECTIONBACKEND_H
+#define VIRTUALKEYBOARD_INJECTIONBACKEND_H
+
+#include <QString>
+#include <memory>
+
+#include "keyevent.h"
+
+// 按键注入后端接口
+// KeyInjector 的工作线程把一批事件 (例如修饰键组合加按键) 交给后端一次提交。
+// 后端只会在注入线程中被调用。
+class InjectionBackend {
+public:
+    virtual ~InjectionBackend() = default;
+
+    // 后端名称 (用于日志)
+    virtual const char* name() const = 0;
+    // 一次提交一批事件，返回被系统接受的事件数
+    virtual int send(const KeyEvent* events, int count) = 0;
+
+    // --- 主机键盘布局 ---
+    // 按 VK 码注入的按键由主机 (目标窗口) 的键盘布局翻译为字符。键盘据此判断按键上的文本能否按 VK 码输入，
+    // 不能时改用 Unicode 事件 (见 VirtualKeyboardWidget::syncHostKeyText)。
+    // 查询主机布局的标识 (映射固定的后端返回 0)。可能调用系统接口，只由注入线程调用，
+    // 结果缓存在 KeyInjector::hostLayout 中供 UI 线程读取
+    virtual quintptr hostLayout() const { return 0; }
+    // vkCode 在主机布局 layout (hostLayout 的返回值) 上产生的文本 (shifted 表示按住 Shift，不含 CapsLock)，
+    // 不产生字符或无法得知时为空。可在任意线程调用。
+    // 默认按美式布局: XTest 后端按美式布局把 VK 码转换为 keysym，内存记录后端也按美式布局解释
+    virtual QString keyText(quintptr layout, int vkCode, bool shifted) const;
+};
+
+// 按名称创建后端: "sendinput" (Windows)、"xtest" (X11)、"recording" (内存记录)
+// 名称为空时选择当前平台的默认后端；不可用时回退到内存记录后端
+std::unique_ptr<InjectionBackend> createInjectionBackend(const QString& name);
+
+#endif // VIRTUALKEYBOARD_INJECTIONBACKEND_H
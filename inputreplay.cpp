@@ -0,0 +1,179 @@
+#include "inputreplay.h"
+#include "virtualkeyboardwidget.h"
+#include "recordingbackend.h"
+#include "latencystats.h"
+#include "allocstats.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QTextStream>
+#include <algorithm>
+#include <cstdio>
+
+// --- 常量定义 ---
+const int REPLAY_DRAIN_POLL_MS = 1;     // 等待注入队列排空的检查周期
+const int REPLAY_DIFF_CONTEXT = 3;      // 报告第一处差异时前后显示的行数
+
+// 已排序样本的百分位数 (最近秩)
+static double percentile(const QVector<double>& sorted, double p) {
+    if (sorted.isEmpty()) return 0.0;
+    int index = int(p * sorted.size() + 0.999999) - 1;
+    return sorted[qBound(0, index, int(sorted.size()) - 1)];
+}
+
+// --- 构造函数 ---
+InputReplayer::InputReplayer(VirtualKeyboardWidget& keyboardWidget, const InputReplayOptions& replayOptions, QObject *parent)
+        : QObject(parent), keyboard(keyboardWidget), options(replayOptions)
+{
+    timer.setSingleShot(true);
+    timer.setTimerType(Qt::PreciseTimer);
+    connect(&timer, &QTimer::timeout, this, &InputReplayer::onTimer);
+}
+
+// --- load: 读取轨迹，布局 (按键表) 必须与记录时一致 ---
+bool InputReplayer::load(QString* errorMessage) {
+    if (!InputTrace::read(options.tracePath, header, records, errorMessage)) return false;
+    const KeyTable& table = keyboard.layoutKeys();
+    if (header.keyCount != table.size() || header.layoutHash != InputTrace::layoutHash(table)) {
+        if (errorMessage) *errorMessage = QStringLiteral("轨迹记录时的布局与当前布局不同 (需要相同的 --layout)");
+        return false;
+    }
+    if (!dynamic_cast<RecordingBackend*>(keyboard.injectionBackend())) {
+        if (errorMessage) *errorMessage = QStringLiteral("回放需要内存记录后端 (--inject=recording)");
+        return false;
+    }
+    handlerNs.reserve(records.size());
+    return true;
+}
+
+// --- start: 开始回放 ---
+void InputReplayer::start() {
+    std::printf("回放 %s: %d 条记录 (%s)\n", qPrintable(options.tracePath), int(records.size()),
+                options.realtime ? "实时" : "尽快");
+    std::fflush(stdout);
+    nextRecord = 0;
+    startNs = LatencyStats::now();
+    timer.start(0);
+}
+
+// --- replayRecord: 回放一条记录，只计处理函数本身的耗时 ---
+void InputReplayer::replayRecord(int index) {
+    const qint64 beforeNs = LatencyStats::now();
+    const bool stateMatched = keyboard.replayInput(records[index]);
+    handlerNs.append(double(LatencyStats::now() - beforeNs));
+    if (!stateMatched) ++stateMismatches;
+}
+
+// --- onTimer: 回放到期的记录 ---
+// 尽快回放: 每次回放一条后立即重新调度 (中间处理一轮事件循环)；
+// 实时回放: 回放所有到期的记录，再按下一条记录的时间启动定时器
+void InputReplayer::onTimer() {
+    if (!options.realtime) {
+        if (nextRecord < records.size()) {
+            replayRecord(nextRecord++);
+            timer.start(0);
+            return;
+        }
+    } else {
+        const qint64 baseNs = records.isEmpty() ? 0 : records.first().timeNs;
+        const qint64 nowNs = LatencyStats::now();
+        while (nextRecord < records.size() && startNs + (records[nextRecord].timeNs - baseNs) <= nowNs) {
+            replayRecord(nextRecord++);
+        }
+        if (nextRecord < records.size()) {
+            const qint64 remainingNs = startNs + (records[nextRecord].timeNs - baseNs) - LatencyStats::now();
+            timer.start(remainingNs <= 0 ? 0 : int((remainingNs + 999999) / 1000000));
+            return;
+        }
+    }
+    replayEndNs = LatencyStats::now();
+    waitForInjection();
+}
+
+// --- waitForInjection: 注入队列排空后报告 ---
+void InputReplayer::waitForInjection() {
+    if (!keyboard.isInjectionIdle()) {
+        QTimer::singleShot(REPLAY_DRAIN_POLL_MS, this, &InputReplayer::waitForInjection);
+        return;
+    }
+    emit finished(report());
+}
+
+// --- formatEvent: golden 文件中的一行 ---
+QString InputReplayer::formatEvent(const KeyEvent& event) {
+    QString line = event.isDown() ? QStringLiteral("D") : QStringLiteral("U");
+    if (event.isExtended()) line += QLatin1Char('E');
+    if (event.isUnicode()) line += QLatin1Char('U');
+    return line + QStringLiteral(" %1 %2").arg(event.vkCode, 2, 16, QLatin1Char('0')).arg(event.scanCode, 4, 16, QLatin1Char('0'));
+}
+
+// --- report: 输出吞吐、处理耗时和 golden 比较结果 ---
+int InputReplayer::report() {
+    const qint64 elapsedNs = replayEndNs - startNs;
+    std::printf("处理 %d 条记录用时 %.1f ms: %.0f 事件/秒, 修饰键状态不一致 %d 次\n", int(records.size()), elapsedNs / 1e6,
+                elapsedNs > 0 ? records.size() * 1e9 / double(elapsedNs) : 0.0, stateMismatches);
+    if (!handlerNs.isEmpty()) {
+        QVector<double> sorted = handlerNs;
+        std::sort(sorted.begin(), sorted.end());
+        double total = 0;
+        for (double ns : std::as_const(sorted)) total += ns;
+        std::printf("每条记录的处理函数耗时: 平均 %.0f ns   中位数 %.0f ns   p99 %.0f ns   最大 %.0f ns\n",
+                    total / sorted.size(), percentile(sorted, 0.5), percentile(sorted, 0.99), sorted.last());
+    }
+
+    if (AllocStats::enabled()) std::printf("%s\n", qPrintable(AllocStats::summary()));
+
+    const auto* recorder = static_cast<RecordingBackend*>(keyboard.injectionBackend());
+    const QVector<KeyEvent> injected = recorder->events();
+    QStringList lines;
+    lines.reserve(injected.size());
+    for (const KeyEvent& event : injected) lines.append(formatEvent(event));
+    std::printf("注入事件: %d 个, %d 批\n", int(injected.size()), int(recorder->batchSizes().size()));
+
+    int exitCode = stateMismatches > 0 ? 1 : 0;
+    if (!options.writeGoldenPath.isEmpty()) {
+        QSaveFile output(options.writeGoldenPath);
+        if (output.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            QTextStream out(&output);
+            out << "# vkreplay 1 " << records.size() << " records\n";
+            for (const QString& line : std::as_const(lines)) out << line << '\n';
+            out.flush();
+        }
+        if (!output.commit()) {
+            std::fprintf(stderr, "无法写出注入事件流 %s: %s\n", qPrintable(options.writeGoldenPath), qPrintable(output.errorString()));
+            exitCode = 1;
+        }
+    }
+    if (options.goldenPath.isEmpty()) return exitCode;
+
+    QFile golden(options.goldenPath);
+    if (!golden.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        std::fprintf(stderr, "无法打开 golden 文件 %s: %s\n", qPrintable(options.goldenPath), qPrintable(golden.errorString()));
+        return 1;
+    }
+    QStringList expected;
+    QTextStream in(&golden);
+    while (!in.atEnd()) {
+        const QString line = in.readLine().trimmed();
+        if (!line.isEmpty() && !line.startsWith(QLatin1Char('#'))) expected.append(line);
+    }
+    int first = 0;
+    while (first < expected.size() && first < lines.size() && expected[first] == lines[first]) ++first;
+    if (first == expected.size() && first == lines.size()) {
+        std::printf("与 golden 一致 (%d 个事件)\n", int(expected.size()));
+        return exitCode;
+    }
+
+    int differing = 0;
+    for (int i = first; i < qMax(expected.size(), lines.size()); ++i) {
+        if (i >= expected.size() || i >= lines.size() || expected[i] != lines[i]) ++differing;
+    }
+    std::printf("与 golden 不同: 期望 %d 个事件, 实际 %d 个, 第一处差异在第 %d 个事件, 逐位置比较共 %d 处不同\n",
+                int(expected.size()), int(lines.size()), first + 1, differing);
+    for (int i = qMax(0, first - REPLAY_DIFF_CONTEXT); i < first; ++i) std::printf("  %s\n", qPrintable(lines[i]));
+    for (int i = first; i < first + REPLAY_DIFF_CONTEXT; ++i) {
+        if (i < expected.size()) std::printf("- %s\n", qPrintable(expected[i]));
+        if (i < lines.size()) std::printf("+ %s\n", qPrintable(lines[i]));
+    }
+    return 1;
+}
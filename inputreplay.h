@@ -0,0 +1,67 @@
+#ifndef VIRTUALKEYBOARD_INPUTREPLAY_H
+#define VIRTUALKEYBOARD_INPUTREPLAY_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+#include <QVector>
+
+#include "inputtrace.h"
+#include "keyevent.h"
+
+class VirtualKeyboardWidget;
+
+// 回放选项 (由命令行决定)
+struct InputReplayOptions {
+    QString tracePath;       // 输入轨迹文件 (--input-trace 记录)
+    bool realtime = false;   // 按记录的时间间隔回放 (否则尽快回放)
+    QString goldenPath;      // 与之比较的注入事件流 (空表示不比较)
+    QString writeGoldenPath; // 把注入事件流写为该文件 (空表示不写)
+};
+
+// 输入轨迹回放驱动
+// 把轨迹中的每条记录交给 VirtualKeyboardWidget::replayInput (同步执行按键处理函数)，
+// 尽快回放时每条记录之间处理一次事件循环 (合并后的建议栏刷新等延后工作照常执行)，
+// 实时回放时按记录的时间间隔用高精度定时器调度 (从开始时间累加，不漂移)。
+// 结束后等注入队列排空，从内存记录后端取出注入的事件流，报告每秒事件数和每次处理函数的耗时，
+// 并与 golden 文件逐行比较。golden 文件为文本，每行一个事件: "D|U[E][U] <VK> <扫描码>" (十六进制)。
+class InputReplayer : public QObject {
+Q_OBJECT
+
+public:
+    InputReplayer(VirtualKeyboardWidget& keyboard, const InputReplayOptions& options, QObject *parent = nullptr);
+
+    // 读取轨迹并检查布局是否一致
+    bool load(QString* errorMessage = nullptr);
+    // 开始回放 (应在首帧之后调用，使延后初始化先完成)
+    void start();
+
+    // 注入事件 -> golden 文件中的一行
+    static QString formatEvent(const KeyEvent& event);
+
+signals:
+    // 回放结束 (exitCode 为 0 表示成功且与 golden 一致)
+    void finished(int exitCode);
+
+private slots:
+    void onTimer();
+
+private:
+    void replayRecord(int index); // 回放一条记录并计时
+    void waitForInjection();      // 等注入队列排空后报告
+    int report();                 // 输出报告并比较 golden，返回退出码
+
+    VirtualKeyboardWidget& keyboard;
+    InputReplayOptions options;
+    InputTrace::Header header;
+    QVector<InputTrace::Record> records;
+    QVector<double> handlerNs;    // 每条记录的处理函数耗时
+    QTimer timer;
+    int nextRecord = 0;
+    int stateMismatches = 0;      // 处理前修饰键状态与记录不一致的次数
+    qint64 startNs = 0;
+    qint64 replayEndNs = 0;       // 最后一条记录处理完的时间
+};
+
+#endif // VIRTUALKEYBOARD_INPUTREPLAY_H
@@ -0,0 +1,111 @@
+#include "inputtrace.h"
+#include "latencystats.h"
+
+#include <QDateTime>
+#include <cstring>
+
+// --- 常量定义 ---
+const int INPUT_TRACE_FLUSH_RECORDS = 256; // 缓冲这么多条记录后写出一次
+
+// --- 析构函数: 写出剩余的记录 ---
+InputTrace::~InputTrace() {
+    flush();
+}
+
+// --- layoutHash: 按键表指纹 (FNV-1a) ---
+quint32 InputTrace::layoutHash(const KeyTable& table) {
+    quint32 hash = 2166136261u;
+    const auto mix = [&hash](quint32 value) {
+        for (int i = 0; i < 4; ++i) {
+            hash ^= (value >> (i * 8)) & 0xFF;
+            hash *= 16777619u;
+        }
+    };
+    for (int keyId = 0; keyId < table.size(); ++keyId) {
+        const KeyEntry& key = table.entry(keyId);
+        mix(quint32(key.vkCode) | quint32(key.scanCode) << 16);
+        mix(quint32(key.type));
+    }
+    return hash;
+}
+
+// --- open: 创建轨迹文件并写出文件头 ---
+bool InputTrace::open(const QString& path, const KeyTable& table, QString* errorMessage) {
+    file.setFileName(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        if (errorMessage) *errorMessage = file.errorString();
+        return false;
+    }
+    Header header;
+    header.keyCount = quint16(table.size());
+    header.layoutHash = layoutHash(table);
+    header.startMs = QDateTime::currentMSecsSinceEpoch();
+    if (file.write(reinterpret_cast<const char*>(&header), sizeof(header)) != qint64(sizeof(header))) {
+        if (errorMessage) *errorMessage = file.errorString();
+        file.close();
+        return false;
+    }
+    pending.reserve(INPUT_TRACE_FLUSH_RECORDS);
+    startNs = LatencyStats::now();
+    return true;
+}
+
+// --- record: 追加一条记录 (满一块时写出) ---
+void InputTrace::record(Kind kind, int keyId, const KeyEntry& key, quint8 modifiers, qint64 timeNs) {
+    if (!file.isOpen()) return;
+    Record record;
+    record.timeNs = timeNs - startNs;
+    record.keyId = quint16(keyId);
+    record.vkCode = key.vkCode;
+    record.scanCode = key.scanCode;
+    record.kind = kind;
+    record.modifiers = modifiers;
+    pending.append(record);
+    if (pending.size() >= INPUT_TRACE_FLUSH_RECORDS) flush();
+}
+
+// --- flush: 写出缓冲的记录 ---
+void InputTrace::flush() {
+    if (!file.isOpen() || pending.isEmpty()) return;
+    const qint64 bytes = qint64(pending.size()) * qint64(sizeof(Record));
+    if (file.write(reinterpret_cast<const char*>(pending.constData()), bytes) != bytes) {
+        qWarning("写入输入轨迹失败: %s", qPrintable(file.errorString()));
+        file.close();
+    } else {
+        file.flush();
+    }
+    pending.clear();
+}
+
+// --- read: 读取并校验轨迹文件 ---
+bool InputTrace::read(const QString& path, Header& header, QVector<Record>& records, QString* errorMessage) {
+    QFile input(path);
+    if (!input.open(QIODevice::ReadOnly)) {
+        if (errorMessage) *errorMessage = input.errorString();
+        return false;
+    }
+    const QByteArray data = input.readAll();
+    if (data.size() < qsizetype(sizeof(Header))) {
+        if (errorMessage) *errorMessage = QStringLiteral("文件太短");
+        return false;
+    }
+    std::memcpy(&header, data.constData(), sizeof(Header));
+    if (header.magic != MAGIC || header.version != VERSION) {
+        if (errorMessage) *errorMessage = QStringLiteral("不是输入轨迹文件或版本不匹配");
+        return false;
+    }
+    const qsizetype payload = data.size() - qsizetype(sizeof(Header));
+    if (payload % qsizetype(sizeof(Record)) != 0) {
+        if (errorMessage) *errorMessage = QStringLiteral("记录不完整");
+        return false;
+    }
+    records.resize(payload / qsizetype(sizeof(Record)));
+    std::memcpy(records.data(), data.constData() + sizeof(Header), size_t(payload));
+    for (const Record& record : std::as_const(records)) {
+        if (record.keyId >= header.keyCount || quint8(record.kind) > quint8(Kind::Repeat)) {
+            if (errorMessage) *errorMessage = QStringLiteral("记录中的按键 id 或类型无效");
+            return false;
+        }
+    }
+    return true;
+}
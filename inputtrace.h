@@ -0,0 +1,68 @@
+#ifndef VIRTUALKEYBOARD_INPUTTRACE_H
+#define VIRTUALKEYBOARD_INPUTTRACE_H
+
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+#include "keytable.h"
+
+// 输入轨迹: 按下/释放/自动重复处理函数看到的按键序列，用于在 offscreen 平台下确定性地重放现场会话
+// 每条记录是处理函数入口的按键 id、VK 码、扫描码、处理前的修饰键状态和时间 (相对于开始记录)。
+// 建议栏、批量输入和宏按钮等不经过按键处理函数的操作不记录。
+//
+// 文件格式: [Header][Record x N]，本机字节序；记录按块追加 (异常退出时最多丢失最后一块)
+class InputTrace {
+public:
+    static constexpr quint32 MAGIC = 0x54494B56; // "VKIT"
+    static constexpr quint16 VERSION = 1;
+
+    enum class Kind : quint8 {
+        Press,   // onKeyPressed
+        Release, // onKeyReleased
+        Repeat   // onKeyRepeat (回放时重复只来自轨迹)
+    };
+
+    struct Header {
+        quint32 magic = MAGIC;
+        quint16 version = VERSION;
+        quint16 keyCount = 0;  // 记录时按键表的按键数
+        quint32 layoutHash = 0; // 记录时按键表的 layoutHash()
+        quint32 reserved = 0;
+        qint64 startMs = 0;    // 开始记录的时间 (自纪元起的毫秒，只用于显示)
+    };
+    struct Record {
+        qint64 timeNs = 0;     // 相对于开始记录的时间 (输入事件时间，没有时为处理函数入口时间)
+        quint16 keyId = 0;
+        quint16 vkCode = 0;
+        quint16 scanCode = 0;
+        Kind kind = Kind::Press;
+        quint8 modifiers = 0;  // 处理前的 ModifierStateBit 组合
+    };
+
+    ~InputTrace();
+
+    // 按键表的指纹 (按 id 顺序的 VK 码、扫描码和类型)，回放时布局必须一致
+    static quint32 layoutHash(const KeyTable& table);
+
+    // 创建轨迹文件
+    bool open(const QString& path, const KeyTable& table, QString* errorMessage = nullptr);
+    bool isOpen() const { return file.isOpen(); }
+    // 追加一条记录 (timeNs 为 LatencyStats::now() 时基)
+    void record(Kind kind, int keyId, const KeyEntry& key, quint8 modifiers, qint64 timeNs);
+    // 把缓冲的记录写入文件
+    void flush();
+
+    // 读取轨迹文件
+    static bool read(const QString& path, Header& header, QVector<Record>& records, QString* errorMessage = nullptr);
+
+private:
+    QFile file;
+    QVector<Record> pending; // 尚未写出的记录
+    qint64 startNs = 0;
+};
+
+static_assert(sizeof(InputTrace::Header) == 24, "轨迹文件头布局不应改变");
+static_assert(sizeof(InputTrace::Record) == 16, "轨迹记录布局不应改变");
+
+#endif // VIRTUALKEYBOARD_INPUTTRACE_H
@@ -0,0 +1,475 @@
+#include "keyboardcanvas.h"
+
+#include <QPainter>
+#include <QLinearGradient>
+#include <QMouseEvent>
+#include <QTouchEvent>
+#include <QResizeEvent>
+#include <utility>
+
+// --- 常量定义 ---
+const int CANVAS_KEY_SPACING = 4;     // 按键间距 (与按钮模式的网格间距一致)
+const int CANVAS_SECTION_PADDING = 8; // 区域内边距
+const int CANVAS_SECTION_SPACING = 10; // 区域之间的最小间距
+const int CANVAS_KEY_MIN_HEIGHT = 45; // 按键最小高度 (像素)
+const int CANVAS_KEY_MIN_WIDTH = 45;  // 按键最小宽度 (像素)
+const qreal CANVAS_KEY_RADIUS = 5.0;  // 按键圆角
+const qreal CANVAS_SECTION_RADIUS = 8.0; // 区域圆角
+const qreal CANVAS_GESTURE_START = 0.5;  // 拖离起点超过按键宽度的这个比例后按滑行处理
+const qreal CANVAS_GESTURE_MIN_STEP = 2.0; // 轨迹相邻点的最小间距 (像素)
+const qreal CANVAS_GESTURE_PEN_WIDTH = 6.0; // 轨迹线宽
+
+// --- 样式画刷 ---
+// 使用 ObjectBoundingMode 的渐变，一个画刷即可用于所有尺寸的按键，避免每次绘制时重新构建
+static QBrush verticalGradient(const QColor& top, const QColor& bottom) {
+    QLinearGradient gradient(0, 0, 0, 1);
+    gradient.setCoordinateMode(QGradient::ObjectBoundingMode);
+    gradient.setColorAt(0, top);
+    gradient.setColorAt(1, bottom);
+    return QBrush(gradient);
+}
+
+// --- baseStyle: 按键未激活时的样式 ---
+// 空格键在按钮模式中使用 SpaceKey 对象名，其外观与普通键相同
+KeyVisualStyle KeyboardCanvas::baseStyle(const KeyInfo& keyInfo) {
+    return (keyInfo.type == KeyType::Normal || keyInfo.vkCode == VK_SPACE) ? KeyVisualStyle::Normal : KeyVisualStyle::Special;
+}
+
+// --- isGestureKey: 单个字母的普通键可以开始滑行 ---
+bool KeyboardCanvas::isGestureKey(const KeyInfo& keyInfo) {
+    return !KeyTable::touchLetter(keyInfo).isNull();
+}
+
+// --- 构造函数 ---
+KeyboardCanvas::KeyboardCanvas(QWidget *parent)
+        : QWidget(parent)
+{
+    // !!! 关键: 画布不接受焦点，避免从目标应用窃取焦点 !!!
+    setFocusPolicy(Qt::NoFocus);
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+    // 背景由我们自行绘制 (半透明区域)
+    setAttribute(Qt::WA_NoSystemBackground, true);
+    // 直接接收触摸事件 (否则 Qt 只为第一个触摸点合成鼠标事件)
+    setAttribute(Qt::WA_AcceptTouchEvents, true);
+
+    QFont keyFont = font();
+    keyFont.setPointSize(11); // 与 QSS 中的 font-size 一致
+    keyFont.setBold(true);
+    setFont(keyFont);
+}
+
+// --- setSections: 设置要绘制的键盘区域 ---
+void KeyboardCanvas::setSections(const QList<KeyboardLayout>& layouts) {
+    keys.clear();
+    sections.clear();
+    firstIndexById.clear();
+    hitGrid.clear();
+    pressedKey = -1;
+    touchChanges.clear();
+    touchTracker.cancel(touchChanges); // 旧按键已不存在，丢弃变化
+    touchChanges.clear();
+    gestureTracking = false;
+    gestureActive = false;
+    gesturePath.clear();
+
+    for (int s = 0; s < layouts.size(); ++s) {
+        Section section;
+        int minRow = -1, maxRow = -1;
+        for (const auto& row : layouts[s]) {
+            for (const auto& keyInfo : row) {
+                // 跳过完全空的占位符 (与按钮模式一致)
+                if (keyInfo.vkCode == 0 && keyInfo.text.isEmpty()) continue;
+
+                CanvasKey key;
+                key.info = keyInfo;
+                key.section = s;
+                key.label = keyInfo.text;
+                key.style = baseStyle(keyInfo);
+
+                // 维护 id -> 按键索引的链表 (拆分的空格键两半共用一个 id)
+                if (keyInfo.keyId >= 0) {
+                    if (keyInfo.keyId >= firstIndexById.size()) firstIndexById.resize(keyInfo.keyId + 1, -1);
+                    key.nextSameId = firstIndexById[keyInfo.keyId];
+                    firstIndexById[keyInfo.keyId] = keys.size();
+                }
+                keys.append(key);
+
+                if (minRow < 0 || keyInfo.row < minRow) minRow = keyInfo.row;
+                if (keyInfo.row > maxRow) maxRow = keyInfo.row;
+                section.columnCount = qMax(section.columnCount, keyInfo.column + keyInfo.columnSpan);
+            }
+        }
+        section.firstRow = qMax(minRow, 0);
+        section.rowCount = minRow < 0 ? 0 : maxRow - minRow + 1;
+        sections.append(section);
+    }
+
+    layoutKeys();
+    updateGeometry();
+    update();
+}
+
+// --- rebindSections: 原地换成几何相同的另一组区域 ---
+// 按 setSections 的顺序遍历，每个按键的 id、区域、行列和跨度都必须与现有按键一致
+void KeyboardCanvas::rebindSections(const QList<KeyboardLayout>& layouts) {
+    const auto matches = [this, &layouts]() {
+        if (layouts.size() != sections.size()) return false;
+        int index = 0;
+        for (int s = 0; s < layouts.size(); ++s) {
+            for (const auto& row : layouts[s]) {
+                for (const auto& keyInfo : row) {
+                    if (keyInfo.vkCode == 0 && keyInfo.text.isEmpty()) continue;
+                    if (index >= keys.size()) return false;
+                    const CanvasKey& current = keys[index++];
+                    if (current.section != s || current.info.keyId != keyInfo.keyId || current.info.row != keyInfo.row ||
+                        current.info.column != keyInfo.column || current.info.columnSpan != keyInfo.columnSpan) return false;
+                }
+            }
+        }
+        return index == keys.size();
+    };
+    if (!matches()) {
+        setSections(layouts);
+        return;
+    }
+
+    int index = 0;
+    for (const KeyboardLayout& layout : layouts) {
+        for (const auto& row : layout) {
+            for (const auto& keyInfo : row) {
+                if (keyInfo.vkCode == 0 && keyInfo.text.isEmpty()) continue;
+                keys[index++].info = keyInfo;
+            }
+        }
+    }
+    updateTouchDecoder(); // 字母可能改变 (矩形不变)
+}
+
+// --- isKeyDown: 按键是否处于按下状态 ---
+bool KeyboardCanvas::isKeyDown(int keyId) const {
+    for (int index = firstIndexById.value(keyId, -1); index >= 0; index = keys[index].nextSameId) {
+        if (keys[index].down) return true;
+    }
+    return false;
+}
+
+// --- setBackgroundAlpha: 设置区域背景透明度 ---
+void KeyboardCanvas::setBackgroundAlpha(int alpha) {
+    alpha = qBound(0, alpha, 255);
+    if (alpha == backgroundAlpha) return;
+    backgroundAlpha = alpha;
+    update(); // 背景位于所有按键下方，需要整体重绘
+}
+
+// --- setKeyVisual: 更新按键文本和样式，只重绘变化的按键 ---
+bool KeyboardCanvas::setKeyVisual(int keyId, const QString& label, KeyVisualStyle style) {
+    if (keyId < 0 || keyId >= firstIndexById.size()) return false;
+    bool changed = false;
+    for (int i = firstIndexById[keyId]; i >= 0; i = keys[i].nextSameId) {
+        CanvasKey& key = keys[i];
+        if (label == key.label && style == key.style) continue;
+        key.label = label;
+        key.style = style;
+        updateKey(i);
+        changed = true;
+    }
+    return changed;
+}
+
+// --- setGestureMode: 开关滑行输入 (正在进行的滑行被丢弃) ---
+void KeyboardCanvas::setGestureMode(bool enabled) {
+    if (enabled == gestureEnabled) return;
+    gestureEnabled = enabled;
+    if (gestureTracking) {
+        if (pressedKey >= 0) keys[pressedKey].down = false;
+        pressedKey = -1;
+        gestureTracking = false;
+        gestureActive = false;
+        gesturePath.clear();
+        update();
+    }
+}
+
+// --- keyRect: 按键矩形 (拆分的空格键返回其中一半) ---
+QRectF KeyboardCanvas::keyRect(int keyId) const {
+    if (keyId < 0 || keyId >= firstIndexById.size() || firstIndexById[keyId] < 0) return QRectF();
+    return keys[firstIndexById[keyId]].rect;
+}
+
+// --- sizeHint / minimumSizeHint ---
+QSize KeyboardCanvas::sizeHint() const {
+    return minimumSizeHint();
+}
+
+QSize KeyboardCanvas::minimumSizeHint() const {
+    int width = 0, rows = 0;
+    for (const Section& section : sections) {
+        width += section.columnCount * (CANVAS_KEY_MIN_WIDTH + CANVAS_KEY_SPACING) + 2 * CANVAS_SECTION_PADDING;
+        rows = qMax(rows, section.rowCount);
+    }
+    if (sections.size() > 1) width += (sections.size() - 1) * CANVAS_SECTION_SPACING;
+    int height = rows * (CANVAS_KEY_MIN_HEIGHT + CANVAS_KEY_SPACING) + 2 * CANVAS_SECTION_PADDING;
+    return QSize(width, height);
+}
+
+// --- layoutKeys: 计算区域和按键的矩形 ---
+// 区域排布与按钮模式一致：各区域等宽，区域之间的伸缩空间与一个区域同宽
+void KeyboardCanvas::layoutKeys() {
+    const int count = sections.size();
+    if (count == 0) return;
+
+    const qreal totalWidth = width();
+    const qreal totalHeight = height();
+    const qreal slots = 2 * count - 1; // 区域 + 区域之间的伸缩空间
+    const qreal sectionWidth = qMax<qreal>(0, (totalWidth - (count - 1) * CANVAS_SECTION_SPACING) / slots);
+    const qreal gapWidth = count > 1 ? (totalWidth - count * sectionWidth) / (count - 1) : 0;
+
+    for (int s = 0; s < count; ++s) {
+        Section& section = sections[s];
+        section.rect = QRectF(s * (sectionWidth + gapWidth), 0, sectionWidth, totalHeight);
+    }
+
+    for (CanvasKey& key : keys) {
+        const Section& section = sections[key.section];
+        if (section.columnCount == 0 || section.rowCount == 0) continue;
+        const QRectF inner = section.rect.adjusted(CANVAS_SECTION_PADDING, CANVAS_SECTION_PADDING,
+                                                   -CANVAS_SECTION_PADDING, -CANVAS_SECTION_PADDING);
+        const qreal cellWidth = (inner.width() - (section.columnCount - 1) * CANVAS_KEY_SPACING) / section.columnCount;
+        const qreal cellHeight = (inner.height() - (section.rowCount - 1) * CANVAS_KEY_SPACING) / section.rowCount;
+        const int row = key.info.row - section.firstRow;
+        key.rect = QRectF(inner.left() + key.info.column * (cellWidth + CANVAS_KEY_SPACING),
+                          inner.top() + row * (cellHeight + CANVAS_KEY_SPACING),
+                          key.info.columnSpan * cellWidth + (key.info.columnSpan - 1) * CANVAS_KEY_SPACING,
+                          cellHeight);
+    }
+
+    // 重建命中测试索引
+    QVector<QRectF> rects;
+    rects.reserve(keys.size());
+    for (const CanvasKey& key : std::as_const(keys)) rects.append(key.rect);
+    hitGrid.build(rects);
+    updateTouchDecoder();
+}
+
+// --- updateTouchDecoder: 概率触摸定位的按键矩形和字母 ---
+void KeyboardCanvas::updateTouchDecoder() {
+    if (!touchTargeting) return;
+    QVector<TouchDecoder::Key> decoderKeys;
+    decoderKeys.reserve(keys.size());
+    for (const CanvasKey& key : std::as_const(keys)) decoderKeys.append({key.rect, KeyTable::touchLetter(key.info)});
+    touchDecoder.setKeys(decoderKeys);
+}
+
+// --- setTouchTargeting: 开启概率触摸定位 ---
+void KeyboardCanvas::setTouchTargeting(const TouchLanguageModel* model, TouchTrace* trace) {
+    touchTargeting = true;
+    touchDecoder.setModel(model);
+    touchDecoder.setTrace(trace, QStringLiteral("canvas"));
+    layoutKeys();
+}
+
+// --- keyAt: 命中测试 (只检查所在网格单元中的按键) ---
+int KeyboardCanvas::keyAt(const QPointF& pos) const {
+    return hitGrid.indexAt(pos);
+}
+
+// --- updateKey: 只重绘单个按键区域 ---
+void KeyboardCanvas::updateKey(int index) {
+    if (index < 0 || index >= keys.size()) return;
+    update(keys[index].rect.toAlignedRect().adjusted(-1, -1, 1, 1));
+}
+
+// --- setKeyDown: 改变按键按下状态并发出信号 ---
+void KeyboardCanvas::setKeyDown(int index, bool down) {
+    CanvasKey& key = keys[index];
+    if (key.down == down) return;
+    key.down = down;
+    updateKey(index);
+
+    if (down) emit keyPressed(key.info.keyId);
+    else emit keyReleased(key.info.keyId);
+}
+
+// --- updateGestureSegment: 只重绘轨迹新增 (或清除) 的一段 ---
+void KeyboardCanvas::updateGestureSegment(const QPointF& from, const QPointF& to) {
+    const qreal margin = CANVAS_GESTURE_PEN_WIDTH;
+    update(QRectF(from, to).normalized().adjusted(-margin, -margin, margin, margin).toAlignedRect());
+}
+
+// --- 鼠标事件 ---
+// 滑行模式下从字母键按下时先只显示按下状态: 松开前没有拖离按键则作为一次点击发出，
+// 拖离超过 CANVAS_GESTURE_START 个按键宽度则记录轨迹，松开时作为滑行发出。
+// 触摸点正由 handleTouch 处理时，系统为触摸合成的鼠标事件被忽略
+void KeyboardCanvas::mousePressEvent(QMouseEvent *event) {
+    const bool fromTouch = event->pointingDevice() && event->pointingDevice()->type() == QInputDevice::DeviceType::TouchScreen;
+    if (event->button() != Qt::LeftButton || pressedKey >= 0 || (fromTouch && touchTracker.activeCount() > 0)) {
+        event->ignore();
+        return;
+    }
+    int index = keyAt(event->position());
+    // 滑行模式下单点触摸经由合成的鼠标事件到达这里，同样按概率定位
+    if (fromTouch && touchTargeting) index = touchDecoder.decode(event->position(), index);
+    if (index < 0) return;
+    pressedKey = index;
+    pressedArea = fromTouch && touchTargeting ? TouchDecoder::holdArea(keys[index].rect, event->position()) : keys[index].rect;
+    if (gestureEnabled && isGestureKey(keys[index].info)) {
+        gestureTracking = true;
+        gestureActive = false;
+        gesturePath.clear();
+        gesturePath.append(event->position());
+        keys[index].down = true;
+        updateKey(index);
+        return;
+    }
+    setKeyDown(index, true);
+}
+
+void KeyboardCanvas::mouseMoveEvent(QMouseEvent *event) {
+    if (pressedKey < 0) return;
+    if (gestureTracking) {
+        const QPointF pos = event->position();
+        const QPointF last = gesturePath.last();
+        if (qAbs(pos.x() - last.x()) + qAbs(pos.y() - last.y()) < CANVAS_GESTURE_MIN_STEP) return;
+        gesturePath.append(pos);
+        if (!gestureActive) {
+            const QPointF moved = pos - gesturePath.first();
+            const qreal threshold = keys[pressedKey].rect.width() * CANVAS_GESTURE_START;
+            if (moved.x() * moved.x() + moved.y() * moved.y() < threshold * threshold) return;
+            gestureActive = true;
+            keys[pressedKey].down = false;
+            updateKey(pressedKey);
+            for (int i = 1; i < gesturePath.size(); ++i) updateGestureSegment(gesturePath[i - 1], gesturePath[i]);
+            return;
+        }
+        updateGestureSegment(last, pos);
+        return;
+    }
+    // 与 QAbstractButton 一致：拖出按键时释放，拖回时重新按下
+    bool inside = pressedArea.contains(event->position());
+    if (inside != keys[pressedKey].down) setKeyDown(pressedKey, inside);
+}
+
+void KeyboardCanvas::mouseReleaseEvent(QMouseEvent *event) {
+    if (event->button() != Qt::LeftButton || pressedKey < 0) return;
+    int index = pressedKey;
+    pressedKey = -1;
+    if (gestureTracking) {
+        gestureTracking = false;
+        if (gestureActive) {
+            gestureActive = false;
+            const QVector<QPointF> path = std::exchange(gesturePath, {});
+            for (int i = 1; i < path.size(); ++i) updateGestureSegment(path[i - 1], path[i]); // 擦除轨迹
+            emit gestureFinished(path);
+        } else {
+            gesturePath.clear();
+            keys[index].down = false;
+            updateKey(index);
+            emit keyPressed(keys[index].info.keyId);
+            emit keyReleased(keys[index].info.keyId);
+        }
+        return;
+    }
+    setKeyDown(index, false);
+}
+
+// --- event: 触摸事件 ---
+bool KeyboardCanvas::event(QEvent *event) {
+    switch (event->type()) {
+        case QEvent::TouchBegin:
+        case QEvent::TouchUpdate:
+        case QEvent::TouchEnd:
+        case QEvent::TouchCancel:
+            return handleTouch(static_cast<QTouchEvent*>(event));
+        default:
+            return QWidget::event(event);
+    }
+}
+
+// --- handleTouch: 每个触摸点独立地按下/释放自己的按键 ---
+// 滑行模式下从字母键开始的单点触摸不接受，由 Qt 合成的鼠标事件按滑行处理
+bool KeyboardCanvas::handleTouch(QTouchEvent *event) {
+    touchChanges.clear();
+    if (event->type() == QEvent::TouchCancel) {
+        touchTracker.cancel(touchChanges);
+    } else {
+        if (event->type() == QEvent::TouchBegin && gestureEnabled && event->points().size() == 1) {
+            const int index = keyAt(event->points().first().position());
+            if (index >= 0 && isGestureKey(keys[index].info)) {
+                event->ignore();
+                return false;
+            }
+        }
+        touchTracker.handle(event, hitGrid, touchChanges, activeTouchDecoder());
+    }
+    for (const TouchKeyTracker::Change& change : std::as_const(touchChanges)) setKeyDown(change.index, change.down);
+    event->accept();
+    return true;
+}
+
+// --- resizeEvent: 尺寸改变时重新计算按键矩形 ---
+void KeyboardCanvas::resizeEvent(QResizeEvent *event) {
+    QWidget::resizeEvent(event);
+    // 按住的触摸点对应的按键位置已经改变: 先全部释放
+    touchChanges.clear();
+    touchTracker.cancel(touchChanges);
+    for (const TouchKeyTracker::Change& change : std::as_const(touchChanges)) setKeyDown(change.index, false);
+    layoutKeys();
+}
+
+// --- paintEvent: 绘制区域背景和与脏区相交的按键 ---
+void KeyboardCanvas::paintEvent(QPaintEvent *event) {
+    QPainter painter(this);
+    painter.setRenderHint(QPainter::Antialiasing, true);
+    const QRectF dirty = event->rect();
+
+    // --- 区域背景 ---
+    // 半透明背景需要先清除脏区，再重新绘制背景和按键
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    painter.fillRect(dirty, Qt::transparent);
+    painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+    painter.setPen(QPen(QColor(80, 80, 80, backgroundAlpha), 1));
+    painter.setBrush(QColor(40, 40, 45, backgroundAlpha));
+    for (const Section& section : sections) {
+        if (!section.rect.intersects(dirty)) continue;
+        painter.drawRoundedRect(section.rect.adjusted(0.5, 0.5, -0.5, -0.5), CANVAS_SECTION_RADIUS, CANVAS_SECTION_RADIUS);
+    }
+
+    // --- 按键 ---
+    for (const CanvasKey& key : keys) {
+        if (key.rect.intersects(dirty)) paintKey(painter, key);
+    }
+
+    // --- 滑行轨迹 (绘制在按键之上) ---
+    if (gestureActive && gesturePath.size() > 1) {
+        painter.setPen(QPen(QColor(0x00, 0x7A, 0xCC, 160), CANVAS_GESTURE_PEN_WIDTH, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin));
+        painter.setBrush(Qt::NoBrush);
+        painter.drawPolyline(gesturePath.constData(), int(gesturePath.size()));
+    }
+}
+
+// --- paintKey: 绘制单个按键 (对应按钮模式的 QSS 样式) ---
+void KeyboardCanvas::paintKey(QPainter& painter, const CanvasKey& key) const {
+    static const QBrush normalBrush = verticalGradient(QColor(0x5a, 0x5a, 0x5a), QColor(0x3a, 0x3a, 0x3a));
+    static const QBrush specialBrush = verticalGradient(QColor(0x68, 0x68, 0x68), QColor(0x48, 0x48, 0x48));
+    static const QBrush activeBrush = verticalGradient(QColor(0x00, 0x7A, 0xCC), QColor(0x00, 0x5C, 0x99)); // 蓝色
+    static const QBrush toggleBrush = verticalGradient(QColor(0x50, 0xA6, 0x4F), QColor(0x38, 0x8E, 0x3C)); // 绿色
+
+    const QBrush* brush = &normalBrush;
+    QColor border(0x66, 0x66, 0x66);
+    if (key.down || key.style == KeyVisualStyle::ModifierActive) {
+        brush = &activeBrush;
+        border = QColor(0x00, 0xAA, 0xCC);
+    } else if (key.style == KeyVisualStyle::ToggleActive) {
+        brush = &toggleBrush;
+        border = QColor(0x81, 0xC7, 0x84);
+    } else if (key.style == KeyVisualStyle::Special) {
+        brush = &specialBrush;
+    }
+
+    painter.setPen(QPen(border, 1));
+    painter.setBrush(*brush);
+    painter.drawRoundedRect(key.rect.adjusted(0.5, 0.5, -0.5, -0.5), CANVAS_KEY_RADIUS, CANVAS_KEY_RADIUS);
+
+    painter.setPen(Qt::white);
+    painter.drawText(key.rect, Qt::AlignCenter, key.label);
+}
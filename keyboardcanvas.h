@@ -0,0 +1,114 @@
+#ifndef VIRTUALKEYBOARD_KEYBOARDCANVAS_H
+#define VIRTUALKEYBOARD_KEYBOARDCANVAS_H
+
+#include <QWidget>
+#include <QVector>
+#include <QList>
+#include <QPointF>
+#include <QRectF>
+#include "keyboardlayout.h" // 包含键盘布局定义
+#include "keytable.h"       // KeyVisualStyle
+#include "keyhitgrid.h"     // 命中测试的空间索引
+#include "touchkeytracker.h" // 多点触摸
+#include "touchdecoder.h"   // 概率触摸定位
+
+// 单控件自绘键盘：
+// 用一个 QWidget 绘制布局中的所有按键，自行完成命中测试 (网格桶索引)，
+// 只重绘状态发生变化的按键，并复刻 QPushButton 的按下/释放行为 (自动重复由 KeyRepeater 统一调度)。
+// 直接处理 QTouchEvent: 每个触摸点独立地按下/释放自己的按键，多个手指可以同时按住 (例如 Shift + 字母)。
+class KeyboardCanvas : public QWidget {
+Q_OBJECT
+
+public:
+    explicit KeyboardCanvas(QWidget *parent = nullptr);
+    ~KeyboardCanvas() override = default;
+
+    // 设置要绘制的键盘区域 (例如左右两个半区)，每个区域单独绘制圆角背景
+    void setSections(const QList<KeyboardLayout>& sections);
+    // 换成几何相同的另一组区域 (切换布局): 原地替换按键数据，保留矩形、命中索引和按下状态；
+    // 按键数量或位置不同时退回 setSections。文本由随后的 setKeyVisual 更新
+    void rebindSections(const QList<KeyboardLayout>& sections);
+    // 按键 (按 id) 是否处于按下状态 (鼠标或触摸)
+    bool isKeyDown(int keyId) const;
+    // 设置键盘区域背景的 alpha 值 (0-255)
+    void setBackgroundAlpha(int alpha);
+    // 更新某个按键 (按 id) 的文本和样式，只重绘真正发生变化的按键；返回是否有变化
+    bool setKeyVisual(int keyId, const QString& label, KeyVisualStyle style);
+    // 滑行输入模式: 从字母键开始拖动超过半个按键即为滑行，松开时发出 gestureFinished 而不是按键信号；
+    // 字母键的点击改为在松开时发出 (按下 + 释放)，其他键不受影响
+    void setGestureMode(bool enabled);
+    bool gestureMode() const { return gestureEnabled; }
+    // 按键 (按 id) 在画布中的矩形，不在画布中时为空矩形
+    QRectF keyRect(int keyId) const;
+    // 开启概率触摸定位: 触摸按下的字母键由语言模型加权的解码器选择 (model 由调用者持有，trace 可为 nullptr)
+    void setTouchTargeting(const TouchLanguageModel* model, TouchTrace* trace = nullptr);
+
+    QSize sizeHint() const override;
+    QSize minimumSizeHint() const override;
+
+signals:
+    // 与 QPushButton::pressed/released 语义一致，只携带按键 id (KeyInfo::keyId)
+    void keyPressed(int keyId);
+    void keyReleased(int keyId);
+    // 一次滑行的轨迹 (画布坐标，按鼠标事件顺序)
+    void gestureFinished(const QVector<QPointF>& path);
+
+protected:
+    bool event(QEvent *event) override; // 触摸事件
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+
+private:
+    // 画布中的单个按键
+    struct CanvasKey {
+        KeyInfo info;           // 按键数据
+        int section = 0;        // 所属键盘区域
+        QRectF rect;            // 在画布中的矩形 (resize 时计算)
+        QString label;          // 当前显示的文本
+        KeyVisualStyle style = KeyVisualStyle::Normal; // 当前样式
+        bool down = false;      // 是否处于按下状态
+        int nextSameId = -1;    // 同一 id 的下一个按键索引 (拆分的空格键)
+    };
+
+    // 键盘区域 (半区) 的网格信息
+    struct Section {
+        int rowCount = 0;       // 行数
+        int columnCount = 0;    // 列数
+        int firstRow = 0;       // 布局数据中的起始行号
+        QRectF rect;            // 在画布中的矩形
+    };
+
+    static KeyVisualStyle baseStyle(const KeyInfo& keyInfo); // 按键未激活时的样式
+    static bool isGestureKey(const KeyInfo& keyInfo);         // 可以开始滑行的键 (单个字母)
+    void layoutKeys();                   // 根据当前尺寸计算所有按键矩形
+    void updateTouchDecoder();           // 按当前矩形和字母更新概率触摸定位的按键
+    int keyAt(const QPointF& pos) const; // 命中测试，返回按键索引 (-1 表示未命中)
+    const TouchDecoder* activeTouchDecoder() const { return touchTargeting ? &touchDecoder : nullptr; }
+    bool handleTouch(QTouchEvent *event); // 处理触摸事件，返回是否接受
+    void setKeyDown(int index, bool down); // 改变按键按下状态并发出信号
+    void updateKey(int index);           // 只重绘单个按键
+    void paintKey(QPainter& painter, const CanvasKey& key) const;
+    void updateGestureSegment(const QPointF& from, const QPointF& to); // 重绘轨迹的一段
+
+    QVector<CanvasKey> keys;       // 所有按键
+    QVector<Section> sections;     // 所有键盘区域
+    QVector<int> firstIndexById;   // 按键 id -> 第一个按键索引 (-1 表示不在画布中)
+    int backgroundAlpha = 217;     // 区域背景 alpha
+    int pressedKey = -1;           // 当前被鼠标按住的按键索引
+    QRectF pressedArea;            // 鼠标按住的区域 (拖出时释放)
+    KeyHitGrid hitGrid;            // 按键矩形的空间索引 (下标与 keys 一致)
+    TouchKeyTracker touchTracker;  // 各触摸点按住的按键
+    QVector<TouchKeyTracker::Change> touchChanges; // 触摸事件产生的变化 (复用缓冲区)
+    bool touchTargeting = false;   // 概率触摸定位
+    TouchDecoder touchDecoder;     // 下标与 keys 一致
+    // --- 滑行输入 ---
+    bool gestureEnabled = false;   // 滑行输入模式
+    bool gestureTracking = false;  // 从字母键按下，尚未松开 (pressedKey 为起始键)
+    bool gestureActive = false;    // 已拖离起始键，按滑行处理
+    QVector<QPointF> gesturePath;  // 当前轨迹
+};
+
+#endif // VIRTUALKEYBOARD_KEYBOARDCANVAS_H
@@ -0,0 +1,146 @@
+#include "keyboardgeometry.h"
+
+#include <algorithm>
+#include <utility>
+
+// --- 常量定义 ---
+const char* const GEOMETRY_MODE_NAMES[GEOMETRY_MODE_COUNT] = { "full", "split", "compact", "numpad" };
+const char* const GEOMETRY_MODE_LABELS[GEOMETRY_MODE_COUNT] = { "完整", "拆分", "紧凑", "小键盘" };
+
+// --- geometryModeName / geometryModeLabel / parseGeometryMode ---
+const char* geometryModeName(GeometryMode mode) {
+    return GEOMETRY_MODE_NAMES[qBound(0, int(mode), GEOMETRY_MODE_COUNT - 1)];
+}
+
+QString geometryModeLabel(GeometryMode mode) {
+    return QString::fromUtf8(GEOMETRY_MODE_LABELS[qBound(0, int(mode), GEOMETRY_MODE_COUNT - 1)]);
+}
+
+bool parseGeometryMode(const QString& name, GeometryMode& mode) {
+    for (int i = 0; i < GEOMETRY_MODE_COUNT; ++i) {
+        if (name.compare(QLatin1String(GEOMETRY_MODE_NAMES[i]), Qt::CaseInsensitive) == 0) {
+            mode = GeometryMode(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+// --- rowCount / columnCount ---
+int KeyboardGeometry::rowCount(int section) const {
+    int rows = 0;
+    for (const auto& row : sections.value(section)) {
+        for (const KeyInfo& key : row) rows = qMax(rows, key.row + 1);
+    }
+    return rows;
+}
+
+int KeyboardGeometry::columnCount(int section) const {
+    int columns = 0;
+    for (const auto& row : sections.value(section)) {
+        for (const KeyInfo& key : row) columns = qMax(columns, key.column + key.columnSpan);
+    }
+    return columns;
+}
+
+// --- 紧凑模式去掉的键 ---
+static bool isFunctionRowKey(const KeyInfo& key) {
+    return (key.vkCode >= VK_F1 && key.vkCode <= VK_F12) || key.vkCode == VK_SNAPSHOT ||
+           key.vkCode == VK_SCROLL || key.vkCode == VK_PAUSE;
+}
+
+static bool isNavigationKey(const KeyInfo& key) {
+    switch (key.vkCode) {
+        case VK_INSERT: case VK_DELETE: case VK_HOME: case VK_END: case VK_PRIOR: case VK_NEXT: return true;
+        default: return false;
+    }
+}
+
+// --- firstFreeColumn: 行中第一个能放下 span 列的空位 (-1 表示没有) ---
+static int firstFreeColumn(const QList<KeyInfo>& row, int span, int columns) {
+    int column = 0;
+    for (const KeyInfo& key : row) { // 行内按键按列排序
+        if (key.column - column >= span) return column;
+        column = qMax(column, key.column + key.columnSpan);
+    }
+    return columns - column >= span ? column : -1;
+}
+
+// --- packSection: 去掉空行，行列从 0 连续编号 (行内按列排序) ---
+static KeyboardLayout packSection(const KeyboardLayout& rows) {
+    int firstColumn = -1;
+    for (const auto& row : rows) {
+        for (const KeyInfo& key : row) {
+            if (firstColumn < 0 || key.column < firstColumn) firstColumn = key.column;
+        }
+    }
+    KeyboardLayout packed;
+    for (const auto& row : rows) {
+        if (row.isEmpty()) continue;
+        QList<KeyInfo> keys = row;
+        std::sort(keys.begin(), keys.end(), [](const KeyInfo& a, const KeyInfo& b) { return a.column < b.column; });
+        for (KeyInfo& key : keys) {
+            key.row = int(packed.size());
+            key.column -= firstColumn;
+        }
+        packed.append(keys);
+    }
+    return packed;
+}
+
+// --- buildKeyboardGeometry: 计算一个模式的几何 ---
+KeyboardGeometry buildKeyboardGeometry(GeometryMode mode, const KeyboardLayout& full,
+                                       const KeyboardLayout& left, const KeyboardLayout& right) {
+    KeyboardGeometry geometry;
+    switch (mode) {
+        case GeometryMode::Split:
+            if (!left.isEmpty() || !right.isEmpty()) geometry.sections = {left, right};
+            return geometry;
+        case GeometryMode::Full:
+        case GeometryMode::Numpad: {
+            KeyboardLayout rows;
+            for (const auto& row : full) {
+                QList<KeyInfo> kept;
+                for (const KeyInfo& key : row) {
+                    if (mode == GeometryMode::Full || isNumpadKey(key)) kept.append(key);
+                }
+                rows.append(kept);
+            }
+            KeyboardLayout packed = packSection(rows);
+            if (!packed.isEmpty()) geometry.sections = {packed};
+            return geometry;
+        }
+        case GeometryMode::Compact: {
+            int columns = 0;
+            KeyboardLayout rows;
+            QList<KeyInfo> displaced; // 功能键行中留下的键
+            for (const auto& row : full) {
+                QList<KeyInfo> kept;
+                bool functionRow = false;
+                for (const KeyInfo& key : row) {
+                    if (isFunctionRowKey(key)) functionRow = true;
+                    else if (!isNavigationKey(key) && !isNumpadKey(key)) kept.append(key);
+                }
+                for (const KeyInfo& key : std::as_const(kept)) columns = qMax(columns, key.column + key.columnSpan);
+                if (functionRow) displaced.append(kept);
+                else rows.append(kept);
+            }
+            while (!rows.isEmpty() && rows.last().isEmpty()) rows.removeLast();
+            for (KeyInfo key : std::as_const(displaced)) {
+                const int column = rows.isEmpty() ? -1 : firstFreeColumn(rows.last(), key.columnSpan, columns);
+                if (column < 0) {
+                    rows.prepend(QList<KeyInfo>{key}); // 放不下时单独占一行
+                    continue;
+                }
+                key.column = column;
+                rows.last().append(key);
+                std::sort(rows.last().begin(), rows.last().end(),
+                          [](const KeyInfo& a, const KeyInfo& b) { return a.column < b.column; });
+            }
+            KeyboardLayout packed = packSection(rows);
+            if (!packed.isEmpty()) geometry.sections = {packed};
+            return geometry;
+        }
+    }
+    return geometry;
+}
@@ -0,0 +1,38 @@
+#ifndef VIRTUALKEYBOARD_KEYBOARDGEOMETRY_H
+#define VIRTUALKEYBOARD_KEYBOARDGEOMETRY_H
+
+#include <QList>
+#include <QString>
+#include "keyboardlayout.h" // KeyboardLayout
+
+// 键盘几何模式: 同一布局的按键的不同排布 (按键 id 不变)
+enum class GeometryMode : quint8 {
+    Full,    // 完整键盘: 主键区和小键盘在一个区域中
+    Split,   // 拆分: 左右两个半区 (默认，不含小键盘)
+    Compact, // 紧凑: 去掉功能键行、导航键和小键盘，一个区域
+    Numpad   // 只有小键盘
+};
+constexpr int GEOMETRY_MODE_COUNT = 4;
+
+// 模式名称 (命令行和日志用) 和界面上显示的简称
+const char* geometryModeName(GeometryMode mode);
+QString geometryModeLabel(GeometryMode mode);
+// 解析模式名称 (不区分大小写)，未知名称返回 false
+bool parseGeometryMode(const QString& name, GeometryMode& mode);
+
+// 某个模式下的按键排布: 每个区域单独绘制背景 (拆分模式两个，其余一个)。
+// 拆分模式直接使用拆分结果，其余模式去掉空行后行列都从 0 连续编号；布局中没有任何按键的模式为空，不可用
+struct KeyboardGeometry {
+    QList<KeyboardLayout> sections;
+
+    bool isEmpty() const { return sections.isEmpty(); }
+    int rowCount(int section) const;    // 区域的行数
+    int columnCount(int section) const; // 区域的列数 (最右按键的结束列)
+};
+
+// 由完整布局 (已写入 keyId) 和拆分结果计算一个模式的几何。
+// 紧凑模式中与功能键同一行的其他键 (Esc) 移到最后一行第一个放得下的空位，放不下时单独占一行
+KeyboardGeometry buildKeyboardGeometry(GeometryMode mode, const KeyboardLayout& full,
+                                       const KeyboardLayout& left, const KeyboardLayout& right);
+
+#endif // VIRTUALKEYBOARD_KEYBOARDGEOMETRY_H
@@ -0,0 +1,130 @@
+#include "keyboardpanel.h"
+
+#include <QPainter>
+#include <QPaintEvent>
+#include <QPushButton>
+#include <QTouchEvent>
+#include <utility>
+
+// --- 常量定义 ---
+const qreal PANEL_RADIUS = 8.0; // 圆角 (与原 QSS 中的 border-radius 一致)
+
+// --- 构造函数 ---
+KeyboardPanel::KeyboardPanel(QWidget *parent)
+        : QWidget(parent)
+{
+    // 背景由 paintEvent 绘制，不需要 QSS 背景
+    setAttribute(Qt::WA_NoSystemBackground, true);
+    // 接收落在子按钮上的触摸事件 (否则 Qt 只为第一个触摸点合成鼠标事件)
+    setAttribute(Qt::WA_AcceptTouchEvents, true);
+}
+
+// --- setBackgroundAlpha: 设置背景透明度 ---
+void KeyboardPanel::setBackgroundAlpha(int value) {
+    value = qBound(0, value, 255);
+    if (value == alpha) return;
+    alpha = value;
+    update(); // 只重绘本控件；Qt 会把同一帧内的多次 update() 合并为一次绘制
+}
+
+// --- addTouchKey: 登记触摸按键 ---
+void KeyboardPanel::addTouchKey(QPushButton *button, const KeyInfo& keyInfo) {
+    touchButtons.append(button);
+    touchKeyIds.append(keyInfo.keyId);
+    touchLetters.append(KeyTable::touchLetter(keyInfo));
+    hitGridDirty = true;
+}
+
+// --- clearTouchKeys: 释放按住的按键并清空登记 ---
+void KeyboardPanel::clearTouchKeys() {
+    touchChanges.clear();
+    touchTracker.cancel(touchChanges);
+    applyTouchChanges(); // 按下标释放，必须在清空之前
+    touchChanges.clear();
+    touchButtons.clear();
+    touchKeyIds.clear();
+    touchLetters.clear();
+    hitGridDirty = true;
+}
+
+// --- rebindTouchKeys: 按新的按键表更新字母 ---
+void KeyboardPanel::rebindTouchKeys(const KeyTable& table) {
+    for (int i = 0; i < touchKeyIds.size(); ++i) touchLetters[i] = table.touchLetter(touchKeyIds[i]);
+    hitGridDirty = true;
+}
+
+// --- setTouchTargeting: 开启概率触摸定位 (索引在下次触摸时重建) ---
+void KeyboardPanel::setTouchTargeting(const TouchLanguageModel* model, TouchTrace* trace, const QString& surface) {
+    touchTargeting = true;
+    touchDecoder.setModel(model);
+    touchDecoder.setTrace(trace, surface);
+    hitGridDirty = true;
+}
+
+// --- event: 触摸事件；尺寸或布局变化时标记索引过期 ---
+bool KeyboardPanel::event(QEvent *event) {
+    switch (event->type()) {
+        case QEvent::TouchBegin:
+        case QEvent::TouchUpdate:
+        case QEvent::TouchEnd:
+        case QEvent::TouchCancel:
+            return handleTouch(static_cast<QTouchEvent*>(event));
+        case QEvent::Resize:
+        case QEvent::LayoutRequest:
+            hitGridDirty = true;
+            break;
+        default:
+            break;
+    }
+    return QWidget::event(event);
+}
+
+// --- handleTouch: 每个触摸点独立地按下/释放自己的按钮 ---
+bool KeyboardPanel::handleTouch(QTouchEvent *event) {
+    touchChanges.clear();
+    if (event->type() == QEvent::TouchCancel) {
+        touchTracker.cancel(touchChanges);
+    } else {
+        // 几何只在没有触摸点按住时重建，按住的按键下标保持有效
+        if (hitGridDirty && touchTracker.activeCount() == 0) rebuildHitGrid();
+        touchTracker.handle(event, hitGrid, touchChanges, touchTargeting ? &touchDecoder : nullptr);
+    }
+    applyTouchChanges();
+    event->accept();
+    return true;
+}
+
+// --- rebuildHitGrid: 按钮矩形 (容器坐标) -> 网格桶索引 ---
+void KeyboardPanel::rebuildHitGrid() {
+    QVector<QRectF> rects;
+    rects.reserve(touchButtons.size());
+    for (QPushButton *button : std::as_const(touchButtons)) rects.append(QRectF(button->geometry()));
+    hitGrid.build(rects);
+    if (touchTargeting) {
+        QVector<TouchDecoder::Key> decoderKeys;
+        decoderKeys.reserve(rects.size());
+        for (int i = 0; i < rects.size(); ++i) decoderKeys.append({rects[i], touchLetters[i]});
+        touchDecoder.setKeys(decoderKeys);
+    }
+    hitGridDirty = false;
+}
+
+// --- applyTouchChanges: 显示按下状态并发出信号 ---
+// setDown 只改变外观，不发出 pressed/released，按键处理完全由 keyPressed/keyReleased 驱动
+void KeyboardPanel::applyTouchChanges() {
+    for (const TouchKeyTracker::Change& change : std::as_const(touchChanges)) {
+        touchButtons[change.index]->setDown(change.down);
+        if (change.down) emit keyPressed(touchKeyIds[change.index]);
+        else emit keyReleased(touchKeyIds[change.index]);
+    }
+}
+
+// --- paintEvent: 绘制圆角半透明背景 ---
+void KeyboardPanel::paintEvent(QPaintEvent *event) {
+    Q_UNUSED(event);
+    QPainter painter(this);
+    painter.setRenderHint(QPainter::Antialiasing, true);
+    painter.setPen(QPen(QColor(80, 80, 80, alpha), 1)); // 边框，带 alpha
+    painter.setBrush(QColor(40, 40, 45, alpha));        // 背景色: 深灰色，带 alpha
+    painter.drawRoundedRect(QRectF(rect()).adjusted(0.5, 0.5, -0.5, -0.5), PANEL_RADIUS, PANEL_RADIUS);
+}
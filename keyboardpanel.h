@@ -0,0 +1,65 @@
+#ifndef VIRTUALKEYBOARD_KEYBOARDPANEL_H
+#define VIRTUALKEYBOARD_KEYBOARDPANEL_H
+
+#include <QWidget>
+#include <QVector>
+#include "keyhitgrid.h"      // 命中测试的空间索引
+#include "touchkeytracker.h" // 多点触摸
+#include "touchdecoder.h"   // 概率触摸定位
+#include "keytable.h"       // 按 id 索引的按键表
+
+class QPushButton;
+class QTouchEvent;
+
+// 键盘半区容器 (按钮模式)
+// 圆角半透明背景在 paintEvent 中直接绘制，改变透明度只需设置 alpha 并重绘，
+// 不必改写和重新解析整个样式表。
+// 按钮本身不接受触摸，落在按钮上的触摸事件传递到容器: 容器按按钮几何建立网格桶索引，
+// 每个触摸点独立地按下/释放自己的按钮 (QPushButton 只能跟踪一个鼠标指针，无法同时按住两个键)。
+class KeyboardPanel : public QWidget {
+Q_OBJECT
+
+public:
+    explicit KeyboardPanel(QWidget *parent = nullptr);
+    ~KeyboardPanel() override = default;
+
+    // 设置背景和边框的 alpha 值 (0-255)
+    void setBackgroundAlpha(int alpha);
+    int backgroundAlpha() const { return alpha; }
+    // 登记可以被触摸按下的按钮 (必须是本容器的子控件) 和它代表的按键 (字母由 KeyTable::touchLetter 决定)
+    void addTouchKey(QPushButton *button, const KeyInfo& keyInfo);
+    // 取消所有触摸点 (按住的按键发出 keyReleased) 并清空登记的按键 (切换几何模式时重新登记)
+    void clearTouchKeys();
+    // 切换布局后按新的按键表更新字母 (按钮和按键 id 不变，索引在下次触摸时重建)
+    void rebindTouchKeys(const KeyTable& table);
+    // 开启概率触摸定位 (model 由调用者持有并在各容器间共享，surface 为轨迹文件中的表面名)
+    void setTouchTargeting(const TouchLanguageModel* model, TouchTrace* trace, const QString& surface);
+
+signals:
+    // 触摸点按下/释放按键 (与 QPushButton::pressed/released 语义一致，只携带按键 id)
+    void keyPressed(int keyId);
+    void keyReleased(int keyId);
+
+protected:
+    bool event(QEvent *event) override; // 触摸事件和几何变化
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    bool handleTouch(QTouchEvent *event); // 处理触摸事件，返回是否接受
+    void rebuildHitGrid();                // 按当前按钮几何重建索引
+    void applyTouchChanges();             // 把 touchChanges 应用到按钮并发出信号
+
+    int alpha = 217; // 背景和边框 alpha
+    // --- 触摸 ---
+    QVector<QPushButton*> touchButtons; // 下标与 hitGrid 一致
+    QVector<int> touchKeyIds;
+    QVector<QChar> touchLetters;
+    KeyHitGrid hitGrid;
+    bool hitGridDirty = true;           // 按钮几何可能已改变，下次触摸时重建
+    TouchKeyTracker touchTracker;
+    QVector<TouchKeyTracker::Change> touchChanges;
+    bool touchTargeting = false;        // 概率触摸定位
+    TouchDecoder touchDecoder;          // 下标与 hitGrid 一致
+};
+
+#endif // VIRTUALKEYBOARD_KEYBOARDPANEL_H
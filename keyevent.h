@@ -0,0 +1,43 @@
+#ifndef VIRTUALKEYBOARD_KEYEVENT_H
+#define VIRTUALKEYBOARD_KEYEVENT_H
+
+#include <QtGlobal>
+
+// 注入队列中的紧凑按键事件 (按值传递，不含任何堆内存)
+struct KeyEvent {
+    enum Flag : quint8 {
+        KeyDown       = 0x01, // 按下 (否则为释放)
+        ExtendedKey   = 0x02, // 扩展键 (KEYEVENTF_EXTENDEDKEY)
+        BatchContinue = 0x04, // 同一批次中后面还有事件，注入线程应等齐后一次提交
+        Unicode       = 0x08  // Unicode 字符事件: scanCode 为 UTF-16 代码单元，vkCode 为 0 (KEYEVENTF_UNICODE)
+    };
+
+    quint16 vkCode = 0;   // Windows 虚拟键码
+    quint16 scanCode = 0; // 硬件扫描码
+    quint8 flags = 0;     // Flag 组合
+    qint64 inputTimeNs = 0;   // 触发此事件的输入事件时间 (LatencyStats::now，0 表示未知，例如自动重复)
+    qint64 enqueueTimeNs = 0; // 进入注入队列的时间 (由 KeyInjector 填写)
+
+    bool isDown() const { return flags & KeyDown; }
+    bool isExtended() const { return flags & ExtendedKey; }
+    bool continuesBatch() const { return flags & BatchContinue; }
+    bool isUnicode() const { return flags & Unicode; }
+
+    static KeyEvent key(int vkCode, int scanCode, bool press, bool isExtended) {
+        KeyEvent event;
+        event.vkCode = static_cast<quint16>(vkCode);
+        event.scanCode = static_cast<quint16>(scanCode);
+        event.flags = quint8((press ? KeyDown : 0) | (isExtended ? ExtendedKey : 0));
+        return event;
+    }
+
+    // 不经过键盘布局直接输入一个 UTF-16 代码单元 (代理对需要连续两个事件)
+    static KeyEvent unicode(char16_t codeUnit, bool press) {
+        KeyEvent event;
+        event.scanCode = codeUnit;
+        event.flags = quint8((press ? KeyDown : 0) | Unicode);
+        return event;
+    }
+};
+
+#endif // VIRTUALKEYBOARD_KEYEVENT_H
@@ -0,0 +1,87 @@
+#include "keyhitgrid.h"
+
+#include <QtMath>
+#include <limits>
+
+// --- build: 计算网格尺寸并把每个按键放入与它相交的单元格 ---
+void KeyHitGrid::build(const QVector<QRectF>& rects) {
+    clear();
+    itemRects = rects;
+
+    QRectF bounds;
+    qreal minWidth = std::numeric_limits<qreal>::max();
+    qreal minHeight = std::numeric_limits<qreal>::max();
+    for (const QRectF& rect : rects) {
+        if (rect.isEmpty()) continue;
+        bounds = bounds.united(rect);
+        minWidth = qMin(minWidth, rect.width());
+        minHeight = qMin(minHeight, rect.height());
+    }
+    if (bounds.isEmpty()) return;
+
+    // 单元格与最小按键同样大小: 每个单元格最多与 2x2 个按键相交
+    origin = bounds.topLeft();
+    cellWidth = minWidth;
+    cellHeight = minHeight;
+    columns = qMax(1, qCeil(bounds.width() / cellWidth));
+    rows = qMax(1, qCeil(bounds.height() / cellHeight));
+    while (columns * rows > MAX_CELLS) {
+        cellWidth *= 2;
+        cellHeight *= 2;
+        columns = qMax(1, qCeil(bounds.width() / cellWidth));
+        rows = qMax(1, qCeil(bounds.height() / cellHeight));
+    }
+
+    // 两遍计数排序生成 CSR 数组
+    cellStart.fill(0, columns * rows + 1);
+    for (int pass = 0; pass < 2; ++pass) {
+        QVector<int> fill;
+        if (pass == 1) {
+            for (int c = 0; c < columns * rows; ++c) cellStart[c + 1] += cellStart[c];
+            cellItems.resize(cellStart.last());
+            fill = cellStart;
+        }
+        for (int i = 0; i < itemRects.size(); ++i) {
+            const QRectF& rect = itemRects[i];
+            if (rect.isEmpty()) continue;
+            const int left = cellColumn(rect.left()), right = cellColumn(rect.right());
+            const int top = cellRow(rect.top()), bottom = cellRow(rect.bottom());
+            for (int row = top; row <= bottom; ++row) {
+                for (int column = left; column <= right; ++column) {
+                    const int cell = row * columns + column;
+                    if (pass == 0) ++cellStart[cell + 1];
+                    else cellItems[fill[cell]++] = i;
+                }
+            }
+        }
+    }
+}
+
+// --- clear ---
+void KeyHitGrid::clear() {
+    itemRects.clear();
+    cellStart.clear();
+    cellItems.clear();
+    columns = rows = 0;
+}
+
+// --- indexAt: 只检查 pos 所在单元格中的按键 ---
+int KeyHitGrid::indexAt(const QPointF& pos) const {
+    if (columns == 0) return -1;
+    const qreal x = (pos.x() - origin.x()) / cellWidth;
+    const qreal y = (pos.y() - origin.y()) / cellHeight;
+    if (x < 0 || y < 0 || x >= columns || y >= rows) return -1;
+    const int cell = int(y) * columns + int(x);
+    for (int k = cellStart[cell]; k < cellStart[cell + 1]; ++k) {
+        if (itemRects[cellItems[k]].contains(pos)) return cellItems[k];
+    }
+    return -1;
+}
+
+int KeyHitGrid::cellColumn(qreal x) const {
+    return qBound(0, int((x - origin.x()) / cellWidth), columns - 1);
+}
+
+int KeyHitGrid::cellRow(qreal y) const {
+    return qBound(0, int((y - origin.y()) / cellHeight), rows - 1);
+}
@@ -0,0 +1,42 @@
+#ifndef VIRTUALKEYBOARD_KEYHITGRID_H
+#define VIRTUALKEYBOARD_KEYHITGRID_H
+
+#include <QPointF>
+#include <QRectF>
+#include <QVector>
+
+// 按键矩形的网格桶空间索引
+// 把按键所在区域划分为与最小按键同样大小的单元格，每个单元格预先记录与它相交的按键
+// (紧凑的 CSR 数组: cellStart + cellItems)。命中测试只需算出单元格下标并检查其中的一两个按键，
+// 与按键数无关。按键几何改变 (resize) 时重新构建。
+class KeyHitGrid {
+public:
+    static const int MAX_CELLS = 16384; // 单元格数上限 (按键极小时放大单元格)
+
+    // 用按键矩形构建索引 (下标即 rects 中的位置，空矩形不参与命中)
+    void build(const QVector<QRectF>& rects);
+    void clear();
+    bool isEmpty() const { return columns == 0; }
+
+    // 命中测试: 返回包含 pos 的按键下标，-1 表示未命中
+    int indexAt(const QPointF& pos) const;
+    // 按键矩形
+    const QRectF& rect(int index) const { return itemRects[index]; }
+    int size() const { return itemRects.size(); }
+
+private:
+    // 单元格坐标 (已限制在网格范围内)
+    int cellColumn(qreal x) const;
+    int cellRow(qreal y) const;
+
+    QVector<QRectF> itemRects;
+    QVector<int> cellStart; // 单元格 c 的按键位于 cellItems[cellStart[c] .. cellStart[c + 1])
+    QVector<int> cellItems;
+    QPointF origin;         // 网格左上角
+    qreal cellWidth = 1;
+    qreal cellHeight = 1;
+    int columns = 0;
+    int rows = 0;
+};
+
+#endif // VIRTUALKEYBOARD_KEYHITGRID_H
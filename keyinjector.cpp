@@ -0,0 +1,198 @@
+#include "keyinjector.h"
+#include "asynclogger.h"
+
+#include <QDebug>
+#include <QString>
+#include <QVector>
+#include <chrono>
+
+// --- 常量定义 ---
+// 工作线程空闲时的最长等待时间 (防御性超时，正常情况下由 post 唤醒)
+const std::chrono::milliseconds INJECTOR_IDLE_WAIT(50);
+// 工作线程一次提交给后端的最大事件数 (超过时提前提交，批次内顺序不变)
+// 与批量输入的默认批次大小一致，一批文本只需一次 SendInput
+const int INJECTOR_MAX_BATCH = 256;
+
+// --- 析构函数 ---
+KeyInjector::~KeyInjector() {
+    shutdown();
+}
+
+// --- start: 选择后端并启动工作线程 ---
+void KeyInjector::start(std::unique_ptr<InjectionBackend> backend) {
+    if (running.load()) return; // 已经在运行
+    // 后端在线程启动前设置，之后只由工作线程使用
+    injectionBackend = backend ? std::move(backend) : createInjectionBackend(QString());
+    qDebug() << "按键注入后端:" << injectionBackend->name();
+    refreshHostLayout(); // 第一次按键之前已有主机布局
+    running.store(true);
+    worker = std::thread(&KeyInjector::run, this);
+}
+
+// --- post: UI 线程入队一个事件 ---
+void KeyInjector::post(const KeyEvent& event) {
+    KeyEvent single = event;
+    single.flags &= ~KeyEvent::BatchContinue; // 单个事件自成一批
+    postBatch(&single, 1);
+}
+
+// --- postBatch: UI 线程入队一批事件 ---
+void KeyInjector::postBatch(const KeyEvent* events, int count) {
+    if (count <= 0) return;
+    if (!running.load(std::memory_order_relaxed)) {
+        // 工作线程未运行 (例如已关闭)，直接同步注入，保证事件不丢失 (没有入队时间)
+        inject(events, count);
+        return;
+    }
+    // 除最后一个事件外都带 BatchContinue 标志，工作线程据此凑齐整批再提交
+    const qint64 enqueueTimeNs = LatencyStats::now();
+    for (int i = 0; i < count; ++i) {
+        KeyEvent event = events[i];
+        event.enqueueTimeNs = enqueueTimeNs;
+        if (i + 1 < count) event.flags |= KeyEvent::BatchContinue;
+        else event.flags &= ~KeyEvent::BatchContinue;
+        enqueue(event);
+    }
+    postedCount += count;
+    wake();
+}
+
+// --- enqueue: 入队单个事件 ---
+void KeyInjector::enqueue(const KeyEvent& event) {
+    // 队列满时唤醒消费者并让出时间片，不丢弃事件，以保证按下/释放的顺序
+    while (!queue.push(event)) {
+        wake();
+        std::this_thread::yield();
+    }
+}
+
+// --- wake: 唤醒等待中的工作线程 ---
+void KeyInjector::wake() {
+    // 只有工作线程在等待时才需要加锁唤醒 (push 和 sleeping 都是 seq_cst)
+    if (sleeping.load(std::memory_order_seq_cst)) {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        wakeCondition.notify_one();
+    }
+}
+
+// --- refreshHostLayout: 查询主机布局并更新缓存 (不在 UI 线程的按键路径上调用) ---
+void KeyInjector::refreshHostLayout() {
+    cachedHostLayout.store(injectionBackend->hostLayout(), std::memory_order_relaxed);
+}
+
+// --- flush: 等待此前入队的事件全部注入 ---
+void KeyInjector::flush() {
+    if (!running.load()) return;
+    while (injectedCount.load(std::memory_order_acquire) < postedCount) {
+        std::this_thread::yield();
+    }
+}
+
+// --- shutdown: 排空队列、释放按下的键并停止工作线程 ---
+void KeyInjector::shutdown() {
+    if (!running.load()) return;
+
+    // 先排空队列；flush 之后工作线程空闲，injectedCount 的 acquire 保证可以安全读取 keysDown 和 unicodeDown
+    flush();
+    // 按按下时的扫描码和扩展标志释放 (右 Ctrl/Alt、方向键等不能被当作非扩展的同名键抬起)
+    QVector<KeyEvent> releases;
+    for (int slot = 0; slot < KEY_SLOT_COUNT; ++slot) {
+        if (!keysDown.test(slot)) continue;
+        const int vk = slot & 0xFF;
+        const bool extended = slot >= 256;
+        VK_LOG_DEBUG("关闭时释放仍处于按下状态的键 VK: {x} 扫描码: {x} 扩展: {}", vk, downScanCodes[slot], extended);
+        releases.append(KeyEvent::key(vk, downScanCodes[slot], false, extended));
+    }
+    // Unicode 键按按下顺序抬起 (代理对先高位后低位，与按下时相同)
+    for (char16_t unit : unicodeDown) {
+        VK_LOG_DEBUG("关闭时释放仍处于按下状态的 Unicode 字符 {x}", unsigned(unit));
+        releases.append(KeyEvent::unicode(unit, false));
+    }
+    postBatch(releases.constData(), releases.size());
+    flush();
+
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        running.store(false);
+        wakeCondition.notify_one();
+    }
+    if (worker.joinable()) worker.join();
+}
+
+// --- run: 工作线程主循环 ---
+void KeyInjector::run() {
+    KeyEvent batch[INJECTOR_MAX_BATCH];
+    int batchSize = 0;
+    while (true) {
+        if (queue.pop(batch[batchSize])) {
+            ++batchSize;
+            // 批次结束 (最后一个事件不带 BatchContinue) 或缓冲区已满时提交
+            if (!batch[batchSize - 1].continuesBatch() || batchSize == INJECTOR_MAX_BATCH) {
+                inject(batch, batchSize);
+                injectedCount.fetch_add(batchSize, std::memory_order_release);
+                batchSize = 0;
+                // 注入之后前台窗口可能已切换输入语言 (例如按下了切换语言的组合键)
+                refreshHostLayout();
+            }
+            continue;
+        }
+
+        // 批次只收到一部分: UI 线程正在入队其余事件，短暂让出而不休眠
+        if (batchSize > 0) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        // 队列为空: 等待新事件或停止请求
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        if (!running.load()) break;
+        sleeping.store(true, std::memory_order_seq_cst);
+        const bool woken = wakeCondition.wait_for(lock, INJECTOR_IDLE_WAIT, [this]() { return !queue.empty() || !running.load(); });
+        sleeping.store(false, std::memory_order_relaxed);
+        if (!running.load() && queue.empty()) break;
+        // 空闲超时: 用户可能在前台窗口中切换了输入语言，刷新缓存使下一次按键不必查询
+        if (!woken) {
+            lock.unlock();
+            refreshHostLayout();
+        }
+    }
+}
+
+// --- inject: 把一批事件交给后端 (在工作线程中执行) ---
+void KeyInjector::inject(const KeyEvent* events, int count) {
+    // 跟踪按下状态，关闭时用于释放卡住的键 (按住的 Unicode 键在释放之前同样处于按下状态)
+    for (int i = 0; i < count; ++i) {
+        if (events[i].isUnicode()) {
+            const char16_t unit = char16_t(events[i].scanCode);
+            const int held = unicodeDown.indexOf(unit);
+            if (events[i].isDown()) {
+                if (held < 0) unicodeDown.append(unit); // 自动重复只发送按下，不重复记录
+            } else if (held >= 0) {
+                unicodeDown.remove(held);
+            }
+            continue;
+        }
+        if (events[i].vkCode > 0xFF) continue;
+        const int slot = events[i].vkCode + (events[i].isExtended() ? 256 : 0);
+        keysDown.set(slot, events[i].isDown());
+        if (events[i].isDown()) downScanCodes[slot] = events[i].scanCode;
+    }
+    // 从未启动过时 (同步注入路径) 按需创建默认后端
+    if (!injectionBackend) injectionBackend = createInjectionBackend(QString());
+
+    const qint64 sendStartNs = LatencyStats::now();
+    const int accepted = injectionBackend->send(events, count);
+    const qint64 commitTimeNs = LatencyStats::now();
+
+    // --- 延迟统计 (同步注入路径的事件没有入队时间，不计入) ---
+    latencyStats.record(LatencyStage::BackendSend, commitTimeNs - sendStartNs);
+    for (int i = 0; i < count; ++i) {
+        if (events[i].enqueueTimeNs) latencyStats.record(LatencyStage::EnqueueToCommit, commitTimeNs - events[i].enqueueTimeNs);
+        if (events[i].inputTimeNs) latencyStats.record(LatencyStage::EndToEnd, commitTimeNs - events[i].inputTimeNs);
+    }
+
+    if (accepted != count) {
+        droppedCount.fetch_add(quint64(count - qBound(0, accepted, count)), std::memory_order_relaxed);
+        VK_LOG_WARNING("注入后端 {} 只接受了 {}/{} 个事件", injectionBackend->name(), accepted, count);
+    }
+}
@@ -0,0 +1,80 @@
+#ifndef VIRTUALKEYBOARD_KEYINJECTOR_H
+#define VIRTUALKEYBOARD_KEYINJECTOR_H
+
+#include <atomic>
+#include <bitset>
+#include <condition_variable>
+#include <mutex>
+#include <memory>
+#include <thread>
+#include <QVarLengthArray>
+
+#include "injectionbackend.h"
+#include "keyevent.h"
+#include "latencystats.h"
+#include "spscqueue.h"
+
+// 按键注入工作线程
+// UI 线程 (唯一生产者) 只把紧凑的 KeyEvent 放入无锁队列，
+// 工作线程 (唯一消费者) 按入队顺序取出，凑齐一批 (以不带 BatchContinue 的事件结束) 后
+// 交给 InjectionBackend 一次提交，保证按下/释放的顺序不变。
+class KeyInjector {
+public:
+    KeyInjector() = default;
+    ~KeyInjector();
+
+    KeyInjector(const KeyInjector&) = delete;
+    KeyInjector& operator=(const KeyInjector&) = delete;
+
+    // 使用给定后端启动工作线程 (backend 为空时使用当前平台的默认后端)
+    void start(std::unique_ptr<InjectionBackend> backend = std::unique_ptr<InjectionBackend>());
+    // 当前后端 (start 之后有效)
+    InjectionBackend* backend() const { return injectionBackend.get(); }
+    // 主机键盘布局 (InjectionBackend::hostLayout) 的缓存值，任意线程可读且不调用系统接口；
+    // 注入线程在 start、每批事件之后和空闲时刷新
+    quintptr hostLayout() const { return cachedHostLayout.load(std::memory_order_relaxed); }
+    // 各阶段延迟直方图 (任意线程可读；UI 线程记录前两个阶段，注入线程记录其余阶段)
+    LatencyStats& latency() { return latencyStats; }
+    const LatencyStats& latency() const { return latencyStats; }
+
+    // UI 线程: 入队一个事件。队列满时短暂等待消费者，不丢弃事件，以保证顺序
+    void post(const KeyEvent& event);
+    // UI 线程: 入队一批事件 (例如修饰键组合和按键)，后端会一次提交整批事件
+    void postBatch(const KeyEvent* events, int count);
+    // UI 线程: 阻塞直到此前入队的所有事件都已注入
+    void flush();
+    // 事件计数: 已入队 (只在 UI 线程读取)、已注入、后端报告未被系统接受的事件数
+    quint64 postedEvents() const { return postedCount; }
+    quint64 injectedEvents() const { return injectedCount.load(std::memory_order_acquire); }
+    quint64 droppedEvents() const { return droppedCount.load(std::memory_order_relaxed); }
+    // UI 线程: 排空队列，释放所有仍处于按下状态的键 (避免修饰键卡住)，然后停止工作线程
+    void shutdown();
+
+private:
+    void run();                                      // 工作线程主循环
+    void inject(const KeyEvent* events, int count);  // 在工作线程中提交一批事件
+    void enqueue(const KeyEvent& event);             // 入队单个事件 (不唤醒工作线程)
+    void wake();                                     // 唤醒等待中的工作线程
+    void refreshHostLayout();                        // 查询后端的主机布局并更新缓存
+
+    std::unique_ptr<InjectionBackend> injectionBackend;
+    LatencyStats latencyStats;
+    SpscQueue<KeyEvent, 1024> queue;     // UI 线程 -> 工作线程
+    std::thread worker;
+    std::atomic<bool> running{false};
+    std::atomic<bool> sleeping{false};   // 工作线程是否在等待新事件
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+
+    quint64 postedCount = 0;                  // UI 线程已入队的事件数
+    std::atomic<quint64> injectedCount{0};    // 工作线程已处理的事件数
+    std::atomic<quint64> droppedCount{0};     // 后端未接受的事件数
+    std::atomic<quintptr> cachedHostLayout{0}; // 主机布局的缓存 (注入线程写，UI 线程读)
+    // 工作线程: 当前处于按下状态的键，按 VK 码 + 扩展标志 (扩展键加 256) 区分 (例如主键盘和小键盘的 Enter)
+    static const int KEY_SLOT_COUNT = 512;
+    std::bitset<KEY_SLOT_COUNT> keysDown;
+    quint16 downScanCodes[KEY_SLOT_COUNT] = {}; // 按下时的扫描码 (关闭时按原样释放)
+    QVarLengthArray<char16_t, 8> unicodeDown;   // 处于按下状态的 Unicode 代码单元 (按按下顺序)
+};
+
+#endif // VIRTUALKEYBOARD_KEYINJECTOR_H
@@ -0,0 +1,121 @@
+#include "keyrepeater.h"
+#include "latencystats.h"
+#include "asynclogger.h"
+
+// --- 重复策略表 ---
+// 普通字符键: 500 ms 后每 50 ms 重复一次 (与原先 QPushButton 的设置一致)
+const RepeatPolicy CHARACTER_REPEAT_POLICY = {500, 50, 50, 0};
+
+struct RepeatPolicyRule {
+    int vkCode;
+    RepeatPolicy policy;
+};
+
+// 允许重复的特殊键: 删除和方向键按住时逐渐加速，空格与字符键相同
+const RepeatPolicyRule SPECIAL_REPEAT_POLICIES[] = {
+    {VK_BACK,   {500, 50, 20, 30}},
+    {VK_DELETE, {500, 50, 20, 30}},
+    {VK_SPACE,  {500, 50, 50, 0}},
+    {VK_LEFT,   {400, 40, 15, 40}},
+    {VK_RIGHT,  {400, 40, 15, 40}},
+    {VK_UP,     {400, 50, 25, 20}},
+    {VK_DOWN,   {400, 50, 25, 20}},
+};
+
+// --- intervalAfter: 线性加速的重复间隔 ---
+int RepeatPolicy::intervalAfter(int repeatCount) const {
+    if (rampRepeats == 0 || repeatCount >= rampRepeats) return rampRepeats == 0 ? intervalMs : minIntervalMs;
+    return intervalMs - (intervalMs - minIntervalMs) * repeatCount / rampRepeats;
+}
+
+// --- repeatPolicyFor: 查策略表 ---
+RepeatPolicy repeatPolicyFor(const KeyInfo& keyInfo) {
+    switch (keyInfo.type) {
+        case KeyType::Normal:
+            return CHARACTER_REPEAT_POLICY;
+        case KeyType::Special:
+            for (const RepeatPolicyRule& rule : SPECIAL_REPEAT_POLICIES) {
+                if (rule.vkCode == keyInfo.vkCode) return rule.policy;
+            }
+            return {};
+        default: // 修饰键和切换键不自动重复
+            return {};
+    }
+}
+
+// --- 构造函数 ---
+KeyRepeater::KeyRepeater(QObject *parent) : QObject(parent) {
+    timer.setSingleShot(true);
+    timer.setTimerType(Qt::PreciseTimer);
+    connect(&timer, &QTimer::timeout, this, &KeyRepeater::onTimeout);
+}
+
+// --- setPolicies: 为每个按键建立策略 ---
+void KeyRepeater::setPolicies(const KeyTable& table) {
+    cancel();
+    policies.resize(table.size());
+    for (int keyId = 0; keyId < table.size(); ++keyId) policies[keyId] = repeatPolicyFor(table.info(keyId));
+    enabled.fill(true, table.size());
+}
+
+// --- setEnabled / isEnabled: 单个按键的开关 ---
+void KeyRepeater::setEnabled(int keyId, bool on) {
+    if (keyId < 0 || keyId >= enabled.size()) return;
+    enabled[keyId] = on;
+    if (!on && keyId == activeKey) cancel();
+}
+
+bool KeyRepeater::isEnabled(int keyId) const {
+    return keyId >= 0 && keyId < enabled.size() && enabled[keyId] && policies[keyId].repeats();
+}
+
+// --- press: 可重复的键接替当前的重复 ---
+void KeyRepeater::press(int keyId, qint64 pressNs) {
+    if (!isEnabled(keyId)) return;
+    activeKey = keyId;
+    repeatCount = 0;
+    deadlineNs = pressNs + qint64(policies[keyId].delayMs) * 1000000;
+    arm(LatencyStats::now());
+}
+
+// --- release: 正在重复的键松开时停止 ---
+void KeyRepeater::release(int keyId) {
+    if (keyId == activeKey) cancel();
+}
+
+// --- cancel: 停止重复 ---
+void KeyRepeater::cancel() {
+    activeKey = -1;
+    timer.stop();
+}
+
+// --- arm: 向上取整到毫秒，定时器不会在 deadlineNs 之前触发 ---
+void KeyRepeater::arm(qint64 nowNs) {
+    const qint64 remainingNs = deadlineNs - nowNs;
+    timer.start(remainingNs <= 0 ? 0 : int((remainingNs + 999999) / 1000000));
+}
+
+// --- onTimeout: 发出一次重复，下一次的时刻从上一次的时刻累加 ---
+void KeyRepeater::onTimeout() {
+    if (activeKey < 0) return;
+    const qint64 nowNs = LatencyStats::now();
+    if (nowNs < deadlineNs) { // 定时器提前触发 (毫秒精度)
+        arm(nowNs);
+        return;
+    }
+    const int keyId = activeKey;
+    const RepeatPolicy& keyPolicy = policies[keyId];
+    deadlineNs += qint64(keyPolicy.intervalAfter(++repeatCount)) * 1000000;
+    // 落后超过一个间隔 (UI 线程被阻塞): 跳过错过的重复，保持原来的节奏
+    int missed = 0;
+    while (deadlineNs <= nowNs) {
+        deadlineNs += qint64(keyPolicy.intervalAfter(++repeatCount)) * 1000000;
+        ++missed;
+    }
+    if (missed > 0) {
+        skipped += missed;
+        VK_LOG_DEBUG("自动重复落后，跳过 {} 次", missed);
+    }
+    arm(nowNs);
+    emit repeat(keyId); // 接收者可能调用 cancel()/release()，放在最后
+}
@@ -0,0 +1,72 @@
+#ifndef VIRTUALKEYBOARD_KEYREPEATER_H
+#define VIRTUALKEYBOARD_KEYREPEATER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QVector>
+
+#include "keytable.h"
+
+// 按键的自动重复策略 (delayMs 为 0 表示不重复)
+// 重复间隔从 intervalMs 开始，经过 rampRepeats 次重复线性加速到 minIntervalMs
+struct RepeatPolicy {
+    quint16 delayMs = 0;       // 按下到第一次重复 (毫秒)
+    quint16 intervalMs = 0;    // 初始重复间隔
+    quint16 minIntervalMs = 0; // 加速后的间隔 (等于 intervalMs 表示不加速)
+    quint16 rampRepeats = 0;   // 加速经过的重复次数
+
+    bool repeats() const { return delayMs > 0; }
+    // 第 repeatCount 次重复 (从 1 开始) 之后到下一次重复的间隔 (毫秒)
+    int intervalAfter(int repeatCount) const;
+};
+
+// 按键的默认重复策略 (按 VK 码查策略表；普通字符键使用字符键策略，修饰键和切换键不重复)
+RepeatPolicy repeatPolicyFor(const KeyInfo& keyInfo);
+
+// 自动重复调度器: 所有按键 (按钮、画布、触摸) 共用一个高精度定时器
+// 与硬件的 typematic 重复一致，只有最近按下的可重复键会重复；按下修饰键等不重复的键不打断当前的重复。
+// 重复时刻按按下时间和策略累加 (不以定时器实际触发的时间为基准)，负载下不会漂移；
+// 落后超过一个间隔时跳过错过的重复而不是连发。
+class KeyRepeater : public QObject {
+Q_OBJECT
+
+public:
+    explicit KeyRepeater(QObject *parent = nullptr);
+
+    // 按 repeatPolicyFor 为表中的每个按键建立策略 (全部启用)
+    void setPolicies(const KeyTable& table);
+    // 启用/禁用某个按键的重复 (例如绑定了宏的键)，禁用正在重复的键会立即停止
+    void setEnabled(int keyId, bool enabled);
+    bool isEnabled(int keyId) const;
+    const RepeatPolicy& policy(int keyId) const { return policies[keyId]; }
+
+    // 按键在 pressNs (LatencyStats::now() 时基) 按下
+    void press(int keyId, qint64 pressNs);
+    // 按键释放 (不是正在重复的键时忽略)
+    void release(int keyId);
+    // 停止重复
+    void cancel();
+
+    int repeatingKey() const { return activeKey; } // -1 表示没有
+    quint64 skippedRepeats() const { return skipped; } // 因落后而跳过的重复次数
+
+signals:
+    // 一次重复 (接收者只发送按下事件)
+    void repeat(int keyId);
+
+private slots:
+    void onTimeout();
+
+private:
+    void arm(qint64 nowNs); // 按 deadlineNs 启动定时器
+
+    QVector<RepeatPolicy> policies; // 按 id 索引
+    QVector<bool> enabled;          // 按 id 索引
+    QTimer timer;
+    int activeKey = -1;
+    int repeatCount = 0;            // 当前按键已经重复的次数
+    qint64 deadlineNs = 0;          // 下一次重复的时刻
+    quint64 skipped = 0;
+};
+
+#endif // VIRTUALKEYBOARD_KEYREPEATER_H
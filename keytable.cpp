@@ -0,0 +1,94 @@
+#include "keytable.h"
+
+// --- modifierGroupFor: 根据 VK 码确定修饰键分组 ---
+static ModifierGroup modifierGroupFor(int vkCode) {
+    switch (vkCode) {
+        case VK_LSHIFT: case VK_RSHIFT: return ModifierGroup::Shift;
+        case VK_LCONTROL: case VK_RCONTROL: return ModifierGroup::Ctrl;
+        case VK_LMENU: case VK_RMENU: return ModifierGroup::Alt;
+        case VK_LWIN: case VK_RWIN: return ModifierGroup::Win;
+        case VK_CAPITAL: return ModifierGroup::CapsLock;
+        case VK_NUMLOCK: return ModifierGroup::NumLock;
+        case VK_SCROLL: return ModifierGroup::ScrollLock;
+        default: return ModifierGroup::None;
+    }
+}
+
+// --- build: 从完整布局构建按键表 ---
+void KeyTable::build(KeyboardLayout& fullLayout) {
+    entries.clear();
+    infos.clear();
+    labels.clear();
+    for (auto& keys : dependentKeys) keys.clear();
+    charKeys.clear();
+
+    for (auto& row : fullLayout) {
+        for (auto& keyInfo : row) {
+            // 完全空的占位符不会生成按钮，也不需要 id
+            if (keyInfo.vkCode == 0 && keyInfo.text.isEmpty()) continue;
+
+            keyInfo.keyId = entries.size();
+
+            KeyEntry entry;
+            entry.vkCode = static_cast<quint16>(keyInfo.vkCode);
+            entry.scanCode = static_cast<quint16>(keyInfo.scanCode);
+            entry.type = keyInfo.type;
+            if (keyInfo.type == KeyType::ModifierSticky || keyInfo.type == KeyType::ModifierToggle) {
+                entry.modifier = modifierGroupFor(keyInfo.vkCode);
+            }
+            if (keyInfo.isExtendedKey) entry.flags |= KeyEntry::ExtendedKey;
+            if (isCaseLetterKey(keyInfo)) entry.flags |= KeyEntry::LetterKey;
+            if (!keyInfo.shiftedText.isEmpty()) entry.flags |= KeyEntry::HasShifted;
+
+            // --- 视觉依赖 ---
+            // 字母文本随 Shift 和 CapsLock 变化，符号文本只随 Shift 变化，修饰键/切换键随自身状态高亮
+            if (keyInfo.type == KeyType::Normal && (entry.flags & KeyEntry::HasShifted)) {
+                entry.dependsOn = (entry.flags & KeyEntry::LetterKey) ? (ShiftBit | CapsLockBit) : ShiftBit;
+            }
+            entry.dependsOn |= stateBit(entry.modifier);
+            for (int bit = 0; bit < MODIFIER_STATE_BIT_COUNT; ++bit) {
+                if (entry.dependsOn & (1u << bit)) dependentKeys[bit].append(keyInfo.keyId);
+            }
+
+            // --- 预先计算每种 Shift/CapsLock 组合的文本 ---
+            labels.append(keyLabelForState(keyInfo, false, false));
+            labels.append(keyLabelForState(keyInfo, true, false));
+            labels.append(keyLabelForState(keyInfo, false, true));
+            labels.append(keyLabelForState(keyInfo, true, true));
+
+            // --- 字符 -> 按键 (同一字符出现在多个键上时使用第一个；小键盘的键受 NumLock 影响，不参与) ---
+            const bool numpad = isNumpadKey(keyInfo);
+            if (keyInfo.type == KeyType::Normal && !numpad) {
+                if (entry.flags & KeyEntry::LetterKey) {
+                    const QChar letter = keyInfo.text.at(0);
+                    charKeys.insert(letter.toLower().unicode(), { keyInfo.keyId, false, true });
+                    charKeys.insert(letter.toUpper().unicode(), { keyInfo.keyId, true, true });
+                } else {
+                    if (keyInfo.text.length() == 1 && !charKeys.contains(keyInfo.text.at(0).unicode())) {
+                        charKeys.insert(keyInfo.text.at(0).unicode(), { keyInfo.keyId, false, false });
+                    }
+                    if (keyInfo.shiftedText.length() == 1 && !charKeys.contains(keyInfo.shiftedText.at(0).unicode())) {
+                        charKeys.insert(keyInfo.shiftedText.at(0).unicode(), { keyInfo.keyId, true, false });
+                    }
+                }
+            } else if (!numpad && (keyInfo.vkCode == VK_SPACE || keyInfo.vkCode == VK_RETURN || keyInfo.vkCode == VK_TAB)) {
+                const char16_t ch = keyInfo.vkCode == VK_SPACE ? u' ' : keyInfo.vkCode == VK_RETURN ? u'\n' : u'\t';
+                if (!charKeys.contains(ch)) charKeys.insert(ch, { keyInfo.keyId, false, false });
+            }
+
+            entries.append(entry);
+            infos.append(keyInfo);
+        }
+    }
+}
+
+// --- visualStyle: 按键在给定状态下的视觉样式 ---
+KeyVisualStyle KeyTable::visualStyle(int keyId, quint8 stateBits) const {
+    const KeyEntry& key = entries[keyId];
+    const bool isActive = (stateBits & stateBit(key.modifier)) != 0;
+    if (key.type == KeyType::ModifierSticky && isActive) return KeyVisualStyle::ModifierActive;
+    if (key.type == KeyType::ModifierToggle && isActive) return KeyVisualStyle::ToggleActive;
+    // 空格键在按钮模式中使用 SpaceKey 对象名，其外观与普通键相同
+    if (key.type == KeyType::Normal || key.vkCode == VK_SPACE) return KeyVisualStyle::Normal;
+    return KeyVisualStyle::Special;
+}
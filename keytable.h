@@ -0,0 +1,111 @@
+#ifndef VIRTUALKEYBOARD_KEYTABLE_H
+#define VIRTUALKEYBOARD_KEYTABLE_H
+
+#include <QHash>
+#include <QVector>
+#include "keyboardlayout.h" // 包含键盘布局定义
+
+// 按键所属的修饰键/切换键分组 (非修饰键为 None)
+enum class ModifierGroup : quint8 {
+    None,
+    Shift,
+    Ctrl,
+    Alt,
+    Win,
+    CapsLock,
+    NumLock,
+    ScrollLock
+};
+
+// 修饰键/切换键状态位 (与 ModifierGroup 一一对应: 位序号 = int(group) - 1)
+enum ModifierStateBit : quint8 {
+    ShiftBit      = 0x01,
+    CtrlBit       = 0x02,
+    AltBit        = 0x04,
+    WinBit        = 0x08,
+    CapsLockBit   = 0x10,
+    NumLockBit    = 0x20,
+    ScrollLockBit = 0x40
+};
+const int MODIFIER_STATE_BIT_COUNT = 7;
+
+// 按键的视觉样式 (按钮模式下对应 QSS 的 objectName)
+enum class KeyVisualStyle : quint8 {
+    Normal,         // 普通键 (以及空格键)
+    Special,        // 特殊键/未激活的修饰键 ("SpecialKey")
+    ModifierActive, // 按下的粘滞修饰键 ("ModifierActive")
+    ToggleActive    // 激活的切换键 ("ToggleActive")
+};
+
+// 按下路径上使用的紧凑按键数据 (POD，不含 QString)
+struct KeyEntry {
+    quint16 vkCode = 0;     // Windows 虚拟键码
+    quint16 scanCode = 0;   // 硬件扫描码
+    KeyType type = KeyType::Normal;            // 按键类型
+    ModifierGroup modifier = ModifierGroup::None; // 修饰键分组
+    quint8 flags = 0;       // KeyEntryFlag 组合
+    quint8 dependsOn = 0;   // 视觉上依赖的 ModifierStateBit 组合 (文本或高亮随这些状态变化)
+
+    bool isExtended() const { return flags & ExtendedKey; }
+
+    enum KeyEntryFlag : quint8 {
+        ExtendedKey = 0x01, // 扩展键 (KEYEVENTF_EXTENDEDKEY)
+        LetterKey   = 0x02, // 字母键 (文本受 CapsLock 影响)
+        HasShifted  = 0x04  // 定义了 shifted 文本
+    };
+};
+
+// 产生某个字符的按键 (用于把文本转换为按键事件)
+struct CharKey {
+    int keyId = -1;       // -1 表示当前布局不能直接输入该字符
+    bool shifted = false; // 需要 Shift 状态 (字母键表示大写)
+    bool letter = false;  // 字母键: 实际是否按 Shift 还取决于 CapsLock
+};
+
+// 扁平的、按 id 索引的按键表
+// 由完整布局构建一次；按钮或命中区域只保存一个小整数 id，
+// 按下/释放处理和视觉更新直接按 id 取数据，不经过 QVariant 和元类型系统。
+class KeyTable {
+public:
+    // 从完整布局构建按键表，并把分配的 id 写回布局中的 KeyInfo::keyId
+    void build(KeyboardLayout& fullLayout);
+
+    int size() const { return entries.size(); }
+    // 热路径数据 (按下/释放处理)
+    const KeyEntry& entry(int keyId) const { return entries[keyId]; }
+    // 冷数据 (显示文本等)
+    const KeyInfo& info(int keyId) const { return infos[keyId]; }
+
+    // --- 视觉依赖 ---
+    // 依赖某个状态位的所有按键 id (bitIndex 为 ModifierStateBit 的位序号)
+    const QVector<int>& dependents(int bitIndex) const { return dependentKeys[bitIndex]; }
+    // 预先计算好的显示文本 (只取 stateBits 中的 Shift/CapsLock 位)
+    const QString& label(int keyId, quint8 stateBits) const {
+        return labels[keyId * 4 + ((stateBits & ShiftBit) ? 1 : 0) + ((stateBits & CapsLockBit) ? 2 : 0)];
+    }
+    // 按键在给定状态下的视觉样式
+    KeyVisualStyle visualStyle(int keyId, quint8 stateBits) const;
+    // 能输入字符 ch 的按键 (空格、回车和 Tab 对应各自的特殊键)
+    CharKey keyForChar(QChar ch) const { return charKeys.value(ch.unicode()); }
+    // 参与概率触摸定位和滑行输入的字母: 文本为单个字母的普通键，其余按键为空字符。
+    // 画布、按钮容器和滑行模板都通过它取字母，各路径的按键集合保持一致
+    static QChar touchLetter(const KeyInfo& keyInfo) {
+        const bool letter = keyInfo.type == KeyType::Normal && keyInfo.text.size() == 1 && keyInfo.text.at(0).isLetter();
+        return letter ? keyInfo.text.at(0) : QChar();
+    }
+    QChar touchLetter(int keyId) const { return touchLetter(infos[keyId]); }
+
+    // 修饰键分组对应的状态位 (None 返回 0)
+    static quint8 stateBit(ModifierGroup group) {
+        return group == ModifierGroup::None ? 0 : quint8(1u << (int(group) - 1));
+    }
+
+private:
+    QVector<KeyEntry> entries; // 按 id 索引的紧凑按键数据
+    QVector<KeyInfo> infos;    // 按 id 索引的完整按键信息
+    QVector<QString> labels;   // 每个按键 4 个文本: [Shift][CapsLock] 组合
+    QVector<int> dependentKeys[MODIFIER_STATE_BIT_COUNT]; // 每个状态位的依赖按键列表
+    QHash<char16_t, CharKey> charKeys; // 字符 -> 按键
+};
+
+#endif // VIRTUALKEYBOARD_KEYTABLE_H
@@ -0,0 +1,145 @@
+#include "latencystats.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QtAlgorithms> // qCountLeadingZeroBits
+#include <chrono>
+
+// --- bucketFor: 值 -> 桶下标 ---
+int LatencyHistogram::bucketFor(quint64 ns) {
+    if (ns < quint64(SUB_BUCKET_COUNT)) return int(ns);
+    const int msb = 63 - int(qCountLeadingZeroBits(ns)); // 最高位位置 (>= SUB_BUCKET_BITS)
+    if (msb >= MAX_VALUE_BITS) return BUCKET_COUNT - 1;
+    const int shift = msb - SUB_BUCKET_BITS;
+    const int subBucket = int((ns >> shift) & (SUB_BUCKET_COUNT - 1)); // 最高位之后的 SUB_BUCKET_BITS 位
+    return SUB_BUCKET_COUNT + shift * SUB_BUCKET_COUNT + subBucket;
+}
+
+// --- bucketUpperBound: 桶 -> 桶内最大值 ---
+quint64 LatencyHistogram::bucketUpperBound(int bucket) {
+    if (bucket < SUB_BUCKET_COUNT) return quint64(bucket);
+    const int shift = (bucket - SUB_BUCKET_COUNT) / SUB_BUCKET_COUNT;
+    const quint64 subBucket = quint64((bucket - SUB_BUCKET_COUNT) % SUB_BUCKET_COUNT);
+    const quint64 lowerBound = (quint64(SUB_BUCKET_COUNT) + subBucket) << shift;
+    return lowerBound + (quint64(1) << shift) - 1;
+}
+
+// --- record: 记录一个值 (无锁) ---
+void LatencyHistogram::record(qint64 ns) {
+    const quint64 value = ns > 0 ? quint64(ns) : 0;
+    buckets[bucketFor(value)].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    sumNs.fetch_add(value, std::memory_order_relaxed);
+    quint64 previousMax = maxNs.load(std::memory_order_relaxed);
+    while (value > previousMax && !maxNs.compare_exchange_weak(previousMax, value, std::memory_order_relaxed)) {}
+}
+
+// --- snapshot: 复制当前计数 ---
+// 与写入并发时各字段之间可能相差几个样本，对统计没有影响
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const {
+    Snapshot result;
+    result.buckets.resize(BUCKET_COUNT);
+    for (int i = 0; i < BUCKET_COUNT; ++i) result.buckets[i] = buckets[i].load(std::memory_order_relaxed);
+    result.count = count.load(std::memory_order_relaxed);
+    result.sumNs = sumNs.load(std::memory_order_relaxed);
+    result.maxNs = maxNs.load(std::memory_order_relaxed);
+    return result;
+}
+
+void LatencyHistogram::reset() {
+    for (auto& bucket : buckets) bucket.store(0, std::memory_order_relaxed);
+    count.store(0, std::memory_order_relaxed);
+    sumNs.store(0, std::memory_order_relaxed);
+    maxNs.store(0, std::memory_order_relaxed);
+}
+
+// --- percentileNs: 百分位数 ---
+quint64 LatencyHistogram::Snapshot::percentileNs(double percent) const {
+    quint64 total = 0;
+    for (quint64 bucketCount : buckets) total += bucketCount;
+    if (total == 0) return 0;
+    // 需要覆盖的样本数 (至少 1 个)
+    const quint64 target = qMax<quint64>(1, quint64(percent / 100.0 * double(total) + 0.5));
+    quint64 seen = 0;
+    for (int i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= target) return qMin(bucketUpperBound(i), maxNs);
+    }
+    return maxNs;
+}
+
+// --- now: 单调时钟 ---
+qint64 LatencyStats::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+const char* LatencyStats::stageName(LatencyStage stage) {
+    switch (stage) {
+        case LatencyStage::InputToHandler: return "inputToHandler";
+        case LatencyStage::HandlerToEnqueue: return "handlerToEnqueue";
+        case LatencyStage::EnqueueToCommit: return "enqueueToCommit";
+        case LatencyStage::BackendSend: return "backendSend";
+        case LatencyStage::EndToEnd: return "endToEnd";
+        case LatencyStage::TouchToKeyDown: return "touchToKeyDown";
+        default: return "unknown";
+    }
+}
+
+void LatencyStats::reset() {
+    for (auto& histogram : histograms) histogram.reset();
+}
+
+// --- summary: 文本摘要 ---
+QString LatencyStats::summary() const {
+    QString text;
+    for (int i = 0; i < STAGE_COUNT; ++i) {
+        const LatencyHistogram::Snapshot snapshot = histograms[i].snapshot();
+        text += QStringLiteral("%1: n=%2 mean=%3us p50=%4us p90=%5us p99=%6us max=%7us\n")
+                        .arg(QString::fromLatin1(stageName(LatencyStage(i))), -16)
+                        .arg(snapshot.count)
+                        .arg(snapshot.meanNs() / 1000.0, 0, 'f', 1)
+                        .arg(snapshot.percentileNs(50) / 1000.0, 0, 'f', 1)
+                        .arg(snapshot.percentileNs(90) / 1000.0, 0, 'f', 1)
+                        .arg(snapshot.percentileNs(99) / 1000.0, 0, 'f', 1)
+                        .arg(snapshot.maxNs / 1000.0, 0, 'f', 1);
+    }
+    return text;
+}
+
+// --- writeJson: 写出各阶段的统计和非空桶 ---
+// 格式: {"stages":[{"name":..., "count":..., "meanNs":..., "p50Ns":..., "p90Ns":..., "p99Ns":..., "maxNs":...,
+//                   "buckets":[[上界ns, 次数], ...]}, ...]}
+bool LatencyStats::writeJson(const QString& path) const {
+    QJsonArray stages;
+    for (int i = 0; i < STAGE_COUNT; ++i) {
+        const LatencyHistogram::Snapshot snapshot = histograms[i].snapshot();
+        QJsonArray buckets;
+        for (int bucket = 0; bucket < snapshot.buckets.size(); ++bucket) {
+            if (snapshot.buckets[bucket] == 0) continue;
+            buckets.append(QJsonArray{ double(LatencyHistogram::bucketUpperBound(bucket)), double(snapshot.buckets[bucket]) });
+        }
+        QJsonObject stage;
+        stage.insert(QStringLiteral("name"), QString::fromLatin1(stageName(LatencyStage(i))));
+        stage.insert(QStringLiteral("count"), double(snapshot.count));
+        stage.insert(QStringLiteral("meanNs"), snapshot.meanNs());
+        stage.insert(QStringLiteral("p50Ns"), double(snapshot.percentileNs(50)));
+        stage.insert(QStringLiteral("p90Ns"), double(snapshot.percentileNs(90)));
+        stage.insert(QStringLiteral("p99Ns"), double(snapshot.percentileNs(99)));
+        stage.insert(QStringLiteral("maxNs"), double(snapshot.maxNs));
+        stage.insert(QStringLiteral("buckets"), buckets);
+        stages.append(stage);
+    }
+    QJsonObject root;
+    root.insert(QStringLiteral("stages"), stages);
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) ||
+        file.write(QJsonDocument(root).toJson(QJsonDocument::Indented)) < 0) {
+        qWarning() << "无法写入延迟直方图:" << path << file.errorString();
+        return false;
+    }
+    return true;
+}
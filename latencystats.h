@@ -0,0 +1,83 @@
+#ifndef VIRTUALKEYBOARD_LATENCYSTATS_H
+#define VIRTUALKEYBOARD_LATENCYSTATS_H
+
+#include <QString>
+#include <QVector>
+#include <atomic>
+
+// 固定大小、无锁的对数-线性 (HDR 风格) 延迟直方图
+// 小于 32ns 的值每纳秒一个桶；之后每个 2 的幂区间分成 32 个子桶，相对误差不超过 1/32。
+// 覆盖到 2^40ns (约 18 分钟)，更大的值计入最后一个桶。
+// record 只做一次前导零计数和几次 relaxed 原子加，可以在任意线程调用，适合常开。
+class LatencyHistogram {
+public:
+    static const int SUB_BUCKET_BITS = 5;
+    static const int SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+    static const int MAX_VALUE_BITS = 40;
+    static const int BUCKET_COUNT = SUB_BUCKET_COUNT + (MAX_VALUE_BITS - SUB_BUCKET_BITS) * SUB_BUCKET_COUNT;
+
+    // 直方图在某一时刻的副本 (读取时不阻塞写入者)
+    struct Snapshot {
+        quint64 count = 0;
+        quint64 sumNs = 0;
+        quint64 maxNs = 0;
+        QVector<quint64> buckets;
+
+        double meanNs() const { return count ? double(sumNs) / double(count) : 0.0; }
+        // 百分位数 (0-100)，返回所在桶的上界
+        quint64 percentileNs(double percent) const;
+    };
+
+    LatencyHistogram() { reset(); }
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    // 记录一个延迟 (纳秒，负值按 0 处理)
+    void record(qint64 ns);
+    Snapshot snapshot() const;
+    void reset();
+
+    static int bucketFor(quint64 ns);
+    static quint64 bucketUpperBound(int bucket); // 桶内最大值
+
+private:
+    std::atomic<quint64> buckets[BUCKET_COUNT];
+    std::atomic<quint64> count;
+    std::atomic<quint64> sumNs;
+    std::atomic<quint64> maxNs;
+};
+
+// 按下到注入的各阶段
+enum class LatencyStage : int {
+    InputToHandler,   // 输入事件到达键盘控件 -> onKeyPressed/onKeyReleased 入口
+    HandlerToEnqueue, // 处理函数入口 -> 事件进入注入队列
+    EnqueueToCommit,  // 入队 -> 后端提交完成 (注入线程)
+    BackendSend,      // 后端一次 send 调用的耗时 (每批一次)
+    EndToEnd,         // 输入事件 -> 后端提交完成
+    TouchToKeyDown,   // 触摸事件到达键盘控件 -> 按下事件进入注入队列 (只统计由触摸按下的键)
+    Count
+};
+
+// 各阶段的延迟直方图
+class LatencyStats {
+public:
+    static const int STAGE_COUNT = int(LatencyStage::Count);
+
+    // 单调时钟 (纳秒)，所有阶段共用
+    static qint64 now();
+    static const char* stageName(LatencyStage stage);
+
+    void record(LatencyStage stage, qint64 ns) { histograms[int(stage)].record(ns); }
+    const LatencyHistogram& histogram(LatencyStage stage) const { return histograms[int(stage)]; }
+    void reset();
+
+    // 文本摘要 (每个阶段一行: 次数、平均、p50/p90/p99、最大，单位微秒)
+    QString summary() const;
+    // 写出 JSON (包括非空的桶，便于离线合并)
+    bool writeJson(const QString& path) const;
+
+private:
+    LatencyHistogram histograms[STAGE_COUNT];
+};
+
+#endif // VIRTUALKEYBOARD_LATENCYSTATS_H
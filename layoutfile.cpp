@@ -0,0 +1,404 @@
+#include "layoutfile.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QVector>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+// --- 二进制缓存格式 ---
+// [CacheHeader][CachedKey x keyCount][SplitKey x leftCount][SplitKey x rightCount][UTF-16 字符串池]
+// 全部使用本机字节序 (缓存只在本机生成和使用)
+namespace {
+
+const char CACHE_MAGIC[4] = { 'V', 'K', 'L', 'C' };
+const quint32 CACHE_VERSION = 1;
+const int LAYOUT_FILE_MAX_ROWS = 32;     // 布局文件允许的最大行数
+const int LAYOUT_FILE_MAX_COLUMNS = 64;  // 布局文件允许的最大列数
+
+struct CacheHeader {
+    char magic[4];       // "VKLC"
+    quint32 version;     // CACHE_VERSION
+    qint64 sourceMtime;  // 源文件修改时间 (毫秒)
+    qint64 sourceSize;   // 源文件大小
+    quint32 keyCount;    // 按键数
+    quint32 leftCount;   // 左半按键数
+    quint32 rightCount;  // 右半按键数
+    quint32 poolLength;  // 字符串池长度 (UTF-16 码元)
+};
+
+struct CachedKey {
+    quint32 textOffset;    // 文本在字符串池中的位置
+    quint32 shiftedOffset; // Shift 文本在字符串池中的位置
+    quint16 textLength;
+    quint16 shiftedLength;
+    quint16 vkCode;
+    quint16 scanCode;
+    quint8 type;           // KeyType
+    quint8 row;
+    quint8 column;
+    quint8 columnSpan;
+    quint8 extended;
+    quint8 reserved[3];
+};
+
+static_assert(sizeof(CacheHeader) == 40, "CacheHeader 大小应固定");
+static_assert(sizeof(CachedKey) == 24, "CachedKey 大小应固定");
+static_assert(sizeof(SplitKey) == 16, "SplitKey 大小应固定");
+
+const CacheHeader* headerOf(const uchar* data) { return reinterpret_cast<const CacheHeader*>(data); }
+const CachedKey* keysOf(const uchar* data) { return reinterpret_cast<const CachedKey*>(data + sizeof(CacheHeader)); }
+const SplitKey* leftKeysOf(const uchar* data) {
+    return reinterpret_cast<const SplitKey*>(keysOf(data) + headerOf(data)->keyCount);
+}
+const SplitKey* rightKeysOf(const uchar* data) { return leftKeysOf(data) + headerOf(data)->leftCount; }
+const char16_t* poolOf(const uchar* data) {
+    return reinterpret_cast<const char16_t*>(rightKeysOf(data) + headerOf(data)->rightCount);
+}
+
+// 缓存文件的预期大小
+qint64 cacheSizeFor(const CacheHeader& header) {
+    return qint64(sizeof(CacheHeader)) + qint64(header.keyCount) * sizeof(CachedKey) +
+           (qint64(header.leftCount) + header.rightCount) * sizeof(SplitKey) + qint64(header.poolLength) * 2;
+}
+
+// --- VK 名称表 (布局文件中可以使用的 VK_* 名称) ---
+struct VkName {
+    const char* name;
+    int vkCode;
+};
+
+const VkName VK_NAMES[] = {
+    { "VK_SHIFT", VK_SHIFT }, { "VK_LSHIFT", VK_LSHIFT }, { "VK_RSHIFT", VK_RSHIFT },
+    { "VK_CONTROL", VK_CONTROL }, { "VK_LCONTROL", VK_LCONTROL }, { "VK_RCONTROL", VK_RCONTROL },
+    { "VK_MENU", VK_MENU }, { "VK_LMENU", VK_LMENU }, { "VK_RMENU", VK_RMENU },
+    { "VK_LWIN", VK_LWIN }, { "VK_RWIN", VK_RWIN }, { "VK_APPS", VK_APPS },
+    { "VK_CAPITAL", VK_CAPITAL }, { "VK_NUMLOCK", VK_NUMLOCK }, { "VK_SCROLL", VK_SCROLL },
+    { "VK_BACK", VK_BACK }, { "VK_TAB", VK_TAB }, { "VK_RETURN", VK_RETURN },
+    { "VK_ESCAPE", VK_ESCAPE }, { "VK_SPACE", VK_SPACE },
+    { "VK_PRIOR", VK_PRIOR }, { "VK_NEXT", VK_NEXT }, { "VK_END", VK_END }, { "VK_HOME", VK_HOME },
+    { "VK_LEFT", VK_LEFT }, { "VK_UP", VK_UP }, { "VK_RIGHT", VK_RIGHT }, { "VK_DOWN", VK_DOWN },
+    { "VK_INSERT", VK_INSERT }, { "VK_DELETE", VK_DELETE }, { "VK_SNAPSHOT", VK_SNAPSHOT }, { "VK_PAUSE", VK_PAUSE },
+    { "VK_F1", VK_F1 }, { "VK_F2", VK_F2 }, { "VK_F3", VK_F3 }, { "VK_F4", VK_F4 },
+    { "VK_F5", VK_F5 }, { "VK_F6", VK_F6 }, { "VK_F7", VK_F7 }, { "VK_F8", VK_F8 },
+    { "VK_F9", VK_F9 }, { "VK_F10", VK_F10 }, { "VK_F11", VK_F11 }, { "VK_F12", VK_F12 },
+    { "VK_OEM_1", VK_OEM_1 }, { "VK_OEM_2", VK_OEM_2 }, { "VK_OEM_3", VK_OEM_3 }, { "VK_OEM_4", VK_OEM_4 },
+    { "VK_OEM_5", VK_OEM_5 }, { "VK_OEM_6", VK_OEM_6 }, { "VK_OEM_7", VK_OEM_7 },
+    { "VK_OEM_MINUS", VK_OEM_MINUS }, { "VK_OEM_PLUS", VK_OEM_PLUS },
+    { "VK_OEM_COMMA", VK_OEM_COMMA }, { "VK_OEM_PERIOD", VK_OEM_PERIOD }, { "VK_OEM_8", VK_OEM_8 },
+    { "VK_NUMPAD0", VK_NUMPAD0 }, { "VK_NUMPAD1", VK_NUMPAD1 }, { "VK_NUMPAD2", VK_NUMPAD2 }, { "VK_NUMPAD3", VK_NUMPAD3 },
+    { "VK_NUMPAD4", VK_NUMPAD4 }, { "VK_NUMPAD5", VK_NUMPAD5 }, { "VK_NUMPAD6", VK_NUMPAD6 }, { "VK_NUMPAD7", VK_NUMPAD7 },
+    { "VK_NUMPAD8", VK_NUMPAD8 }, { "VK_NUMPAD9", VK_NUMPAD9 },
+    { "VK_MULTIPLY", VK_MULTIPLY }, { "VK_ADD", VK_ADD }, { "VK_SUBTRACT", VK_SUBTRACT },
+    { "VK_DECIMAL", VK_DECIMAL }, { "VK_DIVIDE", VK_DIVIDE }
+};
+
+// --- parseVkCode: 解析 VK 字段 ---
+bool parseVkCode(const QByteArray& token, int& vkCode) {
+    if (token.size() == 1) { vkCode = static_cast<unsigned char>(token.at(0)); return true; } // 字符码，如 A、1
+    if (token.startsWith("VK_")) {
+        for (const VkName& entry : VK_NAMES) {
+            if (token == entry.name) { vkCode = entry.vkCode; return true; }
+        }
+        return false;
+    }
+    bool ok = false;
+    vkCode = token.toInt(&ok, 0);
+    return ok;
+}
+
+// --- parseKeyType: 解析类型字段 ---
+bool parseKeyType(const QByteArray& token, KeyType& type) {
+    if (token == "normal") type = KeyType::Normal;
+    else if (token == "sticky") type = KeyType::ModifierSticky;
+    else if (token == "toggle") type = KeyType::ModifierToggle;
+    else if (token == "special") type = KeyType::Special;
+    else if (token == "layout") type = KeyType::LayoutSwitch;
+    else return false;
+    return true;
+}
+
+// --- parseSide: 解析侧字段 ---
+bool parseSide(const QByteArray& token, KeySide& side) {
+    if (token == "left") side = KeySide::Left;
+    else if (token == "right") side = KeySide::Right;
+    else if (token == "both") side = KeySide::Both;
+    else if (token == "none") side = KeySide::None;
+    else return false;
+    return true;
+}
+
+// --- unescapeText: 处理文本字段中的转义 ---
+QByteArray unescapeText(const QByteArray& token) {
+    QByteArray text;
+    text.reserve(token.size());
+    for (int i = 0; i < token.size(); ++i) {
+        if (token.at(i) == '\\' && i + 1 < token.size()) {
+            const char next = token.at(++i);
+            text.append(next == 's' ? ' ' : next);
+        } else {
+            text.append(token.at(i));
+        }
+    }
+    return text;
+}
+
+void setError(QString* errorMessage, const QString& message) {
+    if (errorMessage) *errorMessage = message;
+}
+
+// 已打开的布局文件 (进程结束时才释放，因为 KeyInfo 文本直接引用其映射内存)
+std::vector<std::unique_ptr<LayoutFile>>& openedLayoutFiles() {
+    static std::vector<std::unique_ptr<LayoutFile>> files;
+    return files;
+}
+
+} // namespace
+
+// --- cachePathFor: 布局文件对应的缓存路径 ---
+// 缓存文件名包含源文件绝对路径的哈希，不同目录下的同名布局互不干扰
+QString LayoutFile::cachePathFor(const QString& sourcePath) {
+    const QFileInfo sourceInfo(sourcePath);
+    const QByteArray pathHash = QCryptographicHash::hash(sourceInfo.absoluteFilePath().toUtf8(), QCryptographicHash::Sha1).toHex().left(12);
+    const QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/layouts");
+    return cacheDir + QLatin1Char('/') + sourceInfo.completeBaseName() + QLatin1Char('-') + QString::fromLatin1(pathHash) + QStringLiteral(".vklc");
+}
+
+// --- compile: 把文本布局文件编译为二进制缓存 ---
+bool LayoutFile::compile(const QString& sourcePath, const QString& cachePath, QString* errorMessage) {
+    QFile source(sourcePath);
+    if (!source.open(QIODevice::ReadOnly)) {
+        setError(errorMessage, QStringLiteral("无法打开布局文件 %1: %2").arg(sourcePath, source.errorString()));
+        return false;
+    }
+    const QFileInfo sourceInfo(source);
+
+    // --- 解析文本 ---
+    QList<QByteArray> texts;          // 解码后的文本 (KeyDef 中的指针指向这里)
+    QVector<KeyDef> keys;
+    QVector<int> textIndex;           // 每个按键的文本在 texts 中的下标 (Shift 文本紧随其后)
+    int lineNumber = 0;
+    while (!source.atEnd()) {
+        const QByteArray line = source.readLine().trimmed();
+        ++lineNumber;
+        if (line.isEmpty() || line.startsWith('#')) continue;
+
+        const QList<QByteArray> fields = line.simplified().split(' ');
+        KeyDef key = { "", "", 0, 0, KeyType::Normal, 0, 0, 1, false, KeySide::Left };
+        bool ok = fields.size() == 9 || fields.size() == 10;
+        bool rowOk = false, columnOk = false, spanOk = false, scanOk = false;
+        if (ok) {
+            key.row = fields[0].toInt(&rowOk);
+            key.column = fields[1].toInt(&columnOk);
+            key.columnSpan = fields[2].toInt(&spanOk);
+            key.scanCode = fields[4].toInt(&scanOk, 0);
+            key.extended = fields[7] == "ext";
+            ok = rowOk && columnOk && spanOk && scanOk && parseVkCode(fields[3], key.vkCode) &&
+                 parseKeyType(fields[5], key.type) && parseSide(fields[6], key.side) &&
+                 (fields[7] == "ext" || fields[7] == "-");
+        }
+        if (!ok) {
+            setError(errorMessage, QStringLiteral("%1:%2: 无法解析按键定义").arg(sourcePath).arg(lineNumber));
+            return false;
+        }
+        textIndex.append(texts.size());
+        texts.append(unescapeText(fields[8]));
+        texts.append(fields.size() == 10 ? unescapeText(fields[9]) : QByteArray());
+        keys.append(key);
+    }
+    if (keys.isEmpty()) {
+        setError(errorMessage, QStringLiteral("%1: 布局文件中没有按键").arg(sourcePath));
+        return false;
+    }
+    // texts 不再增长，可以安全地引用其中的数据
+    for (int i = 0; i < keys.size(); ++i) {
+        keys[i].text = texts[textIndex[i]].constData();
+        keys[i].shiftedText = texts[textIndex[i] + 1].constData();
+    }
+
+    // --- 与内置表相同的布局检查 ---
+    const std::size_t count = std::size_t(keys.size());
+    const char* failure = nullptr;
+    if (!layoutcheck::spansValid(keys.constData(), count, LAYOUT_FILE_MAX_ROWS, LAYOUT_FILE_MAX_COLUMNS)) failure = "按键超出网格或跨度无效";
+    else if (!layoutcheck::sortedByCell(keys.constData(), count)) failure = "按键必须按行、列顺序排列";
+    else if (!layoutcheck::cellsDisjoint(keys.constData(), count)) failure = "同一行的按键重叠";
+    else if (!layoutcheck::vkCodesUnique(keys.constData(), count)) failure = "VK 码缺失或重复";
+    else if (!layoutcheck::sidesAssigned(keys.constData(), count)) failure = "按键的左右归属无效";
+    if (failure) {
+        setError(errorMessage, QStringLiteral("%1: %2").arg(sourcePath, QString::fromUtf8(failure)));
+        return false;
+    }
+
+    // --- 预先计算拆分结果 ---
+    QVector<SplitKey> leftKeys(keys.size()), rightKeys(keys.size());
+    int leftCount = 0, rightCount = 0;
+    splitKeys(keys.constData(), count, leftKeys.data(), leftCount, rightKeys.data(), rightCount);
+
+    // --- 生成缓存内容 ---
+    QString pool;
+    QVector<CachedKey> cachedKeys(keys.size());
+    for (int i = 0; i < keys.size(); ++i) {
+        const KeyDef& key = keys[i];
+        const QString text = QString::fromUtf8(key.text);
+        const QString shiftedText = QString::fromUtf8(key.shiftedText);
+        CachedKey& cached = cachedKeys[i];
+        std::memset(&cached, 0, sizeof(CachedKey));
+        cached.textOffset = quint32(pool.size());
+        cached.textLength = quint16(text.size());
+        pool += text;
+        cached.shiftedOffset = quint32(pool.size());
+        cached.shiftedLength = quint16(shiftedText.size());
+        pool += shiftedText;
+        cached.vkCode = quint16(key.vkCode);
+        cached.scanCode = quint16(key.scanCode);
+        cached.type = quint8(key.type);
+        cached.row = quint8(key.row);
+        cached.column = quint8(key.column);
+        cached.columnSpan = quint8(key.columnSpan);
+        cached.extended = key.extended ? 1 : 0;
+    }
+
+    CacheHeader header;
+    std::memset(&header, 0, sizeof(CacheHeader));
+    std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = CACHE_VERSION;
+    header.sourceMtime = sourceInfo.lastModified().toMSecsSinceEpoch();
+    header.sourceSize = sourceInfo.size();
+    header.keyCount = quint32(keys.size());
+    header.leftCount = quint32(leftCount);
+    header.rightCount = quint32(rightCount);
+    header.poolLength = quint32(pool.size());
+
+    QByteArray bytes;
+    bytes.reserve(int(cacheSizeFor(header)));
+    bytes.append(reinterpret_cast<const char*>(&header), sizeof(CacheHeader));
+    bytes.append(reinterpret_cast<const char*>(cachedKeys.constData()), cachedKeys.size() * int(sizeof(CachedKey)));
+    bytes.append(reinterpret_cast<const char*>(leftKeys.constData()), leftCount * int(sizeof(SplitKey)));
+    bytes.append(reinterpret_cast<const char*>(rightKeys.constData()), rightCount * int(sizeof(SplitKey)));
+    bytes.append(reinterpret_cast<const char*>(pool.utf16()), pool.size() * 2);
+
+    // --- 原子地写入缓存文件 ---
+    QDir().mkpath(QFileInfo(cachePath).absolutePath());
+    QSaveFile cache(cachePath);
+    if (!cache.open(QIODevice::WriteOnly) || cache.write(bytes) != bytes.size() || !cache.commit()) {
+        setError(errorMessage, QStringLiteral("无法写入布局缓存 %1: %2").arg(cachePath, cache.errorString()));
+        return false;
+    }
+    qDebug() << "布局文件已编译:" << sourcePath << "->" << cachePath << "按键数:" << keys.size();
+    return true;
+}
+
+// --- map: 映射并校验缓存文件 ---
+bool LayoutFile::map(const QString& cachePath, QString* errorMessage) {
+    cacheFile.setFileName(cachePath);
+    if (!cacheFile.open(QIODevice::ReadOnly)) {
+        setError(errorMessage, QStringLiteral("无法打开布局缓存 %1").arg(cachePath));
+        return false;
+    }
+    const qint64 size = cacheFile.size();
+    if (size >= qint64(sizeof(CacheHeader))) data = cacheFile.map(0, size);
+    if (!data) {
+        setError(errorMessage, QStringLiteral("无法映射布局缓存 %1").arg(cachePath));
+        cacheFile.close();
+        return false;
+    }
+
+    // 只检查结构完整性 (不分配内存)，源文件是否变化由调用者判断
+    const CacheHeader& header = *headerOf(data);
+    bool valid = std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0 && header.version == CACHE_VERSION &&
+                 header.keyCount > 0 && cacheSizeFor(header) == size;
+    for (quint32 i = 0; valid && i < header.keyCount; ++i) {
+        const CachedKey& key = keysOf(data)[i];
+        valid = quint64(key.textOffset) + key.textLength <= header.poolLength &&
+                quint64(key.shiftedOffset) + key.shiftedLength <= header.poolLength;
+    }
+    const SplitKey* splitEntries = leftKeysOf(data);
+    for (quint32 i = 0; valid && i < header.leftCount + header.rightCount; ++i) {
+        valid = splitEntries[i].source >= 0 && quint32(splitEntries[i].source) < header.keyCount;
+    }
+    if (!valid) {
+        setError(errorMessage, QStringLiteral("布局缓存 %1 已损坏或版本不符").arg(cachePath));
+        cacheFile.unmap(const_cast<uchar*>(data));
+        data = nullptr;
+        cacheFile.close();
+        return false;
+    }
+    return true;
+}
+
+// --- open: 打开布局文件 (缓存过期时重新编译) ---
+const LayoutFile* LayoutFile::open(const QString& sourcePath, QString* errorMessage) {
+    const QFileInfo sourceInfo(sourcePath);
+    if (!sourceInfo.isFile()) {
+        setError(errorMessage, QStringLiteral("布局文件不存在: %1").arg(sourcePath));
+        return nullptr;
+    }
+    const QString cachePath = cachePathFor(sourcePath);
+
+    std::unique_ptr<LayoutFile> file(new LayoutFile);
+    bool upToDate = file->map(cachePath, nullptr);
+    if (upToDate) {
+        const CacheHeader& header = *headerOf(file->data);
+        upToDate = header.sourceMtime == sourceInfo.lastModified().toMSecsSinceEpoch() && header.sourceSize == sourceInfo.size();
+        if (!upToDate) {
+            // 先解除映射，否则部分平台无法替换被映射的文件
+            file->cacheFile.unmap(const_cast<uchar*>(file->data));
+            file->data = nullptr;
+            file->cacheFile.close();
+        }
+    }
+    if (!upToDate) {
+        if (!compile(sourcePath, cachePath, errorMessage) || !file->map(cachePath, errorMessage)) return nullptr;
+        file->recompiled = true;
+    }
+
+    const LayoutFile* opened = file.get();
+    openedLayoutFiles().push_back(std::move(file));
+    return opened;
+}
+
+int LayoutFile::keyCount() const {
+    return int(headerOf(data)->keyCount);
+}
+
+// --- stringAt: 直接引用字符串池中的文本 (不复制) ---
+QString LayoutFile::stringAt(quint32 offset, quint16 length) const {
+    if (length == 0) return QString();
+    return QString::fromRawData(reinterpret_cast<const QChar*>(poolOf(data) + offset), length);
+}
+
+// --- fullLayout: 生成完整布局 ---
+KeyboardLayout LayoutFile::fullLayout() const {
+    KeyboardLayout layout;
+    const CachedKey* keys = keysOf(data);
+    for (int i = 0; i < keyCount(); ++i) {
+        const CachedKey& key = keys[i];
+        while (layout.size() <= key.row) layout.append(QList<KeyInfo>());
+        layout[key.row].append(KeyInfo(stringAt(key.textOffset, key.textLength), stringAt(key.shiftedOffset, key.shiftedLength),
+                                       key.vkCode, key.scanCode, KeyType(key.type), key.row, key.column, key.columnSpan,
+                                       key.extended != 0));
+    }
+    return layout;
+}
+
+// --- splitLayout: 按预先计算的拆分结果生成左右布局 ---
+void LayoutFile::splitLayout(const KeyboardLayout& fullLayout, KeyboardLayout& leftLayout, KeyboardLayout& rightLayout) const {
+    leftLayout.clear(); rightLayout.clear();
+
+    QVector<const KeyInfo*> fullKeys;
+    fullKeys.reserve(keyCount());
+    for (const auto& row : fullLayout) {
+        for (const auto& key : row) fullKeys.append(&key);
+    }
+    Q_ASSERT(fullKeys.size() == keyCount());
+
+    const CacheHeader& header = *headerOf(data);
+    appendSplitHalf(fullKeys, leftKeysOf(data), int(header.leftCount), leftLayout);
+    appendSplitHalf(fullKeys, rightKeysOf(data), int(header.rightCount), rightLayout);
+}
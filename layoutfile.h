@@ -0,0 +1,51 @@
+#ifndef VIRTUALKEYBOARD_LAYOUTFILE_H
+#define VIRTUALKEYBOARD_LAYOUTFILE_H
+
+#include <QFile>
+#include <QString>
+
+#include "layouttable.h" // KeyDef、SplitKey 和布局检查
+
+// 数据驱动的键盘布局
+// 文本布局文件第一次加载时被编译为紧凑的二进制缓存 (位于 CacheLocation)，
+// 之后的启动直接映射缓存文件: 不解析文本，按键文本通过 QString::fromRawData 直接引用映射内存。
+// 缓存头部记录源文件的修改时间和大小，二者变化时自动重新编译。
+//
+// 文本格式 (每行一个按键，按行、列顺序排列，# 开头的行为注释):
+//   行 列 跨度 VK 扫描码 类型 侧 标志 文本 [Shift文本]
+//   - VK: 单个字符 (如 A、1，取其字符码)、数字 (如 0x1B) 或 VK_* 名称 (如 VK_ESCAPE)
+//   - 扫描码: 数字 (Set 1)
+//   - 类型: normal | sticky | toggle | special | layout (布局切换键，VK 码写 0x00)
+//   - 侧: left | right | both (仅空格键) | none (小键盘: 不参与拆分，只在完整模式和小键盘模式中显示)
+//   - 标志: ext (扩展键) 或 -
+//   - 文本: \s 表示空格，\\ 表示反斜杠
+class LayoutFile {
+public:
+    // 打开布局文件 (必要时先编译缓存)，失败返回 nullptr。
+    // 返回的对象在进程生命周期内有效: 生成的 KeyInfo 文本直接引用其映射内存。
+    static const LayoutFile* open(const QString& sourcePath, QString* errorMessage = nullptr);
+
+    // 把文本布局文件编译为二进制缓存
+    static bool compile(const QString& sourcePath, const QString& cachePath, QString* errorMessage = nullptr);
+    // 布局文件对应的缓存路径
+    static QString cachePathFor(const QString& sourcePath);
+
+    int keyCount() const;
+    bool compiledOnOpen() const { return recompiled; } // 本次打开是否重新编译了缓存
+
+    // 生成完整布局 (按键顺序与文件一致)
+    KeyboardLayout fullLayout() const;
+    // 按缓存中预先计算的拆分结果生成左右布局 (fullLayout 必须来自本对象，可以已写入 keyId)
+    void splitLayout(const KeyboardLayout& fullLayout, KeyboardLayout& leftLayout, KeyboardLayout& rightLayout) const;
+
+private:
+    LayoutFile() = default;
+    bool map(const QString& cachePath, QString* errorMessage); // 映射并校验缓存文件
+    QString stringAt(quint32 offset, quint16 length) const;   // 引用字符串池中的文本
+
+    QFile cacheFile;
+    const uchar* data = nullptr; // 映射的缓存内容
+    bool recompiled = false;
+};
+
+#endif // VIRTUALKEYBOARD_LAYOUTFILE_H
@@ -0,0 +1,88 @@
+#include "layoutset.h"
+#include "layouttable.h" // 内置布局和布局变体
+#include "layoutfile.h"  // 数据驱动的布局文件
+
+#include <QDebug>
+#include <utility>
+
+// --- defaultNames: 全部内置布局 ---
+QStringList LayoutSet::defaultNames() {
+    QStringList names;
+    for (const LayoutVariantDef& variant : LAYOUT_VARIANTS) names.append(QString::fromLatin1(variant.name));
+    return names;
+}
+
+// --- load: 按顺序加载布局 ---
+void LayoutSet::load(const QStringList& names, const QString& primaryFile) {
+    layouts.clear();
+    for (const QString& name : names) {
+        const QString trimmed = name.trimmed();
+        if (!trimmed.isEmpty()) appendLayout(trimmed, primaryFile);
+    }
+    if (layouts.isEmpty()) appendLayout(QString::fromLatin1(LAYOUT_VARIANTS[0].name), QString());
+}
+
+// --- appendLayout: 生成一个布局的完整布局、按键表、拆分结果和各几何模式的排布 ---
+bool LayoutSet::appendLayout(const QString& name, const QString& primaryFile) {
+    const LayoutVariantDef* variant = findLayoutVariant(name);
+    // 内置的 us 布局可以由布局文件代替；不是内置名称的按布局文件路径打开
+    const QString filePath = !variant ? name : (variant == &LAYOUT_VARIANTS[0] ? primaryFile : QString());
+    const LayoutFile* file = nullptr;
+    if (!filePath.isEmpty()) {
+        QString layoutError;
+        file = LayoutFile::open(filePath, &layoutError);
+        if (!file) {
+            if (!variant) {
+                qWarning() << "加载布局文件失败，已跳过:" << layoutError;
+                return false;
+            }
+            qWarning() << "加载布局文件失败，使用内置布局:" << layoutError;
+        }
+    }
+
+    Layout layout;
+    layout.name = file ? filePath : name;
+    // 由映射的缓存或编译期布局表生成完整布局
+    layout.full = file ? file->fullLayout() : getFullKeyboardLayout(*variant);
+    layout.table.build(layout.full); // 构建按 id 索引的按键表，并为布局中的按键分配 id
+    // 使用缓存中或编译期的拆分结果生成左右布局
+    if (file) file->splitLayout(layout.full, layout.left, layout.right);
+    else splitLayout(layout.full, layout.left, layout.right);
+    for (int mode = 0; mode < GEOMETRY_MODE_COUNT; ++mode) {
+        layout.geometries[mode] = buildKeyboardGeometry(GeometryMode(mode), layout.full, layout.left, layout.right);
+    }
+
+    if (!layouts.isEmpty() && !sameGeometry(layouts.first(), layout)) {
+        qWarning() << "布局" << layout.name << "的按键位置与" << layouts.first().name << "不同，不能原地切换，已跳过";
+        return false;
+    }
+    layouts.append(std::move(layout));
+    return true;
+}
+
+// --- sameGeometry: 按键数相同，每种几何模式中每个位置的按键 id、行列、跨度和类型都相同 ---
+bool LayoutSet::sameGeometry(const Layout& a, const Layout& b) {
+    if (a.table.size() != b.table.size()) return false;
+    const auto sameSection = [](const KeyboardLayout& x, const KeyboardLayout& y) {
+        if (x.size() != y.size()) return false;
+        for (int r = 0; r < x.size(); ++r) {
+            if (x[r].size() != y[r].size()) return false;
+            for (int k = 0; k < x[r].size(); ++k) {
+                const KeyInfo& p = x[r][k];
+                const KeyInfo& q = y[r][k];
+                if (p.keyId != q.keyId || p.row != q.row || p.column != q.column ||
+                    p.columnSpan != q.columnSpan || p.type != q.type) return false;
+            }
+        }
+        return true;
+    };
+    for (int mode = 0; mode < GEOMETRY_MODE_COUNT; ++mode) {
+        const QList<KeyboardLayout>& x = a.geometries[mode].sections;
+        const QList<KeyboardLayout>& y = b.geometries[mode].sections;
+        if (x.size() != y.size()) return false;
+        for (int s = 0; s < x.size(); ++s) {
+            if (!sameSection(x[s], y[s])) return false;
+        }
+    }
+    return true;
+}
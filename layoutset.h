@@ -0,0 +1,48 @@
+#ifndef VIRTUALKEYBOARD_LAYOUTSET_H
+#define VIRTUALKEYBOARD_LAYOUTSET_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "keyboardlayout.h" // KeyboardLayout
+#include "keytable.h"       // 按 id 索引的按键表
+#include "keyboardgeometry.h" // 各几何模式的按键排布
+
+// 同时加载的一组键盘布局 (布局切换键按顺序循环切换)
+// 所有布局的几何必须与第一个布局相同: 按键数相同，每种几何模式中同一位置的按键 id、行列、跨度和类型都相同，
+// 只有文本和 VK 码不同。这样切换布局时按键 id 不变，按钮、画布按键和命中区域原地换成新的文本，
+// 不创建或销毁任何控件。每个布局的按键表、拆分结果和各几何模式的排布在启动时一起生成，切换时只交换隐式共享的数据。
+class LayoutSet {
+public:
+    struct Layout {
+        QString name;        // 内置布局名称或布局文件路径
+        KeyboardLayout full; // 完整布局 (已写入 keyId)
+        KeyboardLayout left; // 左半部分
+        KeyboardLayout right; // 右半部分
+        KeyTable table;      // 按 id 索引的按键表
+        KeyboardGeometry geometries[GEOMETRY_MODE_COUNT]; // 各几何模式的排布 (按 GeometryMode 索引)
+
+        const KeyboardGeometry& geometry(GeometryMode mode) const { return geometries[int(mode)]; }
+    };
+
+    // 默认加载的布局 (全部内置布局)
+    static QStringList defaultNames();
+
+    // 按顺序加载布局: 名称为内置布局 (us、azerty、dvorak、ru) 或文本布局文件路径；
+    // primaryFile 不为空时代替内置的 us 布局 (加载失败时仍使用内置布局)。
+    // 无法加载或几何与第一个布局不同的布局被跳过 (输出警告)，一个都没有加载时使用内置 us 布局
+    void load(const QStringList& names, const QString& primaryFile = QString());
+
+    int size() const { return layouts.size(); }
+    const Layout& layout(int index) const { return layouts[index]; }
+    // 循环的下一个布局
+    int next(int index) const { return layouts.isEmpty() ? 0 : (index + 1) % layouts.size(); }
+
+private:
+    bool appendLayout(const QString& name, const QString& primaryFile); // 加载一个布局，返回是否加入
+    static bool sameGeometry(const Layout& a, const Layout& b);         // 两个布局是否可以原地切换
+
+    QVector<Layout> layouts;
+};
+
+#endif // VIRTUALKEYBOARD_LAYOUTSET_H
@@ -0,0 +1,489 @@
+#ifndef VIRTUALKEYBOARD_LAYOUTTABLE_H
+#define VIRTUALKEYBOARD_LAYOUTTABLE_H
+
+#include <QVector>
+#include <cstddef>
+#include "keyboardlayout.h" // KeyInfo、KeyType 和 VK_* 常量
+
+// 拆分键盘中按键所属的一侧
+enum class KeySide : quint8 {
+    Left,  // 左半部分
+    Right, // 右半部分
+    Both,  // 拆成两半 (只用于空格键)
+    None   // 不属于任何一侧 (小键盘，只在完整模式和小键盘模式中显示)
+};
+
+// 编译期按键定义 (只含字面量，不分配堆内存)
+// 行列号全部显式给出，扫描码使用 PC/AT Set 1 的 make code (扩展键的 E0 前缀由 extended 表示)
+struct KeyDef {
+    const char* text;        // 默认文本 (UTF-8)
+    const char* shiftedText; // Shift 文本 (UTF-8)
+    int vkCode;              // Windows 虚拟键码
+    int scanCode;            // Set 1 扫描码
+    KeyType type;            // 按键类型
+    int row;                 // 行号
+    int column;              // 起始列号
+    int columnSpan;          // 列跨度
+    bool extended;           // 是否为扩展键
+    KeySide side;            // 拆分时所属的一侧
+};
+
+// 完整布局的网格大小
+constexpr int FULL_LAYOUT_ROWS = 7;
+constexpr int FULL_LAYOUT_COLUMNS = 20; // 主键区 16 列 + 小键盘 4 列
+
+// 简写，仅用于下面的表
+#define VK_KEY_N(text, shifted, vk, sc, row, col, side) { text, shifted, vk, sc, KeyType::Normal, row, col, 1, false, KeySide::side }
+#define VK_KEY_P(text, vk, sc, row, col) { text, "", vk, sc, KeyType::Normal, row, col, 1, false, KeySide::None }
+
+// --- QWERTY_KEYS: 标准 QWERTY 布局 (按行、列顺序排列) ---
+// 第 1-5 行的第 16-19 列是小键盘 (不属于拆分的任何一侧；+ 和 Enter 只占一行)
+inline constexpr KeyDef QWERTY_KEYS[] = {
+    // 第 0 行: 功能键等
+    { "Esc", "", VK_ESCAPE, 0x01, KeyType::Special, 0, 0, 1, false, KeySide::Left },
+    { "F1", "", VK_F1, 0x3B, KeyType::Special, 0, 1, 1, false, KeySide::Left },
+    { "F2", "", VK_F2, 0x3C, KeyType::Special, 0, 2, 1, false, KeySide::Left },
+    { "F3", "", VK_F3, 0x3D, KeyType::Special, 0, 3, 1, false, KeySide::Left },
+    { "F4", "", VK_F4, 0x3E, KeyType::Special, 0, 4, 1, false, KeySide::Left },
+    { "F5", "", VK_F5, 0x3F, KeyType::Special, 0, 5, 1, false, KeySide::Left },
+    { "F6", "", VK_F6, 0x40, KeyType::Special, 0, 6, 1, false, KeySide::Right },
+    { "F7", "", VK_F7, 0x41, KeyType::Special, 0, 7, 1, false, KeySide::Right },
+    { "F8", "", VK_F8, 0x42, KeyType::Special, 0, 8, 1, false, KeySide::Right },
+    { "F9", "", VK_F9, 0x43, KeyType::Special, 0, 9, 1, false, KeySide::Right },
+    { "F10", "", VK_F10, 0x44, KeyType::Special, 0, 10, 1, false, KeySide::Right },
+    { "F11", "", VK_F11, 0x57, KeyType::Special, 0, 11, 1, false, KeySide::Right },
+    { "F12", "", VK_F12, 0x58, KeyType::Special, 0, 12, 1, false, KeySide::Right },
+    { "PrtSc", "", VK_SNAPSHOT, 0x37, KeyType::Special, 0, 13, 1, true, KeySide::Right },      // PrtSc 使用扩展标志
+    { "ScrLk", "", VK_SCROLL, 0x46, KeyType::ModifierToggle, 0, 14, 1, false, KeySide::Right }, // ScrLk 不是扩展键
+    { "Pause", "", VK_PAUSE, 0x45, KeyType::Special, 0, 15, 1, false, KeySide::Right },        // Pause 可能需要特殊处理 (Ctrl+Pause)
+    // 第 1 行: 数字和符号
+    VK_KEY_N("`", "~", VK_OEM_3, 0x29, 1, 0, Left),
+    VK_KEY_N("1", "!", '1', 0x02, 1, 1, Left),
+    VK_KEY_N("2", "@", '2', 0x03, 1, 2, Left),
+    VK_KEY_N("3", "#", '3', 0x04, 1, 3, Left),
+    VK_KEY_N("4", "$", '4', 0x05, 1, 4, Left),
+    VK_KEY_N("5", "%", '5', 0x06, 1, 5, Left),
+    VK_KEY_N("6", "^", '6', 0x07, 1, 6, Right),
+    VK_KEY_N("7", "&", '7', 0x08, 1, 7, Right),
+    VK_KEY_N("8", "*", '8', 0x09, 1, 8, Right),
+    VK_KEY_N("9", "(", '9', 0x0A, 1, 9, Right),
+    VK_KEY_N("0", ")", '0', 0x0B, 1, 10, Right),
+    VK_KEY_N("-", "_", VK_OEM_MINUS, 0x0C, 1, 11, Right),
+    VK_KEY_N("=", "+", VK_OEM_PLUS, 0x0D, 1, 12, Right),
+    { "Backspace", "", VK_BACK, 0x0E, KeyType::Special, 1, 13, 3, false, KeySide::Right },
+    { "NumLk", "", VK_NUMLOCK, 0x45, KeyType::ModifierToggle, 1, 16, 1, true, KeySide::None }, // NumLock 需要扩展标志
+    { "/", "", VK_DIVIDE, 0x35, KeyType::Normal, 1, 17, 1, true, KeySide::None },
+    { "*", "", VK_MULTIPLY, 0x37, KeyType::Normal, 1, 18, 1, false, KeySide::None },
+    { "-", "", VK_SUBTRACT, 0x4A, KeyType::Normal, 1, 19, 1, false, KeySide::None },
+    // 第 2 行: QWERTY 行
+    { "Tab", "", VK_TAB, 0x0F, KeyType::Special, 2, 0, 2, false, KeySide::Left },
+    VK_KEY_N("Q", "q", 'Q', 0x10, 2, 2, Left),
+    VK_KEY_N("W", "w", 'W', 0x11, 2, 3, Left),
+    VK_KEY_N("E", "e", 'E', 0x12, 2, 4, Left),
+    VK_KEY_N("R", "r", 'R', 0x13, 2, 5, Left),
+    VK_KEY_N("T", "t", 'T', 0x14, 2, 6, Left),
+    VK_KEY_N("Y", "y", 'Y', 0x15, 2, 7, Right),
+    VK_KEY_N("U", "u", 'U', 0x16, 2, 8, Right),
+    VK_KEY_N("I", "i", 'I', 0x17, 2, 9, Right),
+    VK_KEY_N("O", "o", 'O', 0x18, 2, 10, Right),
+    VK_KEY_N("P", "p", 'P', 0x19, 2, 11, Right),
+    VK_KEY_N("[", "{", VK_OEM_4, 0x1A, 2, 12, Right),
+    VK_KEY_N("]", "}", VK_OEM_6, 0x1B, 2, 13, Right),
+    { "\\", "|", VK_OEM_5, 0x2B, KeyType::Normal, 2, 14, 2, false, KeySide::Right },
+    VK_KEY_P("7", VK_NUMPAD7, 0x47, 2, 16),
+    VK_KEY_P("8", VK_NUMPAD8, 0x48, 2, 17),
+    VK_KEY_P("9", VK_NUMPAD9, 0x49, 2, 18),
+    VK_KEY_P("+", VK_ADD, 0x4E, 2, 19),
+    // 第 3 行: ASDF 行
+    { "Caps", "", VK_CAPITAL, 0x3A, KeyType::ModifierToggle, 3, 0, 2, false, KeySide::Left },
+    VK_KEY_N("A", "a", 'A', 0x1E, 3, 2, Left),
+    VK_KEY_N("S", "s", 'S', 0x1F, 3, 3, Left),
+    VK_KEY_N("D", "d", 'D', 0x20, 3, 4, Left),
+    VK_KEY_N("F", "f", 'F', 0x21, 3, 5, Left),
+    VK_KEY_N("G", "g", 'G', 0x22, 3, 6, Left),
+    VK_KEY_N("H", "h", 'H', 0x23, 3, 7, Right),
+    VK_KEY_N("J", "j", 'J', 0x24, 3, 8, Right),
+    VK_KEY_N("K", "k", 'K', 0x25, 3, 9, Right),
+    VK_KEY_N("L", "l", 'L', 0x26, 3, 10, Right),
+    VK_KEY_N(";", ":", VK_OEM_1, 0x27, 3, 11, Right),
+    VK_KEY_N("'", "\"", VK_OEM_7, 0x28, 3, 12, Right),
+    { "Enter", "", VK_RETURN, 0x1C, KeyType::Special, 3, 13, 3, false, KeySide::Right }, // 主 Enter 不是扩展键 (小键盘 Enter 是)
+    VK_KEY_P("4", VK_NUMPAD4, 0x4B, 3, 16),
+    VK_KEY_P("5", VK_NUMPAD5, 0x4C, 3, 17),
+    VK_KEY_P("6", VK_NUMPAD6, 0x4D, 3, 18),
+    // 第 4 行: ZXCV 行
+    { "Shift", "", VK_LSHIFT, 0x2A, KeyType::ModifierSticky, 4, 0, 3, false, KeySide::Left },
+    VK_KEY_N("Z", "z", 'Z', 0x2C, 4, 3, Left),
+    VK_KEY_N("X", "x", 'X', 0x2D, 4, 4, Left),
+    VK_KEY_N("C", "c", 'C', 0x2E, 4, 5, Left),
+    VK_KEY_N("V", "v", 'V', 0x2F, 4, 6, Left),
+    VK_KEY_N("B", "b", 'B', 0x30, 4, 7, Left),
+    VK_KEY_N("N", "n", 'N', 0x31, 4, 8, Right),
+    VK_KEY_N("M", "m", 'M', 0x32, 4, 9, Right),
+    VK_KEY_N(",", "<", VK_OEM_COMMA, 0x33, 4, 10, Right),
+    VK_KEY_N(".", ">", VK_OEM_PERIOD, 0x34, 4, 11, Right),
+    VK_KEY_N("/", "?", VK_OEM_2, 0x35, 4, 12, Right),
+    { "Shift", "", VK_RSHIFT, 0x36, KeyType::ModifierSticky, 4, 13, 3, false, KeySide::Right }, // 右 Shift 不是扩展键
+    VK_KEY_P("1", VK_NUMPAD1, 0x4F, 4, 16),
+    VK_KEY_P("2", VK_NUMPAD2, 0x50, 4, 17),
+    VK_KEY_P("3", VK_NUMPAD3, 0x51, 4, 18),
+    { "Enter", "", VK_RETURN, 0x1C, KeyType::Special, 4, 19, 1, true, KeySide::None },
+    // 第 5 行: 底部行 (注意: RCtrl, RAlt, RWin, Apps 是扩展键；布局切换键显示当前布局的简称，不注入)
+    { "Ctrl", "", VK_LCONTROL, 0x1D, KeyType::ModifierSticky, 5, 0, 2, false, KeySide::Left },
+    { "Win", "", VK_LWIN, 0x5B, KeyType::ModifierSticky, 5, 2, 1, true, KeySide::Left },
+    { "Alt", "", VK_LMENU, 0x38, KeyType::ModifierSticky, 5, 3, 1, false, KeySide::Left },
+    { "Space", "", VK_SPACE, 0x39, KeyType::Special, 5, 4, 6, false, KeySide::Both },
+    { "EN", "", 0, 0, KeyType::LayoutSwitch, 5, 10, 1, false, KeySide::Right },
+    { "Alt", "", VK_RMENU, 0x38, KeyType::ModifierSticky, 5, 11, 1, true, KeySide::Right },
+    { "Win", "", VK_RWIN, 0x5C, KeyType::ModifierSticky, 5, 12, 1, true, KeySide::Right },
+    { "Menu", "", VK_APPS, 0x5D, KeyType::Special, 5, 13, 1, true, KeySide::Right },
+    { "Ctrl", "", VK_RCONTROL, 0x1D, KeyType::ModifierSticky, 5, 14, 2, true, KeySide::Right },
+    { "0", "", VK_NUMPAD0, 0x52, KeyType::Normal, 5, 16, 2, false, KeySide::None },
+    VK_KEY_P(".", VK_DECIMAL, 0x53, 5, 18),
+    // 第 6 行: 方向键 & 导航键 (扩展键；第 6-8 列和第 10 列留空)
+    { "Ins", "", VK_INSERT, 0x52, KeyType::Special, 6, 0, 1, true, KeySide::Right },
+    { "Del", "", VK_DELETE, 0x53, KeyType::Special, 6, 1, 1, true, KeySide::Right },
+    { "Home", "", VK_HOME, 0x47, KeyType::Special, 6, 2, 1, true, KeySide::Right },
+    { "End", "", VK_END, 0x4F, KeyType::Special, 6, 3, 1, true, KeySide::Right },
+    { "PgUp", "", VK_PRIOR, 0x49, KeyType::Special, 6, 4, 1, true, KeySide::Right },
+    { "PgDn", "", VK_NEXT, 0x51, KeyType::Special, 6, 5, 1, true, KeySide::Right },
+    { "↑", "", VK_UP, 0x48, KeyType::Special, 6, 9, 1, true, KeySide::Right },
+    { "←", "", VK_LEFT, 0x4B, KeyType::Special, 6, 11, 1, true, KeySide::Right },
+    { "↓", "", VK_DOWN, 0x50, KeyType::Special, 6, 12, 1, true, KeySide::Right },
+    { "→", "", VK_RIGHT, 0x4D, KeyType::Special, 6, 13, 1, true, KeySide::Right }
+};
+
+#undef VK_KEY_N
+#undef VK_KEY_P
+
+constexpr int QWERTY_KEY_COUNT = int(sizeof(QWERTY_KEYS) / sizeof(QWERTY_KEYS[0]));
+
+// --- 布局检查 ---
+// 这些函数既用于内置表的 static_assert，也用于运行时校验布局文件
+namespace layoutcheck {
+
+// 每个按键都在 rows x columns 网格内，且跨度至少为 1
+constexpr bool spansValid(const KeyDef* keys, std::size_t count, int rows, int columns) {
+    for (std::size_t i = 0; i < count; ++i) {
+        const KeyDef& key = keys[i];
+        if (key.columnSpan < 1 || key.column < 0 || key.column + key.columnSpan > columns) return false;
+        if (key.row < 0 || key.row >= rows) return false;
+    }
+    return true;
+}
+
+// 按行、列顺序排列 (拆分时按此顺序重新编号列)
+constexpr bool sortedByCell(const KeyDef* keys, std::size_t count) {
+    for (std::size_t i = 1; i < count; ++i) {
+        const KeyDef& prev = keys[i - 1];
+        const KeyDef& key = keys[i];
+        if (key.row < prev.row || (key.row == prev.row && key.column <= prev.column)) return false;
+    }
+    return true;
+}
+
+// 同一行的按键不重叠
+constexpr bool cellsDisjoint(const KeyDef* keys, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        for (std::size_t j = i + 1; j < count; ++j) {
+            if (keys[i].row != keys[j].row) continue;
+            if (keys[i].column < keys[j].column + keys[j].columnSpan &&
+                keys[j].column < keys[i].column + keys[i].columnSpan) return false;
+        }
+    }
+    return true;
+}
+
+// 每个 VK 码只出现一次且都有 VK 码 (左右 Alt/Ctrl 等使用不同的 VK 码；
+// 主键区和小键盘的 Enter 共用 VK_RETURN，以扩展标志区分，因此按 VK 码 + 扩展标志判断)；
+// 布局切换键不注入，VK 码必须为 0
+constexpr bool vkCodesUnique(const KeyDef* keys, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        if (keys[i].type == KeyType::LayoutSwitch) {
+            if (keys[i].vkCode != 0) return false;
+            continue;
+        }
+        if (keys[i].vkCode <= 0 || keys[i].vkCode > 0xFF) return false;
+        for (std::size_t j = i + 1; j < count; ++j) {
+            if (keys[i].vkCode == keys[j].vkCode && keys[i].extended == keys[j].extended) return false;
+        }
+    }
+    return true;
+}
+
+// 每个按键都属于一侧: 只有空格键可以拆成两半 (且跨度足够拆分)，
+// 同一行中左侧按键都在右侧按键之前 (不属于任何一侧的小键盘按键不参与排序检查)
+constexpr bool sidesAssigned(const KeyDef* keys, std::size_t count) {
+    int row = -1;
+    bool seenRight = false;
+    for (std::size_t i = 0; i < count; ++i) {
+        const KeyDef& key = keys[i];
+        if (key.row != row) { row = key.row; seenRight = false; }
+        if (key.side == KeySide::None) continue;
+        if (key.side == KeySide::Both && (key.vkCode != VK_SPACE || key.columnSpan < 2)) return false;
+        if (key.side != KeySide::Right && seenRight) return false;
+        if (key.side != KeySide::Left) seenRight = true;
+    }
+    return true;
+}
+
+} // namespace layoutcheck
+
+static_assert(layoutcheck::spansValid(QWERTY_KEYS, QWERTY_KEY_COUNT, FULL_LAYOUT_ROWS, FULL_LAYOUT_COLUMNS), "QWERTY 布局: 按键超出网格或跨度无效");
+static_assert(layoutcheck::sortedByCell(QWERTY_KEYS, QWERTY_KEY_COUNT), "QWERTY 布局: 按键必须按行、列顺序排列");
+static_assert(layoutcheck::cellsDisjoint(QWERTY_KEYS, QWERTY_KEY_COUNT), "QWERTY 布局: 同一行的按键重叠");
+static_assert(layoutcheck::vkCodesUnique(QWERTY_KEYS, QWERTY_KEY_COUNT), "QWERTY 布局: VK 码缺失或重复");
+static_assert(layoutcheck::sidesAssigned(QWERTY_KEYS, QWERTY_KEY_COUNT), "QWERTY 布局: 按键的左右归属无效");
+
+// --- 拆分 ---
+// 拆分后一侧中的按键: 引用完整布局中的按键，并给出该侧内部从 0 开始的连续列号
+struct SplitKey {
+    int source = 0;     // 在 KeyDef 表中的下标
+    int row = 0;        // 行号 (与完整布局相同)
+    int column = 0;     // 该侧内部的列号
+    int columnSpan = 1; // 该侧内部的列跨度
+};
+
+// --- splitKeys: 把完整布局拆分为左右两半 ---
+// 空格键拆成两半 (奇数跨度时左半多一列)，各侧的列号重新从 0 连续编号；不属于任何一侧的按键 (小键盘) 不出现在拆分结果中。
+// left/right 各需容纳 count 个元素；返回时 leftCount/rightCount 为各侧按键数
+constexpr void splitKeys(const KeyDef* keys, std::size_t count,
+                         SplitKey* left, int& leftCount, SplitKey* right, int& rightCount) {
+    int row = -1, leftColumn = 0, rightColumn = 0;
+    leftCount = 0;
+    rightCount = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        const KeyDef& key = keys[i];
+        if (key.side == KeySide::None) continue;
+        if (key.row != row) { row = key.row; leftColumn = 0; rightColumn = 0; }
+        const bool both = key.side == KeySide::Both;
+        if (key.side == KeySide::Left || both) {
+            const int span = both ? (key.columnSpan + 1) / 2 : key.columnSpan;
+            left[leftCount++] = SplitKey{ int(i), key.row, leftColumn, span };
+            leftColumn += span;
+        }
+        if (key.side == KeySide::Right || both) {
+            const int span = both ? key.columnSpan / 2 : key.columnSpan;
+            right[rightCount++] = SplitKey{ int(i), key.row, rightColumn, span };
+            rightColumn += span;
+        }
+    }
+}
+
+// 编译期拆分结果
+template<std::size_t N>
+struct SplitLayoutDef {
+    SplitKey left[N] = {};
+    SplitKey right[N] = {};
+    int leftCount = 0;
+    int rightCount = 0;
+};
+
+template<std::size_t N>
+constexpr SplitLayoutDef<N> computeSplit(const KeyDef (&keys)[N]) {
+    SplitLayoutDef<N> split;
+    splitKeys(keys, N, split.left, split.leftCount, split.right, split.rightCount);
+    return split;
+}
+
+inline constexpr SplitLayoutDef<QWERTY_KEY_COUNT> QWERTY_SPLIT = computeSplit(QWERTY_KEYS);
+// 不属于任何一侧的按键数
+constexpr int countUnsided(const KeyDef* keys, std::size_t count) {
+    int unsided = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        if (keys[i].side == KeySide::None) ++unsided;
+    }
+    return unsided;
+}
+
+static_assert(QWERTY_SPLIT.leftCount + QWERTY_SPLIT.rightCount == QWERTY_KEY_COUNT - countUnsided(QWERTY_KEYS, QWERTY_KEY_COUNT) + 1,
+              "QWERTY 布局: 只有空格键应被拆成两半");
+
+// --- 布局变体 ---
+// 其他语言的布局与 QWERTY 共用同一套几何 (行列、跨度、扫描码和左右归属)，只替换普通键的文本和 VK 码，
+// 因此同一位置的按键在各个布局中的 id 相同，切换布局时按钮和命中区域可以原地复用。
+// VK 码取 Windows 对应键盘布局中该物理键的 VK 码 (例如 AZERTY 中扫描码 0x10 的键为 'A')。
+// 切换布局不会切换主机 (操作系统) 的键盘布局，按 VK 码注入的字符仍由主机布局决定。
+// 因此普通键的文本与其 VK 码在主机布局上产生的字符不一致时 (例如美式主机上的 "Й" -> 'Q' -> q)，
+// 按键和文本输入都改为以 Unicode 事件输入按键上的文本 (InjectionBackend::keyText、VirtualKeyboardWidget::syncHostKeyText)；
+// 一致时 (主机已切换到对应布局) 仍按 VK 码注入。Ctrl/Alt/Win 按住时总按 VK 码注入，快捷键按物理键匹配。
+struct KeyOverlay {
+    int scanCode;            // 被替换的普通键 (按 Set 1 扫描码匹配)
+    const char* text;        // 默认文本 (UTF-8)
+    const char* shiftedText; // Shift 文本 (UTF-8)
+    int vkCode;              // Windows 虚拟键码
+};
+
+// 内置布局变体
+struct LayoutVariantDef {
+    const char* name;        // 名称 (--layouts 中使用)
+    const char* label;       // 布局切换键上显示的简称
+    const KeyOverlay* keys;  // 与 QWERTY 不同的按键 (只列出不同的键)
+    std::size_t count;
+};
+
+// --- AZERTY_OVERLAY: 法语 AZERTY (数字需要 Shift) ---
+inline constexpr KeyOverlay AZERTY_OVERLAY[] = {
+    { 0x29, "²", "", VK_OEM_7 },
+    { 0x02, "&", "1", '1' }, { 0x03, "é", "2", '2' }, { 0x04, "\"", "3", '3' }, { 0x05, "'", "4", '4' },
+    { 0x06, "(", "5", '5' }, { 0x07, "-", "6", '6' }, { 0x08, "è", "7", '7' }, { 0x09, "_", "8", '8' },
+    { 0x0A, "ç", "9", '9' }, { 0x0B, "à", "0", '0' }, { 0x0C, ")", "°", VK_OEM_4 }, { 0x0D, "=", "+", VK_OEM_PLUS },
+    { 0x10, "A", "a", 'A' }, { 0x11, "Z", "z", 'Z' }, { 0x1A, "^", "¨", VK_OEM_6 }, { 0x1B, "$", "£", VK_OEM_1 },
+    { 0x2B, "*", "µ", VK_OEM_5 },
+    { 0x1E, "Q", "q", 'Q' }, { 0x27, "M", "m", 'M' }, { 0x28, "ù", "%", VK_OEM_3 },
+    { 0x2C, "W", "w", 'W' }, { 0x32, ",", "?", VK_OEM_COMMA }, { 0x33, ";", ".", VK_OEM_PERIOD },
+    { 0x34, ":", "/", VK_OEM_2 }, { 0x35, "!", "§", VK_OEM_8 }
+};
+
+// --- DVORAK_OVERLAY: 美式 Dvorak ---
+inline constexpr KeyOverlay DVORAK_OVERLAY[] = {
+    { 0x0C, "[", "{", VK_OEM_4 }, { 0x0D, "]", "}", VK_OEM_6 },
+    { 0x10, "'", "\"", VK_OEM_7 }, { 0x11, ",", "<", VK_OEM_COMMA }, { 0x12, ".", ">", VK_OEM_PERIOD },
+    { 0x13, "P", "p", 'P' }, { 0x14, "Y", "y", 'Y' }, { 0x15, "F", "f", 'F' }, { 0x16, "G", "g", 'G' },
+    { 0x17, "C", "c", 'C' }, { 0x18, "R", "r", 'R' }, { 0x19, "L", "l", 'L' },
+    { 0x1A, "/", "?", VK_OEM_2 }, { 0x1B, "=", "+", VK_OEM_PLUS },
+    { 0x1F, "O", "o", 'O' }, { 0x20, "E", "e", 'E' }, { 0x21, "U", "u", 'U' }, { 0x22, "I", "i", 'I' },
+    { 0x23, "D", "d", 'D' }, { 0x24, "H", "h", 'H' }, { 0x25, "T", "t", 'T' }, { 0x26, "N", "n", 'N' },
+    { 0x27, "S", "s", 'S' }, { 0x28, "-", "_", VK_OEM_MINUS },
+    { 0x2C, ";", ":", VK_OEM_1 }, { 0x2D, "Q", "q", 'Q' }, { 0x2E, "J", "j", 'J' }, { 0x2F, "K", "k", 'K' },
+    { 0x30, "X", "x", 'X' }, { 0x31, "B", "b", 'B' }, { 0x32, "M", "m", 'M' }, { 0x33, "W", "w", 'W' },
+    { 0x34, "V", "v", 'V' }, { 0x35, "Z", "z", 'Z' }
+};
+
+// --- RUSSIAN_OVERLAY: 俄语 ЙЦУКЕН (VK 码与 QWERTY 中同一位置的键相同) ---
+inline constexpr KeyOverlay RUSSIAN_OVERLAY[] = {
+    { 0x29, "Ё", "ё", VK_OEM_3 },
+    { 0x03, "2", "\"", '2' }, { 0x04, "3", "№", '3' }, { 0x05, "4", ";", '4' }, { 0x07, "6", ":", '6' },
+    { 0x08, "7", "?", '7' },
+    { 0x10, "Й", "й", 'Q' }, { 0x11, "Ц", "ц", 'W' }, { 0x12, "У", "у", 'E' }, { 0x13, "К", "к", 'R' },
+    { 0x14, "Е", "е", 'T' }, { 0x15, "Н", "н", 'Y' }, { 0x16, "Г", "г", 'U' }, { 0x17, "Ш", "ш", 'I' },
+    { 0x18, "Щ", "щ", 'O' }, { 0x19, "З", "з", 'P' }, { 0x1A, "Х", "х", VK_OEM_4 }, { 0x1B, "Ъ", "ъ", VK_OEM_6 },
+    { 0x2B, "\\", "/", VK_OEM_5 },
+    { 0x1E, "Ф", "ф", 'A' }, { 0x1F, "Ы", "ы", 'S' }, { 0x20, "В", "в", 'D' }, { 0x21, "А", "а", 'F' },
+    { 0x22, "П", "п", 'G' }, { 0x23, "Р", "р", 'H' }, { 0x24, "О", "о", 'J' }, { 0x25, "Л", "л", 'K' },
+    { 0x26, "Д", "д", 'L' }, { 0x27, "Ж", "ж", VK_OEM_1 }, { 0x28, "Э", "э", VK_OEM_7 },
+    { 0x2C, "Я", "я", 'Z' }, { 0x2D, "Ч", "ч", 'X' }, { 0x2E, "С", "с", 'C' }, { 0x2F, "М", "м", 'V' },
+    { 0x30, "И", "и", 'B' }, { 0x31, "Т", "т", 'N' }, { 0x32, "Ь", "ь", 'M' }, { 0x33, "Б", "б", VK_OEM_COMMA },
+    { 0x34, "Ю", "ю", VK_OEM_PERIOD }, { 0x35, ".", ",", VK_OEM_2 }
+};
+
+// --- LAYOUT_VARIANTS: 内置布局 (第一个为默认布局) ---
+inline constexpr LayoutVariantDef LAYOUT_VARIANTS[] = {
+    { "us", "EN", nullptr, 0 },
+    { "azerty", "FR", AZERTY_OVERLAY, sizeof(AZERTY_OVERLAY) / sizeof(AZERTY_OVERLAY[0]) },
+    { "dvorak", "DV", DVORAK_OVERLAY, sizeof(DVORAK_OVERLAY) / sizeof(DVORAK_OVERLAY[0]) },
+    { "ru", "RU", RUSSIAN_OVERLAY, sizeof(RUSSIAN_OVERLAY) / sizeof(RUSSIAN_OVERLAY[0]) }
+};
+
+constexpr int LAYOUT_VARIANT_COUNT = int(sizeof(LAYOUT_VARIANTS) / sizeof(LAYOUT_VARIANTS[0]));
+
+namespace layoutcheck {
+
+// 普通键在覆盖表中的替换项 (没有时返回 nullptr)
+constexpr const KeyOverlay* overlayFor(const KeyDef& key, const LayoutVariantDef& variant) {
+    if (key.type != KeyType::Normal || key.extended) return nullptr;
+    for (std::size_t i = 0; i < variant.count; ++i) {
+        if (variant.keys[i].scanCode == key.scanCode) return &variant.keys[i];
+    }
+    return nullptr;
+}
+
+// 覆盖表中的每一项都恰好替换一个普通键 (扫描码不重复)，且替换后的布局中 VK 码 (+ 扩展标志) 仍然唯一
+constexpr bool overlayValid(const KeyDef* keys, std::size_t count, const LayoutVariantDef& variant) {
+    for (std::size_t i = 0; i < variant.count; ++i) {
+        int matches = 0;
+        for (std::size_t k = 0; k < count; ++k) {
+            if (keys[k].type == KeyType::Normal && !keys[k].extended && keys[k].scanCode == variant.keys[i].scanCode) ++matches;
+        }
+        if (matches != 1) return false;
+        for (std::size_t j = i + 1; j < variant.count; ++j) {
+            if (variant.keys[i].scanCode == variant.keys[j].scanCode) return false;
+        }
+    }
+    for (std::size_t i = 0; i < count; ++i) {
+        if (keys[i].type == KeyType::LayoutSwitch) continue;
+        const KeyOverlay* overlay = overlayFor(keys[i], variant);
+        const int vkCode = overlay ? overlay->vkCode : keys[i].vkCode;
+        if (vkCode <= 0 || vkCode > 0xFF) return false;
+        for (std::size_t j = i + 1; j < count; ++j) {
+            if (keys[j].type == KeyType::LayoutSwitch || keys[j].extended != keys[i].extended) continue;
+            const KeyOverlay* other = overlayFor(keys[j], variant);
+            if (vkCode == (other ? other->vkCode : keys[j].vkCode)) return false;
+        }
+    }
+    return true;
+}
+
+} // namespace layoutcheck
+
+static_assert(layoutcheck::overlayValid(QWERTY_KEYS, QWERTY_KEY_COUNT, LAYOUT_VARIANTS[0]), "US 布局: 覆盖表无效");
+static_assert(layoutcheck::overlayValid(QWERTY_KEYS, QWERTY_KEY_COUNT, LAYOUT_VARIANTS[1]), "AZERTY 布局: 覆盖表无效");
+static_assert(layoutcheck::overlayValid(QWERTY_KEYS, QWERTY_KEY_COUNT, LAYOUT_VARIANTS[2]), "Dvorak 布局: 覆盖表无效");
+static_assert(layoutcheck::overlayValid(QWERTY_KEYS, QWERTY_KEY_COUNT, LAYOUT_VARIANTS[3]), "俄语布局: 覆盖表无效");
+
+// --- findLayoutVariant: 按名称查找内置布局 (不区分大小写)，未找到返回 nullptr ---
+inline const LayoutVariantDef* findLayoutVariant(const QString& name) {
+    for (const LayoutVariantDef& variant : LAYOUT_VARIANTS) {
+        if (name.compare(QLatin1String(variant.name), Qt::CaseInsensitive) == 0) return &variant;
+    }
+    return nullptr;
+}
+
+// --- keyInfoFromDef: 把编译期定义转换为 KeyInfo ---
+inline KeyInfo keyInfoFromDef(const KeyDef& def) {
+    return KeyInfo(QString::fromUtf8(def.text), QString::fromUtf8(def.shiftedText), def.vkCode, def.scanCode,
+                   def.type, def.row, def.column, def.columnSpan, def.extended);
+}
+
+// --- getFullKeyboardLayout 函数 ---
+// 按表生成完整布局 (行列号和扫描码已在表中给出，无需运行时修正)；
+// 给出布局变体时替换其中列出的普通键，布局切换键显示变体的简称
+inline KeyboardLayout getFullKeyboardLayout(const LayoutVariantDef& variant = LAYOUT_VARIANTS[0]) {
+    KeyboardLayout layout;
+    layout.reserve(FULL_LAYOUT_ROWS);
+    for (const KeyDef& def : QWERTY_KEYS) {
+        while (layout.size() <= def.row) layout.append(QList<KeyInfo>());
+        KeyInfo info = keyInfoFromDef(def);
+        if (def.type == KeyType::LayoutSwitch) {
+            info.text = QString::fromUtf8(variant.label);
+        } else if (const KeyOverlay* overlay = layoutcheck::overlayFor(def, variant)) {
+            info.text = QString::fromUtf8(overlay->text);
+            info.shiftedText = QString::fromUtf8(overlay->shiftedText);
+            info.vkCode = overlay->vkCode;
+        }
+        layout[def.row].append(info);
+    }
+    return layout;
+}
+
+// --- appendSplitHalf: 按编译期拆分结果生成一侧的布局 ---
+inline void appendSplitHalf(const QVector<const KeyInfo*>& fullKeys, const SplitKey* keys, int count, KeyboardLayout& half) {
+    int row = -1;
+    for (int i = 0; i < count; ++i) {
+        const SplitKey& splitKey = keys[i];
+        KeyInfo key = *fullKeys[splitKey.source]; // 复制完整布局中的按键 (包括 keyId)
+        key.column = splitKey.column;
+        key.columnSpan = splitKey.columnSpan;
+        if (splitKey.row != row) { half.append(QList<KeyInfo>()); row = splitKey.row; }
+        half.last().append(key);
+    }
+}
+
+// --- splitLayout 函数 (拆分完整布局) ---
+// fullLayout 必须由 getFullKeyboardLayout 生成 (可以已由 KeyTable::build 写入 keyId)，
+// 按键顺序与 QWERTY_KEYS 一致，因此可以直接使用编译期的拆分结果
+inline void splitLayout(const KeyboardLayout& fullLayout, KeyboardLayout& leftLayout, KeyboardLayout& rightLayout) {
+    leftLayout.clear(); rightLayout.clear(); // 清空目标布局
+
+    QVector<const KeyInfo*> fullKeys;
+    fullKeys.reserve(QWERTY_KEY_COUNT);
+    for (const auto& row : fullLayout) {
+        for (const auto& key : row) fullKeys.append(&key);
+    }
+    Q_ASSERT(fullKeys.size() == QWERTY_KEY_COUNT);
+
+    appendSplitHalf(fullKeys, QWERTY_SPLIT.left, QWERTY_SPLIT.leftCount, leftLayout);
+    appendSplitHalf(fullKeys, QWERTY_SPLIT.right, QWERTY_SPLIT.rightCount, rightLayout);
+}
+
+#endif // VIRTUALKEYBOARD_LAYOUTTABLE_H
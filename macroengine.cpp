@@ -0,0 +1,271 @@
+#include "macroengine.h"
+#include "latencystats.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <cstring>
+#include <utility>
+
+// --- 宏文件格式 ---
+namespace {
+
+const char MACRO_MAGIC[4] = { 'V', 'K', 'M', 'C' };
+const quint32 MACRO_VERSION = 2;        // 2: MacroHeader 记录绑定键的扩展标志
+const quint32 MACRO_VERSION_NO_FLAGS = 1; // 仍可读取: 绑定键只按 VK 码和扫描码查找
+const quint8 MACRO_BOUND_EXTENDED = 0x01; // MacroHeader::boundFlags: 绑定键是扩展键
+
+struct FileHeader {
+    char magic[4];       // "VKMC"
+    quint32 version;     // MACRO_VERSION
+    quint32 macroCount;  // 宏的个数
+    quint32 reserved;
+};
+
+struct MacroHeader {
+    quint16 boundVk;          // 绑定键的 VK 码
+    quint16 boundScanCode;    // 绑定键的扫描码
+    quint8 initialModifiers;  // 录制开始时的修饰键状态
+    quint8 boundFlags;        // MACRO_BOUND_EXTENDED (版本 1 中为保留字节)
+    quint8 reserved[2];
+    quint32 stepCount;        // 后面的 MacroStep 个数
+};
+
+static_assert(sizeof(FileHeader) == 16, "FileHeader 大小应固定");
+static_assert(sizeof(MacroHeader) == 12, "MacroHeader 大小应固定");
+static_assert(sizeof(MacroStep) == 8, "MacroStep 大小应固定");
+
+// 回放前后补齐状态时使用的修饰键 (粘滞修饰键使用左侧的键)
+struct ModifierKey {
+    quint8 bit;        // ModifierStateBit
+    quint16 vkCode;
+    quint16 scanCode;
+    bool extended;
+    bool toggle;       // 切换键: 通过一次按下+释放改变状态
+};
+
+const ModifierKey MACRO_MODIFIER_KEYS[] = {
+    { ShiftBit, VK_LSHIFT, 0x2A, false, false },
+    { CtrlBit, VK_LCONTROL, 0x1D, false, false },
+    { AltBit, VK_LMENU, 0x38, false, false },
+    { WinBit, VK_LWIN, 0x5B, true, false },
+    { CapsLockBit, VK_CAPITAL, 0x3A, false, true },
+    { NumLockBit, VK_NUMLOCK, 0x45, true, true } // 扩展标志不能少: 非扩展的 0x45 是 Pause
+};
+
+const quint8 STICKY_MODIFIER_BITS = ShiftBit | CtrlBit | AltBit | WinBit;
+const quint8 EVENT_FLAG_MASK = KeyEvent::KeyDown | KeyEvent::ExtendedKey | KeyEvent::Unicode;
+
+// 把粘滞修饰键从 from 状态改为 to 状态 (切换键不处理)
+void appendStickyChanges(quint8 from, quint8 to, QVector<KeyEvent>& events) {
+    for (const ModifierKey& modifier : MACRO_MODIFIER_KEYS) {
+        if (modifier.toggle || !((from ^ to) & modifier.bit)) continue;
+        events.append(KeyEvent::key(modifier.vkCode, modifier.scanCode, (to & modifier.bit) != 0, modifier.extended));
+    }
+}
+
+// 把切换键从 from 状态改为 to 状态 (每个需要改变的切换键按下+释放一次)
+void appendToggleChanges(quint8 from, quint8 to, QVector<KeyEvent>& events) {
+    for (const ModifierKey& modifier : MACRO_MODIFIER_KEYS) {
+        if (!modifier.toggle || !((from ^ to) & modifier.bit)) continue;
+        events.append(KeyEvent::key(modifier.vkCode, modifier.scanCode, true, modifier.extended));
+        events.append(KeyEvent::key(modifier.vkCode, modifier.scanCode, false, modifier.extended));
+    }
+}
+
+} // namespace
+
+// --- MacroStep::toKeyEvent ---
+KeyEvent MacroStep::toKeyEvent() const {
+    KeyEvent event;
+    event.vkCode = vkCode;
+    event.scanCode = scanCode;
+    event.flags = quint8(flags & EVENT_FLAG_MASK);
+    return event;
+}
+
+// --- startRecording: 丢弃尚未绑定的录制，开始新的录制 ---
+void MacroEngine::startRecording(quint8 modifierBits) {
+    pending = Macro();
+    pending.initialModifiers = modifierBits;
+    recording = true;
+    lastStepNs = LatencyStats::now();
+}
+
+// --- record: 记录一个事件和距上一步的时间 ---
+bool MacroEngine::record(const KeyEvent& event, quint8 modifierBits) {
+    if (!recording || pending.steps.size() >= MAX_STEPS) return false;
+    const qint64 nowNs = LatencyStats::now();
+    MacroStep step;
+    step.vkCode = event.vkCode;
+    step.scanCode = event.scanCode;
+    step.flags = quint8(event.flags & EVENT_FLAG_MASK);
+    step.modifiers = modifierBits;
+    step.delayMs = pending.steps.isEmpty() ? 0 : quint16(qBound<qint64>(0, (nowNs - lastStepNs) / 1000000, 0xFFFF));
+    pending.steps.append(step);
+    lastStepNs = nowNs;
+    return true;
+}
+
+// --- stopRecording ---
+void MacroEngine::stopRecording() {
+    recording = false;
+}
+
+// --- bindRecording: 绑定最近录制的宏 (空宏解除绑定) ---
+void MacroEngine::bindRecording(int keyId, const KeyEntry& key) {
+    recording = false;
+    Macro macro = std::exchange(pending, Macro());
+    if (macro.steps.isEmpty()) {
+        unbind(keyId);
+        return;
+    }
+    macro.boundVk = key.vkCode;
+    macro.boundScanCode = key.scanCode;
+    macro.boundExtended = key.isExtended();
+    setBinding(keyId, std::move(macro));
+}
+
+// --- unbind: 解除按键的绑定 ---
+void MacroEngine::unbind(int keyId) {
+    if (!isBound(keyId)) return;
+    macros.remove(macroByKey[keyId]);
+    macroByKey.fill(-1);
+    for (int i = 0; i < macros.size(); ++i) macroByKey[macros[i].keyId] = i;
+}
+
+// --- setBinding: 预先编码并绑定 (替换该键原有的宏) ---
+void MacroEngine::setBinding(int keyId, Macro macro) {
+    if (keyId < 0) return;
+    macro.keyId = keyId;
+    prepare(macro);
+    if (keyId >= macroByKey.size()) macroByKey.resize(keyId + 1, -1);
+    if (macroByKey[keyId] >= 0) {
+        macros[macroByKey[keyId]] = std::move(macro);
+    } else {
+        macroByKey[keyId] = macros.size();
+        macros.append(std::move(macro));
+    }
+}
+
+// --- prepare: 编码事件、分批边界，以及宏结束时的修饰键状态 ---
+void MacroEngine::prepare(Macro& macro) {
+    macro.events.clear();
+    macro.pressStarts.clear();
+    macro.events.reserve(macro.steps.size());
+    quint8 previous = macro.initialModifiers;
+    macro.touchedModifiers = 0;
+    for (const MacroStep& step : std::as_const(macro.steps)) {
+        if (step.flags & KeyEvent::KeyDown) macro.pressStarts.append(macro.events.size());
+        macro.events.append(step.toKeyEvent());
+        macro.touchedModifiers |= quint8(previous ^ step.modifiers);
+        previous = step.modifiers;
+    }
+    macro.finalModifiers = previous;
+}
+
+// --- appendPlayback: 修饰键前奏 + 预先编码的事件 + 恢复修饰键 ---
+void MacroEngine::appendPlayback(int keyId, quint8 currentModifiers, QVector<KeyEvent>& events,
+                                 QVector<BulkTyper::Batch>* batches) const {
+    if (!isBound(keyId)) return;
+    const Macro& macro = macros[macroByKey[keyId]];
+    const int base = events.size();
+
+    // 前奏: 按下录制时按住而用户没有按住的修饰键，切换键改为录制时的状态
+    const quint8 currentSticky = currentModifiers & STICKY_MODIFIER_BITS;
+    const quint8 playSticky = currentSticky | (macro.initialModifiers & STICKY_MODIFIER_BITS);
+    appendStickyChanges(currentSticky, playSticky, events);
+    appendToggleChanges(currentModifiers, macro.initialModifiers, events);
+    const int bodyStart = events.size();
+
+    // 宏本身: 预先编码的事件，按每次按下分批
+    events.append(macro.events);
+    if (batches) {
+        // 前奏与第一次按下同属第一批
+        for (int i = 1; i < macro.pressStarts.size(); ++i) batches->append({ bodyStart + macro.pressStarts[i], i });
+    }
+
+    // 结束: 宏内部改变过的粘滞修饰键以宏结束时为准，其余保持前奏后的状态；然后全部恢复为用户当前的状态
+    const quint8 endSticky = quint8((playSticky & ~macro.touchedModifiers) |
+                                    (macro.finalModifiers & macro.touchedModifiers & STICKY_MODIFIER_BITS));
+    appendStickyChanges(endSticky, currentSticky, events);
+    appendToggleChanges(macro.finalModifiers, currentModifiers, events);
+    if (batches && events.size() > base) batches->append({ int(events.size()), int(macro.pressStarts.size()) });
+}
+
+// --- load: 读取宏文件并按 VK 码和扫描码重新绑定 ---
+bool MacroEngine::load(const QString& path, const KeyTable& keyTable, QString* errorMessage) {
+    QFile file(path);
+    if (!file.exists()) return true; // 还没有保存过宏
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (errorMessage) *errorMessage = file.errorString();
+        return false;
+    }
+    const QByteArray bytes = file.readAll();
+    const auto fail = [&](const char* message) {
+        if (errorMessage) *errorMessage = QString::fromUtf8(message);
+        return false;
+    };
+
+    FileHeader header;
+    if (bytes.size() < qsizetype(sizeof(header))) return fail("宏文件太短");
+    std::memcpy(&header, bytes.constData(), sizeof(header));
+    if (std::memcmp(header.magic, MACRO_MAGIC, 4) != 0 ||
+        (header.version != MACRO_VERSION && header.version != MACRO_VERSION_NO_FLAGS)) return fail("不是宏文件或版本不兼容");
+    const bool hasBoundFlags = header.version != MACRO_VERSION_NO_FLAGS;
+
+    qsizetype offset = sizeof(header);
+    for (quint32 m = 0; m < header.macroCount; ++m) {
+        MacroHeader macroHeader;
+        if (bytes.size() - offset < qsizetype(sizeof(macroHeader))) return fail("宏文件被截断");
+        std::memcpy(&macroHeader, bytes.constData() + offset, sizeof(macroHeader));
+        offset += sizeof(macroHeader);
+        if (macroHeader.stepCount > quint32(MAX_STEPS) ||
+            bytes.size() - offset < qsizetype(macroHeader.stepCount * sizeof(MacroStep))) return fail("宏文件被截断");
+
+        Macro macro;
+        macro.boundVk = macroHeader.boundVk;
+        macro.boundScanCode = macroHeader.boundScanCode;
+        macro.boundExtended = (macroHeader.boundFlags & MACRO_BOUND_EXTENDED) != 0;
+        macro.initialModifiers = macroHeader.initialModifiers;
+        macro.steps.resize(int(macroHeader.stepCount));
+        std::memcpy(macro.steps.data(), bytes.constData() + offset, macroHeader.stepCount * sizeof(MacroStep));
+        offset += macroHeader.stepCount * sizeof(MacroStep);
+
+        // 在当前布局中查找绑定键 (只允许普通键和特殊键)；VK 码和扫描码相同的键 (主键盘和小键盘的 Enter) 按扩展标志区分
+        for (int keyId = 0; keyId < keyTable.size(); ++keyId) {
+            const KeyEntry& key = keyTable.entry(keyId);
+            if (key.vkCode != macro.boundVk || key.scanCode != macro.boundScanCode) continue;
+            if (hasBoundFlags && key.isExtended() != macro.boundExtended) continue;
+            if (key.type == KeyType::Normal || key.type == KeyType::Special) setBinding(keyId, std::move(macro));
+            break;
+        }
+    }
+    return true;
+}
+
+// --- save: 写出所有宏 (原子替换) ---
+bool MacroEngine::save(const QString& path, QString* errorMessage) const {
+    QByteArray bytes;
+    FileHeader header = {};
+    std::memcpy(header.magic, MACRO_MAGIC, 4);
+    header.version = MACRO_VERSION;
+    header.macroCount = quint32(macros.size());
+    bytes.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const Macro& macro : macros) {
+        MacroHeader macroHeader = {};
+        macroHeader.boundVk = macro.boundVk;
+        macroHeader.boundScanCode = macro.boundScanCode;
+        macroHeader.initialModifiers = macro.initialModifiers;
+        macroHeader.boundFlags = macro.boundExtended ? MACRO_BOUND_EXTENDED : 0;
+        macroHeader.stepCount = quint32(macro.steps.size());
+        bytes.append(reinterpret_cast<const char*>(&macroHeader), sizeof(macroHeader));
+        bytes.append(reinterpret_cast<const char*>(macro.steps.constData()), macro.steps.size() * sizeof(MacroStep));
+    }
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(bytes) != bytes.size() || !file.commit()) {
+        if (errorMessage) *errorMessage = file.errorString();
+        return false;
+    }
+    return true;
+}
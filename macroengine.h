@@ -0,0 +1,90 @@
+#ifndef VIRTUALKEYBOARD_MACROENGINE_H
+#define VIRTUALKEYBOARD_MACROENGINE_H
+
+#include <QString>
+#include <QVector>
+
+#include "bulktyper.h" // BulkTyper::Batch
+#include "keyevent.h"
+#include "keytable.h"  // KeyEntry、ModifierStateBit
+
+// 宏的一步: 一个按下或释放事件 (8 字节，同时也是宏文件中的存储格式)
+struct MacroStep {
+    quint16 vkCode = 0;    // Windows 虚拟键码 (Unicode 事件为 0)
+    quint16 scanCode = 0;  // 扫描码 (Unicode 事件为 UTF-16 代码单元)
+    quint8 flags = 0;      // KeyEvent::KeyDown | ExtendedKey | Unicode
+    quint8 modifiers = 0;  // 事件之后的修饰键/切换键状态 (ModifierStateBit 组合)
+    quint16 delayMs = 0;   // 距上一步的时间 (毫秒，超过 65535 时截断)
+
+    KeyEvent toKeyEvent() const;
+};
+
+// 宏的录制、按键绑定和回放
+// 录制时按键处理函数把注入的每个事件连同当时的修饰键状态和时间交给 record()；
+// 绑定到某个键后，宏的事件序列立即预先编码为 KeyEvent 数组 (按每次按下分好批次)，
+// 按下绑定键时只需在前后补上修饰键的差异，就可以作为一批事件一次交给注入线程。
+//
+// 修饰键: 录制开始时按住的粘滞修饰键在回放前按下 (用户已按住的除外)，回放结束时恢复为用户当前的状态；
+// 大小写锁定和数字锁定在回放前切换为录制开始时的状态，回放后切换回来。
+// 用户按住而录制时没有按住的修饰键保持不变 (与硬件组合键一样作用于宏)。
+//
+// 宏文件格式: [FileHeader][MacroHeader][MacroStep x stepCount]...，本机字节序
+class MacroEngine {
+public:
+    static const int MAX_STEPS = 480; // 一个宏最多的事件数 (加上修饰键后一批不超过注入队列容量的一半)
+
+    // --- 录制 ---
+    // 开始录制 (modifierBits 为开始时的修饰键状态)
+    void startRecording(quint8 modifierBits);
+    // 记录一个注入的事件 (modifierBits 为事件之后的状态)，超过 MAX_STEPS 时忽略并返回 false
+    bool record(const KeyEvent& event, quint8 modifierBits);
+    // 停止录制，已录制的事件留待 bindRecording
+    void stopRecording();
+    bool isRecording() const { return recording; }
+    int recordedSteps() const { return pending.steps.size(); }
+
+    // --- 绑定 ---
+    // 把最近录制的宏绑定到按键 (没有录制任何事件时解除该键的绑定)
+    void bindRecording(int keyId, const KeyEntry& key);
+    void unbind(int keyId);
+    bool isBound(int keyId) const { return keyId >= 0 && keyId < macroByKey.size() && macroByKey[keyId] >= 0; }
+    int macroCount() const { return macros.size(); }
+    int stepCount(int keyId) const { return isBound(keyId) ? macros[macroByKey[keyId]].steps.size() : 0; }
+
+    // --- 回放 ---
+    // 生成绑定在 keyId 上的宏的完整事件序列 (currentModifiers 为用户当前的修饰键状态)；
+    // batches 不为空时在每次按下之前分批 (用于固定的按键间隔)
+    void appendPlayback(int keyId, quint8 currentModifiers, QVector<KeyEvent>& events,
+                        QVector<BulkTyper::Batch>* batches = nullptr) const;
+
+    // --- 宏文件 ---
+    // 加载宏文件 (按绑定键的 VK 码、扫描码和扩展标志在 keyTable 中查找按键，找不到的宏被忽略)；文件不存在时返回 true
+    bool load(const QString& path, const KeyTable& keyTable, QString* errorMessage = nullptr);
+    bool save(const QString& path, QString* errorMessage = nullptr) const;
+
+private:
+    struct Macro {
+        int keyId = -1;              // 绑定键的 id
+        quint16 boundVk = 0;         // 绑定键 (保存到文件，加载时重新查找 id)
+        quint16 boundScanCode = 0;
+        bool boundExtended = false;
+        quint8 initialModifiers = 0; // 录制开始时的状态
+        QVector<MacroStep> steps;
+        // --- 绑定时预先计算 ---
+        QVector<KeyEvent> events;    // 编码好的事件
+        QVector<int> pressStarts;    // 每次按下在 events 中的位置 (分批边界)
+        quint8 finalModifiers = 0;   // 最后一步之后的状态
+        quint8 touchedModifiers = 0; // 宏内部改变过的状态位
+    };
+
+    static void prepare(Macro& macro); // 预先编码事件和修饰键信息
+    void setBinding(int keyId, Macro macro);
+
+    QVector<Macro> macros;
+    QVector<int> macroByKey; // 按键 id -> macros 下标 (-1 表示未绑定)
+    Macro pending;           // 正在录制或等待绑定的宏
+    bool recording = false;
+    qint64 lastStepNs = 0;   // 上一步的时间 (LatencyStats::now)
+};
+
+#endif // VIRTUALKEYBOARD_MACROENGINE_H
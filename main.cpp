@@ -1,19 +1,199 @@
 #include <QApplication>           // Qt 应用程序类
 #include "virtualkeyboardwidget.h" // 包含虚拟键盘窗口类
 #include <QStyleFactory> // 包含样式工厂
+#include <QCommandLineParser> // 命令行参数解析
+#include "startuptrace.h"        // 启动阶段计时
+#include "asynclogger.h"         // 异步日志
+#include "inputreplay.h"         // 输入轨迹回放
+#include <cstring>
+#include <memory>
 
 int main(int argc, char *argv[]) {
+    // 启动计时从这里开始 (首帧时间相对于 main 入口)
+    StartupTrace::start();
+
+    // 回放输入轨迹时默认使用 offscreen 平台 (已设置 QT_QPA_PLATFORM 时不覆盖)，必须在创建 QApplication 之前决定
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--replay", 8) == 0 && !qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+            break;
+        }
+    }
+
     // 创建 Qt 应用程序实例
+    StartupTrace::Phase applicationPhase("qapplication");
     QApplication a(argc, argv);
+    applicationPhase.end();
 
     // 推荐设置一个融合样式，确保跨平台视觉一致性
     QApplication::setStyle(QStyleFactory::create("Fusion"));
 
+    // --- 解析命令行参数 ---
+    // --render=buttons|canvas 选择渲染模式，也可以通过环境变量 VK_RENDER_MODE 设置
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption renderOption("render", "键盘渲染模式: buttons (默认) 或 canvas", "mode",
+                                    qEnvironmentVariable("VK_RENDER_MODE", "buttons"));
+    parser.addOption(renderOption);
+    // --inject=sendinput|xtest|recording 选择注入后端，也可以通过环境变量 VK_INJECT_BACKEND 设置
+    QCommandLineOption injectOption("inject", "按键注入后端: sendinput (Windows 默认)、xtest (X11 默认) 或 recording", "backend",
+                                    qEnvironmentVariable("VK_INJECT_BACKEND"));
+    parser.addOption(injectOption);
+    // --layout=<文件> 从文本布局文件加载布局 (首次加载时编译为二进制缓存，代替内置的 us 布局)，也可以通过环境变量 VK_LAYOUT_FILE 设置
+    QCommandLineOption layoutOption("layout", "文本布局文件 (代替内置的 us QWERTY 布局)", "file",
+                                    qEnvironmentVariable("VK_LAYOUT_FILE"));
+    parser.addOption(layoutOption);
+    // --layouts=<名称,...> 布局切换键循环切换的布局 (内置 us、azerty、dvorak、ru 或布局文件路径，默认全部内置布局)，
+    // 也可以通过环境变量 VK_LAYOUTS 设置
+    QCommandLineOption layoutsOption("layouts", "布局切换键循环的布局，逗号分隔 (默认 us,azerty,dvorak,ru)", "names",
+                                     qEnvironmentVariable("VK_LAYOUTS"));
+    parser.addOption(layoutsOption);
+    // --geometry=full|split|compact|numpad 启动时的键盘排布 (运行时用底部的几何按钮切换)，也可以通过环境变量 VK_GEOMETRY 设置
+    QCommandLineOption geometryOption("geometry", "键盘排布: full、split (默认)、compact 或 numpad", "mode",
+                                      qEnvironmentVariable("VK_GEOMETRY", "split"));
+    parser.addOption(geometryOption);
+    // --startup-trace=<文件> 把启动阶段计时写为 JSON，也可以通过环境变量 VK_STARTUP_TRACE 设置
+    QCommandLineOption startupTraceOption("startup-trace", "把启动阶段计时写入 JSON 文件", "file",
+                                          qEnvironmentVariable("VK_STARTUP_TRACE"));
+    parser.addOption(startupTraceOption);
+    // --quit-after-first-frame 首帧后退出 (用于启动基准测试)
+    QCommandLineOption quitAfterFirstFrameOption("quit-after-first-frame", "首帧绘制完成后退出 (用于启动基准测试)");
+    parser.addOption(quitAfterFirstFrameOption);
+    // --latency-dump=<文件> 退出时把按下到注入的延迟直方图写为 JSON，也可以通过环境变量 VK_LATENCY_DUMP 设置
+    QCommandLineOption latencyDumpOption("latency-dump", "退出时把按键延迟直方图写入 JSON 文件", "file",
+                                         qEnvironmentVariable("VK_LATENCY_DUMP"));
+    parser.addOption(latencyDumpOption);
+    // --dictionary=<文件> 单词预测词典 (每行 "单词 [频率]"，或已编译的 .vkdt 文件)，也可以通过环境变量 VK_DICTIONARY 设置
+    QCommandLineOption dictionaryOption("dictionary", "单词预测词典 (指定后在键盘上方显示建议栏)", "file",
+                                        qEnvironmentVariable("VK_DICTIONARY"));
+    parser.addOption(dictionaryOption);
+    // --pinyin=<文件> 拼音词库 (文本词库或已编译的 .vkpy 文件)，也可以通过环境变量 VK_PINYIN 设置
+    QCommandLineOption pinyinOption("pinyin", "拼音词库 (指定后启用内置拼音输入，建议栏左侧的标签切换中/英)", "file",
+                                    qEnvironmentVariable("VK_PINYIN"));
+    parser.addOption(pinyinOption);
+    // --swipe 滑行输入 (画布模式下从字母键拖动划过单词的各个字母)，也可以通过环境变量 VK_SWIPE 设置
+    QCommandLineOption swipeOption("swipe", "启用滑行输入 (需要 --render=canvas 和 --dictionary)");
+    parser.addOption(swipeOption);
+    // --bulk-batch=<事件数> / --bulk-interval=<毫秒> 批量输入 (输入剪贴板) 的批次大小和批次间隔，
+    // 也可以通过环境变量 VK_BULK_BATCH / VK_BULK_INTERVAL 设置；目标应用处理不过来时增大间隔
+    QCommandLineOption bulkBatchOption("bulk-batch", "批量输入每批的事件数 (默认 256)", "events",
+                                       qEnvironmentVariable("VK_BULK_BATCH"));
+    parser.addOption(bulkBatchOption);
+    QCommandLineOption bulkIntervalOption("bulk-interval", "批量输入两批之间的间隔 (毫秒，默认 0 表示尽快)", "ms",
+                                          qEnvironmentVariable("VK_BULK_INTERVAL"));
+    parser.addOption(bulkIntervalOption);
+    // --macros=<文件> 宏文件 (录制的宏及其绑定键，绑定后立即保存)，也可以通过环境变量 VK_MACROS 设置
+    QCommandLineOption macrosOption("macros", "宏文件 (录制并绑定的宏保存在这里，启动时加载)", "file",
+                                    qEnvironmentVariable("VK_MACROS"));
+    parser.addOption(macrosOption);
+    // --macro-delay=<毫秒> 宏回放时每次按下之间的固定间隔 (默认 0: 整个宏作为一批提交)，也可以通过环境变量 VK_MACRO_DELAY 设置
+    QCommandLineOption macroDelayOption("macro-delay", "宏回放的按键间隔 (毫秒，默认 0 表示一次提交整个宏)", "ms",
+                                        qEnvironmentVariable("VK_MACRO_DELAY"));
+    parser.addOption(macroDelayOption);
+    // --touch-targeting 概率触摸定位 (触摸按下的字母键按高斯按键模型和字符语言模型选择)，也可以通过环境变量 VK_TOUCH_TARGETING 设置
+    QCommandLineOption touchTargetingOption("touch-targeting", "启用概率触摸定位 (有 --dictionary 时由字符语言模型加权)");
+    parser.addOption(touchTargetingOption);
+    // --touch-trace=<文件> 把每次触摸按下的位置、上下文和选中的按键写入轨迹文件 (供 bench_touch 离线回放)，也可以通过环境变量 VK_TOUCH_TRACE 设置
+    QCommandLineOption touchTraceOption("touch-trace", "记录触摸轨迹 (需要 --touch-targeting)", "file",
+                                        qEnvironmentVariable("VK_TOUCH_TRACE"));
+    parser.addOption(touchTraceOption);
+    // --autocorrect 空格/回车时按词典纠正刚输入的单词 (紧接着按退格撤销)，也可以通过环境变量 VK_AUTOCORRECT 设置
+    QCommandLineOption autocorrectOption("autocorrect", "启用自动纠错 (需要 --dictionary)");
+    parser.addOption(autocorrectOption);
+    // --input-trace=<文件> 把每次按下/释放/自动重复的按键、修饰键状态和时间记录为二进制轨迹，也可以通过环境变量 VK_INPUT_TRACE 设置
+    QCommandLineOption inputTraceOption("input-trace", "记录按键输入轨迹 (供 --replay 回放)", "file",
+                                        qEnvironmentVariable("VK_INPUT_TRACE"));
+    parser.addOption(inputTraceOption);
+    // --replay=<文件> 在 offscreen 平台下用内存记录后端回放输入轨迹，报告吞吐和处理耗时后退出；
+    // --replay-realtime 按记录的时间间隔回放 (默认尽快)；--replay-golden=<文件> 与注入事件流比较 (不一致时退出码为 1)；
+    // --replay-write-golden=<文件> 把注入事件流写为 golden 文件
+    QCommandLineOption replayOption("replay", "回放输入轨迹并退出 (使用 offscreen 平台和内存记录后端)", "file");
+    parser.addOption(replayOption);
+    QCommandLineOption replayRealtimeOption("replay-realtime", "按记录的时间间隔回放 (默认尽快回放)");
+    parser.addOption(replayRealtimeOption);
+    QCommandLineOption replayGoldenOption("replay-golden", "与之比较注入事件流的 golden 文件", "file");
+    parser.addOption(replayGoldenOption);
+    QCommandLineOption replayWriteGoldenOption("replay-write-golden", "把回放的注入事件流写为 golden 文件", "file");
+    parser.addOption(replayWriteGoldenOption);
+    // --log-level=trace|debug|info|warning|error 运行期日志级别 (不能低于编译期的 VK_LOG_MIN_LEVEL)，也可以通过环境变量 VK_LOG_LEVEL 设置
+    QCommandLineOption logLevelOption("log-level", "日志级别: trace、debug、info、warning 或 error", "level",
+                                      qEnvironmentVariable("VK_LOG_LEVEL"));
+    parser.addOption(logLevelOption);
+    // --log-file=<文件> 把日志追加到文件 (默认输出到 stderr)，也可以通过环境变量 VK_LOG_FILE 设置
+    QCommandLineOption logFileOption("log-file", "把日志追加写入文件 (默认 stderr)", "file",
+                                     qEnvironmentVariable("VK_LOG_FILE"));
+    parser.addOption(logFileOption);
+    parser.process(a);
+    StartupTrace::setOutputPath(parser.value(startupTraceOption));
+
+    // 日志格式化线程在键盘窗口之前启动、之后停止，窗口析构期间的日志也会输出
+    const QString logLevel = parser.value(logLevelOption);
+    if (!logLevel.isEmpty() && !AsyncLogger::setMinLevel(logLevel)) {
+        qWarning() << "未知的日志级别:" << logLevel;
+    }
+    AsyncLogger::Scope logScope(parser.value(logFileOption));
+
+    KeyboardOptions options;
+    options.renderMode = parser.value(renderOption).compare("canvas", Qt::CaseInsensitive) == 0
+                         ? RenderMode::Canvas : RenderMode::Buttons;
+    options.injectionBackend = parser.value(injectOption);
+    options.layoutFile = parser.value(layoutOption);
+    if (!parser.value(layoutsOption).isEmpty()) options.layouts = parser.value(layoutsOption).split(QLatin1Char(','), Qt::SkipEmptyParts);
+    if (!parseGeometryMode(parser.value(geometryOption), options.geometryMode)) {
+        qWarning() << "未知的键盘排布:" << parser.value(geometryOption) << "，使用 split";
+    }
+    options.latencyDumpPath = parser.value(latencyDumpOption);
+    options.dictionaryFile = parser.value(dictionaryOption);
+    options.pinyinLexicon = parser.value(pinyinOption);
+    options.swipeTyping = parser.isSet(swipeOption) || qEnvironmentVariableIsSet("VK_SWIPE");
+    if (!parser.value(bulkBatchOption).isEmpty()) options.bulkTyping.batchEvents = parser.value(bulkBatchOption).toInt();
+    if (!parser.value(bulkIntervalOption).isEmpty()) options.bulkTyping.intervalMs = parser.value(bulkIntervalOption).toInt();
+    options.macroFile = parser.value(macrosOption);
+    if (!parser.value(macroDelayOption).isEmpty()) options.macroDelayMs = parser.value(macroDelayOption).toInt();
+    options.touchTargeting = parser.isSet(touchTargetingOption) || qEnvironmentVariableIsSet("VK_TOUCH_TARGETING");
+    options.touchTraceFile = parser.value(touchTraceOption);
+    options.autocorrect = parser.isSet(autocorrectOption) || qEnvironmentVariableIsSet("VK_AUTOCORRECT");
+    InputReplayOptions replayOptions;
+    replayOptions.tracePath = parser.value(replayOption);
+    replayOptions.realtime = parser.isSet(replayRealtimeOption);
+    replayOptions.goldenPath = parser.value(replayGoldenOption);
+    replayOptions.writeGoldenPath = parser.value(replayWriteGoldenOption);
+    if (replayOptions.tracePath.isEmpty()) {
+        options.inputTraceFile = parser.value(inputTraceOption);
+    } else {
+        options.injectionBackend = QStringLiteral("recording"); // 回放时不向系统注入，事件流用于比较
+    }
+
     // 创建虚拟键盘窗口实例
-    VirtualKeyboardWidget keyboard;
+    StartupTrace::Phase widgetPhase("widget");
+    VirtualKeyboardWidget keyboard(options);
+    widgetPhase.end();
+
+    // 首帧完成后停止计时并写出结果
+    const bool quitAfterFirstFrame = parser.isSet(quitAfterFirstFrameOption);
+    QObject::connect(&keyboard, &VirtualKeyboardWidget::firstFrameShown, &a, [quitAfterFirstFrame]() {
+        const bool written = StartupTrace::finish();
+        if (quitAfterFirstFrame) QCoreApplication::exit(written ? 0 : 1);
+    });
+
+    // 回放: 首帧之后开始 (延后的初始化先完成)，结束后以比较结果作为退出码
+    std::unique_ptr<InputReplayer> replayer;
+    if (!replayOptions.tracePath.isEmpty()) {
+        replayer = std::make_unique<InputReplayer>(keyboard, replayOptions);
+        QString replayError;
+        if (!replayer->load(&replayError)) {
+            qWarning() << "无法回放输入轨迹:" << replayError;
+            return 1;
+        }
+        QObject::connect(&keyboard, &VirtualKeyboardWidget::firstFrameShown, replayer.get(), &InputReplayer::start, Qt::QueuedConnection);
+        QObject::connect(replayer.get(), &InputReplayer::finished, &a, [](int exitCode) { QCoreApplication::exit(exitCode); });
+    }
+
     // 显示虚拟键盘窗口
+    StartupTrace::Phase showPhase("show");
     keyboard.show();
+    showPhase.end();
 
     // 进入 Qt 应用程序的事件循环
     return QApplication::exec();
-}
\ No newline at end of file
+}
@@ -0,0 +1,228 @@
+#include "pinyinengine.h"
+#include "latencystats.h" // LatencyStats::now
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+// --- 常量定义 ---
+const int PINYIN_MAX_WORDS_PER_COLUMN = 64; // 每列保留的词边数 (按代价)
+const int PINYIN_BEAM = 8;                  // Viterbi 每个词边考察的前驱数 (前驱列中代价最低的几个)
+const int PINYIN_ENTRIES_PER_SPAN = 16;     // 每个音节序列最多取的词条数
+const int PINYIN_LOOKUP_BUDGET = 512;       // 每列最多的词库查找次数 (防止病态输入)
+
+// --- load: 加载词库并清空缓冲区 ---
+bool PinyinEngine::load(const QString& path, QString* errorMessage) {
+    lexicon = PinyinLexicon::open(path, errorMessage);
+    reset();
+    return lexicon != nullptr;
+}
+
+// --- appendChar: 追加字母或分隔符，只计算新的一列 ---
+// 缓冲区已满时仍返回 true (按键被吞掉而不是漏给目标应用)，但不再追加
+bool PinyinEngine::appendChar(QChar ch) {
+    const bool letter = ch >= QLatin1Char('a') && ch <= QLatin1Char('z');
+    const bool separator = ch == QLatin1Char('\'') && !input.isEmpty();
+    if (!letter && !separator) return false;
+    if (input.size() >= MAX_INPUT_LENGTH) return true;
+
+    const qint64 startNs = LatencyStats::now();
+    input.append(ch);
+    columns.resize(input.size() + 1);
+    buildColumn(input.size());
+    cacheValid = false;
+    updateNs = LatencyStats::now() - startNs;
+    return true;
+}
+
+// --- backspace: 删除最后一个字符 (之前的列不受影响) ---
+void PinyinEngine::backspace() {
+    if (input.isEmpty()) return;
+    const qint64 startNs = LatencyStats::now();
+    input.chop(1);
+    columns.resize(input.size() + 1);
+    cacheValid = false;
+    updateNs = LatencyStats::now() - startNs;
+}
+
+void PinyinEngine::reset() {
+    input.clear();
+    columns.clear();
+    columns.resize(1);
+    cacheValid = false;
+}
+
+// --- buildColumn: 计算在 end 结束的音节边和词边 ---
+void PinyinEngine::buildColumn(int end) {
+    Column& column = columns[end];
+    column = Column();
+    if (input.at(end - 1) == QLatin1Char('\'')) {
+        column.syllables.append({ quint16(end - 1), 0, 0, true });
+        return;
+    }
+    // 最长音节 6 个字母: 只需检查最后 6 个字符组成的后缀
+    for (int length = 1; length <= 6 && length <= end; ++length) {
+        const int start = end - length;
+        if (input.at(start) == QLatin1Char('\'')) break;
+        const QStringView letters = QStringView(input).mid(start, length);
+        const quint16 id = PinyinLexicon::syllableId(letters);
+        if (id != PinyinLexicon::NO_SYLLABLE) column.syllables.append({ quint16(start), id, quint16(id + 1), false });
+        quint16 first = 0, last = 0;
+        PinyinLexicon::syllablePrefixRange(letters, &first, &last);
+        if (first != last) column.partialSyllables.append({ quint16(start), first, last, false });
+    }
+    if (!lexicon) return;
+
+    for (const SyllableEdge& edge : std::as_const(column.syllables)) collectWords(edge, column.words);
+    for (const SyllableEdge& edge : std::as_const(column.partialSyllables)) collectWords(edge, column.partialWords);
+
+    // 按代价排序并截断 (后面的列通过下标引用本列的词边，排序必须在它们计算之前完成)
+    const auto byCost = [](const WordEdge& a, const WordEdge& b) { return a.cost < b.cost; };
+    for (QVector<WordEdge>* words : { &column.words, &column.partialWords }) {
+        std::sort(words->begin(), words->end(), byCost);
+        if (words->size() > PINYIN_MAX_WORDS_PER_COLUMN) words->resize(PINYIN_MAX_WORDS_PER_COLUMN);
+    }
+}
+
+// --- collectWords: 以 lastEdge 结尾的所有音节链 (最多 MAX_WORD_SYLLABLES 个音节) ---
+void PinyinEngine::collectWords(const SyllableEdge& lastEdge, QVector<WordEdge>& out) {
+    quint16 chain[PinyinLexicon::MAX_WORD_SYLLABLES];
+    int budget = PINYIN_LOOKUP_BUDGET;
+    extendChain(lastEdge.start, 0, chain, lastEdge, out, budget, true);
+}
+
+// chain[0..depth) 为倒序收集的、位于最后一个音节之前的音节，链从 position 开始
+void PinyinEngine::extendChain(int position, int depth, quint16* chain, const SyllableEdge& lastEdge,
+                               QVector<WordEdge>& out, int& budget, bool lookupHere) {
+    if (lookupHere) {
+        // 正序的音节序列: chain 倒序 + 最后一个音节 (未写完的音节逐个展开范围)
+        quint16 ids[PinyinLexicon::MAX_WORD_SYLLABLES];
+        for (int i = 0; i < depth; ++i) ids[i] = chain[depth - 1 - i];
+        for (quint16 id = lastEdge.first; id < lastEdge.last && budget > 0; ++id, --budget) {
+            ids[depth] = id;
+            addWords(position, ids, depth + 1, out);
+        }
+    }
+    if (depth + 1 >= PinyinLexicon::MAX_WORD_SYLLABLES || position == 0 || budget <= 0) return;
+
+    for (const SyllableEdge& edge : std::as_const(columns[position].syllables)) {
+        if (edge.separator) {
+            // 词可以跨过分隔符 (如 "xi'an")，但分隔符本身不构成音节
+            extendChain(edge.start, depth, chain, lastEdge, out, budget, false);
+        } else {
+            chain[depth] = edge.first;
+            extendChain(edge.start, depth + 1, chain, lastEdge, out, budget, true);
+        }
+    }
+}
+
+// --- addWords: 查词并用 Viterbi 求每个词的最优前驱 ---
+// 前驱是在词的起点 (跳过前导分隔符) 结束的完整词，只考察其中代价最低的 PINYIN_BEAM 个
+void PinyinEngine::addWords(int start, const quint16* ids, int count, QVector<WordEdge>& out) {
+    quint32 found[PINYIN_ENTRIES_PER_SPAN];
+    const int foundCount = lexicon->lookup(ids, count, found, PINYIN_ENTRIES_PER_SPAN);
+    if (foundCount == 0) return;
+
+    while (start > 0 && input.at(start - 1) == QLatin1Char('\'')) --start;
+    const QVector<WordEdge>* predecessors = start > 0 ? &columns[start].words : nullptr;
+    if (predecessors && predecessors->isEmpty()) return; // 起点不可达
+
+    for (int f = 0; f < foundCount; ++f) {
+        WordEdge edge;
+        edge.entry = found[f];
+        edge.start = quint16(start);
+        edge.backColumn = quint16(start);
+        edge.backIndex = -1;
+        edge.cost = lexicon->entry(found[f]).cost;
+        if (predecessors) {
+            edge.cost = std::numeric_limits<qint32>::max();
+            const int beam = qMin(int(predecessors->size()), PINYIN_BEAM);
+            for (int p = 0; p < beam; ++p) {
+                const WordEdge& previous = predecessors->at(p);
+                const qint32 cost = previous.cost + lexicon->transitionCost(previous.entry, edge.entry);
+                if (cost < edge.cost) {
+                    edge.cost = cost;
+                    edge.backIndex = p;
+                }
+            }
+        }
+        out.append(edge);
+    }
+}
+
+// --- pathText: 沿前驱回溯出整条路径的文本 ---
+QString PinyinEngine::pathText(int column, int index, bool partial) const {
+    const WordEdge* edge = &(partial ? columns[column].partialWords : columns[column].words)[index];
+    QString text = lexicon->text(edge->entry);
+    while (edge->backIndex >= 0) {
+        edge = &columns[edge->backColumn].words[edge->backIndex];
+        text.prepend(lexicon->text(edge->entry));
+    }
+    return text;
+}
+
+// --- candidates: 整句最优转换 + 从开头开始的词 ---
+const QStringList& PinyinEngine::candidates() {
+    if (cacheValid) return cachedCandidates;
+    cacheValid = true;
+    cachedCandidates.clear();
+    candidateSources.clear();
+    if (!lexicon || input.isEmpty()) return cachedCandidates;
+
+    // 末尾的分隔符不消耗拼音；末尾未写完的音节只在它确实位于缓冲区末尾时使用
+    int end = input.size();
+    while (end > 0 && input.at(end - 1) == QLatin1Char('\'')) --end;
+    const bool usePartial = end == input.size();
+
+    const auto addCandidate = [this](const QString& text, const Candidate& source) {
+        if (cachedCandidates.size() >= MAX_CANDIDATES || cachedCandidates.contains(text)) return;
+        cachedCandidates.append(text);
+        candidateSources.append(source);
+    };
+
+    // --- 整句: 末尾列中代价最低的词边 ---
+    if (end > 0) {
+        const Column& last = columns[end];
+        const bool fromPartial = usePartial && !last.partialWords.isEmpty() &&
+                                 (last.words.isEmpty() || last.partialWords.first().cost < last.words.first().cost);
+        if (fromPartial || !last.words.isEmpty()) addCandidate(pathText(end, 0, fromPartial), { end, 0, fromPartial });
+    }
+
+    // --- 从开头开始的词: 先长后短，同样长度按代价 ---
+    QVector<Candidate> prefixWords;
+    for (int column = end; column > 0 && prefixWords.size() < MAX_CANDIDATES * 4; --column) {
+        for (int pass = 0; pass < 2; ++pass) {
+            const bool partial = pass == 0; // 末尾列中未写完的词和完整的词按代价合并在下面排序
+            if (partial && !(usePartial && column == end)) continue;
+            const QVector<WordEdge>& words = partial ? columns[column].partialWords : columns[column].words;
+            for (int i = 0; i < words.size(); ++i) {
+                if (words.at(i).start == 0) prefixWords.append({ column, i, partial });
+            }
+        }
+    }
+    std::stable_sort(prefixWords.begin(), prefixWords.end(), [this](const Candidate& a, const Candidate& b) {
+        if (a.column != b.column) return a.column > b.column;
+        const auto& wa = a.partial ? columns[a.column].partialWords : columns[a.column].words;
+        const auto& wb = b.partial ? columns[b.column].partialWords : columns[b.column].words;
+        return wa.at(a.index).cost < wb.at(b.index).cost;
+    });
+    for (const Candidate& source : std::as_const(prefixWords)) {
+        const auto& words = source.partial ? columns[source.column].partialWords : columns[source.column].words;
+        addCandidate(lexicon->text(words.at(source.index).entry), source);
+    }
+    return cachedCandidates;
+}
+
+// --- choose: 提交候选并保留它之后的拼音 ---
+QString PinyinEngine::choose(int index) {
+    candidates();
+    if (index < 0 || index >= cachedCandidates.size()) return QString();
+    const QString text = cachedCandidates.at(index);
+    QString remaining = input.mid(candidateSources.at(index).column);
+    while (remaining.startsWith(QLatin1Char('\''))) remaining.remove(0, 1);
+
+    // 剩余部分从头重建 (选择候选不在按键的热路径上)
+    reset();
+    for (QChar ch : std::as_const(remaining)) appendChar(ch);
+    return text;
+}
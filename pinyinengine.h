@@ -0,0 +1,86 @@
+#ifndef VIRTUALKEYBOARD_PINYINENGINE_H
+#define VIRTUALKEYBOARD_PINYINENGINE_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <memory>
+
+#include "pinyinlexicon.h"
+
+// 拼音输入引擎 (由按键逐字驱动)
+// 输入缓冲区中的每个位置是格 (lattice) 的一列: 列 p 保存在 p 处结束的音节边和词边。
+// 追加一个字母只计算新的一列 (在这里结束的音节、由这些音节组成的词，以及每个词的最优前驱)，
+// 退格只删除最后一列，之前的列不变，因此每次按键的开销与缓冲区长度基本无关。
+// 词边之间用 Viterbi 在二元语法上求最优路径；缓冲区末尾未写完的音节 (如 "zhongg" 的 "g")
+// 按前缀匹配，得到的词边只在它位于末尾时使用。
+class PinyinEngine {
+public:
+    static constexpr int MAX_CANDIDATES = 5;    // 候选数 (与建议栏槽数一致)
+    static constexpr int MAX_INPUT_LENGTH = 96; // 缓冲区最多的字符数
+
+    bool load(const QString& path, QString* errorMessage = nullptr);
+    bool isLoaded() const { return lexicon != nullptr; }
+    const PinyinLexicon* dictionary() const { return lexicon.get(); }
+
+    // 追加一个字符: 小写字母或音节分隔符 '，其他字符不接受 (返回 false)
+    bool appendChar(QChar ch);
+    void backspace();
+    void reset();
+    bool isComposing() const { return !input.isEmpty(); }
+    const QString& composition() const { return input; } // 当前拼音缓冲区
+
+    // 候选: 第一个是整句的最优转换，其余是从缓冲区开头开始的词 (先长后短，同长按代价)
+    const QStringList& candidates();
+    // 选择候选 index: 返回要提交的文本，并从缓冲区中移除它覆盖的拼音 (剩余部分继续组字)
+    QString choose(int index);
+    // 最近一次追加/退格更新格所用的时间 (纳秒)
+    qint64 lastUpdateNs() const { return updateNs; }
+
+private:
+    // 在某列结束的音节边
+    struct SyllableEdge {
+        quint16 start;      // 起始位置
+        quint16 first;      // 音节编号 (前缀匹配时为范围 [first, last))
+        quint16 last;
+        bool separator;     // 分隔符 ' (不构成音节，词可以跨过它)
+    };
+    // 在某列结束的词边
+    struct WordEdge {
+        quint32 entry;      // 词库词条
+        qint32 cost;        // 从缓冲区开头到本词的最优路径代价
+        quint16 start;      // 起始位置 (不含前导分隔符)
+        quint16 backColumn; // 最优前驱所在的列 (start)，没有前驱时为 0
+        qint32 backIndex;   // 最优前驱在该列 words 中的下标 (-1 表示从开头开始)
+    };
+    struct Column {
+        QVector<SyllableEdge> syllables;        // 完整音节和分隔符
+        QVector<SyllableEdge> partialSyllables; // 未写完的音节 (只在末尾列使用)
+        QVector<WordEdge> words;                // 完整的词，按代价升序
+        QVector<WordEdge> partialWords;         // 以未写完的音节结尾的词
+    };
+    struct Candidate {
+        int column;   // 末尾列 (选中后消耗的字符数)
+        int index;    // 在该列中的下标 (-1 表示整句)
+        bool partial; // 在 partialWords 中
+    };
+
+    void buildColumn(int end); // 计算在 end 结束的所有边
+    // 以 lastEdge 为最后一个音节的所有音节链 (向前逐个音节延伸)，逐个查词
+    void collectWords(const SyllableEdge& lastEdge, QVector<WordEdge>& out);
+    void extendChain(int position, int depth, quint16* chain, const SyllableEdge& lastEdge,
+                     QVector<WordEdge>& out, int& budget, bool lookupHere);
+    // 查找音节序列 ids 对应的词条，为每个词条求最优前驱后加入 out
+    void addWords(int start, const quint16* ids, int count, QVector<WordEdge>& out);
+    QString pathText(int column, int index, bool partial) const;
+
+    std::unique_ptr<PinyinLexicon> lexicon;
+    QString input;             // 拼音缓冲区 (小写字母和 ')
+    QVector<Column> columns;   // columns[p]: 在位置 p 结束的边 (columns[0] 为空)
+    QStringList cachedCandidates;
+    QVector<Candidate> candidateSources;
+    bool cacheValid = false;
+    qint64 updateNs = 0;
+};
+
+#endif // VIRTUALKEYBOARD_PINYINENGINE_H
@@ -0,0 +1,466 @@
+#include "pinyinlexicon.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QVector>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <vector>
+
+namespace {
+
+// --- 音节表 (按字母序，ü 写作 v) ---
+const char* const SYLLABLES[] = {
+    "a", "ai", "an", "ang", "ao",
+    "ba", "bai", "ban", "bang", "bao", "bei", "ben", "beng", "bi", "bian", "biao", "bie", "bin", "bing", "bo", "bu",
+    "ca", "cai", "can", "cang", "cao", "ce", "cen", "ceng", "cha", "chai", "chan", "chang", "chao", "che", "chen",
+    "cheng", "chi", "chong", "chou", "chu", "chua", "chuai", "chuan", "chuang", "chui", "chun", "chuo", "ci", "cong",
+    "cou", "cu", "cuan", "cui", "cun", "cuo",
+    "da", "dai", "dan", "dang", "dao", "de", "dei", "den", "deng", "di", "dia", "dian", "diao", "die", "ding", "diu",
+    "dong", "dou", "du", "duan", "dui", "dun", "duo",
+    "e", "ei", "en", "eng", "er",
+    "fa", "fan", "fang", "fei", "fen", "feng", "fo", "fou", "fu",
+    "ga", "gai", "gan", "gang", "gao", "ge", "gei", "gen", "geng", "gong", "gou", "gu", "gua", "guai", "guan", "guang",
+    "gui", "gun", "guo",
+    "ha", "hai", "han", "hang", "hao", "he", "hei", "hen", "heng", "hong", "hou", "hu", "hua", "huai", "huan", "huang",
+    "hui", "hun", "huo",
+    "ji", "jia", "jian", "jiang", "jiao", "jie", "jin", "jing", "jiong", "jiu", "ju", "juan", "jue", "jun",
+    "ka", "kai", "kan", "kang", "kao", "ke", "kei", "ken", "keng", "kong", "kou", "ku", "kua", "kuai", "kuan", "kuang",
+    "kui", "kun", "kuo",
+    "la", "lai", "lan", "lang", "lao", "le", "lei", "leng", "li", "lia", "lian", "liang", "liao", "lie", "lin", "ling",
+    "liu", "lo", "long", "lou", "lu", "luan", "lue", "lun", "luo", "lv", "lve",
+    "ma", "mai", "man", "mang", "mao", "me", "mei", "men", "meng", "mi", "mian", "miao", "mie", "min", "ming", "miu",
+    "mo", "mou", "mu",
+    "na", "nai", "nan", "nang", "nao", "ne", "nei", "nen", "neng", "ni", "nian", "niang", "niao", "nie", "nin", "ning",
+    "niu", "nong", "nou", "nu", "nuan", "nue", "nuo", "nv", "nve",
+    "o", "ou",
+    "pa", "pai", "pan", "pang", "pao", "pei", "pen", "peng", "pi", "pian", "piao", "pie", "pin", "ping", "po", "pou", "pu",
+    "qi", "qia", "qian", "qiang", "qiao", "qie", "qin", "qing", "qiong", "qiu", "qu", "quan", "que", "qun",
+    "ran", "rang", "rao", "re", "ren", "reng", "ri", "rong", "rou", "ru", "rua", "ruan", "rui", "run", "ruo",
+    "sa", "sai", "san", "sang", "sao", "se", "sen", "seng", "sha", "shai", "shan", "shang", "shao", "she", "shei",
+    "shen", "sheng", "shi", "shou", "shu", "shua", "shuai", "shuan", "shuang", "shui", "shun", "shuo", "si", "song",
+    "sou", "su", "suan", "sui", "sun", "suo",
+    "ta", "tai", "tan", "tang", "tao", "te", "tei", "teng", "ti", "tian", "tiao", "tie", "ting", "tong", "tou", "tu",
+    "tuan", "tui", "tun", "tuo",
+    "wa", "wai", "wan", "wang", "wei", "wen", "weng", "wo", "wu",
+    "xi", "xia", "xian", "xiang", "xiao", "xie", "xin", "xing", "xiong", "xiu", "xu", "xuan", "xue", "xun",
+    "ya", "yan", "yang", "yao", "ye", "yi", "yin", "ying", "yo", "yong", "you", "yu", "yuan", "yue", "yun",
+    "za", "zai", "zan", "zang", "zao", "ze", "zei", "zen", "zeng", "zha", "zhai", "zhan", "zhang", "zhao", "zhe",
+    "zhei", "zhen", "zheng", "zhi", "zhong", "zhou", "zhu", "zhua", "zhuai", "zhuan", "zhuang", "zhui", "zhun", "zhuo",
+    "zi", "zong", "zou", "zu", "zuan", "zui", "zun", "zuo",
+};
+const int SYLLABLE_COUNT = int(sizeof(SYLLABLES) / sizeof(SYLLABLES[0]));
+const int MAX_SYLLABLE_LETTERS = 6; // 最长音节 (如 "zhuang") 的字母数
+
+// letters 与以 NUL 结尾的 ASCII 音节比较 (只比较 letters 的长度，返回 <0/0/>0)
+int compareLetters(QStringView letters, const char* syllable) {
+    for (qsizetype i = 0; i < letters.size(); ++i) {
+        const char16_t a = letters[i].unicode();
+        const char16_t b = char16_t(uchar(syllable[i]));
+        if (b == 0) return 1; // 音节较短
+        if (a != b) return a < b ? -1 : 1;
+    }
+    return 0;
+}
+
+// --- 二进制格式 ---
+// [LexiconHeader][Entry x entryCount][quint32 firstIndex x (SYLLABLE_COUNT + 1)]
+// [quint16 音节池 (按 4 字节对齐)][char16_t 文本池 (按 4 字节对齐)][Bigram x bigramCount]，本机字节序
+const char LEXICON_MAGIC[4] = { 'V', 'K', 'P', 'Y' };
+const quint32 LEXICON_VERSION = 1;
+
+struct LexiconHeader {
+    char magic[4];          // "VKPY"
+    quint32 version;        // LEXICON_VERSION
+    qint64 sourceMtime;     // 源文件修改时间 (毫秒，直接打开的 .vkpy 文件不检查)
+    qint64 sourceSize;      // 源文件大小
+    quint32 syllableCount;  // 编译时的音节表大小 (音节表变化时缓存失效)
+    quint32 entryCount;     // 词条数
+    quint32 syllablePoolSize; // 音节池中的音节数
+    quint32 textPoolSize;   // 文本池中的 UTF-16 代码单元数
+    quint32 bigramCount;    // 二元语法数
+    quint32 reserved;
+};
+
+static_assert(sizeof(LexiconHeader) == 48, "LexiconHeader 大小应固定");
+static_assert(sizeof(PinyinLexicon::Entry) == 16, "PinyinLexicon::Entry 大小应固定");
+
+const double BIGRAM_WEIGHT = 0.9; // 二元概率的插值权重 (其余为一元概率)
+
+quint32 alignedTo4(quint32 bytes) { return (bytes + 3u) & ~3u; }
+
+const LexiconHeader* headerOf(const uchar* data) { return reinterpret_cast<const LexiconHeader*>(data); }
+
+void setError(QString* errorMessage, const QString& message) {
+    if (errorMessage) *errorMessage = message;
+}
+
+// 文件开头是否为二进制词库
+bool isCompiledLexicon(const QString& path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+    char magic[4];
+    return file.read(magic, sizeof(magic)) == sizeof(magic) && std::memcmp(magic, LEXICON_MAGIC, sizeof(magic)) == 0;
+}
+
+// 概率 -> 定点代价
+quint32 costForProbability(double probability) {
+    const double cost = -std::log2(qMax(probability, 1e-300)) * PinyinLexicon::COST_SCALE;
+    return quint32(qBound(0.0, std::round(cost), 65535.0));
+}
+
+// 各段在文件中的偏移
+struct LexiconLayout {
+    quint32 entries, firstIndex, syllables, text, bigrams, total;
+
+    explicit LexiconLayout(const LexiconHeader& header) {
+        entries = sizeof(LexiconHeader);
+        firstIndex = entries + header.entryCount * quint32(sizeof(PinyinLexicon::Entry));
+        syllables = firstIndex + (header.syllableCount + 1) * quint32(sizeof(quint32));
+        text = syllables + alignedTo4(header.syllablePoolSize * quint32(sizeof(quint16)));
+        bigrams = text + alignedTo4(header.textPoolSize * quint32(sizeof(char16_t)));
+        total = bigrams + header.bigramCount * 12u;
+    }
+};
+
+// 编译时的词条
+struct SourceEntry {
+    QString text;
+    std::vector<quint16> syllables;
+    quint64 frequency;
+};
+
+} // namespace
+
+// --- 音节表 ---
+int PinyinLexicon::syllableCount() { return SYLLABLE_COUNT; }
+
+const char* PinyinLexicon::syllableText(quint16 id) {
+    return id < SYLLABLE_COUNT ? SYLLABLES[id] : "";
+}
+
+quint16 PinyinLexicon::syllableId(QStringView letters) {
+    if (letters.isEmpty() || letters.size() > MAX_SYLLABLE_LETTERS) return NO_SYLLABLE;
+    const char* const* end = SYLLABLES + SYLLABLE_COUNT;
+    const char* const* it = std::lower_bound(SYLLABLES, end, letters, [](const char* syllable, QStringView key) {
+        return compareLetters(key, syllable) > 0;
+    });
+    if (it != end && compareLetters(letters, *it) == 0 && (*it)[letters.size()] == 0) return quint16(it - SYLLABLES);
+    return NO_SYLLABLE;
+}
+
+void PinyinLexicon::syllablePrefixRange(QStringView letters, quint16* first, quint16* last) {
+    *first = *last = 0;
+    if (letters.isEmpty() || letters.size() >= MAX_SYLLABLE_LETTERS) return;
+    // 音节表有序: 以 letters 开头的音节连续存放，完全相等的音节 (如果有) 排在最前面
+    const char* const* end = SYLLABLES + SYLLABLE_COUNT;
+    const char* const* it = std::lower_bound(SYLLABLES, end, letters, [](const char* syllable, QStringView key) {
+        return compareLetters(key, syllable) > 0;
+    });
+    if (it != end && compareLetters(letters, *it) == 0 && (*it)[letters.size()] == 0) ++it;
+    const char* const* stop = it;
+    while (stop != end && compareLetters(letters, *stop) == 0) ++stop;
+    *first = quint16(it - SYLLABLES);
+    *last = quint16(stop - SYLLABLES);
+}
+
+// --- cachePathFor: 文本词库对应的缓存路径 ---
+QString PinyinLexicon::cachePathFor(const QString& sourcePath) {
+    const QFileInfo sourceInfo(sourcePath);
+    const QByteArray pathHash = QCryptographicHash::hash(sourceInfo.absoluteFilePath().toUtf8(), QCryptographicHash::Sha1).toHex().left(12);
+    const QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/dictionaries");
+    return cacheDir + QLatin1Char('/') + sourceInfo.completeBaseName() + QLatin1Char('-') + QString::fromLatin1(pathHash) + QStringLiteral(".vkpy");
+}
+
+// --- compile: 把文本词库编译为二进制文件 ---
+bool PinyinLexicon::compile(const QString& sourcePath, const QString& outputPath, QString* errorMessage) {
+    QFile source(sourcePath);
+    if (!source.open(QIODevice::ReadOnly)) {
+        setError(errorMessage, QStringLiteral("无法打开拼音词库 %1: %2").arg(sourcePath, source.errorString()));
+        return false;
+    }
+    const QFileInfo sourceInfo(source);
+
+    // --- 解析文本 ---
+    enum class Section { Words, Bigrams } section = Section::Words;
+    std::vector<SourceEntry> sourceEntries;
+    std::vector<std::pair<QString, QString>> bigramWords;
+    std::vector<quint64> bigramCounts;
+    int lineNumber = 0;
+    while (!source.atEnd()) {
+        const QByteArray line = source.readLine().trimmed();
+        ++lineNumber;
+        if (line.isEmpty() || line.startsWith('#')) continue;
+        if (line == "[words]") { section = Section::Words; continue; }
+        if (line == "[bigrams]") { section = Section::Bigrams; continue; }
+
+        const QList<QByteArray> fields = line.simplified().split(' ');
+        const auto fail = [&](const char* what) {
+            setError(errorMessage, QStringLiteral("%1:%2: %3").arg(sourcePath).arg(lineNumber).arg(QString::fromUtf8(what)));
+            return false;
+        };
+        bool ok = true;
+        if (section == Section::Bigrams) {
+            if (fields.size() != 3) return fail("二元语法应为 \"前词 后词 次数\"");
+            const quint64 count = fields.at(2).toULongLong(&ok);
+            if (!ok) return fail("无法解析次数");
+            bigramWords.emplace_back(QString::fromUtf8(fields.at(0)), QString::fromUtf8(fields.at(1)));
+            bigramCounts.push_back(count);
+            continue;
+        }
+
+        if (fields.size() < 2 || fields.size() > 3) return fail("词条应为 \"词 拼音 [频率]\"");
+        SourceEntry entry;
+        entry.text = QString::fromUtf8(fields.at(0));
+        entry.frequency = fields.size() > 2 ? fields.at(2).toULongLong(&ok) : 1;
+        if (!ok) return fail("无法解析频率");
+        for (const QByteArray& syllable : fields.at(1).toLower().split('\'')) {
+            const quint16 id = syllableId(QString::fromLatin1(syllable));
+            if (id == NO_SYLLABLE) return fail("无效的拼音音节");
+            entry.syllables.push_back(id);
+        }
+        if (entry.text.isEmpty() || entry.text.size() > 255 || int(entry.syllables.size()) > MAX_WORD_SYLLABLES) continue;
+        sourceEntries.push_back(std::move(entry));
+    }
+
+    // --- 合并重复词条 (频率相加)，分配词编号 ---
+    std::sort(sourceEntries.begin(), sourceEntries.end(), [](const SourceEntry& a, const SourceEntry& b) {
+        return a.syllables < b.syllables || (a.syllables == b.syllables && a.text < b.text);
+    });
+    std::vector<SourceEntry> merged;
+    for (SourceEntry& entry : sourceEntries) {
+        if (!merged.empty() && merged.back().syllables == entry.syllables && merged.back().text == entry.text) {
+            merged.back().frequency += entry.frequency;
+        } else {
+            merged.push_back(std::move(entry));
+        }
+    }
+    quint64 totalFrequency = 0;
+    QHash<QString, quint32> wordIds;
+    std::vector<quint64> wordFrequencies; // 按词编号: 所有读音的频率之和
+    for (const SourceEntry& entry : merged) {
+        totalFrequency += entry.frequency;
+        const quint32 nextId = quint32(wordFrequencies.size());
+        const quint32 id = wordIds.value(entry.text, nextId);
+        if (id == nextId) {
+            wordIds.insert(entry.text, id);
+            wordFrequencies.push_back(0);
+        }
+        wordFrequencies[id] += entry.frequency;
+    }
+    const double total = double(qMax<quint64>(totalFrequency, 1));
+
+    // --- 词条表: 同一音节序列内按代价升序 ---
+    std::vector<Entry> entryTable;
+    std::vector<quint16> syllablePool;
+    std::vector<char16_t> textPool;
+    entryTable.reserve(merged.size());
+    for (const SourceEntry& entry : merged) {
+        Entry out;
+        out.textOffset = quint32(textPool.size());
+        out.syllableOffset = quint32(syllablePool.size());
+        out.wordId = wordIds.value(entry.text);
+        out.syllableCount = quint8(entry.syllables.size());
+        out.textLength = quint8(entry.text.size());
+        out.cost = quint16(costForProbability(entry.frequency / total));
+        syllablePool.insert(syllablePool.end(), entry.syllables.begin(), entry.syllables.end());
+        textPool.insert(textPool.end(), entry.text.utf16(), entry.text.utf16() + entry.text.size());
+        entryTable.push_back(out);
+    }
+    for (size_t begin = 0; begin < entryTable.size();) {
+        size_t end = begin + 1;
+        while (end < entryTable.size() && merged[end].syllables == merged[begin].syllables) ++end;
+        std::stable_sort(entryTable.begin() + begin, entryTable.begin() + end, [](const Entry& a, const Entry& b) { return a.cost < b.cost; });
+        begin = end;
+    }
+    std::vector<quint32> firstIndex(size_t(SYLLABLE_COUNT) + 1, 0);
+    for (size_t i = 0, s = 0; s <= size_t(SYLLABLE_COUNT); ++s) {
+        while (i < merged.size() && merged[i].syllables.front() < s) ++i;
+        firstIndex[s] = quint32(i);
+    }
+
+    // --- 二元语法: 插值概率 λ·P(后|前) + (1-λ)·P(后) ---
+    std::map<std::pair<quint32, quint32>, quint64> bigramTotals;
+    for (size_t i = 0; i < bigramWords.size(); ++i) {
+        const quint32 missing = 0xFFFFFFFFu;
+        const quint32 left = wordIds.value(bigramWords[i].first, missing);
+        const quint32 right = wordIds.value(bigramWords[i].second, missing);
+        if (left == missing || right == missing) continue; // 不在词条段中的词被忽略
+        bigramTotals[{ left, right }] += bigramCounts[i];
+    }
+    std::vector<Bigram> bigramTable;
+    bigramTable.reserve(bigramTotals.size());
+    for (const auto& item : bigramTotals) {
+        const double leftFrequency = double(qMax(wordFrequencies[item.first.first], item.second));
+        const double probability = BIGRAM_WEIGHT * (item.second / leftFrequency) +
+                                   (1.0 - BIGRAM_WEIGHT) * (wordFrequencies[item.first.second] / total);
+        bigramTable.push_back({ item.first.first, item.first.second, costForProbability(probability) });
+    }
+
+    // --- 写入文件 ---
+    LexiconHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, LEXICON_MAGIC, sizeof(LEXICON_MAGIC));
+    header.version = LEXICON_VERSION;
+    header.sourceMtime = sourceInfo.lastModified().toMSecsSinceEpoch();
+    header.sourceSize = sourceInfo.size();
+    header.syllableCount = quint32(SYLLABLE_COUNT);
+    header.entryCount = quint32(entryTable.size());
+    header.syllablePoolSize = quint32(syllablePool.size());
+    header.textPoolSize = quint32(textPool.size());
+    header.bigramCount = quint32(bigramTable.size());
+    const LexiconLayout layout(header);
+
+    QByteArray bytes(int(layout.total), '\0');
+    char* out = bytes.data();
+    std::memcpy(out, &header, sizeof(header));
+    if (!entryTable.empty()) std::memcpy(out + layout.entries, entryTable.data(), entryTable.size() * sizeof(Entry));
+    std::memcpy(out + layout.firstIndex, firstIndex.data(), firstIndex.size() * sizeof(quint32));
+    if (!syllablePool.empty()) std::memcpy(out + layout.syllables, syllablePool.data(), syllablePool.size() * sizeof(quint16));
+    if (!textPool.empty()) std::memcpy(out + layout.text, textPool.data(), textPool.size() * sizeof(char16_t));
+    if (!bigramTable.empty()) std::memcpy(out + layout.bigrams, bigramTable.data(), bigramTable.size() * sizeof(Bigram));
+
+    QDir().mkpath(QFileInfo(outputPath).absolutePath());
+    QSaveFile output(outputPath);
+    if (!output.open(QIODevice::WriteOnly) || output.write(bytes) != bytes.size() || !output.commit()) {
+        setError(errorMessage, QStringLiteral("无法写入拼音词库 %1: %2").arg(outputPath, output.errorString()));
+        return false;
+    }
+    qDebug() << "拼音词库已编译:" << sourcePath << "->" << outputPath << "词条数:" << header.entryCount
+             << "二元语法数:" << header.bigramCount;
+    return true;
+}
+
+// --- map: 映射并校验二进制词库 ---
+bool PinyinLexicon::map(const QString& path, QString* errorMessage) {
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        setError(errorMessage, QStringLiteral("无法打开拼音词库 %1").arg(path));
+        return false;
+    }
+    const qint64 size = file.size();
+    if (size >= qint64(sizeof(LexiconHeader))) data = file.map(0, size);
+    if (!data) {
+        setError(errorMessage, QStringLiteral("无法映射拼音词库 %1").arg(path));
+        file.close();
+        return false;
+    }
+
+    const LexiconHeader& header = *headerOf(data);
+    bool valid = std::memcmp(header.magic, LEXICON_MAGIC, sizeof(LEXICON_MAGIC)) == 0 && header.version == LEXICON_VERSION &&
+                 header.syllableCount == quint32(SYLLABLE_COUNT);
+    if (valid) {
+        const LexiconLayout layout(header);
+        valid = qint64(layout.total) == size;
+        if (valid) {
+            entryTable = reinterpret_cast<const Entry*>(data + layout.entries);
+            firstIndex = reinterpret_cast<const quint32*>(data + layout.firstIndex);
+            syllablePool = reinterpret_cast<const quint16*>(data + layout.syllables);
+            textPool = reinterpret_cast<const char16_t*>(data + layout.text);
+            bigramTable = reinterpret_cast<const Bigram*>(data + layout.bigrams);
+        }
+        // 检查所有偏移都落在各自的池内
+        for (quint32 i = 0; valid && i < header.entryCount; ++i) {
+            const Entry& e = entryTable[i];
+            valid = e.syllableCount > 0 && quint64(e.syllableOffset) + e.syllableCount <= header.syllablePoolSize &&
+                    quint64(e.textOffset) + e.textLength <= header.textPoolSize;
+        }
+        for (int s = 0; valid && s < SYLLABLE_COUNT; ++s) {
+            valid = firstIndex[s] <= firstIndex[s + 1] && firstIndex[s + 1] <= header.entryCount;
+        }
+    }
+    if (!valid) {
+        setError(errorMessage, QStringLiteral("拼音词库 %1 已损坏或版本不符").arg(path));
+        file.unmap(const_cast<uchar*>(data));
+        data = nullptr;
+        file.close();
+        return false;
+    }
+    entries = header.entryCount;
+    bigrams = header.bigramCount;
+    return true;
+}
+
+// --- open: 打开词库 (文本词库的缓存过期时重新编译) ---
+std::unique_ptr<PinyinLexicon> PinyinLexicon::open(const QString& path, QString* errorMessage) {
+    const QFileInfo sourceInfo(path);
+    if (!sourceInfo.isFile()) {
+        setError(errorMessage, QStringLiteral("拼音词库不存在: %1").arg(path));
+        return nullptr;
+    }
+
+    std::unique_ptr<PinyinLexicon> lexicon(new PinyinLexicon);
+    if (isCompiledLexicon(path)) {
+        if (!lexicon->map(path, errorMessage)) return nullptr;
+        return lexicon;
+    }
+
+    const QString cachePath = cachePathFor(path);
+    bool upToDate = lexicon->map(cachePath, nullptr);
+    if (upToDate) {
+        const LexiconHeader& header = *headerOf(lexicon->data);
+        upToDate = header.sourceMtime == sourceInfo.lastModified().toMSecsSinceEpoch() && header.sourceSize == sourceInfo.size();
+        if (!upToDate) {
+            // 先解除映射，否则部分平台无法替换被映射的文件
+            lexicon->file.unmap(const_cast<uchar*>(lexicon->data));
+            lexicon->data = nullptr;
+            lexicon->file.close();
+        }
+    }
+    if (!upToDate) {
+        if (!compile(path, cachePath, errorMessage) || !lexicon->map(cachePath, errorMessage)) return nullptr;
+        lexicon->recompiled = true;
+    }
+    return lexicon;
+}
+
+PinyinLexicon::~PinyinLexicon() {
+    if (data) file.unmap(const_cast<uchar*>(data));
+}
+
+QString PinyinLexicon::text(quint32 index) const {
+    const Entry& e = entryTable[index];
+    return QString(reinterpret_cast<const QChar*>(textPool + e.textOffset), e.textLength);
+}
+
+// --- lookup: 二分查找音节序列 ---
+// 词条按音节序列的字典序排列，与查找序列相等的词条连续存放且按代价升序，取开头的 maxOut 个即可
+int PinyinLexicon::lookup(const quint16* ids, int count, quint32* out, int maxOut) const {
+    if (count <= 0 || ids[0] >= SYLLABLE_COUNT) return 0;
+    const auto less = [this](const Entry& e, const std::pair<const quint16*, int>& key) {
+        const quint16* s = syllablePool + e.syllableOffset;
+        return std::lexicographical_compare(s, s + e.syllableCount, key.first, key.first + key.second);
+    };
+    const Entry* begin = entryTable + firstIndex[ids[0]];
+    const Entry* end = entryTable + firstIndex[ids[0] + 1];
+    const Entry* it = std::lower_bound(begin, end, std::make_pair(ids, count), less);
+
+    int found = 0;
+    for (; it != end && found < maxOut; ++it) {
+        if (it->syllableCount != count || !std::equal(ids, ids + count, syllablePool + it->syllableOffset)) break;
+        out[found++] = quint32(it - entryTable);
+    }
+    return found;
+}
+
+// --- transitionCost: 二元转移代价 ---
+int PinyinLexicon::transitionCost(quint32 left, quint32 right) const {
+    static const int backoffCost = int(costForProbability(1.0 - BIGRAM_WEIGHT));
+    const quint32 leftWord = entryTable[left].wordId;
+    const quint32 rightWord = entryTable[right].wordId;
+    const Bigram* end = bigramTable + bigrams;
+    const Bigram* it = std::lower_bound(bigramTable, end, std::make_pair(leftWord, rightWord),
+                                        [](const Bigram& b, const std::pair<quint32, quint32>& key) {
+        return b.left < key.first || (b.left == key.first && b.right < key.second);
+    });
+    if (it != end && it->left == leftWord && it->right == rightWord) return int(it->cost);
+    return entryTable[right].cost + backoffCost;
+}
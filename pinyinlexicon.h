@@ -0,0 +1,86 @@
+#ifndef VIRTUALKEYBOARD_PINYINLEXICON_H
+#define VIRTUALKEYBOARD_PINYINLEXICON_H
+
+#include <QFile>
+#include <QString>
+#include <QStringView>
+#include <memory>
+
+// 内存映射的拼音词库 (词条 + 二元语法)
+// 文本词库第一次加载时被编译为二进制缓存 (位于 CacheLocation)，之后直接映射；
+// 也可以直接打开已编译的 .vkpy 文件。文本格式:
+//   [words]                 词条段: "词 拼音 [频率]"，拼音的音节用 ' 分隔，例如 "西安 xi'an 5000"
+//   [bigrams]               二元段: "前词 后词 次数"
+//
+// 音节用固定音节表中的编号 (按字母序) 表示。词条按音节序列排序，同一音节序列的词条按代价升序，
+// 查找一个音节序列只需一次二分查找。代价均为 -log2(概率) * COST_SCALE 的整数。
+class PinyinLexicon {
+public:
+    static constexpr int MAX_WORD_SYLLABLES = 8; // 词条最多的音节数 (更长的在编译时被忽略)
+    static constexpr int COST_SCALE = 256;       // 代价的定点比例
+    static constexpr quint16 NO_SYLLABLE = 0xFFFF;
+
+    // 词条 (16 字节)
+    struct Entry {
+        quint32 textOffset;     // 文本在文本池中的位置 (UTF-16 代码单元)
+        quint32 syllableOffset; // 音节序列在音节池中的位置
+        quint32 wordId;         // 词编号 (同一文本的不同读音共享，用于二元语法)
+        quint8 syllableCount;   // 音节数
+        quint8 textLength;      // 文本长度
+        quint16 cost;           // 一元代价
+    };
+
+    // 打开词库 (文本词库必要时先编译缓存)，失败返回 nullptr
+    static std::unique_ptr<PinyinLexicon> open(const QString& path, QString* errorMessage = nullptr);
+    // 把文本词库编译为二进制文件
+    static bool compile(const QString& sourcePath, const QString& outputPath, QString* errorMessage = nullptr);
+    // 文本词库对应的缓存路径
+    static QString cachePathFor(const QString& sourcePath);
+
+    // --- 音节表 ---
+    static int syllableCount();
+    static const char* syllableText(quint16 id);
+    // 完整音节的编号 (不是音节时返回 NO_SYLLABLE)，letters 只含小写字母
+    static quint16 syllableId(QStringView letters);
+    // 以 letters 为真前缀的音节的编号范围 [first, last)，没有时 first == last
+    static void syllablePrefixRange(QStringView letters, quint16* first, quint16* last);
+
+    ~PinyinLexicon();
+    PinyinLexicon(const PinyinLexicon&) = delete;
+    PinyinLexicon& operator=(const PinyinLexicon&) = delete;
+
+    quint32 entryCount() const { return entries; }
+    quint32 bigramCount() const { return bigrams; }
+    bool compiledOnOpen() const { return recompiled; }
+    const Entry& entry(quint32 index) const { return entryTable[index]; }
+    QString text(quint32 index) const;
+
+    // 音节序列恰好为 ids[0..count) 的词条，按代价升序写入最多 maxOut 个下标，返回个数
+    int lookup(const quint16* ids, int count, quint32* out, int maxOut) const;
+    // 从 left 转移到 right 的代价 (有二元语法时使用插值概率，否则为 right 的一元代价加回退代价)
+    int transitionCost(quint32 left, quint32 right) const;
+
+private:
+    PinyinLexicon() = default;
+    bool map(const QString& path, QString* errorMessage); // 映射并校验二进制文件
+
+    // 二元语法 (12 字节)，按 (left, right) 排序
+    struct Bigram {
+        quint32 left;  // 前词 wordId
+        quint32 right; // 后词 wordId
+        quint32 cost;  // 插值后的转移代价
+    };
+
+    QFile file;
+    const uchar* data = nullptr;
+    const Entry* entryTable = nullptr;
+    const quint32* firstIndex = nullptr; // 按首音节分段: [firstIndex[id], firstIndex[id + 1])
+    const quint16* syllablePool = nullptr;
+    const char16_t* textPool = nullptr;
+    const Bigram* bigramTable = nullptr;
+    quint32 entries = 0;
+    quint32 bigrams = 0;
+    bool recompiled = false;
+};
+
+#endif // VIRTUALKEYBOARD_PINYINLEXICON_H
@@ -0,0 +1,86 @@
+#include "predictionengine.h"
+#include "latencystats.h" // LatencyStats::now
+
+#include <utility>
+
+// --- load: 加载词典并重置输入状态 ---
+bool PredictionEngine::load(const QString& path, QString* errorMessage) {
+    trie = WordTrie::open(path, errorMessage);
+    reset();
+    return trie != nullptr;
+}
+
+// --- appendChar: 追加字符，沿前缀树向下走一步 ---
+void PredictionEngine::appendChar(QChar ch) {
+    if (!isWordChar(ch)) {
+        commitWord();
+        return;
+    }
+    // 太长的单词不在词典中，不再查找，但仍记录字符: 之后的退格与追加一一对应，prefix() 与屏幕上的文本一致
+    const QChar lower = ch.toLower();
+    const quint32 parent = nodePath.last();
+    const bool searchable = trie && parent != WordTrie::NO_NODE && typed.size() < WordTrie::MAX_WORD_LENGTH;
+    nodePath.append(searchable ? trie->child(parent, lower.unicode()) : WordTrie::NO_NODE);
+    typed.append(ch);
+    lowered.append(lower);
+    cacheValid = false;
+}
+
+// --- backspace: 回退一个字符 ---
+void PredictionEngine::backspace() {
+    if (typed.isEmpty()) {
+        reset();
+        return;
+    }
+    typed.chop(1);
+    lowered.chop(1);
+    nodePath.removeLast();
+    cacheValid = false;
+}
+
+void PredictionEngine::commitWord() {
+    reset();
+}
+
+// --- reset: 回到单词开头 (根节点) ---
+void PredictionEngine::reset() {
+    typed.clear();
+    lowered.clear();
+    nodePath.clear();
+    nodePath.reserve(WordTrie::MAX_WORD_LENGTH + 1);
+    nodePath.append(WordTrie::ROOT);
+    cacheValid = false;
+}
+
+// --- suggestions: 当前前缀的补全 (前缀未变时返回缓存) ---
+const QStringList& PredictionEngine::suggestions() {
+    if (cacheValid) return cachedSuggestions;
+    cacheValid = true;
+    cachedSuggestions.clear();
+    if (!trie) return cachedSuggestions;
+
+    const qint64 startNs = LatencyStats::now();
+    trie->complete(nodePath.last(), lowered, MAX_SUGGESTIONS + 1, completions);
+    for (const WordTrie::Completion& completion : std::as_const(completions)) {
+        if (completion.word.size() == lowered.size()) continue; // 已完整输入的单词本身不作为建议
+        cachedSuggestions.append(applyCase(completion.word, typed));
+        if (cachedSuggestions.size() == MAX_SUGGESTIONS) break;
+    }
+    queryNs = LatencyStats::now() - startNs;
+    return cachedSuggestions;
+}
+
+// --- applyCase: 让补全结果的大小写跟随已输入的前缀 ---
+// 已输入的部分保持原样，补全的部分在前缀全部大写时大写，否则小写
+QString PredictionEngine::applyCase(const QString& word, const QString& typedPrefix) {
+    if (typedPrefix.isEmpty()) return word;
+    bool allUpper = typedPrefix.size() >= 2;
+    for (QChar ch : typedPrefix) {
+        if (ch.isLower()) {
+            allUpper = false;
+            break;
+        }
+    }
+    const QString completion = word.mid(typedPrefix.size());
+    return typedPrefix + (allUpper ? completion.toUpper() : completion);
+}
@@ -0,0 +1,58 @@
+#ifndef VIRTUALKEYBOARD_PREDICTIONENGINE_H
+#define VIRTUALKEYBOARD_PREDICTIONENGINE_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <memory>
+
+#include "wordtrie.h"
+
+// 单词预测引擎
+// 按键处理函数把输入的字符逐个交给引擎，引擎记录当前单词的前缀以及前缀每个长度对应的前缀树节点:
+// 追加字符只需在当前节点的子节点中查找一次，退格只需弹出一层，不必从根重新查找。
+// 建议列表按前缀缓存，前缀没有变化时直接返回上次的结果。
+// 不在单词中时 (刚输入了空格或标点) 给出词典中最常用的单词作为下一个词的候选。
+class PredictionEngine {
+public:
+    static const int MAX_SUGGESTIONS = 5; // 建议栏中的候选数
+
+    // 加载词典 (文本或已编译的 .vkdt 文件)
+    bool load(const QString& path, QString* errorMessage = nullptr);
+    bool isLoaded() const { return trie != nullptr; }
+    const WordTrie* dictionary() const { return trie.get(); }
+
+    // --- 输入 ---
+    // 追加一个字符: 字母、数字和撇号延长当前单词，其他字符结束当前单词
+    void appendChar(QChar ch);
+    // 删除当前单词的最后一个字符 (不在单词中时无法得知前面的文本，等同于 reset)
+    void backspace();
+    // 单词结束 (空格、回车、标点)
+    void commitWord();
+    // 光标位置未知 (方向键、快捷键等)，丢弃当前单词
+    void reset();
+
+    // 当前单词中已输入的部分 (保持输入时的大小写)
+    const QString& prefix() const { return typed; }
+    // 当前建议 (按得分降序，大小写跟随已输入的前缀)
+    const QStringList& suggestions();
+    // 最近一次重新计算建议的耗时 (纳秒)
+    qint64 lastQueryNs() const { return queryNs; }
+
+    // 按已输入前缀调整补全结果的大小写: 已输入部分保持原样，前缀全部大写 (至少两个字母) 时补全部分也大写
+    static QString applyCase(const QString& word, const QString& typedPrefix);
+    // 是否为单词的组成字符
+    static bool isWordChar(QChar ch) { return ch.isLetterOrNumber() || ch == QLatin1Char('\''); }
+
+private:
+    std::unique_ptr<WordTrie> trie;
+    QString typed;                 // 已输入的前缀 (原始大小写)
+    QString lowered;               // 小写前缀 (前缀树中的路径)
+    QVector<quint32> nodePath;     // nodePath[i] 为长度 i 的前缀对应的节点 (NO_NODE 表示已不在词典中)
+    QStringList cachedSuggestions; // 当前前缀的建议
+    bool cacheValid = false;
+    qint64 queryNs = 0;
+    QVector<WordTrie::Completion> completions; // complete() 的输出缓冲区
+};
+
+#endif // VIRTUALKEYBOARD_PREDICTIONENGINE_H
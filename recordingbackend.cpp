@@ -0,0 +1,28 @@
+#include "recordingbackend.h"
+
+// --- send: 记录一批事件 ---
+int RecordingBackend::send(const KeyEvent* events, int count) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (int i = 0; i < count; ++i) recorded.append(events[i]);
+    batches.append(count);
+    return count;
+}
+
+// --- events: 返回已记录的事件 ---
+QVector<KeyEvent> RecordingBackend::events() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return recorded;
+}
+
+// --- batchSizes: 返回每批事件数 ---
+QVector<int> RecordingBackend::batchSizes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return batches;
+}
+
+// --- clear: 清空记录 ---
+void RecordingBackend::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    recorded.clear();
+    batches.clear();
+}
@@ -0,0 +1,28 @@
+#ifndef VIRTUALKEYBOARD_RECORDINGBACKEND_H
+#define VIRTUALKEYBOARD_RECORDINGBACKEND_H
+
+#include <QVector>
+#include <mutex>
+
+#include "injectionbackend.h"
+
+// 内存记录后端
+// 不向系统注入任何事件，只按顺序记录收到的事件和批次边界，
+// 用于在没有 SendInput/X11 的环境 (例如 CI) 中检查注入流。
+class RecordingBackend : public InjectionBackend {
+public:
+    const char* name() const override { return "recording"; }
+    int send(const KeyEvent* events, int count) override;
+
+    // 以下函数可在任意线程调用
+    QVector<KeyEvent> events() const;   // 已记录的所有事件
+    QVector<int> batchSizes() const;    // 每次 send 的事件数
+    void clear();
+
+private:
+    mutable std::mutex mutex;
+    QVector<KeyEvent> recorded;
+    QVector<int> batches;
+};
+
+#endif // VIRTUALKEYBOARD_RECORDINGBACKEND_H
@@ -0,0 +1,101 @@
+#include "sendinputbackend.h"
+#include "asynclogger.h"
+
+#include <QString>
+#include <QVarLengthArray>
+
+// --- Windows API 头文件 ---
+// WIN32_LEAN_AND_MEAN 和 NOMINMAX 由 CMakeLists.txt 定义
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <winuser.h> // 包含 SendInput, INPUT, KEYEVENTF_*, GetForegroundWindow 等定义
+
+// --- send: 用一次 SendInput 调用发送整批事件 ---
+int SendInputBackend::send(const KeyEvent* events, int count) {
+    if (count <= 0) return 0;
+
+    // 组装 INPUT 数组 (常见批次很小，放在栈上)
+    QVarLengthArray<INPUT, 16> inputs(count);
+    for (int i = 0; i < count; ++i) {
+        INPUT& input = inputs[i];
+        ZeroMemory(&input, sizeof(INPUT)); // 初始化 INPUT 结构体
+        input.type = INPUT_KEYBOARD; // 指定为键盘输入
+        if (events[i].isUnicode()) {
+            // Unicode 字符: wVk 为 0，wScan 为 UTF-16 代码单元 (代理对按两个事件依次发送)
+            input.ki.wScan = events[i].scanCode;
+            input.ki.dwFlags = KEYEVENTF_UNICODE;
+            if (!events[i].isDown()) input.ki.dwFlags |= KEYEVENTF_KEYUP;
+            continue;
+        }
+        // 使用 VK 码通常在不同键盘布局下更可靠
+        input.ki.wVk = events[i].vkCode; // 设置虚拟键码
+        input.ki.dwFlags = 0;            // 标志：使用虚拟键码 (默认)
+        // 如果是释放事件，添加 KEYEVENTF_KEYUP 标志
+        if (!events[i].isDown()) input.ki.dwFlags |= KEYEVENTF_KEYUP;
+        // 如果是扩展键，添加 KEYEVENTF_EXTENDEDKEY 标志
+        // 这对于像右 Ctrl、右 Alt、方向键、数字小键盘 Enter 等键至关重要。
+        if (events[i].isExtended()) input.ki.dwFlags |= KEYEVENTF_EXTENDEDKEY;
+    }
+
+    // --- 获取并记录前台窗口信息以供调试 (每批一次) ---
+    // 查询窗口标题需要跨进程消息，只在 Debug 日志启用时才做 (Release 构建中整段被编译掉)
+    if (VK_LOG_DEBUG_ENABLED()) {
+        HWND fgWin = GetForegroundWindow(); // 获取当前接收输入的窗口句柄
+        QString windowTitle;
+        DWORD processId = 0;
+        if (fgWin) {
+            wchar_t titleBuffer[256];
+            // 获取窗口标题
+            if (GetWindowTextW(fgWin, titleBuffer, 256) > 0) {
+                windowTitle = QString::fromWCharArray(titleBuffer);
+            } else {
+                windowTitle = "<无标题>";
+            }
+            // 获取窗口所属进程 ID
+            GetWindowThreadProcessId(fgWin, &processId);
+        } else {
+            windowTitle = "<无前台窗口>";
+        }
+        VK_LOG_DEBUG("尝试 SendInput: 事件数 {} 首个 VK {x} {} -> 目标窗口: {} (PID: {})",
+                     count, events[0].vkCode, events[0].isDown() ? "按下" : "释放", windowTitle, quint64(processId));
+    }
+
+    // 调用 SendInput 函数，一次发送整个数组
+    UINT result = SendInput(static_cast<UINT>(count), inputs.data(), sizeof(INPUT));
+
+    // 检查 SendInput 是否失败 (返回值为实际插入的事件数)
+    if (result != static_cast<UINT>(count)) {
+        DWORD errorCode = GetLastError(); // 获取错误码
+        VK_LOG_WARNING("SendInput 失败! Result: {}/{} 错误码: {}", quint64(result), count, quint64(errorCode));
+        // 5: ERROR_ACCESS_DENIED - 通常由于 UIPI (用户界面特权隔离)。
+        //    目标窗口比此键盘应用具有更高的权限。
+        // 87: ERROR_INVALID_PARAMETER - 检查 INPUT 结构体标志 (dwFlags)。
+        if (errorCode == 5) {
+            VK_LOG_WARNING(">> 访问被拒绝 (错误 5): 目标窗口可能具有更高权限 (例如，以管理员身份运行)。尝试以管理员身份运行此键盘。");
+        }
+    }
+    return static_cast<int>(result);
+}
+
+// --- hostLayout: 前台窗口线程的键盘布局 (HKL)，由注入线程查询 ---
+quintptr SendInputBackend::hostLayout() const {
+    HWND fgWin = GetForegroundWindow();
+    return quintptr(GetKeyboardLayout(fgWin ? GetWindowThreadProcessId(fgWin, nullptr) : 0));
+}
+
+// --- keyText: VK 码在给定键盘布局 (HKL) 上产生的文本 ---
+QString SendInputBackend::keyText(quintptr layout, int vkCode, bool shifted) const {
+    const HKL hkl = HKL(layout);
+    BYTE keyState[256] = {};
+    if (shifted) keyState[VK_SHIFT] = 0x80;
+    const UINT scanCode = MapVirtualKeyExW(UINT(vkCode), MAPVK_VK_TO_VSC, hkl);
+    wchar_t buffer[8];
+    // 标志 0x4: 不改变内核中的死键状态 (Windows 10 1607 起)；死键返回负数，按不能直接输入处理
+    const int length = ToUnicodeEx(UINT(vkCode), scanCode, keyState, buffer, 8, 0x4, hkl);
+    return length > 0 ? QString::fromWCharArray(buffer, length) : QString();
+}
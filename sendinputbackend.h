@@ -0,0 +1,18 @@
+#ifndef VIRTUALKEYBOARD_SENDINPUTBACKEND_H
+#define VIRTUALKEYBOARD_SENDINPUTBACKEND_H
+
+#include "injectionbackend.h"
+
+// Win32 SendInput 后端 (仅 Windows)
+// 一批事件组装成一个 INPUT 数组，只调用一次 SendInput，
+// 使修饰键组合和按键作为一个不可被其他输入插入的序列到达目标窗口。
+class SendInputBackend : public InjectionBackend {
+public:
+    const char* name() const override { return "sendinput"; }
+    int send(const KeyEvent* events, int count) override;
+    // 主机布局为前台窗口线程的输入语言 (键盘窗口不获得焦点，字符由前台窗口按它的布局翻译)
+    quintptr hostLayout() const override;
+    QString keyText(quintptr layout, int vkCode, bool shifted) const override;
+};
+
+#endif // VIRTUALKEYBOARD_SENDINPUTBACKEND_H
@@ -0,0 +1,300 @@
+#include "spellindex.h"
+#include "wordtrie.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QVarLengthArray>
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+// --- 二进制格式 ---
+// [SpellHeader][Word x wordCount][quint32 x (bucketCount + 1)][Entry x entryCount][char16_t x charCount]，本机字节序
+namespace {
+
+const char SPELL_MAGIC[4] = { 'V', 'K', 'S', 'C' };
+const quint32 SPELL_VERSION = 1;
+
+struct SpellHeader {
+    char magic[4];        // "VKSC"
+    quint32 version;      // SPELL_VERSION
+    qint64 sourceMtime;   // 源词典修改时间 (毫秒)
+    qint64 sourceSize;    // 源词典大小
+    quint32 wordCount;    // 单词数
+    quint32 entryCount;   // 删除串条目数
+    quint32 bucketCount;  // 哈希桶数 (2 的幂)
+    quint32 charCount;    // 单词文本的 UTF-16 字符数
+    quint8 maxDistance;   // 生成删除串时的最大编辑距离 (MAX_DISTANCE)
+    quint8 prefixLength;  // 生成删除串的前缀长度 (PREFIX_LENGTH)
+    quint16 reserved0;
+    quint32 reserved1;
+};
+
+static_assert(sizeof(SpellHeader) == 48, "SpellHeader 大小应固定");
+static_assert(sizeof(SpellIndex::Word) == 8, "SpellIndex::Word 大小应固定");
+static_assert(sizeof(SpellIndex::Entry) == 8, "SpellIndex::Entry 大小应固定");
+
+const SpellHeader* headerOf(const uchar* data) { return reinterpret_cast<const SpellHeader*>(data); }
+
+void setError(QString* errorMessage, const QString& message) {
+    if (errorMessage) *errorMessage = message;
+}
+
+// 删除串的哈希 (FNV-1a，按 UTF-16 代码单元)
+quint32 deleteHash(QStringView text) {
+    quint32 hash = 2166136261u;
+    for (QChar ch : text) {
+        hash ^= ch.unicode();
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// 把 word 本身和删除 1..maxDistance 个字符得到的字符串追加到 out (可能有重复)
+void appendDeletes(QStringView word, int maxDistance, QVector<QString>& out) {
+    int levelStart = int(out.size());
+    out.append(word.toString());
+    for (int distance = 1; distance <= maxDistance; ++distance) {
+        const int levelEnd = int(out.size());
+        for (int i = levelStart; i < levelEnd; ++i) {
+            const QString source = out[i]; // out 会增长，先复制
+            for (int p = 0; p < source.size(); ++p) out.append(QString(source).remove(p, 1));
+        }
+        levelStart = levelEnd;
+    }
+}
+
+// 删除串的哈希，排序去重
+template <typename Hashes>
+void deleteHashes(QStringView word, int maxDistance, QVector<QString>& scratch, Hashes& hashes) {
+    scratch.clear();
+    appendDeletes(word.left(SpellIndex::PREFIX_LENGTH), maxDistance, scratch);
+    hashes.clear();
+    for (const QString& text : std::as_const(scratch)) hashes.push_back(deleteHash(text));
+    std::sort(hashes.begin(), hashes.end());
+    hashes.erase(std::unique(hashes.begin(), hashes.end()), hashes.end());
+}
+
+} // namespace
+
+// --- cachePathFor: 词典对应的索引缓存路径 (与 WordTrie 缓存同目录) ---
+QString SpellIndex::cachePathFor(const QString& sourcePath) {
+    const QFileInfo sourceInfo(sourcePath);
+    const QByteArray pathHash = QCryptographicHash::hash(sourceInfo.absoluteFilePath().toUtf8(), QCryptographicHash::Sha1).toHex().left(12);
+    const QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/dictionaries");
+    return cacheDir + QLatin1Char('/') + sourceInfo.completeBaseName() + QLatin1Char('-') + QString::fromLatin1(pathHash) + QStringLiteral(".vksc");
+}
+
+// --- compile: 生成所有单词的删除串并按哈希桶排序 ---
+bool SpellIndex::compile(const WordTrie& trie, const QString& sourcePath, const QString& outputPath, QString* errorMessage) {
+    const QFileInfo sourceInfo(sourcePath);
+    QVector<WordTrie::Completion> completions;
+    trie.complete(WordTrie::ROOT, QStringView(), int(trie.wordCount()), completions);
+
+    // --- 单词表和文本 ---
+    std::vector<Word> wordTable;
+    std::vector<char16_t> charTable;
+    wordTable.reserve(size_t(completions.size()));
+    for (const WordTrie::Completion& completion : std::as_const(completions)) {
+        wordTable.push_back({ quint32(charTable.size()), quint16(completion.word.size()), quint16(completion.score) });
+        for (QChar ch : completion.word) charTable.push_back(ch.unicode());
+    }
+
+    // --- 删除串条目 (每个单词内去重) ---
+    std::vector<Entry> entryTable;
+    QVector<QString> scratch;
+    std::vector<quint32> hashes;
+    for (quint32 w = 0; w < quint32(wordTable.size()); ++w) {
+        deleteHashes(completions[int(w)].word, MAX_DISTANCE, scratch, hashes);
+        for (quint32 hash : hashes) entryTable.push_back({ hash, w });
+    }
+
+    // --- 按桶排序 (桶数为条目数一半以上的 2 的幂)，桶内按哈希排序 ---
+    quint32 bucketCount = 1;
+    while (bucketCount < entryTable.size() / 2) bucketCount <<= 1;
+    const quint32 mask = bucketCount - 1;
+    std::sort(entryTable.begin(), entryTable.end(), [mask](const Entry& a, const Entry& b) {
+        const quint32 bucketA = a.hash & mask, bucketB = b.hash & mask;
+        if (bucketA != bucketB) return bucketA < bucketB;
+        return a.hash != b.hash ? a.hash < b.hash : a.word < b.word;
+    });
+    std::vector<quint32> buckets(size_t(bucketCount) + 1, 0);
+    for (const Entry& entry : entryTable) ++buckets[(entry.hash & mask) + 1];
+    for (quint32 b = 0; b < bucketCount; ++b) buckets[b + 1] += buckets[b];
+
+    // --- 写入文件 ---
+    SpellHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, SPELL_MAGIC, sizeof(SPELL_MAGIC));
+    header.version = SPELL_VERSION;
+    header.sourceMtime = sourceInfo.lastModified().toMSecsSinceEpoch();
+    header.sourceSize = sourceInfo.size();
+    header.wordCount = quint32(wordTable.size());
+    header.entryCount = quint32(entryTable.size());
+    header.bucketCount = bucketCount;
+    header.charCount = quint32(charTable.size());
+    header.maxDistance = quint8(MAX_DISTANCE);
+    header.prefixLength = quint8(PREFIX_LENGTH);
+
+    QDir().mkpath(QFileInfo(outputPath).absolutePath());
+    QSaveFile output(outputPath);
+    const auto writeBlock = [&output](const void* block, qint64 bytes) {
+        return bytes == 0 || output.write(reinterpret_cast<const char*>(block), bytes) == bytes;
+    };
+    if (!output.open(QIODevice::WriteOnly) ||
+        !writeBlock(&header, sizeof(header)) ||
+        !writeBlock(wordTable.data(), qint64(wordTable.size() * sizeof(Word))) ||
+        !writeBlock(buckets.data(), qint64(buckets.size() * sizeof(quint32))) ||
+        !writeBlock(entryTable.data(), qint64(entryTable.size() * sizeof(Entry))) ||
+        !writeBlock(charTable.data(), qint64(charTable.size() * sizeof(char16_t))) || !output.commit()) {
+        setError(errorMessage, QStringLiteral("无法写入纠错索引 %1: %2").arg(outputPath, output.errorString()));
+        return false;
+    }
+    qDebug() << "纠错索引已编译:" << sourcePath << "->" << outputPath << "单词数:" << header.wordCount << "删除串:" << header.entryCount;
+    return true;
+}
+
+// --- map: 映射并校验索引文件 ---
+// 只检查各区的大小和单词表；条目和桶数组很大，不在打开时遍历 (映射的页面按需载入)，查询时做边界检查
+bool SpellIndex::map(const QString& path, QString* errorMessage) {
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        setError(errorMessage, QStringLiteral("无法打开纠错索引 %1").arg(path));
+        return false;
+    }
+    const qint64 size = file.size();
+    if (size >= qint64(sizeof(SpellHeader))) data = file.map(0, size);
+    if (!data) {
+        setError(errorMessage, QStringLiteral("无法映射纠错索引 %1").arg(path));
+        file.close();
+        return false;
+    }
+
+    const SpellHeader& header = *headerOf(data);
+    const qint64 wordsOffset = qint64(sizeof(SpellHeader));
+    const qint64 bucketsOffset = wordsOffset + qint64(header.wordCount) * qint64(sizeof(Word));
+    const qint64 entriesOffset = bucketsOffset + (qint64(header.bucketCount) + 1) * qint64(sizeof(quint32));
+    const qint64 charsOffset = entriesOffset + qint64(header.entryCount) * qint64(sizeof(Entry));
+    bool valid = std::memcmp(header.magic, SPELL_MAGIC, sizeof(SPELL_MAGIC)) == 0 && header.version == SPELL_VERSION &&
+                 header.maxDistance == MAX_DISTANCE && header.prefixLength == PREFIX_LENGTH &&
+                 header.bucketCount > 0 && (header.bucketCount & (header.bucketCount - 1)) == 0 &&
+                 charsOffset + qint64(header.charCount) * qint64(sizeof(char16_t)) == size;
+    const Word* mappedWords = reinterpret_cast<const Word*>(data + wordsOffset);
+    for (quint32 i = 0; valid && i < header.wordCount; ++i) {
+        valid = quint64(mappedWords[i].offset) + mappedWords[i].length <= header.charCount;
+    }
+    if (!valid) {
+        setError(errorMessage, QStringLiteral("纠错索引 %1 已损坏或版本不符").arg(path));
+        file.unmap(const_cast<uchar*>(data));
+        data = nullptr;
+        file.close();
+        return false;
+    }
+    words = mappedWords;
+    bucketStarts = reinterpret_cast<const quint32*>(data + bucketsOffset);
+    entries = reinterpret_cast<const Entry*>(data + entriesOffset);
+    chars = reinterpret_cast<const char16_t*>(data + charsOffset);
+    wordTotal = header.wordCount;
+    entryTotal = header.entryCount;
+    bucketMask = header.bucketCount - 1;
+    return true;
+}
+
+// --- open: 打开纠错索引 (缓存过期时从 trie 重新编译) ---
+std::unique_ptr<SpellIndex> SpellIndex::open(const QString& sourcePath, const WordTrie& trie, QString* errorMessage) {
+    const QFileInfo sourceInfo(sourcePath);
+    const QString cachePath = cachePathFor(sourcePath);
+    std::unique_ptr<SpellIndex> index(new SpellIndex);
+    bool upToDate = index->map(cachePath, nullptr);
+    if (upToDate) {
+        const SpellHeader& header = *headerOf(index->data);
+        upToDate = header.sourceMtime == sourceInfo.lastModified().toMSecsSinceEpoch() && header.sourceSize == sourceInfo.size();
+        if (!upToDate) {
+            // 先解除映射，否则部分平台无法替换被映射的文件
+            index->file.unmap(const_cast<uchar*>(index->data));
+            index->data = nullptr;
+            index->words = nullptr;
+            index->file.close();
+        }
+    }
+    if (!upToDate) {
+        if (!compile(trie, sourcePath, cachePath, errorMessage) || !index->map(cachePath, errorMessage)) return nullptr;
+        index->recompiled = true;
+    }
+    return index;
+}
+
+SpellIndex::~SpellIndex() {
+    if (data) file.unmap(const_cast<uchar*>(data));
+}
+
+// --- editDistance: 受限 Damerau-Levenshtein 距离 (三行动态规划，整行超过上限时提前结束) ---
+int SpellIndex::editDistance(QStringView a, QStringView b, int maxDistance) {
+    const int n = int(a.size()), m = int(b.size());
+    if (qAbs(n - m) > maxDistance) return maxDistance + 1;
+    QVarLengthArray<int, 160> rows(3 * (m + 1));
+    int* before = rows.data();
+    int* previous = before + (m + 1);
+    int* current = previous + (m + 1);
+    for (int j = 0; j <= m; ++j) previous[j] = j;
+    for (int i = 1; i <= n; ++i) {
+        current[0] = i;
+        int rowMin = i;
+        for (int j = 1; j <= m; ++j) {
+            const int cost = a[i - 1] == b[j - 1] ? 0 : 1;
+            int value = qMin(qMin(previous[j] + 1, current[j - 1] + 1), previous[j - 1] + cost);
+            if (i > 1 && j > 1 && a[i - 1] == b[j - 2] && a[i - 2] == b[j - 1]) value = qMin(value, before[j - 2] + 1);
+            current[j] = value;
+            rowMin = qMin(rowMin, value);
+        }
+        if (rowMin > maxDistance) return maxDistance + 1;
+        int* recycled = before; // 三行轮换: before <- previous <- current
+        before = previous;
+        previous = current;
+        current = recycled;
+    }
+    return qMin(previous[m], maxDistance + 1);
+}
+
+// --- lookup: 输入的删除串 -> 哈希桶 -> 验证编辑距离 ---
+bool SpellIndex::lookup(QStringView word, int maxDistance, Suggestion& out) const {
+    if (!words || word.isEmpty()) return false;
+    maxDistance = qBound(0, maxDistance, int(MAX_DISTANCE));
+    QVarLengthArray<quint32, 64> hashes;
+    deleteHashes(word, maxDistance, deletes, hashes);
+    checked.clear();
+
+    int bestWord = -1;
+    int bestDistance = maxDistance + 1;
+    quint16 bestScore = 0;
+    for (quint32 hash : hashes) {
+        const quint32 bucket = hash & bucketMask;
+        const quint32 begin = bucketStarts[bucket], end = bucketStarts[bucket + 1];
+        if (begin > end || end > entryTotal) continue; // 损坏的桶
+        for (quint32 e = begin; e < end; ++e) {
+            if (entries[e].hash != hash) continue;
+            const quint32 candidate = entries[e].word;
+            if (candidate >= wordTotal || checked.contains(candidate)) continue;
+            checked.append(candidate);
+            const Word& entry = words[candidate];
+            if (qAbs(int(entry.length) - int(word.size())) > maxDistance) continue;
+            const int distance = editDistance(word, wordText(candidate), maxDistance);
+            if (distance < bestDistance || (distance == bestDistance && distance <= maxDistance && entry.score > bestScore)) {
+                bestWord = int(candidate);
+                bestDistance = distance;
+                bestScore = entry.score;
+            }
+        }
+    }
+    if (bestWord < 0) return false;
+    out.word = wordText(quint32(bestWord)).toString();
+    out.distance = bestDistance;
+    out.score = bestScore;
+    return true;
+}
@@ -0,0 +1,84 @@
+#ifndef VIRTUALKEYBOARD_SPELLINDEX_H
+#define VIRTUALKEYBOARD_SPELLINDEX_H
+
+#include <QFile>
+#include <QString>
+#include <QStringView>
+#include <QVector>
+#include <memory>
+
+class WordTrie;
+
+// 内存映射的拼写纠错索引 (SymSpell 对称删除算法)
+// 编译时为词典中每个单词 (前 PREFIX_LENGTH 个字符) 生成删除最多 MAX_DISTANCE 个字符得到的所有字符串，
+// 以 32 位哈希为键存入按桶排序的数组；查询时对输入同样生成删除串，只检查哈希相同的少量单词，
+// 再用受限 Damerau-Levenshtein 距离 (相邻交换算一次编辑) 验证，不扫描词典。
+// 哈希碰撞只会增加需要验证的候选，不影响结果。
+//
+// 索引由 WordTrie 中的单词编译而来，缓存在 CacheLocation (源词典修改后重新编译)。
+// 二进制格式: [Header][Word x wordCount][quint32 x (bucketCount + 1)][Entry x entryCount][char16_t x charCount]
+class SpellIndex {
+public:
+    static constexpr int MAX_DISTANCE = 2;  // 索引支持的最大编辑距离
+    static constexpr int PREFIX_LENGTH = 7; // 只对单词前缀生成删除串 (限制索引大小，更长的部分由验证处理)
+
+    struct Word {
+        quint32 offset;  // 文本在字符区中的位置
+        quint16 length;  // 文本长度 (UTF-16)
+        quint16 score;   // 对数频率得分 (与 WordTrie 一致)
+    };
+    struct Entry {
+        quint32 hash;    // 删除串的哈希
+        quint32 word;    // 单词下标
+    };
+
+    // 纠正结果
+    struct Suggestion {
+        QString word;      // 词典中的单词 (小写)
+        int distance = 0;  // 编辑距离 (0 表示输入本身就在词典中)
+        int score = 0;     // 对数频率得分
+    };
+
+    // 打开 sourcePath 对应的纠错索引 (缓存过期或不存在时从 trie 编译)，失败返回 nullptr
+    static std::unique_ptr<SpellIndex> open(const QString& sourcePath, const WordTrie& trie, QString* errorMessage = nullptr);
+    // 把 trie 中的全部单词编译为索引文件 (sourcePath 的修改时间和大小写入文件头)
+    static bool compile(const WordTrie& trie, const QString& sourcePath, const QString& outputPath, QString* errorMessage = nullptr);
+    // 词典对应的缓存路径
+    static QString cachePathFor(const QString& sourcePath);
+    // 受限 Damerau-Levenshtein 距离，超过 maxDistance 时返回 maxDistance + 1
+    static int editDistance(QStringView a, QStringView b, int maxDistance);
+
+    ~SpellIndex();
+    SpellIndex(const SpellIndex&) = delete;
+    SpellIndex& operator=(const SpellIndex&) = delete;
+
+    quint32 wordCount() const { return words ? wordTotal : 0; }
+    quint32 entryCount() const { return entryTotal; }
+    qint64 fileSize() const { return file.size(); }
+    bool compiledOnOpen() const { return recompiled; } // 本次打开是否重新编译了索引
+
+    // 查找与 word (小写) 距离不超过 maxDistance 的最佳单词: 距离最小，其次得分最高；没有时返回 false
+    bool lookup(QStringView word, int maxDistance, Suggestion& out) const;
+
+private:
+    SpellIndex() = default;
+    bool map(const QString& path, QString* errorMessage); // 映射并校验索引文件
+    QStringView wordText(quint32 index) const { return QStringView(chars + words[index].offset, words[index].length); }
+
+    QFile file;
+    const uchar* data = nullptr;
+    const Word* words = nullptr;
+    const quint32* bucketStarts = nullptr;
+    const Entry* entries = nullptr;
+    const char16_t* chars = nullptr;
+    quint32 wordTotal = 0;
+    quint32 entryTotal = 0;
+    quint32 bucketMask = 0;
+    bool recompiled = false;
+
+    // 查询的复用缓冲区
+    mutable QVector<QString> deletes;
+    mutable QVector<quint32> checked; // 已验证过的单词
+};
+
+#endif // VIRTUALKEYBOARD_SPELLINDEX_H
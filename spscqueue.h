@@ -0,0 +1,57 @@
+#ifndef VIRTUALKEYBOARD_SPSCQUEUE_H
+#define VIRTUALKEYBOARD_SPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+
+// 无锁单生产者/单消费者环形队列
+// 只允许一个线程调用 push，另一个线程调用 pop；容量必须是 2 的幂。
+// head/tail 分别放在不同的缓存行上，避免生产者和消费者互相失效缓存。
+template <typename T, std::size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "SpscQueue 容量必须是 2 的幂");
+
+public:
+    // 生产者: 入队，队列已满时返回 false
+    bool push(const T& value) {
+        const std::size_t tail = tailIndex.load(std::memory_order_relaxed);
+        if (tail - cachedHead == Capacity) {
+            cachedHead = headIndex.load(std::memory_order_acquire);
+            if (tail - cachedHead == Capacity) return false;
+        }
+        buffer[tail & (Capacity - 1)] = value;
+        // seq_cst 发布，配合消费者的“睡眠”标志实现 Dekker 式的唤醒判断
+        tailIndex.store(tail + 1, std::memory_order_seq_cst);
+        return true;
+    }
+
+    // 消费者: 出队，队列为空时返回 false
+    bool pop(T& value) {
+        const std::size_t head = headIndex.load(std::memory_order_relaxed);
+        if (head == cachedTail) {
+            cachedTail = tailIndex.load(std::memory_order_acquire);
+            if (head == cachedTail) return false;
+        }
+        value = buffer[head & (Capacity - 1)];
+        headIndex.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 消费者: 队列是否为空 (seq_cst 读取，见 push)
+    bool empty() const {
+        return headIndex.load(std::memory_order_relaxed) == tailIndex.load(std::memory_order_seq_cst);
+    }
+
+    static constexpr std::size_t capacity() { return Capacity; }
+
+private:
+    static constexpr std::size_t CacheLine = 64;
+
+    alignas(CacheLine) std::atomic<std::size_t> headIndex{0}; // 消费者写
+    std::size_t cachedTail = 0;                               // 消费者缓存的 tail
+    alignas(CacheLine) std::atomic<std::size_t> tailIndex{0}; // 生产者写
+    std::size_t cachedHead = 0;                               // 生产者缓存的 head
+    alignas(CacheLine) T buffer[Capacity];
+};
+
+#endif // VIRTUALKEYBOARD_SPSCQUEUE_H
@@ -0,0 +1,80 @@
+#include "startuptrace.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+bool StartupTrace::recording = false;
+QString StartupTrace::outputPath;
+QVector<StartupTrace::PhaseRecord> StartupTrace::phases;
+
+// 进程内唯一的启动计时器
+static QElapsedTimer& startupClock() {
+    static QElapsedTimer clock;
+    return clock;
+}
+
+// --- Phase: 构造时记录开始时间，end() 或析构时记录持续时间 ---
+StartupTrace::Phase::Phase(const char* phaseName)
+        : name(phaseName), startNs(recording ? elapsedNs() : -1) {}
+
+void StartupTrace::Phase::end() {
+    if (startNs < 0) return;
+    if (recording) phases.append({ name, startNs, elapsedNs() - startNs });
+    startNs = -1;
+}
+
+// --- start: 开始计时和记录 ---
+void StartupTrace::start() {
+    startupClock().start();
+    phases.reserve(16);
+    recording = true;
+}
+
+// --- setOutputPath: 指定 JSON 输出文件 ---
+void StartupTrace::setOutputPath(const QString& path) {
+    outputPath = path;
+}
+
+qint64 StartupTrace::elapsedNs() {
+    return startupClock().isValid() ? startupClock().nsecsElapsed() : 0;
+}
+
+// --- finish: 写出 JSON ---
+// 格式: {"version":1, "pid":..., "firstFrameUs":..., "phases":[{"name":..., "startUs":..., "durationUs":...}, ...]}
+bool StartupTrace::finish() {
+    if (!recording) return true;
+    recording = false;
+    const qint64 firstFrameNs = elapsedNs();
+    if (outputPath.isEmpty()) {
+        phases.clear();
+        return true;
+    }
+
+    QJsonArray phaseArray;
+    for (const PhaseRecord& phase : phases) {
+        QJsonObject entry;
+        entry.insert(QStringLiteral("name"), QString::fromLatin1(phase.name));
+        entry.insert(QStringLiteral("startUs"), double(phase.startNs) / 1000.0);
+        entry.insert(QStringLiteral("durationUs"), double(phase.durationNs) / 1000.0);
+        phaseArray.append(entry);
+    }
+    QJsonObject root;
+    root.insert(QStringLiteral("version"), 1);
+    root.insert(QStringLiteral("pid"), double(QCoreApplication::applicationPid()));
+    root.insert(QStringLiteral("firstFrameUs"), double(firstFrameNs) / 1000.0);
+    root.insert(QStringLiteral("phases"), phaseArray);
+
+    QFile file(outputPath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) ||
+        file.write(QJsonDocument(root).toJson(QJsonDocument::Indented)) < 0) {
+        qWarning() << "无法写入启动计时文件:" << outputPath << file.errorString();
+        return false;
+    }
+    qDebug() << "启动计时已写入" << outputPath << "首帧:" << firstFrameNs / 1000 << "us";
+    return true;
+}
@@ -0,0 +1,52 @@
+#ifndef VIRTUALKEYBOARD_STARTUPTRACE_H
+#define VIRTUALKEYBOARD_STARTUPTRACE_H
+
+#include <QString>
+#include <QVector>
+
+// 启动阶段计时
+// main 开头调用 start() 开始计时，各阶段 (QApplication、QSS、布局、拆分、setupUI、positionWindow 等)
+// 用 Phase 记录起止时间；首帧绘制完成时 finish() 停止记录，
+// 如果通过 --startup-trace 或环境变量 VK_STARTUP_TRACE 指定了输出文件，就把结果写为 JSON。
+// 记录只持续到首帧，开销是每个阶段一次计时和一次追加。只在 UI 线程中使用。
+class StartupTrace {
+public:
+    // 记录一个阶段的作用域对象 (未启用时不做任何事)
+    class Phase {
+    public:
+        explicit Phase(const char* name);
+        ~Phase() { end(); }
+        // 提前结束阶段 (之后析构不再记录)
+        void end();
+
+        Phase(const Phase&) = delete;
+        Phase& operator=(const Phase&) = delete;
+
+    private:
+        const char* name;
+        qint64 startNs;
+    };
+
+    // 开始计时和记录 (在 main 开头调用，之后的时间都相对于此刻)
+    static void start();
+    // 指定输出文件 (为空时 finish 不写文件)
+    static void setOutputPath(const QString& path);
+    static bool hasOutput() { return !outputPath.isEmpty(); }
+    // 从 start() 开始经过的时间 (纳秒)
+    static qint64 elapsedNs();
+    // 首帧完成: 停止记录并写出 JSON 文件，返回是否写入成功 (没有输出文件时直接返回 true)
+    static bool finish();
+
+private:
+    struct PhaseRecord {
+        const char* name;
+        qint64 startNs;
+        qint64 durationNs;
+    };
+
+    static bool recording;
+    static QString outputPath;
+    static QVector<PhaseRecord> phases;
+};
+
+#endif // VIRTUALKEYBOARD_STARTUPTRACE_H
@@ -0,0 +1,153 @@
+#include "suggestionbar.h"
+
+#include <QMouseEvent>
+#include <QPainter>
+#include <QResizeEvent>
+
+// --- 常量定义 ---
+const int SUGGESTION_BAR_HEIGHT = 36;   // 建议栏高度 (像素)
+const int SUGGESTION_SLOT_SPACING = 4;  // 槽间距 (与按键间距一致)
+const qreal SUGGESTION_RADIUS = 5.0;    // 槽圆角
+const qreal PREEDIT_WIDTH_RATIO = 0.3;  // 组字文本占建议栏宽度的比例
+const int MODE_SLOT = -2;               // slotAt 对模式标签的返回值
+
+// --- 构造函数 ---
+SuggestionBar::SuggestionBar(int slots, QWidget *parent)
+        : QWidget(parent), slotCount(qMax(1, slots))
+{
+    // !!! 关键: 建议栏不接受焦点，避免从目标应用窃取焦点 !!!
+    setFocusPolicy(Qt::NoFocus);
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+    setFixedHeight(SUGGESTION_BAR_HEIGHT);
+    setAttribute(Qt::WA_NoSystemBackground, true);
+
+    QFont barFont = font();
+    barFont.setPointSize(11);
+    setFont(barFont);
+}
+
+// --- setSuggestions: 更新建议文本 ---
+void SuggestionBar::setSuggestions(const QStringList& suggestions) {
+    const QStringList visible = suggestions.mid(0, slotCount);
+    if (visible == words) return;
+    words = visible;
+    pressedSlot = -1;
+    update();
+}
+
+// --- setModeLabel/setPreedit: 输入法区域 ---
+void SuggestionBar::setModeLabel(const QString& label) {
+    if (label == modeLabel) return;
+    const bool relayout = label.isEmpty() != modeLabel.isEmpty();
+    modeLabel = label;
+    if (relayout) layoutSlots();
+    update();
+}
+
+void SuggestionBar::setPreedit(const QString& text) {
+    if (text == preedit) return;
+    preedit = text;
+    update(preeditRect.toAlignedRect());
+}
+
+// --- setBackgroundAlpha: 设置背景透明度 ---
+void SuggestionBar::setBackgroundAlpha(int alpha) {
+    alpha = qBound(0, alpha, 255);
+    if (alpha == backgroundAlpha) return;
+    backgroundAlpha = alpha;
+    update();
+}
+
+QSize SuggestionBar::sizeHint() const {
+    return QSize(slotCount * 120, SUGGESTION_BAR_HEIGHT);
+}
+
+// --- layoutSlots: 输入法区域 (有模式标签时) 之后平分宽度 ---
+void SuggestionBar::layoutSlots() {
+    qreal left = 0;
+    modeRect = preeditRect = QRectF();
+    if (!modeLabel.isEmpty()) {
+        modeRect = QRectF(0, 0, height(), height());
+        preeditRect = QRectF(modeRect.right() + SUGGESTION_SLOT_SPACING, 0, width() * PREEDIT_WIDTH_RATIO, height());
+        left = preeditRect.right() + SUGGESTION_SLOT_SPACING;
+    }
+    slotRects.resize(slotCount);
+    const qreal slotWidth = (width() - left - SUGGESTION_SLOT_SPACING * (slotCount - 1)) / qreal(slotCount);
+    for (int i = 0; i < slotCount; ++i) {
+        slotRects[i] = QRectF(left + i * (slotWidth + SUGGESTION_SLOT_SPACING), 0, slotWidth, height());
+    }
+}
+
+void SuggestionBar::resizeEvent(QResizeEvent *event) {
+    QWidget::resizeEvent(event);
+    layoutSlots();
+}
+
+int SuggestionBar::slotAt(const QPointF& pos) const {
+    if (modeRect.contains(pos)) return MODE_SLOT;
+    for (int i = 0; i < words.size() && i < slotRects.size(); ++i) {
+        if (slotRects[i].contains(pos)) return i;
+    }
+    return -1;
+}
+
+// --- paintEvent: 绘制槽背景和建议文本 ---
+void SuggestionBar::paintEvent(QPaintEvent *event) {
+    Q_UNUSED(event);
+    if (slotRects.size() != slotCount) layoutSlots();
+    QPainter painter(this);
+    painter.setRenderHint(QPainter::Antialiasing, true);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    painter.fillRect(rect(), Qt::transparent);
+    painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+
+    // --- 输入法区域: 模式标签和组字文本 (过长时保留末尾) ---
+    if (!modeLabel.isEmpty()) {
+        const QRectF labelRect = modeRect.adjusted(0.5, 0.5, -0.5, -0.5);
+        painter.setPen(QPen(QColor(80, 80, 80, backgroundAlpha), 1));
+        painter.setBrush(pressedSlot == MODE_SLOT ? QColor(0x00, 0x7A, 0xCC) : QColor(60, 60, 65, backgroundAlpha));
+        painter.drawRoundedRect(labelRect, SUGGESTION_RADIUS, SUGGESTION_RADIUS);
+        painter.setPen(Qt::white);
+        painter.drawText(labelRect, Qt::AlignCenter, modeLabel);
+        if (!preedit.isEmpty()) {
+            painter.setPen(QColor(0x00, 0xAA, 0xCC));
+            const QString text = painter.fontMetrics().elidedText(preedit, Qt::ElideLeft, int(preeditRect.width()));
+            painter.drawText(preeditRect, Qt::AlignVCenter | Qt::AlignLeft, text);
+        }
+    }
+
+    for (int i = 0; i < slotCount; ++i) {
+        const QRectF slotRect = slotRects[i].adjusted(0.5, 0.5, -0.5, -0.5);
+        if (i == pressedSlot) {
+            painter.setPen(QPen(QColor(0x00, 0xAA, 0xCC), 1));
+            painter.setBrush(QColor(0x00, 0x7A, 0xCC)); // 按下: 与按键按下时相同的蓝色
+        } else {
+            painter.setPen(QPen(QColor(80, 80, 80, backgroundAlpha), 1));
+            painter.setBrush(QColor(40, 40, 45, backgroundAlpha));
+        }
+        painter.drawRoundedRect(slotRect, SUGGESTION_RADIUS, SUGGESTION_RADIUS);
+        if (i < words.size()) {
+            painter.setPen(Qt::white);
+            const QString text = painter.fontMetrics().elidedText(words.at(i), Qt::ElideRight, int(slotRect.width()) - 8);
+            painter.drawText(slotRect, Qt::AlignCenter, text);
+        }
+    }
+}
+
+// --- 鼠标事件: 按下高亮，在同一个槽内释放才算选择 ---
+void SuggestionBar::mousePressEvent(QMouseEvent *event) {
+    if (event->button() != Qt::LeftButton) return;
+    pressedSlot = slotAt(event->position());
+    if (pressedSlot == MODE_SLOT) update(modeRect.toAlignedRect());
+    else if (pressedSlot >= 0) update(slotRects[pressedSlot].toAlignedRect());
+}
+
+void SuggestionBar::mouseReleaseEvent(QMouseEvent *event) {
+    if (event->button() != Qt::LeftButton || pressedSlot == -1) return;
+    const int slot = pressedSlot;
+    pressedSlot = -1;
+    update((slot == MODE_SLOT ? modeRect : slotRects[slot]).toAlignedRect());
+    if (slotAt(event->position()) != slot) return;
+    if (slot == MODE_SLOT) emit modeClicked();
+    else emit suggestionChosen(slot);
+}
@@ -0,0 +1,56 @@
+#ifndef VIRTUALKEYBOARD_SUGGESTIONBAR_H
+#define VIRTUALKEYBOARD_SUGGESTIONBAR_H
+
+#include <QWidget>
+#include <QStringList>
+#include <QVector>
+#include <QRectF>
+
+// 键盘上方的单词建议栏
+// 单控件自绘 (与 KeyboardCanvas 相同的外观)，建议文本变化时只重绘一次，不创建按钮、不触发重新布局。
+// 点击某个建议时发出 suggestionChosen；控件不接受焦点。
+// 可选的输入法区域位于最左侧: 模式标签 (点击时发出 modeClicked) 和正在组字的拼音。
+class SuggestionBar : public QWidget {
+Q_OBJECT
+
+public:
+    explicit SuggestionBar(int slotCount, QWidget *parent = nullptr);
+    ~SuggestionBar() override = default;
+
+    // 设置建议 (超出槽数的部分被忽略)，与当前内容相同时不重绘
+    void setSuggestions(const QStringList& suggestions);
+    const QStringList& suggestions() const { return words; }
+    // 设置模式标签 (空表示不显示输入法区域) 和组字文本
+    void setModeLabel(const QString& label);
+    void setPreedit(const QString& text);
+    // 设置背景的 alpha 值 (0-255)
+    void setBackgroundAlpha(int alpha);
+
+    QSize sizeHint() const override;
+
+signals:
+    void suggestionChosen(int index); // 点击了第 index 个建议
+    void modeClicked();               // 点击了模式标签
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+
+private:
+    void layoutSlots();                   // 按当前宽度平分槽位 (输入法区域之外的部分)
+    int slotAt(const QPointF& pos) const; // 命中测试 (只命中有文本的槽；模式标签为 MODE_SLOT)
+
+    int slotCount;
+    QStringList words;        // 当前建议
+    QVector<QRectF> slotRects; // 每个槽的矩形
+    QString modeLabel;        // 模式标签 (如 "中"/"英")
+    QString preedit;          // 组字文本
+    QRectF modeRect;          // 模式标签的矩形
+    QRectF preeditRect;       // 组字文本的矩形
+    int pressedSlot = -1;     // 正被按住的槽
+    int backgroundAlpha = 217;
+};
+
+#endif // VIRTUALKEYBOARD_SUGGESTIONBAR_H
@@ -0,0 +1,258 @@
+#include "swipedecoder.h"
+
+#include <QtGlobal>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VK_SWIPE_SSE2 1
+#endif
+
+const float SWIPE_ENDPOINT_RADIUS = 1.25f; // 起点/终点到候选首/尾键中心的最大距离 (按键宽度)
+const float SWIPE_FREQ_WEIGHT = 0.03f;     // 词频减半对应的代价 (按键宽度)
+const float SWIPE_LENGTH_MIN_RATIO = 0.6f; // 模板长度相对路径长度的允许范围 (再加上 SWIPE_LENGTH_SLACK)
+const float SWIPE_LENGTH_MAX_RATIO = 1.6f;
+const float SWIPE_LENGTH_SLACK = 1.5f;
+const qreal SWIPE_GEOMETRY_TOLERANCE = 0.1; // 按键中心移动不超过这个距离 (按键宽度) 时不重建模板
+const int SWIPE_MAX_CANDIDATES = 16;       // decode() 最多返回的候选数
+
+// --- pathDistance: 模板与路径逐点距离之和 ---
+// 每 8 个点检查一次部分和，超过 limit 时提前返回 (返回值大于 limit 即表示已放弃)
+static float pathDistance(const float* tx, const float* ty, const float* px, const float* py, float limit) {
+    static_assert(SwipeDecoder::SAMPLE_POINTS % 8 == 0, "距离核按 8 个点一组处理");
+#ifdef VK_SWIPE_SSE2
+    __m128 sum = _mm_setzero_ps();
+    for (int i = 0; i < SwipeDecoder::SAMPLE_POINTS; i += 8) {
+        const __m128 dx0 = _mm_sub_ps(_mm_loadu_ps(tx + i), _mm_loadu_ps(px + i));
+        const __m128 dy0 = _mm_sub_ps(_mm_loadu_ps(ty + i), _mm_loadu_ps(py + i));
+        const __m128 dx1 = _mm_sub_ps(_mm_loadu_ps(tx + i + 4), _mm_loadu_ps(px + i + 4));
+        const __m128 dy1 = _mm_sub_ps(_mm_loadu_ps(ty + i + 4), _mm_loadu_ps(py + i + 4));
+        sum = _mm_add_ps(sum, _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx0, dx0), _mm_mul_ps(dy0, dy0))));
+        sum = _mm_add_ps(sum, _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx1, dx1), _mm_mul_ps(dy1, dy1))));
+        // 水平求和: (a b c d) -> (a+c b+d ..) -> a+b+c+d
+        __m128 total = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+        total = _mm_add_ss(total, _mm_shuffle_ps(total, total, 1));
+        const float partial = _mm_cvtss_f32(total);
+        if (partial > limit) return partial;
+    }
+    __m128 total = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    total = _mm_add_ss(total, _mm_shuffle_ps(total, total, 1));
+    return _mm_cvtss_f32(total);
+#else
+    float sum = 0.0f;
+    for (int i = 0; i < SwipeDecoder::SAMPLE_POINTS; i += 8) {
+        for (int j = i; j < i + 8; ++j) {
+            const float dx = tx[j] - px[j];
+            const float dy = ty[j] - py[j];
+            sum += std::sqrt(dx * dx + dy * dy);
+        }
+        if (sum > limit) return sum;
+    }
+    return sum;
+#endif
+}
+
+// --- setKeys: 记录按键中心 (换算为按键单位) ---
+// 模板以按键单位存储，窗口缩放通常只改变 keyWidth；按键单位下的中心移动都不超过
+// SWIPE_GEOMETRY_TOLERANCE 时保留已构建的模板
+void SwipeDecoder::setKeys(const QVector<Key>& newKeys, qreal keyWidth) {
+    const qreal unit = keyWidth > 0 ? keyWidth : 1.0;
+    QVector<Key> scaled;
+    scaled.reserve(newKeys.size());
+    for (const Key& key : newKeys) {
+        scaled.append({key.ch.toLower(), QPointF(key.center.x() / unit, key.center.y() / unit)});
+    }
+    keyUnit = float(unit);
+
+    bool same = scaled.size() == keys.size();
+    for (int i = 0; same && i < scaled.size(); ++i) {
+        const QPointF delta = scaled[i].center - keys[i].center;
+        same = scaled[i].ch == keys[i].ch && std::hypot(delta.x(), delta.y()) <= SWIPE_GEOMETRY_TOLERANCE;
+    }
+    if (same) return;
+    keys = std::move(scaled);
+    built = false;
+}
+
+void SwipeDecoder::setWords(QVector<Word> newWords) {
+    words = std::move(newWords);
+    built = false;
+}
+
+int SwipeDecoder::keyIndexFor(QChar ch) const {
+    for (int i = 0; i < keys.size(); ++i) {
+        if (keys[i].ch == ch) return i;
+    }
+    return -1;
+}
+
+// --- resample: 沿折线等距取 SAMPLE_POINTS 个点 ---
+float SwipeDecoder::resample(const QVector<QPointF>& polyline, float* xs, float* ys) {
+    float length = 0.0f;
+    for (int i = 1; i < polyline.size(); ++i) {
+        const QPointF delta = polyline[i] - polyline[i - 1];
+        length += float(std::hypot(delta.x(), delta.y()));
+    }
+    if (length <= 0.0f || polyline.size() < 2) {
+        const QPointF only = polyline.isEmpty() ? QPointF() : polyline.first();
+        std::fill(xs, xs + SAMPLE_POINTS, float(only.x()));
+        std::fill(ys, ys + SAMPLE_POINTS, float(only.y()));
+        return 0.0f;
+    }
+
+    const float step = length / float(SAMPLE_POINTS - 1);
+    int segment = 1;
+    float segmentStart = 0.0f; // 当前线段起点处的累计长度
+    float segmentLength = float(std::hypot(polyline[1].x() - polyline[0].x(), polyline[1].y() - polyline[0].y()));
+    for (int i = 0; i < SAMPLE_POINTS - 1; ++i) {
+        const float target = step * float(i);
+        while (segmentStart + segmentLength < target && segment < polyline.size() - 1) {
+            segmentStart += segmentLength;
+            ++segment;
+            const QPointF delta = polyline[segment] - polyline[segment - 1];
+            segmentLength = float(std::hypot(delta.x(), delta.y()));
+        }
+        const float t = segmentLength > 0.0f ? qBound(0.0f, (target - segmentStart) / segmentLength, 1.0f) : 0.0f;
+        const QPointF& a = polyline[segment - 1];
+        const QPointF& b = polyline[segment];
+        xs[i] = float(a.x() + (b.x() - a.x()) * t);
+        ys[i] = float(a.y() + (b.y() - a.y()) * t);
+    }
+    xs[SAMPLE_POINTS - 1] = float(polyline.last().x());
+    ys[SAMPLE_POINTS - 1] = float(polyline.last().y());
+    return length;
+}
+
+// --- build: 为每个单词生成模板并按 (首键, 尾键) 分桶 ---
+void SwipeDecoder::build() {
+    const int keyCount = keys.size();
+    templateXs.clear();
+    templateYs.clear();
+    templateLengths.clear();
+    templatePriors.clear();
+    templateWords.clear();
+    bucketStarts.assign(size_t(keyCount) * size_t(keyCount) + 1, 0);
+    built = true;
+    if (keyCount == 0) return;
+
+    // --- 单词 -> 按键序列 (跳过没有按键的字符，合并连续的同一按键) ---
+    struct Pending {
+        quint32 bucket;
+        quint32 word;
+        QVector<QPointF> polyline;
+    };
+    std::vector<Pending> pending;
+    pending.reserve(size_t(words.size()));
+    int maxScore = 0;
+    for (const Word& word : std::as_const(words)) maxScore = std::max(maxScore, word.score);
+    for (int w = 0; w < words.size(); ++w) {
+        QVector<QPointF> polyline;
+        int first = -1;
+        int last = -1;
+        int letters = 0;
+        for (QChar ch : words[w].text) {
+            const int key = keyIndexFor(ch.toLower());
+            if (key < 0) continue;
+            ++letters;
+            if (key == last) continue;
+            if (first < 0) first = key;
+            last = key;
+            polyline.append(keys[key].center);
+        }
+        if (letters < 2) continue; // 单个字母直接点击
+        pending.push_back({quint32(first * keyCount + last), quint32(w), std::move(polyline)});
+    }
+
+    // --- 按桶排序 (稳定排序保持词典顺序)，每个桶的模板连续存放 ---
+    std::stable_sort(pending.begin(), pending.end(), [](const Pending& a, const Pending& b) {
+        return a.bucket < b.bucket;
+    });
+    const size_t count = pending.size();
+    templateXs.resize(count * SAMPLE_POINTS);
+    templateYs.resize(count * SAMPLE_POINTS);
+    templateLengths.resize(count);
+    templatePriors.resize(count);
+    templateWords.resize(count);
+    for (size_t t = 0; t < count; ++t) {
+        const Pending& item = pending[t];
+        templateLengths[t] = resample(item.polyline, &templateXs[t * SAMPLE_POINTS], &templateYs[t * SAMPLE_POINTS]);
+        templatePriors[t] = float(maxScore - words[int(item.word)].score) / 1024.0f * SWIPE_FREQ_WEIGHT;
+        templateWords[t] = item.word;
+        ++bucketStarts[item.bucket + 1];
+    }
+    for (size_t b = 1; b < bucketStarts.size(); ++b) bucketStarts[b] += bucketStarts[b - 1];
+}
+
+// --- keysNear: 端点附近的按键 ---
+void SwipeDecoder::keysNear(float x, float y, float radius, QVector<int>& out) const {
+    out.clear();
+    int nearest = -1;
+    float nearestDistance = 0.0f;
+    for (int i = 0; i < keys.size(); ++i) {
+        const float distance = float(std::hypot(keys[i].center.x() - x, keys[i].center.y() - y));
+        if (distance <= radius) out.append(i);
+        if (nearest < 0 || distance < nearestDistance) {
+            nearest = i;
+            nearestDistance = distance;
+        }
+    }
+    if (out.isEmpty() && nearest >= 0) out.append(nearest);
+}
+
+// --- decode: 只扫描端点附近按键对应的桶，保留代价最小的 k 个模板 ---
+int SwipeDecoder::decode(const QVector<QPointF>& path, int k, QVector<Candidate>& out) const {
+    out.clear();
+    k = qBound(0, k, SWIPE_MAX_CANDIDATES);
+    if (!built || path.size() < 2 || k == 0 || templateWords.empty()) return 0;
+
+    QVector<QPointF> scaled;
+    scaled.reserve(path.size());
+    for (const QPointF& point : path) scaled.append(point / keyUnit);
+    float pathXs[SAMPLE_POINTS];
+    float pathYs[SAMPLE_POINTS];
+    const float pathLength = resample(scaled, pathXs, pathYs);
+    const float minLength = pathLength * SWIPE_LENGTH_MIN_RATIO - SWIPE_LENGTH_SLACK;
+    const float maxLength = pathLength * SWIPE_LENGTH_MAX_RATIO + SWIPE_LENGTH_SLACK;
+
+    QVector<int> startKeys;
+    QVector<int> endKeys;
+    keysNear(pathXs[0], pathYs[0], SWIPE_ENDPOINT_RADIUS, startKeys);
+    keysNear(pathXs[SAMPLE_POINTS - 1], pathYs[SAMPLE_POINTS - 1], SWIPE_ENDPOINT_RADIUS, endKeys);
+
+    // 当前最好的 k 个 (按代价升序)
+    std::pair<float, quint32> best[SWIPE_MAX_CANDIDATES];
+    int bestCount = 0;
+    const int keyCount = keys.size();
+    for (int startKey : std::as_const(startKeys)) {
+        for (int endKey : std::as_const(endKeys)) {
+            const size_t bucket = size_t(startKey) * size_t(keyCount) + size_t(endKey);
+            for (quint32 t = bucketStarts[bucket]; t < bucketStarts[bucket + 1]; ++t) {
+                const float templateLength = templateLengths[t];
+                if (templateLength < minLength || templateLength > maxLength) continue;
+                const float prior = templatePriors[t];
+                const float limit = bestCount == k ? (best[k - 1].first - prior) * float(SAMPLE_POINTS)
+                                                   : std::numeric_limits<float>::max();
+                if (limit <= 0.0f) continue;
+                const float distance = pathDistance(&templateXs[size_t(t) * SAMPLE_POINTS], &templateYs[size_t(t) * SAMPLE_POINTS],
+                                                    pathXs, pathYs, limit);
+                if (distance > limit) continue;
+                const float cost = distance / float(SAMPLE_POINTS) + prior;
+                int position = bestCount < k ? bestCount++ : k - 1;
+                while (position > 0 && best[position - 1].first > cost) {
+                    best[position] = best[position - 1];
+                    --position;
+                }
+                best[position] = {cost, t};
+            }
+        }
+    }
+
+    out.reserve(bestCount);
+    for (int i = 0; i < bestCount; ++i) {
+        out.append({words[int(templateWords[best[i].second])].text, best[i].first});
+    }
+    return bestCount;
+}
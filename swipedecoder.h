@@ -0,0 +1,71 @@
+#ifndef VIRTUALKEYBOARD_SWIPEDECODER_H
+#define VIRTUALKEYBOARD_SWIPEDECODER_H
+
+#include <QChar>
+#include <QPointF>
+#include <QString>
+#include <QVector>
+#include <vector>
+
+// 滑行输入解码器
+// 每个单词的模板是依次经过其字母按键中心的折线，重采样为 SAMPLE_POINTS 个等距点；
+// 输入路径同样重采样后与模板逐点比较 (平均欧氏距离，以按键宽度为单位)，再加上词频先验。
+//
+// 模板以结构数组 (SoA) 存放: 所有模板的 x 坐标连续、y 坐标连续，并按 (首字母键, 尾字母键) 分桶，
+// 解码时只扫描路径起点和终点附近按键对应的桶，距离核一次处理 4 个点 (SSE2，其他平台为标量循环)，
+// 每 8 个点检查一次部分和，超过当前第 k 名的代价时提前放弃该模板。
+class SwipeDecoder {
+public:
+    static constexpr int SAMPLE_POINTS = 32; // 重采样点数 (SSE 每次处理 4 个点，应为 8 的倍数)
+
+    // 按键: 字符 (小写) 和中心位置 (像素)
+    struct Key {
+        QChar ch;
+        QPointF center;
+    };
+    // 词典单词和对数频率得分 (与 WordTrie 的得分一致: 每 1024 频率翻倍)
+    struct Word {
+        QString text;
+        int score = 0;
+    };
+    // 解码结果
+    struct Candidate {
+        QString word;
+        float cost = 0; // 平均距离 (按键宽度) + 词频惩罚，越小越好
+    };
+
+    // 设置按键几何 (keyWidth 为按键宽度，用于把像素换算为按键单位)；
+    // 按键单位下的几何有明显变化时需要重新 build()
+    void setKeys(const QVector<Key>& keys, qreal keyWidth);
+    // 设置词典 (构建时跳过按键中没有的字符，少于两个字母的单词不参与滑行)
+    void setWords(QVector<Word> words);
+    // 按当前按键几何构建所有模板
+    void build();
+    bool isReady() const { return built; }
+    int templateCount() const { return int(templateWords.size()); }
+
+    // 解码一条路径 (像素坐标)，按代价升序写入最多 k 个候选，返回个数
+    int decode(const QVector<QPointF>& path, int k, QVector<Candidate>& out) const;
+
+private:
+    // 把折线 (按键单位) 重采样为 SAMPLE_POINTS 个等距点，返回折线长度
+    static float resample(const QVector<QPointF>& polyline, float* xs, float* ys);
+    int keyIndexFor(QChar ch) const;
+    // 离 point 不超过 radius 的按键 (没有时取最近的一个)
+    void keysNear(float x, float y, float radius, QVector<int>& out) const;
+
+    QVector<Key> keys;          // 按键 (中心已换算为按键单位)
+    float keyUnit = 1.0f;       // 按键宽度 (像素)
+    QVector<Word> words;
+    bool built = false;
+
+    // --- 模板 (按桶连续存放) ---
+    std::vector<float> templateXs;        // 模板 t 的点 i: templateXs[t * SAMPLE_POINTS + i]
+    std::vector<float> templateYs;
+    std::vector<float> templateLengths;   // 模板折线长度 (长度预筛选)
+    std::vector<float> templatePriors;    // 词频惩罚
+    std::vector<quint32> templateWords;   // 模板 -> words 下标
+    std::vector<quint32> bucketStarts;    // 桶 (首键 * 键数 + 尾键) -> 第一个模板
+};
+
+#endif // VIRTUALKEYBOARD_SWIPEDECODER_H
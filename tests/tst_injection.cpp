@@ -0,0 +1,286 @@
+// 注入后端测试 (QtTest，由 CTest 运行，见 tests/CMakeLists.txt)
+// recording*: 经 KeyInjector 到达内存记录后端的事件顺序、批次边界，以及关闭时对仍按住的键 (包括 Unicode 字符) 的释放
+// xtest*:     在 Xvfb 下通过 XTest 后端注入，用另一个 X 连接上获得焦点的窗口接收按键事件，
+//             检查一次 send 之后 (不再有任何刷新) 修饰键组合已完整按顺序到达，连续的 Unicode 字符各自正确
+// widget*:    键盘控件经内存记录后端注入: 文本与主机布局不一致的键改用 Unicode 事件，Ctrl 组合仍按 VK 码
+// 只运行一组: tst_injection recordingBatches recordingShutdownRelease recordingShutdownUnicode widgetUnicodeFallback
+
+#include <QtTest>
+#include <QApplication>
+#include <QThread>
+#include <memory>
+
+#include "keyinjector.h"
+#include "recordingbackend.h"
+#include "keyboardlayout.h" // VK_* 常量
+#include "virtualkeyboardwidget.h"
+
+#ifdef VK_HAVE_XTEST
+#include <QDeadlineTimer>
+#include "xtestbackend.h"
+// X11 头文件放在 Qt 头文件之后 (X11 定义了 None、KeyPress 等宏)
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/keysym.h>
+#endif
+
+class InjectionTest : public QObject {
+Q_OBJECT
+
+private slots:
+    void recordingBatches();
+    void recordingShutdownRelease();
+    void recordingShutdownUnicode();
+    void widgetUnicodeFallback();
+    void xtestChord();
+    void xtestUnicode();
+};
+
+// --- 测试数据: Shift + A 的完整组合 ---
+static const KeyEvent SHIFT_A_CHORD[] = {
+    KeyEvent::key(VK_LSHIFT, 0x2A, true, false),
+    KeyEvent::key('A', 0x1E, true, false),
+    KeyEvent::key('A', 0x1E, false, false),
+    KeyEvent::key(VK_LSHIFT, 0x2A, false, false)
+};
+static const int SHIFT_A_CHORD_SIZE = 4;
+
+// --- recordingBatches: 一批事件一次交给后端，单个事件自成一批 ---
+void InjectionTest::recordingBatches() {
+    auto* recording = new RecordingBackend;
+    KeyInjector injector;
+    injector.start(std::unique_ptr<InjectionBackend>(recording));
+
+    injector.postBatch(SHIFT_A_CHORD, SHIFT_A_CHORD_SIZE);
+    injector.post(KeyEvent::key(VK_SPACE, 0x39, true, false));
+    injector.post(KeyEvent::key(VK_SPACE, 0x39, false, false));
+    injector.flush();
+
+    QCOMPARE(recording->batchSizes(), (QVector<int>{ SHIFT_A_CHORD_SIZE, 1, 1 }));
+    const QVector<KeyEvent> events = recording->events();
+    QCOMPARE(events.size(), SHIFT_A_CHORD_SIZE + 2);
+    for (int i = 0; i < SHIFT_A_CHORD_SIZE; ++i) {
+        QCOMPARE(events[i].vkCode, SHIFT_A_CHORD[i].vkCode);
+        QCOMPARE(events[i].scanCode, SHIFT_A_CHORD[i].scanCode);
+        QCOMPARE(events[i].isDown(), SHIFT_A_CHORD[i].isDown());
+        QCOMPARE(events[i].continuesBatch(), i + 1 < SHIFT_A_CHORD_SIZE); // 只有最后一个事件结束批次
+    }
+    QVERIFY(!events[SHIFT_A_CHORD_SIZE].continuesBatch());
+
+    // 没有仍按住的键: 关闭时不再发送任何事件
+    injector.shutdown();
+    QCOMPARE(recording->batchSizes().size(), 3);
+}
+
+// --- recordingShutdownRelease: 关闭时按按下时的扫描码和扩展标志释放 ---
+void InjectionTest::recordingShutdownRelease() {
+    auto* recording = new RecordingBackend;
+    KeyInjector injector;
+    injector.start(std::unique_ptr<InjectionBackend>(recording));
+
+    injector.post(KeyEvent::key(VK_RCONTROL, 0x1D, true, true));
+    injector.post(KeyEvent::key(VK_LEFT, 0x4B, true, true));
+    injector.post(KeyEvent::key(VK_RETURN, 0x1C, true, false));
+    injector.post(KeyEvent::key(VK_RETURN, 0x1C, false, false));
+    injector.shutdown();
+
+    // 释放作为一批，按 (VK 码, 扩展标志) 的顺序: 方向键左 (0x25) 在右 Ctrl (0xA3) 之前
+    QCOMPARE(recording->batchSizes(), (QVector<int>{ 1, 1, 1, 1, 2 }));
+    const QVector<KeyEvent> events = recording->events();
+    const KeyEvent& left = events[4];
+    const KeyEvent& rightControl = events[5];
+    QCOMPARE(left.vkCode, quint16(VK_LEFT));
+    QCOMPARE(left.scanCode, quint16(0x4B));
+    QVERIFY(!left.isDown() && left.isExtended());
+    QCOMPARE(rightControl.vkCode, quint16(VK_RCONTROL));
+    QCOMPARE(rightControl.scanCode, quint16(0x1D));
+    QVERIFY(!rightControl.isDown() && rightControl.isExtended());
+}
+
+// --- recordingShutdownUnicode: 关闭时抬起仍按住的 Unicode 字符，已抬起的不再重复 ---
+void InjectionTest::recordingShutdownUnicode() {
+    auto* recording = new RecordingBackend;
+    KeyInjector injector;
+    injector.start(std::unique_ptr<InjectionBackend>(recording));
+
+    injector.post(KeyEvent::unicode(u'é', true));
+    injector.post(KeyEvent::unicode(u'é', false));
+    injector.post(KeyEvent::unicode(u'ж', true));
+    injector.post(KeyEvent::unicode(u'ж', true)); // 自动重复
+    injector.shutdown();
+
+    QCOMPARE(recording->batchSizes(), (QVector<int>{ 1, 1, 1, 1, 1 }));
+    const KeyEvent release = recording->events().last();
+    QVERIFY(release.isUnicode() && !release.isDown());
+    QCOMPARE(release.scanCode, quint16(u'ж'));
+}
+
+// --- widgetUnicodeFallback: 俄语布局的字母键在美式主机布局上以 Unicode 输入，按住 Ctrl 时按 VK 码 ---
+void InjectionTest::widgetUnicodeFallback() {
+    KeyboardOptions options;
+    options.renderMode = RenderMode::Buttons;
+    options.injectionBackend = QStringLiteral("recording");
+    options.layouts = QStringList{ QStringLiteral("us"), QStringLiteral("ru") };
+    VirtualKeyboardWidget keyboard(options);
+    auto* recording = dynamic_cast<RecordingBackend*>(keyboard.injectionBackend());
+    QVERIFY(recording);
+
+    // 切换布局只替换按键文本，按键 id 不变: Q 键在俄语布局上为 Й
+    const int keyId = keyboard.layoutKeys().keyForChar(QLatin1Char('q')).keyId;
+    int ctrlId = -1;
+    for (int id = 0; id < keyboard.layoutKeys().size() && ctrlId < 0; ++id) {
+        if (keyboard.layoutKeys().entry(id).modifier == ModifierGroup::Ctrl) ctrlId = id;
+    }
+    QVERIFY(keyId >= 0 && ctrlId >= 0);
+    keyboard.switchLayout(1);
+    QCOMPARE(keyboard.activeLayoutIndex(), 1);
+    const auto waitIdle = [&keyboard]() {
+        while (!keyboard.isInjectionIdle()) QThread::yieldCurrentThread();
+    };
+    waitIdle();
+    recording->clear();
+
+    // 美式主机布局上 VK 'Q' 产生 q: 按下和抬起都是字符 й，没有 VK 事件
+    keyboard.onKeyPressed(keyId);
+    keyboard.onKeyReleased(keyId);
+    waitIdle();
+    QVector<KeyEvent> events = recording->events();
+    QCOMPARE(events.size(), 2);
+    QVERIFY(events[0].isUnicode() && events[0].isDown());
+    QVERIFY(events[1].isUnicode() && !events[1].isDown());
+    QCOMPARE(events[0].scanCode, quint16(u'й'));
+    QCOMPARE(events[1].scanCode, quint16(u'й'));
+    recording->clear();
+
+    // 按住 Ctrl: 快捷键按物理键匹配，同一个键按 VK 码注入
+    keyboard.onKeyPressed(ctrlId);
+    keyboard.onKeyPressed(keyId);
+    keyboard.onKeyReleased(keyId);
+    keyboard.onKeyReleased(ctrlId);
+    waitIdle();
+    events = recording->events();
+    QCOMPARE(events.size(), 4);
+    for (const KeyEvent& event : events) QVERIFY(!event.isUnicode());
+    QCOMPARE(events[1].vkCode, quint16('Q'));
+    QVERIFY(events[1].isDown());
+    QCOMPARE(events[2].vkCode, quint16('Q'));
+    QVERIFY(!events[2].isDown());
+}
+
+#ifdef VK_HAVE_XTEST
+// --- XObserver: 另一个 X 连接上获得输入焦点的窗口，接收 XTest 注入的按键事件 ---
+class XObserver {
+public:
+    XObserver() {
+        display = XOpenDisplay(nullptr);
+        if (!display) return;
+        window = XCreateSimpleWindow(display, DefaultRootWindow(display), 0, 0, 100, 100, 0, 0, 0);
+        XSelectInput(display, window, KeyPressMask | KeyReleaseMask | StructureNotifyMask);
+        XMapWindow(display, window);
+        // 窗口映射之后才能获得焦点
+        XEvent event;
+        do { XNextEvent(display, &event); } while (event.type != MapNotify);
+        XSetInputFocus(display, window, RevertToParent, CurrentTime);
+        XSync(display, False);
+    }
+    ~XObserver() {
+        if (!display) return;
+        XDestroyWindow(display, window);
+        XCloseDisplay(display);
+    }
+
+    bool isValid() const { return display != nullptr; }
+
+    // 等待下一个按键事件 (映射变化时刷新本连接的键盘映射)，超时返回 false
+    bool nextKeyEvent(XKeyEvent& keyEvent, int timeoutMs = 2000) {
+        QDeadlineTimer deadline(timeoutMs);
+        while (!deadline.hasExpired()) {
+            if (!XPending(display)) {
+                QThread::msleep(1);
+                continue;
+            }
+            XEvent event;
+            XNextEvent(display, &event);
+            if (event.type == MappingNotify) {
+                XRefreshKeyboardMapping(&event.xmapping);
+                continue;
+            }
+            if (event.type != KeyPress && event.type != KeyRelease) continue;
+            keyEvent = event.xkey;
+            return true;
+        }
+        return false;
+    }
+
+private:
+    Display* display = nullptr;
+    Window window = 0;
+};
+#endif
+
+// --- xtestChord: 修饰键组合在一次 send (一次 XFlush) 之后完整到达 ---
+void InjectionTest::xtestChord() {
+#ifndef VK_HAVE_XTEST
+    QSKIP("没有构建 XTest 后端");
+#else
+    if (qEnvironmentVariableIsEmpty("DISPLAY")) QSKIP("没有 X 显示 (CTest 在 Xvfb 下运行此用例)");
+    XObserver observer;
+    QVERIFY(observer.isValid());
+    XTestBackend backend;
+    QVERIFY(backend.isValid());
+
+    QCOMPARE(backend.send(SHIFT_A_CHORD, SHIFT_A_CHORD_SIZE), SHIFT_A_CHORD_SIZE);
+
+    // send 返回后不再调用后端: 四个事件必须已经刷新到服务器并按顺序到达
+    const struct { int type; KeySym keysym; bool shifted; } expected[SHIFT_A_CHORD_SIZE] = {
+        { KeyPress, XK_Shift_L, false },
+        { KeyPress, XK_a, true },
+        { KeyRelease, XK_a, true },
+        { KeyRelease, XK_Shift_L, true }
+    };
+    for (const auto& want : expected) {
+        XKeyEvent keyEvent;
+        QVERIFY2(observer.nextKeyEvent(keyEvent), "按键事件没有在一次刷新之后到达");
+        QCOMPARE(keyEvent.type, want.type);
+        QCOMPARE(XLookupKeysym(&keyEvent, 0), want.keysym);
+        QCOMPARE((keyEvent.state & ShiftMask) != 0, want.shifted);
+    }
+#endif
+}
+
+// --- xtestUnicode: 同一批中连续的 Unicode 字符各自映射到正确的 keysym ---
+void InjectionTest::xtestUnicode() {
+#ifndef VK_HAVE_XTEST
+    QSKIP("没有构建 XTest 后端");
+#else
+    if (qEnvironmentVariableIsEmpty("DISPLAY")) QSKIP("没有 X 显示 (CTest 在 Xvfb 下运行此用例)");
+    XObserver observer;
+    QVERIFY(observer.isValid());
+    XTestBackend backend;
+    QVERIFY(backend.isValid());
+
+    // é (Latin-1 keysym) 和 ж (0x01000000 + 码点)，中间没有任何等待
+    const KeyEvent text[] = {
+        KeyEvent::unicode(u'é', true), KeyEvent::unicode(u'é', false),
+        KeyEvent::unicode(u'ж', true), KeyEvent::unicode(u'ж', false)
+    };
+    QCOMPARE(backend.send(text, 4), 4);
+
+    const KeySym expected[] = { XK_eacute, XK_eacute, KeySym(0x01000436), KeySym(0x01000436) };
+    for (KeySym keysym : expected) {
+        XKeyEvent keyEvent;
+        QVERIFY(observer.nextKeyEvent(keyEvent));
+        QCOMPARE(XLookupKeysym(&keyEvent, 0), keysym);
+    }
+#endif
+}
+
+int main(int argc, char *argv[]) {
+    // 键盘控件需要 QApplication，但不需要真实的显示 (已设置 QT_QPA_PLATFORM 时不覆盖；XTest 用例直接连接 DISPLAY)
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication app(argc, argv);
+    InjectionTest test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_injection.moc"
@@ -0,0 +1,222 @@
+#include "touchdecoder.h"
+#include "touchtrace.h"
+
+#include <cmath>
+#include <limits>
+
+// --- 语言模型的插值权重 ---
+// 每一阶的概率与低一阶插值: p3 = 0.7 * 三元 + 0.3 * p2，p2 = 0.7 * 二元 + 0.3 * p1，p1 = 0.9 * 一元 + 0.1 * 均匀
+const double NGRAM_HIGHER_WEIGHT = 0.7;
+const double NGRAM_UNIGRAM_WEIGHT = 0.9;
+
+// --- symbolFor: 字符 -> 符号 ---
+int TouchLanguageModel::symbolFor(QChar ch) {
+    const char16_t c = ch.toLower().unicode();
+    return c >= u'a' && c <= u'z' ? int(c - u'a') : BOUNDARY;
+}
+
+// --- charFor: 符号 -> 字符 ---
+QChar TouchLanguageModel::charFor(int symbol) {
+    return symbol >= 0 && symbol < BOUNDARY ? QChar(char16_t(u'a' + symbol)) : QLatin1Char('_');
+}
+
+// --- train: 按词频统计三元/二元/一元计数并插值为对数概率表 ---
+// 每个单词是序列 [边界, 边界, 字母..., 边界]，计数的权重为单词频率 (由对数得分还原)
+void TouchLanguageModel::train(const QVector<Word>& words) {
+    const int contexts = SYMBOLS * SYMBOLS;
+    std::vector<double> trigrams(size_t(contexts) * SYMBOLS, 0.0);
+    std::vector<double> bigrams(size_t(contexts), 0.0);
+    std::vector<double> unigrams(SYMBOLS, 0.0);
+
+    QVector<quint8> sequence;
+    for (const Word& word : words) {
+        sequence.clear();
+        sequence.append(BOUNDARY);
+        sequence.append(BOUNDARY);
+        bool valid = !word.text.isEmpty();
+        for (QChar ch : word.text) {
+            const int symbol = symbolFor(ch);
+            if (symbol == BOUNDARY) { valid = false; break; }
+            sequence.append(quint8(symbol));
+        }
+        if (!valid) continue;
+        sequence.append(BOUNDARY);
+
+        const double weight = std::exp2(word.score / 1024.0);
+        for (int i = 2; i < sequence.size(); ++i) {
+            trigrams[(size_t(sequence[i - 2]) * SYMBOLS + sequence[i - 1]) * SYMBOLS + sequence[i]] += weight;
+            bigrams[size_t(sequence[i - 1]) * SYMBOLS + sequence[i]] += weight;
+            unigrams[sequence[i]] += weight;
+        }
+    }
+
+    double unigramTotal = 0;
+    for (double count : unigrams) unigramTotal += count;
+    if (unigramTotal <= 0) {
+        logProbs.clear();
+        return;
+    }
+    double p1[SYMBOLS];
+    for (int c = 0; c < SYMBOLS; ++c) {
+        p1[c] = NGRAM_UNIGRAM_WEIGHT * unigrams[c] / unigramTotal + (1.0 - NGRAM_UNIGRAM_WEIGHT) / SYMBOLS;
+    }
+
+    logProbs.assign(size_t(contexts) * SYMBOLS, 0.0f);
+    double p2[SYMBOLS];
+    for (int b = 0; b < SYMBOLS; ++b) {
+        double bigramTotal = 0;
+        for (int c = 0; c < SYMBOLS; ++c) bigramTotal += bigrams[size_t(b) * SYMBOLS + c];
+        for (int c = 0; c < SYMBOLS; ++c) {
+            p2[c] = bigramTotal > 0
+                    ? NGRAM_HIGHER_WEIGHT * bigrams[size_t(b) * SYMBOLS + c] / bigramTotal + (1.0 - NGRAM_HIGHER_WEIGHT) * p1[c]
+                    : p1[c];
+        }
+        for (int a = 0; a < SYMBOLS; ++a) {
+            const double* counts = &trigrams[(size_t(a) * SYMBOLS + b) * SYMBOLS];
+            double trigramTotal = 0;
+            for (int c = 0; c < SYMBOLS; ++c) trigramTotal += counts[c];
+            float* row = &logProbs[(size_t(a) * SYMBOLS + b) * SYMBOLS];
+            for (int c = 0; c < SYMBOLS; ++c) {
+                const double p3 = trigramTotal > 0
+                        ? NGRAM_HIGHER_WEIGHT * counts[c] / trigramTotal + (1.0 - NGRAM_HIGHER_WEIGHT) * p2[c]
+                        : p2[c];
+                row[c] = float(std::log(p3));
+            }
+        }
+    }
+}
+
+// --- appendChar: 追加一个符号 ---
+void TouchLanguageModel::appendChar(QChar ch) {
+    const int symbol = symbolFor(ch);
+    if (symbol == BOUNDARY) known = true; // 单词边界之后的上下文总是已知的
+    if (history.size() >= HISTORY) {
+        history.remove(0, HISTORY / 2);
+        truncated = true;
+    }
+    history.append(quint8(symbol));
+}
+
+// --- backspace: 删除最近的符号 (全部删除后上下文未知) ---
+void TouchLanguageModel::backspace() {
+    if (!history.isEmpty()) history.removeLast();
+    if (history.isEmpty()) reset();
+}
+
+// --- reset: 光标位置未知 ---
+void TouchLanguageModel::reset() {
+    history.clear();
+    known = false;
+    truncated = false;
+}
+
+// --- context: 当前上下文 (单词开头处两个都是边界) ---
+bool TouchLanguageModel::context(int& first, int& second) const {
+    if (!known) return false;
+    int boundaryAt = -1;
+    for (int i = int(history.size()) - 1; i >= 0; --i) {
+        if (history[i] == BOUNDARY) { boundaryAt = i; break; }
+    }
+    if (boundaryAt < 0 && !truncated) return false; // 边界已被退格删除，不知道前面是什么
+    const int letters = int(history.size()) - 1 - boundaryAt;
+    second = letters >= 1 ? history[history.size() - 1] : BOUNDARY;
+    first = letters >= 2 ? history[history.size() - 2] : BOUNDARY;
+    return true;
+}
+
+// --- nextLogProbs: 当前上下文的对数概率行 ---
+const float* TouchLanguageModel::nextLogProbs() const {
+    int first = 0, second = 0;
+    if (!isTrained() || !context(first, second)) return nullptr;
+    return logProbsFor(first, second);
+}
+
+const float* TouchLanguageModel::logProbsFor(int first, int second) const {
+    if (!isTrained()) return nullptr;
+    return &logProbs[(size_t(first) * SYMBOLS + second) * SYMBOLS];
+}
+
+// --- setKeys: 预先计算字母键的高斯参数和候选范围 ---
+void TouchDecoder::setKeys(const QVector<Key>& newKeys) {
+    bool changed = newKeys.size() != keys.size();
+    for (int i = 0; !changed && i < keys.size(); ++i) {
+        changed = newKeys[i].rect != keys[i].rect || newKeys[i].ch != keys[i].ch;
+    }
+    if (!changed) return; // 几何没有变化 (例如按钮文本改变引起的布局请求)
+    keys = newKeys;
+    letterKeys.clear();
+    letterSymbols.clear();
+    centerXs.clear();
+    centerYs.clear();
+    inverseSigmaXs.clear();
+    inverseSigmaYs.clear();
+    reachRects.clear();
+    isLetter.fill(false, keys.size());
+
+    for (int i = 0; i < keys.size(); ++i) {
+        const Key& key = keys[i];
+        const int symbol = key.ch.isNull() ? TouchLanguageModel::BOUNDARY : TouchLanguageModel::symbolFor(key.ch);
+        if (symbol == TouchLanguageModel::BOUNDARY || key.rect.isEmpty()) continue;
+        isLetter[i] = true;
+        letterKeys.append(i);
+        letterSymbols.append(quint8(symbol));
+        const QPointF center = key.rect.center();
+        centerXs.append(float(center.x()));
+        centerYs.append(float(center.y()));
+        inverseSigmaXs.append(1.0f / (SIGMA_SCALE * float(key.rect.width())));
+        inverseSigmaYs.append(1.0f / (SIGMA_SCALE * float(key.rect.height())));
+        const qreal reachX = REACH * key.rect.width(), reachY = REACH * key.rect.height();
+        reachRects.append(key.rect.adjusted(-reachX, -reachY, reachX, reachY));
+    }
+    writeTraceKeys();
+}
+
+// --- setTrace: 记录解码 (先写出当前几何) ---
+void TouchDecoder::setTrace(TouchTrace* touchTrace, const QString& surface) {
+    trace = touchTrace;
+    traceSurface = surface;
+    writeTraceKeys();
+}
+
+void TouchDecoder::writeTraceKeys() const {
+    if (trace && !keys.isEmpty()) trace->writeKeys(traceSurface, keys);
+}
+
+// --- decode: 使用共享语言模型的当前上下文 ---
+int TouchDecoder::decode(const QPointF& pos, int strictIndex) const {
+    const int result = decode(pos, strictIndex, model ? model->nextLogProbs() : nullptr);
+    if (trace) trace->writeTouch(traceSurface, pos, model, strictIndex, result);
+    return result;
+}
+
+// --- decode: 在候选范围内的字母键中取 高斯对数似然 + 语言模型 得分最高的一个 ---
+int TouchDecoder::decode(const QPointF& pos, int strictIndex, const float* nextLogProbs) const {
+    if (strictIndex >= 0 && (strictIndex >= isLetter.size() || !isLetter[strictIndex])) return strictIndex; // 非字母键
+    const float x = float(pos.x());
+    const float y = float(pos.y());
+    int result = strictIndex;
+    float bestScore = -std::numeric_limits<float>::infinity();
+    for (int k = 0; k < letterKeys.size(); ++k) {
+        if (!reachRects[k].contains(pos)) continue;
+        const float dx = (x - centerXs[k]) * inverseSigmaXs[k];
+        const float dy = (y - centerYs[k]) * inverseSigmaYs[k];
+        float score = -0.5f * (dx * dx + dy * dy);
+        if (nextLogProbs) score += MODEL_WEIGHT * nextLogProbs[letterSymbols[k]];
+        if (score > bestScore) {
+            bestScore = score;
+            result = letterKeys[k];
+        }
+    }
+    return result;
+}
+
+// --- holdArea: 按键矩形扩展到包含按下点 ---
+QRectF TouchDecoder::holdArea(const QRectF& keyRect, const QPointF& pressPos) {
+    const qreal margin = 1.0;
+    QRectF area = keyRect;
+    area.setLeft(qMin(area.left(), pressPos.x() - margin));
+    area.setRight(qMax(area.right(), pressPos.x() + margin));
+    area.setTop(qMin(area.top(), pressPos.y() - margin));
+    area.setBottom(qMax(area.bottom(), pressPos.y() + margin));
+    return area;
+}
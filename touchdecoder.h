@@ -0,0 +1,110 @@
+#ifndef VIRTUALKEYBOARD_TOUCHDECODER_H
+#define VIRTUALKEYBOARD_TOUCHDECODER_H
+
+#include <QChar>
+#include <QPointF>
+#include <QRectF>
+#include <QString>
+#include <QVector>
+#include <vector>
+
+class TouchTrace;
+
+// 下一个字符的字符级三元语法模型
+// 符号为 a-z 和单词边界 (27 个)，由词典单词按词频训练，每个上下文 (前两个符号) 一行对数概率，
+// 查询只是一次数组下标。上下文跟随输入的字符: 字母延长当前单词，其他字符为单词边界。
+// 光标位置未知 (方向键、快捷键等) 之后直到下一个单词边界都没有上下文。
+class TouchLanguageModel {
+public:
+    static constexpr int SYMBOLS = 27;  // a-z + 单词边界
+    static constexpr int BOUNDARY = 26; // 单词边界符号
+    static constexpr int HISTORY = 32;  // 保留的最近符号数 (退格可以恢复的范围)
+
+    // 词典单词和对数频率得分 (与 WordTrie 的得分一致: 每 1024 频率翻倍)
+    struct Word {
+        QString text;
+        int score = 0;
+    };
+
+    // 按词频训练 (不是 a-z 的字符使所在单词被忽略)
+    void train(const QVector<Word>& words);
+    bool isTrained() const { return !logProbs.empty(); }
+
+    // --- 上下文 ---
+    void appendChar(QChar ch); // 字母延长当前单词，其他字符为单词边界
+    void backspace();          // 删除最近的符号 (超出保留范围时上下文未知)
+    void reset();              // 上下文未知
+
+    // 当前上下文下一个符号的对数概率 (SYMBOLS 个)，未训练或上下文未知时返回 nullptr
+    const float* nextLogProbs() const;
+    // 给定上下文 (前两个符号) 的对数概率 (离线回放用)
+    const float* logProbsFor(int first, int second) const;
+    // 当前上下文的两个符号，未知时返回 false
+    bool context(int& first, int& second) const;
+
+    // 字符 -> 符号 (a-z 不区分大小写)，其他字符返回 BOUNDARY
+    static int symbolFor(QChar ch);
+    // 符号 -> 字符 (边界为 '_')
+    static QChar charFor(int symbol);
+
+private:
+    std::vector<float> logProbs; // 上下文 (a, b) 的下一个符号 c: logProbs[(a * SYMBOLS + b) * SYMBOLS + c]
+    QVector<quint8> history;     // 最近输入的符号
+    bool known = false;          // 上下文是否已知 (遇到单词边界后为真)
+    bool truncated = false;      // history 丢弃过较早的符号
+};
+
+// 概率触摸定位 (每个触摸表面一个: 画布或按钮模式的一个半区)
+// 每个字母键是以按键中心为均值、标准差与按键尺寸成比例的二维高斯分布；
+// 触摸点的得分为 高斯对数似然 + 权重 x 语言模型给出的下一个字符对数概率，取得分最高的字母键。
+// 候选只限于触摸点周围 REACH 个按键尺寸之内的字母键，按在非字母键 (Shift、空格等) 上时不改变结果，
+// 因此可能的字母键的有效命中区域只向相邻字母键扩大，绘制的按键不变。
+// 一次解码只遍历几十个字母键的预先计算的浮点参数，耗时在微秒以下。
+class TouchDecoder {
+public:
+    static constexpr float SIGMA_SCALE = 0.25f; // 高斯标准差 (按键宽/高的比例)
+    static constexpr float REACH = 0.35f;       // 候选范围: 触摸点到按键矩形的距离上限 (按键宽/高的比例)
+    static constexpr float MODEL_WEIGHT = 1.0f; // 语言模型对数概率的权重
+
+    // 按键: 矩形和字母 (不是字母时为空字符，不参与概率定位)
+    struct Key {
+        QRectF rect;
+        QChar ch;
+    };
+
+    // 设置按键几何 (下标与命中测试索引一致)，几何改变时重新设置
+    void setKeys(const QVector<Key>& keys);
+    // 设置共享的语言模型 (nullptr 或未训练时只按几何定位)
+    void setModel(const TouchLanguageModel* languageModel) { model = languageModel; }
+    // 记录每次解码 (surface 区分同一轨迹文件中的多个触摸表面)
+    void setTrace(TouchTrace* trace, const QString& surface);
+    bool isEmpty() const { return letterKeys.isEmpty(); }
+
+    // 解码一次按下: strictIndex 为按键矩形命中测试的结果 (-1 表示未命中)，返回选中的按键下标
+    int decode(const QPointF& pos, int strictIndex) const;
+    // 同上，使用给定的下一个字符对数概率 (nullptr 表示只按几何)
+    int decode(const QPointF& pos, int strictIndex, const float* nextLogProbs) const;
+
+    // 按下后保持按住的区域: 按键矩形扩展到包含按下点 (按下点可能在矩形之外)
+    static QRectF holdArea(const QRectF& keyRect, const QPointF& pressPos);
+
+private:
+    void writeTraceKeys() const;
+
+    QVector<Key> keys;
+    // --- 字母键的预先计算参数 (结构数组) ---
+    QVector<int> letterKeys;       // 字母键 -> 按键下标
+    QVector<quint8> letterSymbols; // 字母键的符号
+    QVector<float> centerXs;
+    QVector<float> centerYs;
+    QVector<float> inverseSigmaXs; // 1 / 标准差
+    QVector<float> inverseSigmaYs;
+    QVector<QRectF> reachRects;    // 按键矩形向外扩展 REACH
+    QVector<bool> isLetter;        // 按键下标 -> 是否为字母键
+
+    const TouchLanguageModel* model = nullptr;
+    TouchTrace* trace = nullptr;
+    QString traceSurface;
+};
+
+#endif // VIRTUALKEYBOARD_TOUCHDECODER_H
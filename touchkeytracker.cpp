@@ -0,0 +1,70 @@
+#include "touchkeytracker.h"
+#include "keyhitgrid.h"
+#include "touchdecoder.h"
+
+#include <QTouchEvent>
+
+// --- handle: 按触摸点的状态更新各自的按键 ---
+void TouchKeyTracker::handle(const QTouchEvent* event, const KeyHitGrid& grid, QVector<Change>& changes, const TouchDecoder* decoder) {
+    for (const QEventPoint& point : event->points()) {
+        switch (point.state()) {
+            case QEventPoint::Pressed: {
+                if (find(point.id())) break; // 重复的按下 (不应发生)
+                const QPointF pos = point.position();
+                int index = grid.indexAt(pos);
+                if (decoder) index = decoder->decode(pos, index);
+                Slot slot{ point.id(), index, false, QRectF() };
+                if (slot.index >= 0) {
+                    slot.area = decoder ? TouchDecoder::holdArea(grid.rect(index), pos) : grid.rect(index);
+                    setDown(slot, true, changes);
+                }
+                touchSlots.append(slot);
+                break;
+            }
+            case QEventPoint::Updated: {
+                Slot* slot = find(point.id());
+                if (!slot || slot->index < 0) break;
+                const bool inside = slot->area.contains(point.position());
+                if (inside != slot->down) setDown(*slot, inside, changes);
+                break;
+            }
+            case QEventPoint::Released: {
+                Slot* slot = find(point.id());
+                if (!slot) break;
+                if (slot->down) setDown(*slot, false, changes);
+                touchSlots.removeAt(int(slot - touchSlots.data()));
+                break;
+            }
+            default: // Stationary: 没有变化
+                break;
+        }
+    }
+}
+
+// --- cancel: 释放所有触摸点的按键 ---
+void TouchKeyTracker::cancel(QVector<Change>& changes) {
+    for (Slot& slot : touchSlots) {
+        if (slot.down) setDown(slot, false, changes);
+    }
+    touchSlots.clear();
+}
+
+TouchKeyTracker::Slot* TouchKeyTracker::find(int pointId) {
+    for (Slot& slot : touchSlots) {
+        if (slot.pointId == pointId) return &slot;
+    }
+    return nullptr;
+}
+
+bool TouchKeyTracker::heldByOther(const Slot& slot) const {
+    for (const Slot& other : touchSlots) {
+        if (&other != &slot && other.down && other.index == slot.index) return true;
+    }
+    return false;
+}
+
+// --- setDown: 改变触摸点的按下状态，同一个键的第一次按下和最后一次释放才产生变化 ---
+void TouchKeyTracker::setDown(Slot& slot, bool down, QVector<Change>& changes) {
+    slot.down = down;
+    if (!heldByOther(slot)) changes.append({ slot.index, down });
+}
@@ -0,0 +1,47 @@
+#ifndef VIRTUALKEYBOARD_TOUCHKEYTRACKER_H
+#define VIRTUALKEYBOARD_TOUCHKEYTRACKER_H
+
+#include <QRectF>
+#include <QVector>
+
+class QTouchEvent;
+class KeyHitGrid;
+class TouchDecoder;
+
+// 多点触摸的按键跟踪
+// 每个触摸点按下时用 KeyHitGrid 找到自己的按键，此后独立地按下/释放它:
+// 与 QAbstractButton 一样，拖出按键时释放、拖回时重新按下，不会换成其他按键。
+// 多个触摸点按住同一个键时，只在第一个按下和最后一个离开时产生变化。
+// 给出 TouchDecoder 时按下的键由它在命中结果附近按概率选择，按住区域扩展到包含按下点。
+class TouchKeyTracker {
+public:
+    // 按键状态变化 (index 为 KeyHitGrid 中的下标)
+    struct Change {
+        int index;
+        bool down;
+    };
+
+    // 处理 TouchBegin/TouchUpdate/TouchEnd，按事件中触摸点的顺序把变化追加到 changes
+    // (decoder 为 nullptr 时按键矩形严格命中)
+    void handle(const QTouchEvent* event, const KeyHitGrid& grid, QVector<Change>& changes, const TouchDecoder* decoder = nullptr);
+    // 释放所有按住的键 (TouchCancel 或几何改变时)
+    void cancel(QVector<Change>& changes);
+    // 当前按下的触摸点数
+    int activeCount() const { return int(touchSlots.size()); }
+
+private:
+    struct Slot {
+        int pointId;
+        int index;  // 按下时命中的按键 (-1 表示按在按键之外)
+        bool down;  // 该触摸点当前是否按着它的按键
+        QRectF area; // 按住区域 (拖出时释放)
+    };
+
+    Slot* find(int pointId);
+    bool heldByOther(const Slot& slot) const; // 其他触摸点是否也按着同一个键
+    void setDown(Slot& slot, bool down, QVector<Change>& changes);
+
+    QVector<Slot> touchSlots;
+};
+
+#endif // VIRTUALKEYBOARD_TOUCHKEYTRACKER_H
@@ -0,0 +1,112 @@
+#include "touchtrace.h"
+
+#include <QHash>
+
+// --- 析构函数: 写出缓冲区 ---
+TouchTrace::~TouchTrace() {
+    if (file.isOpen()) out.flush();
+}
+
+// --- open: 创建轨迹文件 ---
+bool TouchTrace::open(const QString& path, QString* errorMessage) {
+    file.setFileName(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        if (errorMessage) *errorMessage = file.errorString();
+        return false;
+    }
+    out.setDevice(&file);
+    out << "# vktouch 1\n";
+    return true;
+}
+
+// --- writeKeys: 写出表面的按键几何 ---
+void TouchTrace::writeKeys(const QString& surface, const QVector<TouchDecoder::Key>& keys) {
+    if (!file.isOpen()) return;
+    out << "keys " << surface << ' ' << keys.size() << '\n';
+    for (const TouchDecoder::Key& key : keys) {
+        const int symbol = key.ch.isNull() ? TouchLanguageModel::BOUNDARY : TouchLanguageModel::symbolFor(key.ch);
+        out << (symbol == TouchLanguageModel::BOUNDARY ? QLatin1Char('-') : TouchLanguageModel::charFor(symbol)) << ' '
+            << key.rect.x() << ' ' << key.rect.y() << ' ' << key.rect.width() << ' ' << key.rect.height() << '\n';
+    }
+}
+
+// --- writeTouch: 按语言模型的当前上下文写出一次按下 ---
+void TouchTrace::writeTouch(const QString& surface, const QPointF& pos, const TouchLanguageModel* model, int strictIndex, int decodedIndex) {
+    int first = -1, second = -1;
+    if (!model || !model->context(first, second)) first = second = -1;
+    writeTouch(surface, pos, first, second, strictIndex, decodedIndex, -1);
+}
+
+void TouchTrace::writeTouch(const QString& surface, const QPointF& pos, int contextFirst, int contextSecond,
+                            int strictIndex, int decodedIndex, int targetIndex) {
+    if (!file.isOpen()) return;
+    const QString context = contextFirst < 0 ? QStringLiteral("??")
+            : QString(TouchLanguageModel::charFor(contextFirst)) + TouchLanguageModel::charFor(contextSecond);
+    out << "touch " << surface << ' ' << pos.x() << ' ' << pos.y() << ' ' << context << ' '
+        << strictIndex << ' ' << decodedIndex;
+    if (targetIndex >= 0) out << ' ' << targetIndex;
+    out << '\n';
+}
+
+// --- read: 读取轨迹文件 ---
+bool TouchTrace::read(const QString& path, QVector<Surface>& surfaces, QVector<Touch>& touches, QString* errorMessage) {
+    QFile input(path);
+    if (!input.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        if (errorMessage) *errorMessage = input.errorString();
+        return false;
+    }
+    const auto fail = [&](int lineNumber, const char* reason) {
+        if (errorMessage) *errorMessage = QStringLiteral("%1:%2: %3").arg(path).arg(lineNumber).arg(QString::fromUtf8(reason));
+        return false;
+    };
+    const auto symbolOf = [](QChar ch) {
+        return ch == QLatin1Char('_') ? int(TouchLanguageModel::BOUNDARY) : TouchLanguageModel::symbolFor(ch);
+    };
+
+    QHash<QString, int> latestSurface; // 表面名 -> 最近一次几何
+    QTextStream in(&input);
+    int lineNumber = 0;
+    int pendingKeys = 0; // 当前 keys 记录还要读取的按键行数
+    while (!in.atEnd()) {
+        const QString line = in.readLine().trimmed();
+        ++lineNumber;
+        if (line.isEmpty() || line.startsWith(QLatin1Char('#'))) continue;
+        const QStringList fields = line.split(QLatin1Char(' '), Qt::SkipEmptyParts);
+
+        if (pendingKeys > 0) {
+            if (fields.size() != 5 || fields[0].size() != 1) return fail(lineNumber, "按键行格式错误");
+            TouchDecoder::Key key;
+            key.rect = QRectF(fields[1].toDouble(), fields[2].toDouble(), fields[3].toDouble(), fields[4].toDouble());
+            if (fields[0] != QLatin1String("-")) key.ch = fields[0].at(0);
+            surfaces.last().keys.append(key);
+            --pendingKeys;
+        } else if (fields[0] == QLatin1String("keys")) {
+            if (fields.size() != 3) return fail(lineNumber, "keys 记录格式错误");
+            surfaces.append({fields[1], {}});
+            latestSurface.insert(fields[1], int(surfaces.size()) - 1);
+            pendingKeys = fields[2].toInt();
+        } else if (fields[0] == QLatin1String("touch")) {
+            if (fields.size() != 7 && fields.size() != 8) return fail(lineNumber, "touch 记录格式错误");
+            Touch touch;
+            touch.surface = latestSurface.value(fields[1], -1);
+            if (touch.surface < 0) return fail(lineNumber, "touch 之前没有该表面的 keys 记录");
+            touch.pos = QPointF(fields[2].toDouble(), fields[3].toDouble());
+            if (fields[4] != QLatin1String("??") && fields[4].size() == 2) {
+                touch.contextFirst = symbolOf(fields[4].at(0));
+                touch.contextSecond = symbolOf(fields[4].at(1));
+            }
+            touch.strictIndex = fields[5].toInt();
+            touch.decodedIndex = fields[6].toInt();
+            if (fields.size() == 8) touch.targetIndex = fields[7].toInt();
+            const int keyCount = int(surfaces[touch.surface].keys.size());
+            if (touch.strictIndex >= keyCount || touch.decodedIndex >= keyCount || touch.targetIndex >= keyCount) {
+                return fail(lineNumber, "按键下标超出范围");
+            }
+            touches.append(touch);
+        } else {
+            return fail(lineNumber, "未知记录");
+        }
+    }
+    if (pendingKeys > 0) return fail(lineNumber, "keys 记录不完整");
+    return true;
+}
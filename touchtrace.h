@@ -0,0 +1,54 @@
+#ifndef VIRTUALKEYBOARD_TOUCHTRACE_H
+#define VIRTUALKEYBOARD_TOUCHTRACE_H
+
+#include <QFile>
+#include <QString>
+#include <QTextStream>
+#include <QVector>
+#include "touchdecoder.h"
+
+// 触摸轨迹文件 (离线评估概率触摸定位)
+// 文本格式，每行一条记录，# 开头为注释:
+//   keys <表面> <按键数>                         之后每行一个按键: <字母或 -> <x> <y> <宽> <高>
+//   touch <表面> <x> <y> <上下文> <命中> <选中> [<目标>]
+// 上下文为前两个符号 (a-z，单词边界为 _，未知为 ??)；命中/选中/目标为该表面最近一次 keys 中的按键下标
+// (-1 表示未命中)。程序记录的轨迹没有目标列，可以手工标注；基准程序生成的合成轨迹带有目标列。
+// 同一表面的几何改变时 (resize) 重新写出 keys，之后的 touch 使用新的几何。
+class TouchTrace {
+public:
+    // 一个表面的一次几何
+    struct Surface {
+        QString name;
+        QVector<TouchDecoder::Key> keys;
+    };
+    // 一次按下
+    struct Touch {
+        int surface = -1;      // surfaces 中的下标
+        QPointF pos;
+        int contextFirst = -1; // 上下文符号 (-1 表示未知)
+        int contextSecond = -1;
+        int strictIndex = -1;  // 按键矩形命中的按键
+        int decodedIndex = -1; // 记录时选中的按键
+        int targetIndex = -1;  // 想要按的按键 (-1 表示未标注)
+    };
+
+    ~TouchTrace();
+
+    // 创建轨迹文件 (覆盖已有文件)
+    bool open(const QString& path, QString* errorMessage = nullptr);
+    bool isOpen() const { return file.isOpen(); }
+    void writeKeys(const QString& surface, const QVector<TouchDecoder::Key>& keys);
+    void writeTouch(const QString& surface, const QPointF& pos, const TouchLanguageModel* model, int strictIndex, int decodedIndex);
+    // 写出一次按下 (给定上下文和目标，合成轨迹用)
+    void writeTouch(const QString& surface, const QPointF& pos, int contextFirst, int contextSecond,
+                    int strictIndex, int decodedIndex, int targetIndex);
+
+    // 读取轨迹文件
+    static bool read(const QString& path, QVector<Surface>& surfaces, QVector<Touch>& touches, QString* errorMessage = nullptr);
+
+private:
+    QFile file;
+    QTextStream out;
+};
+
+#endif // VIRTUALKEYBOARD_TOUCHTRACE_H
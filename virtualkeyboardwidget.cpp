@@ -1,5 +1,11 @@
 #include "virtualkeyboardwidget.h"
-#include "keyboardlayout.h"
+#include "layoutset.h"      // 启动时生成的全部布局 (内置布局表或布局文件)
+#include "startuptrace.h"   // 启动阶段计时
+#include "asynclogger.h"   // 按键路径上的异步日志
+#include "allocstats.h"    // 按操作的分配统计 (VK_ALLOC_ACCOUNTING)
+#include "keyboardcanvas.h"
+#include "keyboardpanel.h"
+#include "suggestionbar.h"
 
 #include <QScreen>
 #include <QGuiApplication>
@@ -8,7 +14,9 @@
 #include <QFile>
 #include <QDebug>
 #include <QResizeEvent>
-#include <QRegularExpression> // 用于在 QSS 中替换透明度值
+#include <QClipboard>
+#include <QVarLengthArray>
+#include <utility>
 
 // --- Windows API 头文件 ---
 #ifdef _WIN32
@@ -29,12 +37,14 @@ const double MAX_OPACITY = 1.0; // 最大透明度 (100%)
 const int DEFAULT_OPACITY_PERCENT = 85; // 默认透明度百分比
 const int KEY_MIN_HEIGHT = 45; // 按键最小高度 (像素)
 const int KEY_MIN_WIDTH = 45;  // 按键最小宽度 (像素)
-const int AUTO_REPEAT_DELAY_MS = 500; // 按键自动重复的初始延迟 (毫秒)
-const int AUTO_REPEAT_INTERVAL_MS = 50; // 按键自动重复的间隔 (毫秒)
+const int KEY_SPACING = 4;     // 按键间距 (像素)
+const int AUTOCORRECT_MIN_LENGTH = 3;  // 短于此长度的单词不纠正
+const int AUTOCORRECT_SHORT_WORD = 4;  // 不超过此长度的单词只纠正编辑距离 1 的错误
+const int NUMPAD_WINDOW_WIDTH = 360;   // 小键盘模式的窗口宽度 (像素，停靠在屏幕右下角)
 
 // --- 构造函数 ---
-VirtualKeyboardWidget::VirtualKeyboardWidget(QWidget *parent)
-        : QWidget(parent)
+VirtualKeyboardWidget::VirtualKeyboardWidget(const KeyboardOptions& options, QWidget *parent)
+        : QWidget(parent), renderMode(options.renderMode), latencyDumpPath(options.latencyDumpPath)
 {
     // --- 窗口设置 ---
     // 设置窗口标志:
@@ -62,17 +72,34 @@ VirtualKeyboardWidget::VirtualKeyboardWidget(QWidget *parent)
 
     // --- 样式设置 (QSS) ---
     // 使用 QStringLiteral 避免编码问题，%1 %2 %3 是占位符
-    setStyleSheet(QStringLiteral(R"(
+    // 画布模式自行绘制按键，不需要 QPushButton 部分的样式，也就不必解析它
+    StartupTrace::Phase qssPhase("qss");
+    QString styleSheetText = QStringLiteral(R"(
         /* 主窗口透明 */
         QWidget { background-color: transparent; color: white; }
-        /* 键盘半区样式 */
+        /* 键盘半区样式 (背景和边框由 KeyboardPanel 按当前透明度绘制) */
         QWidget#KeyboardHalf {
-             /* 背景色: 深灰色，带 alpha 透明度 (由 %1 控制) */
-             background-color: rgba(40, 40, 45, %1);
-             border-radius: 8px; /* 圆角 */
-             border: 1px solid rgba(80, 80, 80, %1); /* 边框，带 alpha */
              padding: 4px; /* 内边距 */
         }
+        /* 滑块凹槽样式 */
+        QSlider::groove:horizontal {
+            border: 1px solid #bbb;
+            background: rgba(255, 255, 255, 150); /* 半透明白色 */
+            height: 5px; /* 高度 */
+            border-radius: 3px; /* 圆角 */
+        }
+        /* 滑块手柄样式 */
+        QSlider::handle:horizontal {
+            background: qlineargradient(x1:0, y1:0, x2:1, y2:1, stop:0 #eee, stop:1 #ccc); /* 浅灰渐变 */
+            border: 1px solid #777; /* 边框 */
+            width: 16px; /* 宽度 */
+            margin: -6px 0; /* 垂直居中 */
+            border-radius: 8px; /* 圆角 */
+        }
+    )");
+
+    if (renderMode == RenderMode::Buttons) {
+        styleSheetText += QStringLiteral(R"(
         /* 按钮通用样式 */
         QPushButton {
             /* 背景渐变 */
@@ -81,8 +108,8 @@ VirtualKeyboardWidget::VirtualKeyboardWidget(QWidget *parent)
             border: 1px solid #666666; /* 边框 */
             border-radius: 5px; /* 圆角 */
             padding: 5px; /* 内边距 */
-            min-height: %2px; /* 最小高度 (由 %2 控制) */
-            min-width: %3px;  /* 最小宽度 (由 %3 控制) */
+            min-height: %1px; /* 最小高度 (由 %1 控制) */
+            min-width: %2px;  /* 最小宽度 (由 %2 控制) */
             font-size: 11pt; /* 字体大小 */
             font-weight: bold; /* 字体加粗 */
         }
@@ -110,31 +137,75 @@ VirtualKeyboardWidget::VirtualKeyboardWidget(QWidget *parent)
              /* 示例: 如果需要通过 CSS 使空格键更宽，但布局跨度更好 */
              /* min-width: 200px; */
         }
-        /* 滑块凹槽样式 */
-        QSlider::groove:horizontal {
-            border: 1px solid #bbb;
-            background: rgba(255, 255, 255, 150); /* 半透明白色 */
-            height: 5px; /* 高度 */
-            border-radius: 3px; /* 圆角 */
-        }
-        /* 滑块手柄样式 */
-        QSlider::handle:horizontal {
-            background: qlineargradient(x1:0, y1:0, x2:1, y2:1, stop:0 #eee, stop:1 #ccc); /* 浅灰渐变 */
-            border: 1px solid #777; /* 边框 */
-            width: 16px; /* 宽度 */
-            margin: -6px 0; /* 垂直居中 */
-            border-radius: 8px; /* 圆角 */
-        }
     )") // 使用 .arg() 替换占位符
-                          .arg(QString::number(int(DEFAULT_OPACITY_PERCENT / 100.0 * 255))) // %1: 初始背景 alpha 值
-                          .arg(KEY_MIN_HEIGHT - 10) // %2: 按钮最小高度 (QSS)
-                          .arg(KEY_MIN_WIDTH - 10)  // %3: 按钮最小宽度 (QSS)
-    );
+                              .arg(KEY_MIN_HEIGHT - 10) // %1: 按钮最小高度 (QSS)
+                              .arg(KEY_MIN_WIDTH - 10); // %2: 按钮最小宽度 (QSS)
+    }
+    setStyleSheet(styleSheetText);
+    qssPhase.end();
 
     // --- 加载键盘布局数据 ---
-    qRegisterMetaType<KeyInfo>("KeyInfo"); // 注册 KeyInfo 类型，用于 QVariant
-    fullLayoutData = getFullKeyboardLayout(); // 获取完整布局
-    splitLayout(fullLayoutData, leftLayoutData, rightLayoutData); // 拆分布局
+    // 布局切换键循环的全部布局在这里一次生成 (完整布局、按键表和拆分结果)，切换时不再解析或拆分；
+    // 指定了布局文件时使用其二进制缓存代替内置的 us 布局 (加载失败时使用内置布局)
+    {
+        StartupTrace::Phase phase("layout");
+        layoutSet.load(options.layouts.isEmpty() ? LayoutSet::defaultNames() : options.layouts, options.layoutFile);
+        const LayoutSet::Layout& layout = layoutSet.layout(activeLayout);
+        fullLayoutData = layout.full;
+        leftLayoutData = layout.left;
+        rightLayoutData = layout.right;
+        keyTable = layout.table;
+        keyRepeater.setPolicies(keyTable); // 按策略表为每个按键设置自动重复
+        // 各几何模式的排布已在 LayoutSet 中计算，布局中没有所选模式的按键 (例如布局文件没有小键盘) 时使用拆分模式
+        geometryMode = options.geometryMode;
+        if (layout.geometry(geometryMode).isEmpty()) {
+            qWarning() << "布局中没有" << geometryModeName(geometryMode) << "模式的按键，使用拆分模式";
+            geometryMode = GeometryMode::Split;
+        }
+    }
+
+    // --- 加载单词预测词典 (文本词典首次加载时编译为二进制缓存) ---
+    if (!options.dictionaryFile.isEmpty()) {
+        StartupTrace::Phase phase("dictionary");
+        QString dictionaryError;
+        if (!prediction.load(options.dictionaryFile, &dictionaryError)) {
+            qWarning() << "加载词典失败，不显示建议栏:" << dictionaryError;
+        }
+    }
+    // --- 加载拼音词库 (加载成功时默认处于拼音模式) ---
+    if (!options.pinyinLexicon.isEmpty()) {
+        StartupTrace::Phase phase("pinyinLexicon");
+        QString lexiconError;
+        if (pinyin.load(options.pinyinLexicon, &lexiconError)) {
+            pinyinMode = true;
+        } else {
+            qWarning() << "加载拼音词库失败，不启用拼音输入:" << lexiconError;
+        }
+    }
+    consumedKeys.fill(false, keyTable.size());
+    injectedDown.fill(false, keyTable.size());
+    injectedText.resize(keyTable.size());
+
+    // --- 概率触摸定位 (语言模型在首帧之后训练，之前只按几何定位) ---
+    touchTargeting = options.touchTargeting;
+    if (touchTargeting && !options.touchTraceFile.isEmpty()) {
+        QString traceError;
+        if (!touchTrace.open(options.touchTraceFile, &traceError)) qWarning() << "无法创建触摸轨迹文件:" << traceError;
+    }
+    // --- 输入轨迹 (按键表已建立，文件头记录布局指纹) ---
+    if (!options.inputTraceFile.isEmpty()) {
+        QString traceError;
+        if (!inputTrace.open(options.inputTraceFile, keyTable, &traceError)) qWarning() << "无法创建输入轨迹文件:" << traceError;
+    }
+
+    // --- 加载宏 (按绑定键的 VK 码在当前布局中重新查找按键) ---
+    macroFilePath = options.macroFile;
+    macroDelayMs = qMax(0, options.macroDelayMs);
+    if (!macroFilePath.isEmpty()) {
+        StartupTrace::Phase phase("macros");
+        QString macroError;
+        if (!macros.load(macroFilePath, keyTable, &macroError)) qWarning() << "加载宏文件失败:" << macroError;
+    }
 
     // --- 初始化键盘状态 ---
 #ifdef _WIN32
@@ -150,9 +221,47 @@ VirtualKeyboardWidget::VirtualKeyboardWidget(QWidget *parent)
     shiftActive = false; ctrlActive = false; altActive = false; winActive = false;
 #endif
 
+    // --- 启动按键注入线程 ---
+    {
+        StartupTrace::Phase phase("injector");
+        keyInjector.start(createInjectionBackend(options.injectionBackend));
+    }
+
     // --- 设置 UI ---
     setupUI(); // 创建界面元素
-    updateModifierKeysVisuals(); // 根据初始状态更新按键视觉效果
+    // --- 滑行输入 (模板在首帧之后构建，不计入启动时间) ---
+    if (options.swipeTyping) {
+        if (keyboardCanvas && prediction.isLoaded()) {
+            keyboardCanvas->setGestureMode(true);
+            connect(keyboardCanvas, &KeyboardCanvas::gestureFinished, this, &VirtualKeyboardWidget::onGestureFinished);
+            connect(this, &VirtualKeyboardWidget::firstFrameShown, this, &VirtualKeyboardWidget::prepareSwipeDecoder, Qt::QueuedConnection);
+        } else {
+            qWarning() << "滑行输入需要画布模式 (--render=canvas) 和单词预测词典 (--dictionary)，未启用";
+        }
+    }
+    if (touchTargeting && prediction.isLoaded()) {
+        connect(this, &VirtualKeyboardWidget::firstFrameShown, this, &VirtualKeyboardWidget::prepareTouchModel, Qt::QueuedConnection);
+    }
+    // --- 自动纠错 (索引在首帧之后打开，首次使用词典时编译) ---
+    if (options.autocorrect) {
+        if (prediction.isLoaded()) {
+            autocorrectEnabled = true;
+            const QString dictionaryPath = options.dictionaryFile;
+            connect(this, &VirtualKeyboardWidget::firstFrameShown, this,
+                    [this, dictionaryPath]() { prepareAutocorrect(dictionaryPath); }, Qt::QueuedConnection);
+        } else {
+            qWarning() << "自动纠错需要单词预测词典 (--dictionary)，未启用";
+        }
+    }
+    // --- 批量输入 ---
+    bulkTypingOptions = options.bulkTyping;
+    connect(&bulkTyper, &BulkTyper::finished, this, &VirtualKeyboardWidget::onBulkTypingFinished);
+    connect(&macroPlayer, &BulkTyper::finished, this, &VirtualKeyboardWidget::onMacroPlaybackFinished);
+    connect(&keyRepeater, &KeyRepeater::repeat, this, &VirtualKeyboardWidget::onKeyRepeat);
+    {
+        StartupTrace::Phase phase("modifierVisuals");
+        updateModifierKeysVisuals(); // 根据初始状态更新按键视觉效果
+    }
     // 使用 invokeMethod 确保在事件循环开始后再定位窗口，避免初始尺寸问题
     QMetaObject::invokeMethod(this, &VirtualKeyboardWidget::positionWindow, Qt::QueuedConnection);
 
@@ -165,6 +274,20 @@ VirtualKeyboardWidget::VirtualKeyboardWidget(QWidget *parent)
     }
 }
 
+// --- 析构函数 ---
+VirtualKeyboardWidget::~VirtualKeyboardWidget() {
+    // 排空注入队列，并释放仍处于按下状态的键，避免修饰键卡住
+    keyInjector.shutdown();
+
+    // 输出按下到注入的延迟统计
+    if (keyInjector.latency().histogram(LatencyStage::EndToEnd).snapshot().count > 0) {
+        qDebug().noquote() << "按键延迟统计:\n" + keyInjector.latency().summary();
+    }
+    if (!latencyDumpPath.isEmpty()) keyInjector.latency().writeJson(latencyDumpPath);
+    // 输出按操作的分配统计
+    if (AllocStats::enabled()) qDebug().noquote() << "分配统计:\n" + AllocStats::summary();
+}
+
 // --- applyWindowStyles: 应用额外的窗口样式 ---
 void VirtualKeyboardWidget::applyWindowStyles() {
 #ifdef _WIN32
@@ -192,57 +315,160 @@ void VirtualKeyboardWidget::applyWindowStyles() {
 
 // --- setupUI: 初始化用户界面 ---
 void VirtualKeyboardWidget::setupUI() {
+    StartupTrace::Phase phase("setupUI");
     // 创建最外层垂直布局
     outerLayout = new QVBoxLayout(this); // 'this' 作为父对象，布局将设置给主窗口
     outerLayout->setContentsMargins(5, 5, 5, 5); // 设置外边距
     outerLayout->setSpacing(5); // 设置元素间距
 
+    // --- 单词建议栏/拼音候选栏 (键盘上方) ---
+    if (prediction.isLoaded() || pinyin.isLoaded()) {
+        suggestionBar = new SuggestionBar(qMax(PredictionEngine::MAX_SUGGESTIONS, PinyinEngine::MAX_CANDIDATES));
+        suggestionBar->setBackgroundAlpha(opacityToAlpha(DEFAULT_OPACITY_PERCENT));
+        if (pinyin.isLoaded()) suggestionBar->setModeLabel(pinyinMode ? QStringLiteral("中") : QStringLiteral("英"));
+        if (!pinyinMode) suggestionBar->setSuggestions(prediction.suggestions());
+        connect(suggestionBar, &SuggestionBar::suggestionChosen, this, &VirtualKeyboardWidget::onSuggestionChosen);
+        connect(suggestionBar, &SuggestionBar::modeClicked, this, &VirtualKeyboardWidget::togglePinyinMode);
+        outerLayout->addWidget(suggestionBar);
+    }
+
+    if (renderMode == RenderMode::Canvas) {
+        // --- 画布模式: 单个控件绘制当前几何模式的所有区域 ---
+        keyboardCanvas = new KeyboardCanvas();
+        keyboardCanvas->setBackgroundAlpha(opacityToAlpha(DEFAULT_OPACITY_PERCENT));
+        keyboardCanvas->setSections(activeGeometry().sections);
+        connect(keyboardCanvas, &KeyboardCanvas::keyPressed, this, &VirtualKeyboardWidget::onKeyPressed);
+        connect(keyboardCanvas, &KeyboardCanvas::keyReleased, this, &VirtualKeyboardWidget::onKeyReleased);
+        keyboardCanvas->installEventFilter(this); // 记录输入事件时间 (延迟统计)
+        if (touchTargeting) keyboardCanvas->setTouchTargeting(&touchModel, touchTrace.isOpen() ? &touchTrace : nullptr);
+        outerLayout->addWidget(keyboardCanvas, 1);
+    } else {
+        setupButtonKeyboard();
+    }
+
+    // --- 创建透明度滑块 ---
+    opacitySlider = new QSlider(Qt::Horizontal); // 创建水平滑块
+    opacitySlider->setRange(static_cast<int>(MIN_OPACITY * 100), static_cast<int>(MAX_OPACITY * 100)); // 设置范围 (20-100)
+    opacitySlider->setValue(DEFAULT_OPACITY_PERCENT); // 设置初始值
+    opacitySlider->setFixedHeight(20); // 设置固定高度
+    opacitySlider->setToolTip("调节键盘透明度"); // 设置鼠标悬停提示
+    // !!! 关键: 阻止滑块接受焦点 !!!
+    opacitySlider->setFocusPolicy(Qt::NoFocus);
+    connect(opacitySlider, &QSlider::valueChanged, this, &VirtualKeyboardWidget::changeOpacity); // 连接信号槽
+    // 合并滑块事件: 间隔约为一帧 (按屏幕刷新率计算)
+    const qreal refreshRate = QGuiApplication::primaryScreen() ? QGuiApplication::primaryScreen()->refreshRate() : 60.0;
+    opacityTimer.setSingleShot(true);
+    opacityTimer.setTimerType(Qt::PreciseTimer);
+    opacityTimer.setInterval(qMax(1, qRound(1000.0 / (refreshRate > 0 ? refreshRate : 60.0))));
+    connect(&opacityTimer, &QTimer::timeout, this, &VirtualKeyboardWidget::applyPendingOpacity);
+
+    // --- 批量输入按钮 (滑块右侧): 把剪贴板文本作为按键输入，用于不接受粘贴的目标 ---
+    bulkTypeButton = new QPushButton("输入剪贴板");
+    bulkTypeButton->setObjectName("BulkTypeButton");
+    bulkTypeButton->setFixedHeight(20);
+    bulkTypeButton->setToolTip("把剪贴板中的文本逐键输入到当前窗口 (输入过程中再次点击或按任意键取消)");
+    bulkTypeButton->setFocusPolicy(Qt::NoFocus); // 同样不能接受焦点
+    connect(bulkTypeButton, &QPushButton::clicked, this, &VirtualKeyboardWidget::typeClipboard);
+
+    // --- 宏按钮: 录制按键序列并绑定到一个键上 ---
+    macroButton = new QPushButton();
+    macroButton->setObjectName("MacroButton");
+    macroButton->setFixedHeight(20);
+    macroButton->setFocusPolicy(Qt::NoFocus);
+    connect(macroButton, &QPushButton::clicked, this, &VirtualKeyboardWidget::toggleMacroRecording);
+    updateMacroButton();
+    // 绑定了宏的键不自动重复 (否则按住时会反复回放)
+    for (int keyId = 0; keyId < keyTable.size(); ++keyId) {
+        if (macros.isBound(keyId)) keyRepeater.setEnabled(keyId, false);
+    }
+
+    // --- 几何按钮: 在完整、拆分、紧凑和小键盘之间循环 ---
+    geometryButton = new QPushButton(geometryModeLabel(geometryMode));
+    geometryButton->setObjectName("GeometryButton");
+    geometryButton->setFixedHeight(20);
+    geometryButton->setToolTip("切换键盘排布: 完整 / 拆分 / 紧凑 / 小键盘");
+    geometryButton->setFocusPolicy(Qt::NoFocus);
+    connect(geometryButton, &QPushButton::clicked, this, &VirtualKeyboardWidget::cycleGeometryMode);
+
+    QHBoxLayout *bottomLayout = new QHBoxLayout();
+    bottomLayout->setContentsMargins(0, 0, 0, 0);
+    bottomLayout->addWidget(opacitySlider, 1);
+    bottomLayout->addWidget(bulkTypeButton);
+    bottomLayout->addWidget(macroButton);
+    bottomLayout->addWidget(geometryButton);
+    outerLayout->addLayout(bottomLayout); // 将滑块和按钮添加到外层布局底部
+}
+
+// --- setupButtonKeyboard: 按钮模式，创建左右两个键盘半区 ---
+void VirtualKeyboardWidget::setupButtonKeyboard() {
     // 创建容纳左右键盘的水平布局
     keyboardLayout = new QHBoxLayout();
     keyboardLayout->setContentsMargins(0, 0, 0, 0); // 无内边距
     keyboardLayout->setSpacing(10); // 左右键盘间距
 
     // --- 创建左键盘 ---
-    leftKeyboardWidget = new QWidget(); // 创建左侧容器
+    leftKeyboardWidget = new KeyboardPanel(); // 创建左侧容器 (自行绘制半透明背景)
     leftKeyboardWidget->setObjectName("KeyboardHalf"); // 设置对象名，用于 QSS 选择器
-    leftKeyboardWidget->setAttribute(Qt::WA_StyledBackground); // 允许 QSS 设置背景
+    leftKeyboardWidget->setBackgroundAlpha(opacityToAlpha(DEFAULT_OPACITY_PERCENT));
     leftKeyboardWidget->setSizePolicy(QSizePolicy::MinimumExpanding, QSizePolicy::Minimum); // 设置尺寸策略
+    connect(leftKeyboardWidget, &KeyboardPanel::keyPressed, this, &VirtualKeyboardWidget::onKeyPressed);   // 触摸按下
+    connect(leftKeyboardWidget, &KeyboardPanel::keyReleased, this, &VirtualKeyboardWidget::onKeyReleased);
+    leftKeyboardWidget->installEventFilter(this); // 记录触摸事件时间 (延迟统计)
+    if (touchTargeting) leftKeyboardWidget->setTouchTargeting(&touchModel, touchTrace.isOpen() ? &touchTrace : nullptr, QStringLiteral("left"));
     leftGridLayout = new QGridLayout(leftKeyboardWidget); // 创建网格布局并设置给左侧容器
-    leftGridLayout->setSpacing(4); // 按键间距
-    createKeyboardLayout(leftKeyboardWidget, leftGridLayout, leftLayoutData); // 生成左侧按键
+    leftGridLayout->setSpacing(KEY_SPACING); // 按键间距
+    const KeyboardGeometry& geometry = activeGeometry();
+    createKeyboardLayout(leftKeyboardWidget, leftGridLayout, geometry.sections.value(0)); // 生成左侧 (单区域模式为全部) 按键
     keyboardLayout->addWidget(leftKeyboardWidget, 1); // 添加到水平布局，拉伸因子为 1
 
     // --- 添加伸缩项 ---
     keyboardLayout->addStretch(1); // 在左右键盘中间添加可伸缩空间
 
     // --- 创建右键盘 ---
-    rightKeyboardWidget = new QWidget(); // 创建右侧容器
+    rightKeyboardWidget = new KeyboardPanel(); // 创建右侧容器
     rightKeyboardWidget->setObjectName("KeyboardHalf");
-    rightKeyboardWidget->setAttribute(Qt::WA_StyledBackground);
+    rightKeyboardWidget->setBackgroundAlpha(opacityToAlpha(DEFAULT_OPACITY_PERCENT));
     rightKeyboardWidget->setSizePolicy(QSizePolicy::MinimumExpanding, QSizePolicy::Minimum);
+    connect(rightKeyboardWidget, &KeyboardPanel::keyPressed, this, &VirtualKeyboardWidget::onKeyPressed);
+    connect(rightKeyboardWidget, &KeyboardPanel::keyReleased, this, &VirtualKeyboardWidget::onKeyReleased);
+    rightKeyboardWidget->installEventFilter(this);
+    if (touchTargeting) rightKeyboardWidget->setTouchTargeting(&touchModel, touchTrace.isOpen() ? &touchTrace : nullptr, QStringLiteral("right"));
     rightGridLayout = new QGridLayout(rightKeyboardWidget); // 创建网格布局
-    rightGridLayout->setSpacing(4);
-    createKeyboardLayout(rightKeyboardWidget, rightGridLayout, rightLayoutData); // 生成右侧按键
+    rightGridLayout->setSpacing(KEY_SPACING);
+    createKeyboardLayout(rightKeyboardWidget, rightGridLayout, geometry.sections.value(1)); // 生成右侧按键
     keyboardLayout->addWidget(rightKeyboardWidget, 1); // 添加到水平布局，拉伸因子为 1
+    // 单区域模式 (完整、紧凑、小键盘) 隐藏右半区，中间的伸缩空间也不再占位
+    rightKeyboardWidget->setVisible(geometry.sections.size() > 1);
+    keyboardLayout->setStretch(1, geometry.sections.size() > 1 ? 1 : 0);
+
+    // --- 其他几何模式需要的按钮 (小键盘、完整模式中不拆分的空格键等) 预先创建并隐藏 ---
+    // 切换模式时只把现有按钮重新放入网格；所有布局的几何相同，按当前布局计算即可
+    const LayoutSet::Layout& layout = layoutSet.layout(activeLayout);
+    QVector<int> keyCounts;
+    for (int mode = 0; mode < GEOMETRY_MODE_COUNT; ++mode) {
+        keyCounts.fill(0, keyTable.size());
+        for (const KeyboardLayout& section : layout.geometry(GeometryMode(mode)).sections) {
+            for (const auto& row : section) {
+                for (const KeyInfo& keyInfo : row) {
+                    if (keyInfo.keyId >= 0) ++keyCounts[keyInfo.keyId];
+                }
+            }
+        }
+        for (int keyId = 0; keyId < keyTable.size(); ++keyId) {
+            while (keyButtonsById.value(keyId).size() < keyCounts[keyId]) {
+                createKeyButton(keyTable.info(keyId), leftKeyboardWidget)->hide();
+            }
+        }
+    }
 
     // 将包含左右键盘的水平布局添加到外层垂直布局
     outerLayout->addLayout(keyboardLayout);
-
-    // --- 创建透明度滑块 ---
-    opacitySlider = new QSlider(Qt::Horizontal); // 创建水平滑块
-    opacitySlider->setRange(static_cast<int>(MIN_OPACITY * 100), static_cast<int>(MAX_OPACITY * 100)); // 设置范围 (20-100)
-    opacitySlider->setValue(DEFAULT_OPACITY_PERCENT); // 设置初始值
-    opacitySlider->setFixedHeight(20); // 设置固定高度
-    opacitySlider->setToolTip("调节键盘透明度"); // 设置鼠标悬停提示
-    // !!! 关键: 阻止滑块接受焦点 !!!
-    opacitySlider->setFocusPolicy(Qt::NoFocus);
-    connect(opacitySlider, &QSlider::valueChanged, this, &VirtualKeyboardWidget::changeOpacity); // 连接信号槽
-    outerLayout->addWidget(opacitySlider); // 将滑块添加到外层布局底部
 }
 
 // --- createKeyboardLayout: 根据布局数据创建按钮 ---
-void VirtualKeyboardWidget::createKeyboardLayout(QWidget* parentWidget, QGridLayout* layout, const KeyboardLayout& keyRows)
+void VirtualKeyboardWidget::createKeyboardLayout(KeyboardPanel* panel, QGridLayout* layout, const KeyboardLayout& keyRows)
 {
+    StartupTrace::Phase phase("createKeyboardLayout");
     // 遍历布局数据中的每一行
     for (const auto& row : keyRows) {
         // 遍历当前行的每一个按键信息
@@ -250,58 +476,11 @@ void VirtualKeyboardWidget::createKeyboardLayout(QWidget* parentWidget, QGridLay
             // 跳过完全空的占位符
             if (keyInfo.vkCode == 0 && keyInfo.text.isEmpty()) continue;
 
-            // 创建按钮
-            QPushButton *button = new QPushButton(keyInfo.text, parentWidget);
-            // 设置尺寸策略为可扩展
-            button->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
-            // !!! 关键: 设置按钮不接受焦点 !!!
-            // 这可以防止按钮本身在点击时窃取焦点。
-            button->setFocusPolicy(Qt::NoFocus);
-
-            // 根据按键类型或 VK 码设置对象名，用于 QSS 样式区分
-            if (keyInfo.vkCode == VK_SPACE) button->setObjectName("SpaceKey");
-            else if (keyInfo.type != KeyType::Normal) button->setObjectName("SpecialKey"); // 非普通键使用 SpecialKey 样式
-
-            // 使切换键 (Caps Lock 等) 可被选中 (checkable)
-            if (keyInfo.type == KeyType::ModifierToggle) {
-                button->setCheckable(true);
-            }
-
-            // --- 设置按键自动重复 ---
-            bool enableAutoRepeat = false;
-            switch (keyInfo.type) {
-                case KeyType::Normal: // 普通字符键允许重复
-                    enableAutoRepeat = true;
-                    break;
-                case KeyType::Special: // 特殊键只允许部分重复 (如 Backspace, Delete, Space, 方向键)
-                    if (keyInfo.vkCode == VK_BACK || keyInfo.vkCode == VK_DELETE || keyInfo.vkCode == VK_SPACE ||
-                        keyInfo.vkCode == VK_LEFT || keyInfo.vkCode == VK_RIGHT || keyInfo.vkCode == VK_UP || keyInfo.vkCode == VK_DOWN) {
-                        enableAutoRepeat = true;
-                    }
-                    break;
-                default: // 修饰键和切换键不自动重复
-                    enableAutoRepeat = false;
-                    break;
-            }
-            if (enableAutoRepeat) {
-                button->setAutoRepeat(true); // 允许自动重复
-                button->setAutoRepeatDelay(AUTO_REPEAT_DELAY_MS); // 设置重复延迟
-                button->setAutoRepeatInterval(AUTO_REPEAT_INTERVAL_MS); // 设置重复间隔
-            }
-            // --- 结束自动重复设置 ---
-
-            // 将按键信息 (KeyInfo) 存储为按钮的属性，方便后续在槽函数中获取
-            button->setProperty("keyInfo", QVariant::fromValue(keyInfo));
-
-            // 连接按钮的 pressed 和 released 信号到对应的槽函数
-            // 使用 pressed/released 可以更好地处理按键按下和抬起事件，特别是对于修饰键
-            connect(button, &QPushButton::pressed, this, &VirtualKeyboardWidget::onKeyPressed);
-            connect(button, &QPushButton::released, this, &VirtualKeyboardWidget::onKeyReleased);
-
+            QPushButton *button = createKeyButton(keyInfo, panel);
+            // 触摸由容器处理 (多个触摸点可以同时按住不同的按钮)，字母键参与概率触摸定位
+            panel->addTouchKey(button, keyInfo);
             // 将按钮添加到网格布局中，指定行、列、行跨度(1)、列跨度(keyInfo.columnSpan)
             layout->addWidget(button, keyInfo.row, keyInfo.column, 1, keyInfo.columnSpan);
-            // 将按钮指针添加到列表中，方便后续统一更新视觉状态
-            keyButtons.append(button);
         }
     }
     // 设置布局的行和列拉伸因子，使按钮在调整大小时能均匀填充空间
@@ -309,43 +488,163 @@ void VirtualKeyboardWidget::createKeyboardLayout(QWidget* parentWidget, QGridLay
     for(int c=0; c < layout->columnCount(); ++c) layout->setColumnStretch(c, 1);
 }
 
-// --- onKeyPressed: 处理按钮按下事件 ---
-// 使用 SendInput 实现，采用“按下保持”的修饰键逻辑
-void VirtualKeyboardWidget::onKeyPressed() {
-    // 获取发送信号的按钮
-    QPushButton *button = qobject_cast<QPushButton*>(sender());
-    if (!button) return; // 安全检查
+// --- createKeyButton: 创建按键按钮并建立索引 ---
+QPushButton* VirtualKeyboardWidget::createKeyButton(const KeyInfo& keyInfo, QWidget* parent) {
+    // 创建按钮
+    QPushButton *button = new QPushButton(keyInfo.text, parent);
+    // 设置尺寸策略为可扩展
+    button->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+    // !!! 关键: 设置按钮不接受焦点 !!!
+    // 这可以防止按钮本身在点击时窃取焦点。
+    button->setFocusPolicy(Qt::NoFocus);
+
+    // 根据按键类型或 VK 码设置对象名，用于 QSS 样式区分
+    if (keyInfo.vkCode == VK_SPACE) button->setObjectName("SpaceKey");
+    else if (keyInfo.type != KeyType::Normal) button->setObjectName("SpecialKey"); // 非普通键使用 SpecialKey 样式
+
+    // 使切换键 (Caps Lock 等) 可被选中 (checkable)
+    if (keyInfo.type == KeyType::ModifierToggle) {
+        button->setCheckable(true);
+    }
 
-    // 从按钮属性中获取 KeyInfo
-    QVariant variant = button->property("keyInfo");
-    if (!variant.isValid() || !variant.canConvert<KeyInfo>()) return; // 检查 QVariant 是否有效且可转换
-    KeyInfo keyInfo = variant.value<KeyInfo>(); // 获取 KeyInfo 对象
+    // 自动重复由 keyRepeater 统一调度 (不使用 QPushButton::setAutoRepeat，它每次重复都发出 released + pressed)
+
+    // 连接按钮的 pressed 和 released 信号到对应的槽函数
+    // 使用 pressed/released 可以更好地处理按键按下和抬起事件，特别是对于修饰键
+    // 按钮只携带按键 id，槽函数直接按 id 查表，不需要 sender() 和 QVariant 属性
+    const int keyId = keyInfo.keyId;
+    connect(button, &QPushButton::pressed, this, [this, keyId]() { onKeyPressed(keyId); });
+    connect(button, &QPushButton::released, this, [this, keyId]() { onKeyReleased(keyId); });
+    button->installEventFilter(this); // 记录输入事件时间 (延迟统计)
+
+    // 将按钮指针添加到列表中，并按 id 建立索引，方便后续只更新受影响的按钮
+    keyButtons.append(button);
+    if (keyId >= keyButtonsById.size()) keyButtonsById.resize(keyId + 1);
+    keyButtonsById[keyId].append(button);
+    return button;
+}
+
+// --- arrangeButtons: 按几何重新排布现有按钮 ---
+// 同一 id 的按钮按出现顺序依次使用 (拆分的空格键两半)；按钮换到另一个容器时由 addWidget 改变父控件
+void VirtualKeyboardWidget::arrangeButtons(const KeyboardGeometry& geometry) {
+    Q_ASSERT(geometry.sections.size() <= 2);
+    for (QPushButton* button : std::as_const(keyButtons)) {
+        leftGridLayout->removeWidget(button);
+        rightGridLayout->removeWidget(button);
+    }
+    leftKeyboardWidget->clearTouchKeys();
+    rightKeyboardWidget->clearTouchKeys();
+
+    QVector<int> usedById(keyButtonsById.size(), 0);
+    for (int s = 0; s < geometry.sections.size(); ++s) {
+        KeyboardPanel* panel = s == 0 ? leftKeyboardWidget : rightKeyboardWidget;
+        QGridLayout* grid = s == 0 ? leftGridLayout : rightGridLayout;
+        for (const auto& row : geometry.sections[s]) {
+            for (const KeyInfo& keyInfo : row) {
+                if (keyInfo.keyId < 0) continue; // 占位符没有按钮
+                QPushButton* button = keyButtonsById[keyInfo.keyId].value(usedById[keyInfo.keyId]++);
+                if (!button) continue;
+                grid->addWidget(button, keyInfo.row, keyInfo.column, 1, keyInfo.columnSpan);
+                button->show(); // 改变父控件或之前隐藏的按钮需要显式显示
+                panel->addTouchKey(button, keyInfo);
+            }
+        }
+        // 网格的行列数只增不减: 本模式以外的行列不再拉伸 (空行列不占空间)
+        const int rows = geometry.rowCount(s);
+        const int columns = geometry.columnCount(s);
+        for (int r = 0; r < grid->rowCount(); ++r) grid->setRowStretch(r, r < rows ? 1 : 0);
+        for (int c = 0; c < grid->columnCount(); ++c) grid->setColumnStretch(c, c < columns ? 1 : 0);
+    }
+    // 本模式不需要的按钮隐藏
+    for (int keyId = 0; keyId < keyButtonsById.size(); ++keyId) {
+        const QList<QPushButton*>& buttons = keyButtonsById[keyId];
+        for (int i = usedById[keyId]; i < buttons.size(); ++i) buttons[i]->hide();
+    }
+    rightKeyboardWidget->setVisible(geometry.sections.size() > 1);
+    keyboardLayout->setStretch(1, geometry.sections.size() > 1 ? 1 : 0);
+}
+
+// --- modifierFlag: 返回修饰键分组对应的状态标志 (非修饰键返回 nullptr) ---
+bool* VirtualKeyboardWidget::modifierFlag(ModifierGroup group) {
+    switch (group) {
+        case ModifierGroup::Shift: return &shiftActive;
+        case ModifierGroup::Ctrl: return &ctrlActive;
+        case ModifierGroup::Alt: return &altActive;
+        case ModifierGroup::Win: return &winActive;
+        case ModifierGroup::CapsLock: return &capsLockActive;
+        case ModifierGroup::NumLock: return &numLockActive;
+        case ModifierGroup::ScrollLock: return &scrollLockActive;
+        case ModifierGroup::None: break;
+    }
+    return nullptr;
+}
+
+// --- onKeyPressed: 处理按键按下事件 ---
+// 按钮和画布只传递按键 id，直接按 id 从 keyTable 取数据
+// 通过注入后端实现，采用“按下保持”的修饰键逻辑
+void VirtualKeyboardWidget::onKeyPressed(int keyId) {
+    AllocStats::Scope allocScope(AllocOperation::Press);
+    beginKeyHandler();
+    const KeyEntry& key = keyTable.entry(keyId);
+    // 布局切换键不注入，按下时切换到下一个布局 (释放时 VK 码为 0，直接忽略)
+    if (key.type == KeyType::LayoutSwitch) {
+        recordInput(InputTrace::Kind::Press, keyId);
+        switchLayout(layoutSet.next(activeLayout));
+        return;
+    }
     // 忽略没有 VK Code 的键 (切换键除外，它们可能只更新视觉效果)
-    if (keyInfo.vkCode == 0 && keyInfo.type != KeyType::ModifierToggle) return;
+    if (key.vkCode == 0 && key.type != KeyType::ModifierToggle) return;
+    recordInput(InputTrace::Kind::Press, keyId);
+    // 可重复的键从按下 (输入事件) 的时刻开始计时；宏等吞掉按下的情况同样重复 (重复时再决定如何处理)
+    if (!inputReplaying) keyRepeater.press(keyId, handlerInputNs ? handlerInputNs : handlerEntryNs);
+    // 批量输入过程中按键会与剩余文本交错: 取消剩余的批次
+    if (bulkTyper.isRunning()) bulkTyper.cancel();
+    // 任何按键之后都不能再替换滑行输入的单词 (光标可能已不在它后面)
+    if (!swipeCommitted.isEmpty()) {
+        swipeCommitted.clear();
+        swipeAlternatives.clear();
+        scheduleSuggestionRefresh();
+    }
 
     // 调试输出：按下的键和当前键盘窗口是否是活动窗口 (应为 false)
-    qDebug() << "按下:" << keyInfo.text << "VK Code:" << Qt::hex << keyInfo.vkCode << Qt::dec << "| 键盘窗口活动:" << this->isActiveWindow();
+    VK_LOG_DEBUG("按下: {} VK {x} | 键盘窗口活动: {}", keyTable.info(keyId).text, key.vkCode, this->isActiveWindow());
+
+    // 宏: 等待绑定时普通键/特殊键成为绑定键；空闲时绑定键回放宏。两种情况下按键本身都不注入
+    if (key.type == KeyType::Normal || key.type == KeyType::Special) {
+        if (macroState == MacroState::AwaitingKey) {
+            bindMacro(keyId);
+            consumedKeys[keyId] = true;
+            return;
+        }
+        if (macroState == MacroState::Idle && macros.isBound(keyId)) {
+            playMacro(keyId);
+            consumedKeys[keyId] = true;
+            return;
+        }
+    }
+
+    // 拼音模式: 组字用的键不注入，释放时同样跳过
+    if (pinyinMode && handlePinyinKey(keyId)) {
+        consumedKeys[keyId] = true;
+        return;
+    }
+    // 自动纠错: 空格/回车先替换刚输入的单词 (在空格之前入队)；撤销纠正的退格不注入
+    if (autocorrectEnabled && handleAutocorrect(keyId)) {
+        consumedKeys[keyId] = true;
+        return;
+    }
 
     // 根据按键类型处理
-    switch (keyInfo.type) {
+    switch (key.type) {
         case KeyType::ModifierSticky: // 处理 Shift, Ctrl, Alt, Win 按下
         {
             // 检查该修饰键类型是否已处于活动状态
-            bool stateAlreadyActive = false;
-            if ((keyInfo.vkCode == VK_LSHIFT || keyInfo.vkCode == VK_RSHIFT) && shiftActive) stateAlreadyActive = true;
-            else if ((keyInfo.vkCode == VK_LCONTROL || keyInfo.vkCode == VK_RCONTROL) && ctrlActive) stateAlreadyActive = true;
-            else if ((keyInfo.vkCode == VK_LMENU || keyInfo.vkCode == VK_RMENU) && altActive) stateAlreadyActive = true;
-            else if ((keyInfo.vkCode == VK_LWIN || keyInfo.vkCode == VK_RWIN) && winActive) stateAlreadyActive = true;
-
+            bool* active = modifierFlag(key.modifier);
             // 如果尚未激活，则更新内部状态，模拟按键按下，并更新视觉效果
-            if (!stateAlreadyActive) {
-                if (keyInfo.vkCode == VK_LSHIFT || keyInfo.vkCode == VK_RSHIFT) shiftActive = true;
-                else if (keyInfo.vkCode == VK_LCONTROL || keyInfo.vkCode == VK_RCONTROL) ctrlActive = true;
-                else if (keyInfo.vkCode == VK_LMENU || keyInfo.vkCode == VK_RMENU) altActive = true;
-                else if (keyInfo.vkCode == VK_LWIN || keyInfo.vkCode == VK_RWIN) winActive = true;
-
+            if (active && !*active) {
+                *active = true;
                 // 模拟按键按下事件
-                simulateKey(keyInfo.vkCode, keyInfo.scanCode, true, keyInfo.isExtendedKey);
+                simulateKey(key.vkCode, key.scanCode, true, key.isExtended());
                 // 更新所有按键的视觉状态 (反映修饰键状态变化)
                 updateModifierKeysVisuals();
             }
@@ -355,13 +654,10 @@ void VirtualKeyboardWidget::onKeyPressed() {
         case KeyType::ModifierToggle: // 处理 Caps Lock, Num Lock, Scroll Lock 按下
         {
             // 切换内部状态
-            if (keyInfo.vkCode == VK_CAPITAL) capsLockActive = !capsLockActive;
-            else if (keyInfo.vkCode == VK_NUMLOCK) numLockActive = !numLockActive;
-            else if (keyInfo.vkCode == VK_SCROLL) scrollLockActive = !scrollLockActive;
+            if (bool* active = modifierFlag(key.modifier)) *active = !*active;
 
-            // 模拟一次快速的按下和释放以切换系统状态
-            simulateKey(keyInfo.vkCode, keyInfo.scanCode, true, keyInfo.isExtendedKey);
-            simulateKey(keyInfo.vkCode, keyInfo.scanCode, false, keyInfo.isExtendedKey);
+            // 模拟一次快速的按下和释放以切换系统状态 (同一批提交)
+            simulateKeyTap(key.vkCode, key.scanCode, key.isExtended());
 
             // 根据新的内部状态更新视觉效果
             // 注意: 如果视觉更新感觉滞后，可能需要在此处稍作延迟或依赖 OS 反馈
@@ -372,39 +668,49 @@ void VirtualKeyboardWidget::onKeyPressed() {
         case KeyType::Special: // 处理特殊功能键按下 (Enter, Backspace 等)
         {
             // 只模拟按键按下事件。释放事件将在 onKeyReleased 中处理。
-            simulateKey(keyInfo.vkCode, keyInfo.scanCode, true, keyInfo.isExtendedKey);
+            // 按键文本不能按 VK 码在主机布局上输入时 (例如美式主机上的俄语布局) 改用 Unicode 事件输入文本
+            injectedText[keyId] = unicodeTextFor(keyId);
+            if (!injectedText[keyId].isEmpty()) simulateUnicode(injectedText[keyId], true);
+            else simulateKey(key.vkCode, key.scanCode, true, key.isExtended());
+            injectedDown[keyId] = true;
             // 注意：在此“按下保持”模型中，按下普通/特殊键
             // *不会* 自动释放活动的粘滞修饰键。它们保持活动状态，
             // 直到其对应的按钮被释放。
             break;
         }
+        case KeyType::LayoutSwitch: // 已在上面处理
+            break;
     } // 结束 switch
+
+    // 按键事件已入队，再更新预测 (不增加按下到注入的延迟)
+    updatePrediction(keyId);
 }
 
-// --- onKeyReleased: 处理按钮释放事件 ---
-// 使用 SendInput 实现，采用“按下保持”的修饰键逻辑
-void VirtualKeyboardWidget::onKeyReleased() {
-    QPushButton *button = qobject_cast<QPushButton*>(sender());
-    if (!button) return;
-    QVariant variant = button->property("keyInfo");
-    if (!variant.isValid() || !variant.canConvert<KeyInfo>()) return;
-    KeyInfo keyInfo = variant.value<KeyInfo>();
+// --- onKeyReleased: 处理按键释放事件 ---
+// 通过注入后端实现，采用“按下保持”的修饰键逻辑
+void VirtualKeyboardWidget::onKeyReleased(int keyId) {
+    AllocStats::Scope allocScope(AllocOperation::Release);
+    beginKeyHandler();
+    keyRepeater.release(keyId);
+    const KeyEntry& key = keyTable.entry(keyId);
     // 忽略没有 VK Code 的键 (切换键已在按下时处理)
-    if (keyInfo.vkCode == 0) return;
-
+    if (key.vkCode == 0) return;
+    recordInput(InputTrace::Kind::Release, keyId);
+    // 按下时被组字或宏吞掉的键
+    if (consumedKeys.value(keyId)) {
+        consumedKeys[keyId] = false;
+        return;
+    }
 
-    qDebug() << "释放:" << keyInfo.text;
+    VK_LOG_DEBUG("释放: {}", keyTable.info(keyId).text);
 
-    switch (keyInfo.type) {
+    switch (key.type) {
         case KeyType::ModifierSticky: // 处理 Shift, Ctrl, Alt, Win 释放
             // 更新内部状态为非活动
-            if (keyInfo.vkCode == VK_LSHIFT || keyInfo.vkCode == VK_RSHIFT) shiftActive = false;
-            else if (keyInfo.vkCode == VK_LCONTROL || keyInfo.vkCode == VK_RCONTROL) ctrlActive = false;
-            else if (keyInfo.vkCode == VK_LMENU || keyInfo.vkCode == VK_RMENU) altActive = false;
-            else if (keyInfo.vkCode == VK_LWIN || keyInfo.vkCode == VK_RWIN) winActive = false;
+            if (bool* active = modifierFlag(key.modifier)) *active = false;
 
             // 模拟按键抬起事件
-            simulateKey(keyInfo.vkCode, keyInfo.scanCode, false, keyInfo.isExtendedKey);
+            simulateKey(key.vkCode, key.scanCode, false, key.isExtended());
             // 更新视觉效果
             updateModifierKeysVisuals();
             break;
@@ -412,215 +718,976 @@ void VirtualKeyboardWidget::onKeyReleased() {
             break;
         case KeyType::Normal: // 处理普通字符键释放
         case KeyType::Special: // 处理特殊功能键释放
-            // 模拟按键抬起事件
-            simulateKey(keyInfo.vkCode, keyInfo.scanCode, false, keyInfo.isExtendedKey);
+            // 模拟按键抬起事件 (按下时以 Unicode 输入的抬起同样的字符)
+            if (!injectedText[keyId].isEmpty()) simulateUnicode(std::exchange(injectedText[keyId], QString()), false);
+            else simulateKey(key.vkCode, key.scanCode, false, key.isExtended());
+            injectedDown[keyId] = false;
+            break;
+        case KeyType::LayoutSwitch: // 没有 VK 码，不会到达这里
             break;
     }
 }
 
 
-// --- updateModifierKeysVisuals: 更新所有按键的文本和样式 ---
+// --- onKeyRepeat: 自动重复 ---
+// 与硬件的 typematic 重复一致只发送按下事件，抬起在释放时发送一次；不再经过宏、纠错等按下处理
+void VirtualKeyboardWidget::onKeyRepeat(int keyId) {
+    AllocStats::Scope allocScope(AllocOperation::Repeat);
+    beginKeyHandler();
+    const KeyEntry& key = keyTable.entry(keyId);
+    recordInput(InputTrace::Kind::Repeat, keyId);
+    VK_LOG_TRACE("重复: {}", keyTable.info(keyId).text);
+    if (consumedKeys.value(keyId)) {
+        // 组字中的键继续交给拼音处理 (例如按住退格删除拼音)
+        if (pinyinMode && handlePinyinKey(keyId)) return;
+        // 按下被吞掉的键 (例如撤销纠正的退格) 从这次重复开始注入，释放时需要发送抬起
+        consumedKeys[keyId] = false;
+    }
+    autocorrectOriginal.clear(); // 重复之后不能再撤销纠正
+    autocorrectReplacement.clear();
+    if (injectedText[keyId].isEmpty()) injectedText[keyId] = unicodeTextFor(keyId);
+    if (!injectedText[keyId].isEmpty()) simulateUnicode(injectedText[keyId], true);
+    else simulateKey(key.vkCode, key.scanCode, true, key.isExtended());
+    injectedDown[keyId] = true;
+    updatePrediction(keyId);
+}
+
+// --- recordInput: 把处理函数的输入追加到输入轨迹 ---
+void VirtualKeyboardWidget::recordInput(InputTrace::Kind kind, int keyId) {
+    if (!inputTrace.isOpen() || inputReplaying) return;
+    inputTrace.record(kind, keyId, keyTable.entry(keyId), modifierStateBits(), handlerInputNs ? handlerInputNs : handlerEntryNs);
+}
+
+// --- replayInput: 回放一条输入轨迹记录 ---
+bool VirtualKeyboardWidget::replayInput(const InputTrace::Record& record) {
+    if (!inputReplaying) {
+        inputReplaying = true;
+        keyRepeater.cancel();
+    }
+    if (record.keyId >= keyTable.size()) return false;
+    const bool stateMatched = modifierStateBits() == record.modifiers;
+    switch (record.kind) {
+        case InputTrace::Kind::Press: onKeyPressed(record.keyId); break;
+        case InputTrace::Kind::Release: onKeyReleased(record.keyId); break;
+        case InputTrace::Kind::Repeat: onKeyRepeat(record.keyId); break;
+    }
+    return stateMatched;
+}
+
+// --- modifierStateBits: 把修饰键/切换键标志打包为 ModifierStateBit 组合 ---
+quint8 VirtualKeyboardWidget::modifierStateBits() const {
+    quint8 bits = 0;
+    if (shiftActive) bits |= ShiftBit;
+    if (ctrlActive) bits |= CtrlBit;
+    if (altActive) bits |= AltBit;
+    if (winActive) bits |= WinBit;
+    if (capsLockActive) bits |= CapsLockBit;
+    if (numLockActive) bits |= NumLockBit;
+    if (scrollLockActive) bits |= ScrollLockBit;
+    return bits;
+}
+
+// --- updateModifierKeysVisuals: 只更新受修饰键状态变化影响的按键 ---
+// 每个状态位在 keyTable 中都有一份依赖它的按键列表，
+// 例如 Shift 变化只会触及字母/符号键和两个 Shift 键。
 void VirtualKeyboardWidget::updateModifierKeysVisuals() {
-    // 计算有效的 Shift 状态 (Shift XOR CapsLock 对字母生效)
-    bool effectiveShift = shiftActive ^ capsLockActive;
+    AllocStats::Scope allocScope(AllocOperation::ModifierVisuals);
+    const quint8 stateBits = modifierStateBits();
+    // appliedStateBits < 0 表示尚未应用过任何状态，此时所有依赖位都视为已变化
+    const quint8 changedBits = appliedStateBits < 0 ? 0x7F : quint8(stateBits ^ appliedStateBits);
+    appliedStateBits = stateBits;
+    if (changedBits == 0) return;
+
+    // 用递增的代号去重 (字母键同时依赖 Shift 和 CapsLock)，避免每次分配集合
+    if (keyVisitStamp.size() != keyTable.size()) keyVisitStamp.fill(0, keyTable.size());
+    ++keyVisitGeneration;
+
+    int touched = 0;
+    for (int bit = 0; bit < MODIFIER_STATE_BIT_COUNT; ++bit) {
+        if (!(changedBits & (1u << bit))) continue;
+        for (int keyId : keyTable.dependents(bit)) {
+            if (keyVisitStamp[keyId] == keyVisitGeneration) continue;
+            keyVisitStamp[keyId] = keyVisitGeneration;
+            touched += applyKeyVisual(keyId, stateBits);
+        }
+    }
 
-    // 遍历所有按键按钮
-    for (QPushButton* button : keyButtons) {
-        QVariant variant = button->property("keyInfo");
-        if (!variant.isValid() || !variant.canConvert<KeyInfo>()) continue;
-        KeyInfo keyInfo = variant.value<KeyInfo>();
+    // --- 统计与跟踪 ---
+    visualStats.updates++;
+    visualStats.lastTouched = touched;
+    visualStats.totalTouched += touched;
+    // 运行时用 VK_LOG_LEVEL=trace 开启 (Release 构建中被编译掉)
+    VK_LOG_TRACE("修饰键视觉更新: 变化位 {x} 触及控件数 {}", changedBits, touched);
+}
 
+// --- applyKeyVisual: 把某个按键在给定状态下的文本和样式应用到它的控件上 ---
+// 返回实际改动的控件数
+int VirtualKeyboardWidget::applyKeyVisual(int keyId, quint8 stateBits) {
+    const QString& label = keyTable.label(keyId, stateBits);
+    const KeyVisualStyle style = keyTable.visualStyle(keyId, stateBits);
+
+    // 画布模式: 由画布只重绘发生变化的按键
+    if (keyboardCanvas) return keyboardCanvas->setKeyVisual(keyId, label, style) ? 1 : 0;
+
+    // QSS 对象名只构造一次，避免每次更新分配字符串
+    static const QString modifierActiveName = QStringLiteral("ModifierActive");
+    static const QString toggleActiveName = QStringLiteral("ToggleActive");
+    static const QString specialKeyName = QStringLiteral("SpecialKey");
+    static const QString spaceKeyName = QStringLiteral("SpaceKey");
+    static const QString defaultName;
+
+    const KeyEntry& key = keyTable.entry(keyId);
+    const QString* styleObjectName = &defaultName; // 对于 KeyType::Normal 使用默认 QPushButton 样式
+    switch (style) {
+        case KeyVisualStyle::ModifierActive: styleObjectName = &modifierActiveName; break;
+        case KeyVisualStyle::ToggleActive: styleObjectName = &toggleActiveName; break;
+        case KeyVisualStyle::Special: styleObjectName = &specialKeyName; break;
+        case KeyVisualStyle::Normal: if (key.vkCode == VK_SPACE) styleObjectName = &spaceKeyName; break;
+    }
+
+    int touched = 0;
+    for (QPushButton* button : keyButtonsById.value(keyId)) {
+        bool changed = false;
         // --- 更新按钮文本 (大小写/符号切换) ---
-        if (keyInfo.type == KeyType::Normal) { // 只处理普通键的文本更改
-            bool isLetter = (keyInfo.text.length() == 1 && keyInfo.text.at(0).isLetter());
-            // **重要修正：** 字母的大小写应该基于 shiftedText (小写) 和 text (大写)
-            // 而不是相反。这里假设 KeyInfo 定义中 text 是大写，shiftedText 是小写。
-            if (!keyInfo.shiftedText.isEmpty()) { // 如果定义了 shifted 文本
-                if (isLetter) {
-                    // 字母的大小写取决于 effectiveShift
-                    // 如果 effectiveShift 为 true (Shift按下或CapsLock激活但Shift未按下)，显示小写 (shiftedText)
-                    // 否则，显示大写 (text)
-                    button->setText(effectiveShift ? keyInfo.text : keyInfo.shiftedText); // 修正：假设 text 大写, shiftedText 小写
+        if (button->text() != label) {
+            button->setText(label);
+            changed = true;
+        }
+        // --- 切换键的选中状态 (它们是 checkable 的) ---
+        if (key.type == KeyType::ModifierToggle && button->isChecked() != (style == KeyVisualStyle::ToggleActive)) {
+            button->setChecked(style == KeyVisualStyle::ToggleActive);
+            changed = true;
+        }
+        // --- 对象名改变时只重新应用这一个按钮的样式 ---
+        if (button->objectName() != *styleObjectName) {
+            button->setObjectName(*styleObjectName);
+            button->style()->unpolish(button); // 移除旧样式效果
+            button->style()->polish(button);   // 应用基于对象名的新样式效果
+            changed = true;
+        }
+        if (changed) ++touched;
+    }
+    return touched;
+}
+
+// --- switchLayout: 切换到布局组中的另一个布局 ---
+// 所有布局的几何相同 (LayoutSet 保证)，按键 id 不变: 只交换隐式共享的布局数据和按键表，
+// 现有的按钮或画布按键原地换成新的文本，不创建、销毁或重新排布任何控件
+void VirtualKeyboardWidget::switchLayout(int index) {
+    if (index < 0 || index >= layoutSet.size() || index == activeLayout) return;
+    AllocStats::Scope allocScope(AllocOperation::LayoutSwitch);
+    const qint64 startNs = LatencyStats::now();
+    const LayoutSet::Layout& layout = layoutSet.layout(index);
+
+    // 仍按住的键按旧的 VK 码 (或旧文本的 Unicode 字符) 抬起 (否则释放时会抬起新布局中的另一个键，旧键卡在按下状态)，
+    // 其释放不再注入
+    for (int keyId = 0; keyId < keyTable.size(); ++keyId) {
+        const bool heldAsText = !injectedText[keyId].isEmpty();
+        if (!injectedDown[keyId] || (!heldAsText && layout.table.entry(keyId).vkCode == keyTable.entry(keyId).vkCode)) continue;
+        const KeyEntry& key = keyTable.entry(keyId);
+        if (heldAsText) simulateUnicode(std::exchange(injectedText[keyId], QString()), false);
+        else simulateKey(key.vkCode, key.scanCode, false, key.isExtended());
+        injectedDown[keyId] = false;
+        consumedKeys[keyId] = true;
+        keyRepeater.release(keyId);
+    }
+    // 正在组字的拼音按原样上屏；当前单词、纠错和滑行候选都以旧布局的字符为前提
+    if (pinyin.isComposing()) {
+        commitText(pinyin.composition());
+        pinyin.reset();
+    }
+    prediction.reset();
+    touchModel.reset();
+    swipeCommitted.clear();
+    swipeAlternatives.clear();
+    autocorrectOriginal.clear();
+    autocorrectReplacement.clear();
+    scheduleSuggestionRefresh();
+
+    activeLayout = index;
+    fullLayoutData = layout.full;
+    leftLayoutData = layout.left;
+    rightLayoutData = layout.right;
+    keyTable = layout.table;
+    // 重复策略按新布局的按键重新建立，绑定了宏的键仍不重复
+    keyRepeater.setPolicies(keyTable);
+    for (int keyId = 0; keyId < keyTable.size(); ++keyId) {
+        if (macros.isBound(keyId)) keyRepeater.setEnabled(keyId, false);
+    }
+
+    // 画布和触摸定位的字母随布局改变 (矩形不变)；再把新文本应用到每个按键上
+    if (keyboardCanvas) keyboardCanvas->rebindSections(layout.geometry(geometryMode).sections);
+    if (leftKeyboardWidget) leftKeyboardWidget->rebindTouchKeys(keyTable);
+    if (rightKeyboardWidget) rightKeyboardWidget->rebindTouchKeys(keyTable);
+    const quint8 stateBits = modifierStateBits();
+    int touched = 0;
+    for (int keyId = 0; keyId < keyTable.size(); ++keyId) touched += applyKeyVisual(keyId, stateBits);
+    appliedStateBits = stateBits;
+    // 滑行模板按新的字母位置重建 (只在字母改变时)
+    if (swipeWordsLoaded) QMetaObject::invokeMethod(this, &VirtualKeyboardWidget::prepareSwipeDecoder, Qt::QueuedConnection);
+
+    VK_LOG_DEBUG("切换布局: {} 触及控件数 {} 耗时 {} ns", layout.name, touched, LatencyStats::now() - startNs);
+}
+
+// --- setGeometryMode: 切换几何模式 ---
+// 排布在启动时已为每个布局的每个模式计算好 (LayoutSet)。按钮模式只把现有按钮重新放入网格并显示/隐藏，
+// 画布模式由缓存的区域重建画布按键 (值类型，不涉及控件)；之后按新模式的宽度重新定位窗口
+void VirtualKeyboardWidget::setGeometryMode(GeometryMode mode) {
+    const KeyboardGeometry& geometry = layoutSet.layout(activeLayout).geometry(mode);
+    if (mode == geometryMode || geometry.isEmpty()) return;
+    AllocStats::Scope allocScope(AllocOperation::GeometrySwitch);
+    const qint64 startNs = LatencyStats::now();
+
+    // 仍按住的键先释放: 新模式中可能没有这个键，或由另一个控件代表 (之后的释放事件不会再到达)
+    if (keyboardCanvas) {
+        for (int keyId = 0; keyId < keyTable.size(); ++keyId) {
+            if (keyboardCanvas->isKeyDown(keyId)) onKeyReleased(keyId);
+        }
+    } else {
+        leftKeyboardWidget->clearTouchKeys(); // 触摸按住的键在这里发出释放
+        rightKeyboardWidget->clearTouchKeys();
+        for (int keyId = 0; keyId < keyButtonsById.size(); ++keyId) {
+            for (QPushButton* button : std::as_const(keyButtonsById[keyId])) {
+                if (!button->isDown()) continue;
+                button->setDown(false);
+                onKeyReleased(keyId);
+            }
+        }
+    }
+
+    geometryMode = mode;
+    int touched = 0;
+    if (keyboardCanvas) {
+        // 画布按键由布局数据重建，文本和样式需要重新应用
+        keyboardCanvas->setSections(geometry.sections);
+        const quint8 stateBits = modifierStateBits();
+        for (int keyId = 0; keyId < keyTable.size(); ++keyId) touched += applyKeyVisual(keyId, stateBits);
+        appliedStateBits = stateBits;
+    } else {
+        arrangeButtons(geometry);
+    }
+    if (geometryButton) geometryButton->setText(geometryModeLabel(mode));
+    VK_LOG_DEBUG("切换几何模式: {} 区域数 {} 触及控件数 {} 耗时 {} ns", geometryModeName(mode), geometry.sections.size(),
+                 touched, LatencyStats::now() - startNs);
+
+    positionWindow();
+    // 滑行模板按新的字母位置重建 (窗口尺寸改变之后)
+    if (swipeWordsLoaded) QMetaObject::invokeMethod(this, &VirtualKeyboardWidget::prepareSwipeDecoder, Qt::QueuedConnection);
+}
+
+// --- cycleGeometryMode: 切换到下一个可用的几何模式 (跳过当前布局中没有按键的模式) ---
+void VirtualKeyboardWidget::cycleGeometryMode() {
+    const LayoutSet::Layout& layout = layoutSet.layout(activeLayout);
+    for (int step = 1; step < GEOMETRY_MODE_COUNT; ++step) {
+        const GeometryMode mode = GeometryMode((int(geometryMode) + step) % GEOMETRY_MODE_COUNT);
+        if (layout.geometry(mode).isEmpty()) continue;
+        setGeometryMode(mode);
+        return;
+    }
+}
+
+// --- simulateKey: 把按键事件交给注入线程 ---
+// UI 线程只负责入队，后端调用 (SendInput/XTest) 及其日志在 KeyInjector 的工作线程中按顺序执行
+void VirtualKeyboardWidget::simulateKey(int vkCode, int scanCode, bool press, bool isExtended) {
+    // 忽略无效的 VK Code
+    if (vkCode == 0) return;
+    KeyEvent event = KeyEvent::key(vkCode, scanCode, press, isExtended);
+    event.inputTimeNs = handlerInputNs;
+    keyInjector.post(event);
+    if (macroState == MacroState::Recording) macros.record(event, modifierStateBits());
+    const qint64 enqueuedNs = LatencyStats::now();
+    keyInjector.latency().record(LatencyStage::HandlerToEnqueue, enqueuedNs - handlerEntryNs);
+    if (press && handlerInputIsTouch) keyInjector.latency().record(LatencyStage::TouchToKeyDown, enqueuedNs - handlerInputNs);
+}
+
+// --- simulateKeyTap: 按下+释放作为一批事件入队 ---
+void VirtualKeyboardWidget::simulateKeyTap(int vkCode, int scanCode, bool isExtended) {
+    if (vkCode == 0) return;
+    KeyEvent tap[2] = {
+        KeyEvent::key(vkCode, scanCode, true, isExtended),
+        KeyEvent::key(vkCode, scanCode, false, isExtended)
+    };
+    tap[0].inputTimeNs = tap[1].inputTimeNs = handlerInputNs;
+    keyInjector.postBatch(tap, 2);
+    if (macroState == MacroState::Recording) {
+        macros.record(tap[0], modifierStateBits());
+        macros.record(tap[1], modifierStateBits());
+    }
+    const qint64 enqueuedNs = LatencyStats::now();
+    keyInjector.latency().record(LatencyStage::HandlerToEnqueue, enqueuedNs - handlerEntryNs);
+    if (handlerInputIsTouch) keyInjector.latency().record(LatencyStage::TouchToKeyDown, enqueuedNs - handlerInputNs);
+}
+
+// --- simulateUnicode: 以 Unicode 事件按下或抬起文本 (一批提交) ---
+void VirtualKeyboardWidget::simulateUnicode(const QString& text, bool press) {
+    QVarLengthArray<KeyEvent, 4> events;
+    for (QChar unit : text) {
+        KeyEvent event = KeyEvent::unicode(unit.unicode(), press);
+        event.inputTimeNs = handlerInputNs;
+        events.append(event);
+        if (macroState == MacroState::Recording) macros.record(event, modifierStateBits());
+    }
+    keyInjector.postBatch(events.constData(), events.size());
+    const qint64 enqueuedNs = LatencyStats::now();
+    keyInjector.latency().record(LatencyStage::HandlerToEnqueue, enqueuedNs - handlerEntryNs);
+    if (press && handlerInputIsTouch) keyInjector.latency().record(LatencyStage::TouchToKeyDown, enqueuedNs - handlerInputNs);
+}
+
+// --- syncHostKeyText: 比较普通键的文本和它的 VK 码在主机布局上产生的字符 ---
+// 只在切换布局或主机布局改变后重新计算。主机布局只读取 KeyInjector 的缓存 (注入线程在批次之后和空闲时刷新)，
+// 按键路径上不调用系统接口；小键盘的键受 NumLock 影响，总按 VK 码注入
+void VirtualKeyboardWidget::syncHostKeyText() const {
+    const InjectionBackend* backend = keyInjector.backend();
+    if (!backend) return;
+    const quintptr hostLayout = keyInjector.hostLayout();
+    if (hostTextLayout == activeLayout && hostLayout == hostLayoutId && hostTextMismatch.size() == keyTable.size()) return;
+    hostTextLayout = activeLayout;
+    hostLayoutId = hostLayout;
+    hostTextMismatch.fill(0, keyTable.size());
+    int mismatched = 0;
+    for (int keyId = 0; keyId < keyTable.size(); ++keyId) {
+        const KeyInfo& info = keyTable.info(keyId);
+        if (info.type != KeyType::Normal || info.vkCode == 0 || isNumpadKey(info)) continue;
+        // 字母键: 位 0 为小写 (shiftedText)，位 1 为大写 (text)；其他键: 位 0 为 text，位 1 为 shiftedText (有 Shift 文本时)
+        const bool letter = keyTable.entry(keyId).flags & KeyEntry::LetterKey;
+        const QString& plain = letter ? info.shiftedText : info.text;
+        const QString& shifted = letter ? info.text : info.shiftedText;
+        quint8 bits = 0;
+        if (!plain.isEmpty() && backend->keyText(hostLayout, info.vkCode, false) != plain) bits |= 0x01;
+        if (!shifted.isEmpty() && backend->keyText(hostLayout, info.vkCode, true) != shifted) bits |= 0x02;
+        hostTextMismatch[keyId] = bits;
+        if (bits) ++mismatched;
+    }
+    VK_LOG_DEBUG("主机布局 {x}: {} 个按键的文本改用 Unicode 输入", quint64(hostLayout), mismatched);
+}
+
+// --- unicodeTextFor: 普通键在当前状态下需要以 Unicode 输入的文本 ---
+// Ctrl/Alt/Win 按住时总按 VK 码注入 (快捷键按物理键匹配，例如俄语布局下的 Ctrl+C)
+QString VirtualKeyboardWidget::unicodeTextFor(int keyId) const {
+    const KeyEntry& key = keyTable.entry(keyId);
+    if (key.type != KeyType::Normal || ctrlActive || altActive || winActive) return QString();
+    syncHostKeyText();
+    const quint8 bits = hostTextMismatch.value(keyId);
+    if (!bits) return QString();
+    const bool upper = (key.flags & KeyEntry::LetterKey) ? (shiftActive != capsLockActive) : shiftActive;
+    if (!(bits & (upper ? 0x02 : 0x01))) return QString();
+    return keyTable.label(keyId, modifierStateBits());
+}
+
+// --- eventFilter: 记录按键控件收到输入事件的时间 ---
+// 按下/释放处理函数在输入事件分发过程中同步执行，因此可以把这个时间关联到处理函数；
+// 分发结束后排队清零，使自动重复等非输入触发的调用不会使用过期的时间
+bool VirtualKeyboardWidget::eventFilter(QObject *watched, QEvent *event) {
+    switch (event->type()) {
+        case QEvent::MouseButtonPress:
+        case QEvent::MouseButtonRelease:
+        case QEvent::MouseButtonDblClick:
+        case QEvent::MouseMove:
+        case QEvent::TouchBegin:
+        case QEvent::TouchUpdate:
+        case QEvent::TouchEnd:
+            if (dispatchingInputNs == 0) {
+                QMetaObject::invokeMethod(this, [this]() { dispatchingInputNs = 0; dispatchingTouch = false; }, Qt::QueuedConnection);
+            }
+            dispatchingInputNs = LatencyStats::now();
+            dispatchingTouch = event->type() == QEvent::TouchBegin || event->type() == QEvent::TouchUpdate || event->type() == QEvent::TouchEnd;
+            break;
+        default:
+            break;
+    }
+    return QWidget::eventFilter(watched, event);
+}
+
+// --- beginKeyHandler: 记录处理函数入口时间，并关联正在分发的输入事件 ---
+void VirtualKeyboardWidget::beginKeyHandler() {
+    handlerEntryNs = LatencyStats::now();
+    handlerInputNs = dispatchingInputNs; // 0 表示不是由输入事件直接触发 (例如自动重复)
+    handlerInputIsTouch = handlerInputNs != 0 && dispatchingTouch;
+    if (handlerInputNs) keyInjector.latency().record(LatencyStage::InputToHandler, handlerEntryNs - handlerInputNs);
+}
+
+// --- updatePrediction: 把按下的键交给预测引擎 ---
+// 普通键按当前 Shift/CapsLock 状态取得字符；退格回退一个字符；空格/回车/Tab 结束单词；
+// 其他会移动光标或触发快捷键的键使当前单词失效。概率触摸定位的上下文按同样的规则更新
+void VirtualKeyboardWidget::updatePrediction(int keyId) {
+    if (!prediction.isLoaded() || pinyinMode) return;
+    const KeyEntry& key = keyTable.entry(keyId);
+    switch (key.type) {
+        case KeyType::Normal:
+            if (ctrlActive || altActive || winActive) {
+                prediction.reset();
+                touchModel.reset();
+            } else {
+                const QString& text = keyTable.label(keyId, modifierStateBits());
+                if (text.size() == 1) {
+                    prediction.appendChar(text.at(0));
+                    touchModel.appendChar(text.at(0));
                 } else {
-                    // 数字/符号仅取决于物理 Shift 键状态
-                    button->setText(shiftActive ? keyInfo.shiftedText : keyInfo.text); // 修正：假设 text 非 Shift, shiftedText 是 Shift
+                    prediction.commitWord();
+                    touchModel.appendChar(QLatin1Char(' '));
                 }
             }
-            // 如果没有 shiftedText，则文本保持不变 (例如 `\`)
-        }
+            break;
+        case KeyType::Special:
+            if (key.vkCode == VK_BACK) {
+                prediction.backspace();
+                touchModel.backspace();
+            } else if (key.vkCode == VK_SPACE || key.vkCode == VK_RETURN || key.vkCode == VK_TAB) {
+                prediction.commitWord();
+                touchModel.appendChar(QLatin1Char(' '));
+            } else {
+                prediction.reset();
+                touchModel.reset();
+            }
+            break;
+        default: // 修饰键和切换键不影响当前单词
+            return;
+    }
 
+    scheduleSuggestionRefresh();
+}
 
-        // --- 更新按钮视觉样式和选中状态 ---
-        bool isActive = false; // 标记当前按键是否处于视觉“激活”状态
-        QString styleObjectName = ""; // 默认对象名 (无特殊样式)
+// --- scheduleSuggestionRefresh: 安排刷新建议栏 ---
+// 同一轮事件循环中的多次按键 (例如自动重复) 只刷新一次
+void VirtualKeyboardWidget::scheduleSuggestionRefresh() {
+    if (suggestionRefreshPending) return;
+    suggestionRefreshPending = true;
+    QMetaObject::invokeMethod(this, &VirtualKeyboardWidget::refreshSuggestions, Qt::QueuedConnection);
+}
 
-        if (keyInfo.type == KeyType::ModifierSticky) { // Shift, Ctrl, Alt, Win
-            // 根据内部标志判断是否激活
-            if ((keyInfo.vkCode == VK_LSHIFT || keyInfo.vkCode == VK_RSHIFT) && shiftActive) isActive = true;
-            else if ((keyInfo.vkCode == VK_LCONTROL || keyInfo.vkCode == VK_RCONTROL) && ctrlActive) isActive = true;
-            else if ((keyInfo.vkCode == VK_LMENU || keyInfo.vkCode == VK_RMENU) && altActive) isActive = true;
-            else if ((keyInfo.vkCode == VK_LWIN || keyInfo.vkCode == VK_RWIN) && winActive) isActive = true;
-            // 根据激活状态设置 QSS 对象名
-            styleObjectName = isActive ? "ModifierActive" : "SpecialKey"; // 使用 SpecialKey 作为修饰键的基础样式
-            // 粘滞修饰键在 UI 意义上不是 checkable 的
-            button->setCheckable(false);
-            button->setChecked(false); // 确保它们不处于视觉选中状态
+// --- refreshSuggestions: 查询建议并更新建议栏 ---
+void VirtualKeyboardWidget::refreshSuggestions() {
+    suggestionRefreshPending = false;
+    if (!suggestionBar) return;
+    if (pinyinMode) {
+        suggestionBar->setPreedit(pinyin.composition());
+        suggestionBar->setSuggestions(pinyin.candidates());
+        VK_LOG_TRACE("拼音: 缓冲区 {} 更新耗时 {} ns", pinyin.composition(), pinyin.lastUpdateNs());
+        return;
+    }
+    suggestionBar->setPreedit(QString());
+    if (!swipeCommitted.isEmpty()) {
+        suggestionBar->setSuggestions(swipeAlternatives);
+        return;
+    }
+    suggestionBar->setSuggestions(prediction.suggestions());
+    VK_LOG_TRACE("单词预测: 前缀 {} 耗时 {} ns", prediction.prefix(), prediction.lastQueryNs());
+}
 
-        } else if (keyInfo.type == KeyType::ModifierToggle) { // Caps Lock 等
-            // 根据内部标志判断是否激活
-            if (keyInfo.vkCode == VK_CAPITAL) isActive = capsLockActive;
-            else if (keyInfo.vkCode == VK_NUMLOCK) isActive = numLockActive;
-            else if (keyInfo.vkCode == VK_SCROLL) isActive = scrollLockActive;
-            // 设置按钮的选中状态 (因为它们是 checkable 的)
-            button->setChecked(isActive);
-            // 根据激活状态设置 QSS 对象名
-            styleObjectName = isActive ? "ToggleActive" : "SpecialKey"; // 使用 SpecialKey 作为切换键的基础样式
+// --- onSuggestionChosen: 输入所选单词的剩余部分和一个空格 (拼音模式下提交所选候选) ---
+void VirtualKeyboardWidget::onSuggestionChosen(int index) {
+    if (pinyinMode) {
+        if (pinyin.isComposing()) commitPinyinCandidate(index);
+        refreshSuggestions();
+        return;
+    }
+    if (!swipeCommitted.isEmpty()) {
+        // 滑行的其他候选: 退格删除刚输入的单词后输入所选单词，被替换的单词留在原来的位置上
+        if (index < 0 || index >= swipeAlternatives.size()) return;
+        const QString replacement = swipeAlternatives.at(index) + QLatin1Char(' ');
+        QVector<KeyEvent> events;
+        events.reserve((swipeCommitted.size() + replacement.size()) * 4);
+        appendBackspaces(swipeCommitted.size(), events);
+        appendTextEvents(replacement, events);
+        keyInjector.postBatch(events.constData(), events.size());
+        swipeAlternatives[index] = swipeCommitted.chopped(1);
+        swipeCommitted = replacement;
+        refreshSuggestions();
+        return;
+    }
+    const QStringList& words = prediction.suggestions();
+    if (index < 0 || index >= words.size()) return;
+    const QString remainder = words.at(index).mid(prediction.prefix().size()) + QLatin1Char(' ');
 
-        } else if (keyInfo.vkCode == VK_SPACE) { // 空格键
-            styleObjectName = "SpaceKey";
-        } else if (keyInfo.type == KeyType::Special) { // 其他特殊键
-            styleObjectName = "SpecialKey";
-        }
-        // 对于 KeyType::Normal，styleObjectName 保持为 "" (使用默认 QPushButton 样式)
+    commitText(remainder);
 
+    prediction.commitWord();
+    touchModel.appendChar(QLatin1Char(' '));
+    refreshSuggestions();
+}
 
-        // 如果对象名需要改变，则更新并重新应用样式
-        if (button->objectName() != styleObjectName) {
-            button->setObjectName(styleObjectName);
-            style()->unpolish(button); // 移除旧样式效果
-            style()->polish(button);   // 应用基于对象名的新样式效果
+// --- handleAutocorrect: 空格/回车之前纠正刚输入的单词；紧接着的退格撤销纠正 ---
+// 任何其他按键之后都不能再撤销 (光标可能已经移动)。撤销时删除纠正后的单词和空格/换行，恢复原来的单词，
+// 该单词之后不再被纠正
+bool VirtualKeyboardWidget::handleAutocorrect(int keyId) {
+    const KeyEntry& key = keyTable.entry(keyId);
+    if (key.type != KeyType::Normal && key.type != KeyType::Special) return false; // 修饰键不影响撤销
+    const QString original = std::exchange(autocorrectOriginal, QString());
+    const QString replacement = std::exchange(autocorrectReplacement, QString());
+    if (pinyinMode || ctrlActive || altActive || winActive) return false;
+
+    if (key.vkCode == VK_BACK && !original.isEmpty()) {
+        QVector<KeyEvent> events;
+        events.reserve((replacement.size() + 1 + original.size()) * 4);
+        appendBackspaces(replacement.size() + 1, events);
+        appendTextEvents(original, events);
+        keyInjector.postBatch(events.constData(), events.size());
+        autocorrectRejected = original.toLower();
+        VK_LOG_DEBUG("撤销纠正: {} -> {}", replacement, original);
+        // 光标回到原来的单词之后: 重新建立预测前缀和触摸定位上下文
+        prediction.reset();
+        touchModel.reset();
+        touchModel.appendChar(QLatin1Char(' '));
+        for (QChar ch : original) {
+            prediction.appendChar(ch);
+            touchModel.appendChar(ch);
         }
+        scheduleSuggestionRefresh();
+        return true;
     }
+    if (key.vkCode == VK_SPACE || key.vkCode == VK_RETURN) autocorrectWord();
+    return false;
 }
 
-// --- simulateKey: 使用 SendInput 模拟按键事件 ---
-void VirtualKeyboardWidget::simulateKey(int vkCode, int scanCode, bool press, bool isExtended) {
-#ifdef _WIN32 // 只在 Windows 下有效
-    // 忽略无效的 VK Code (除非是无输入操作，但我们之前已过滤)
-    if (vkCode == 0) return;
+// --- autocorrectWord: 查询纠错索引，替换可能拼错的当前单词 ---
+// 只纠正全部由字母组成、至少 AUTOCORRECT_MIN_LENGTH 个字母的单词；短单词只允许编辑距离 1。
+// 大小写跟随输入: 全部大写 (至少两个字母) 时整词大写，首字母大写时纠正结果首字母大写
+void VirtualKeyboardWidget::autocorrectWord() {
+    if (!spell) return;
+    const QString typed = prediction.prefix();
+    if (typed.size() < AUTOCORRECT_MIN_LENGTH) return;
+    for (QChar ch : typed) {
+        if (!ch.isLetter()) return;
+    }
+    const QString lowered = typed.toLower();
+    if (lowered == autocorrectRejected) return;
+
+    SpellIndex::Suggestion suggestion;
+    const qint64 startNs = LatencyStats::now();
+    const bool found = spell->lookup(lowered, typed.size() <= AUTOCORRECT_SHORT_WORD ? 1 : SpellIndex::MAX_DISTANCE, suggestion);
+    VK_LOG_TRACE("纠错: {} -> {} (距离 {}) 耗时 {} ns", typed, found ? suggestion.word : QString(), suggestion.distance,
+                 LatencyStats::now() - startNs);
+    if (!found || suggestion.distance == 0) return;
+
+    QString replacement = suggestion.word;
+    if (typed.size() >= 2 && typed == typed.toUpper()) replacement = replacement.toUpper();
+    else if (typed.at(0).isUpper()) replacement[0] = replacement.at(0).toUpper();
+
+    QVector<KeyEvent> events;
+    events.reserve((typed.size() + replacement.size()) * 4);
+    appendBackspaces(typed.size(), events);
+    appendTextEvents(replacement, events);
+    keyInjector.postBatch(events.constData(), events.size());
+    autocorrectOriginal = typed;
+    autocorrectReplacement = replacement;
+    VK_LOG_DEBUG("自动纠正: {} -> {}", typed, replacement);
+}
 
-    INPUT input = { 0 }; // 初始化 INPUT 结构体
-    input.type = INPUT_KEYBOARD; // 指定为键盘输入
+// --- prepareAutocorrect: 映射纠错索引 (词典修改后或第一次使用时先编译) ---
+void VirtualKeyboardWidget::prepareAutocorrect(const QString& dictionaryPath) {
+    if (spell || !prediction.isLoaded()) return;
+    const qint64 startNs = LatencyStats::now();
+    QString spellError;
+    spell = SpellIndex::open(dictionaryPath, *prediction.dictionary(), &spellError);
+    if (!spell) {
+        qWarning() << "无法打开纠错索引，不启用自动纠错:" << spellError;
+        autocorrectEnabled = false;
+        return;
+    }
+    qDebug() << "纠错索引:" << spell->wordCount() << "个单词," << spell->entryCount() << "个删除串,"
+             << (spell->compiledOnOpen() ? "编译" : "映射") << "耗时" << (LatencyStats::now() - startNs) / 1000000 << "ms";
+}
 
-    // 决定是使用扫描码还是虚拟键码
-    // 使用 VK 码通常在不同键盘布局下更可靠
-    // 除非需要特定扫描码 (例如，区分数字小键盘 Enter)。
-    bool useScanCode = false; // 默认为 VK 码
-    // if (scanCode != 0) useScanCode = true; // 如果扫描码可用且首选，则可选择启用
+// --- handlePinyinKey: 拼音模式下的按键处理 ---
+// 组字时: 字母和 ' 进入缓冲区，数字键选择候选，空格提交第一个候选，回车提交拼音本身，
+// 退格删除一个字母，Esc 取消组字；其他键先提交第一个候选再照常注入。
+// 没有组字时只有小写字母 (没有 Ctrl/Alt/Win) 开始组字，其余键照常注入。
+bool VirtualKeyboardWidget::handlePinyinKey(int keyId) {
+    const KeyEntry& key = keyTable.entry(keyId);
+    if (key.type != KeyType::Normal && key.type != KeyType::Special) return false; // 修饰键和切换键照常处理
+    const bool composing = pinyin.isComposing();
+    bool consumed = false;
+
+    if (ctrlActive || altActive || winActive) {
+        if (composing) commitPinyinCandidate(0);
+    } else if (key.type == KeyType::Normal) {
+        const QString& text = keyTable.label(keyId, modifierStateBits());
+        const QChar ch = text.size() == 1 ? text.at(0) : QChar();
+        if (pinyin.appendChar(ch)) {
+            consumed = true;
+        } else if (composing && ch >= QLatin1Char('1') && ch <= QLatin1Char('0' + PinyinEngine::MAX_CANDIDATES)) {
+            commitPinyinCandidate(ch.unicode() - '1');
+            consumed = true;
+        } else if (composing) {
+            commitPinyinCandidate(0); // 标点等: 先上屏再输入
+        }
+    } else if (composing) {
+        consumed = true;
+        switch (key.vkCode) {
+            case VK_BACK: pinyin.backspace(); break;
+            case VK_SPACE: commitPinyinCandidate(0); break;
+            case VK_RETURN: commitText(pinyin.composition()); pinyin.reset(); break;
+            case VK_ESCAPE: pinyin.reset(); break;
+            default:
+                commitPinyinCandidate(0);
+                consumed = false;
+                break;
+        }
+    }
+    if (composing || consumed) scheduleSuggestionRefresh();
+    return consumed;
+}
 
-    if (useScanCode && scanCode != 0) {
-        input.ki.wScan = static_cast<WORD>(scanCode); // 设置扫描码
-        input.ki.dwFlags = KEYEVENTF_SCANCODE;       // 标志：使用扫描码
-    } else {
-        input.ki.wVk = static_cast<WORD>(vkCode);     // 设置虚拟键码
-        input.ki.dwFlags = 0;                         // 标志：使用虚拟键码 (默认)
+// --- commitPinyinCandidate: 提交候选 (剩余的拼音继续组字) ---
+void VirtualKeyboardWidget::commitPinyinCandidate(int index) {
+    QString text = pinyin.choose(index);
+    if (text.isEmpty()) {
+        if (index != 0) return; // 不存在的候选: 忽略
+        // 没有任何候选 (例如拼音不在词库中): 提交拼音本身
+        text = pinyin.composition();
+        pinyin.reset();
+    }
+    commitText(text);
+}
+
+// --- togglePinyinMode: 切换拼音/英文 (正在组字的拼音原样提交) ---
+void VirtualKeyboardWidget::togglePinyinMode() {
+    if (!pinyin.isLoaded()) return;
+    if (pinyin.isComposing()) {
+        commitText(pinyin.composition());
+        pinyin.reset();
     }
+    pinyinMode = !pinyinMode;
+    prediction.reset();
+    touchModel.reset();
+    swipeCommitted.clear();
+    swipeAlternatives.clear();
+    if (suggestionBar) suggestionBar->setModeLabel(pinyinMode ? QStringLiteral("中") : QStringLiteral("英"));
+    refreshSuggestions();
+}
 
-    // 如果是释放事件，添加 KEYEVENTF_KEYUP 标志
-    if (!press) {
-        input.ki.dwFlags |= KEYEVENTF_KEYUP;
+// --- prepareSwipeDecoder: 用画布上字母键的中心和预测词典准备滑行模板 ---
+// 第一次调用时从词典取出全部单词；之后只在按键几何明显变化 (例如窗口宽高比改变) 时重建模板
+void VirtualKeyboardWidget::prepareSwipeDecoder() {
+    if (!keyboardCanvas || !prediction.isLoaded()) return;
+    QVector<SwipeDecoder::Key> keys;
+    qreal keyWidth = 0;
+    for (int keyId = 0; keyId < keyTable.size(); ++keyId) {
+        const QChar letter = keyTable.touchLetter(keyId);
+        if (letter.isNull()) continue;
+        const QRectF rect = keyboardCanvas->keyRect(keyId);
+        if (rect.isEmpty()) continue;
+        keys.append({letter, rect.center()});
+        if (keyWidth == 0) keyWidth = rect.width();
+    }
+    swipe.setKeys(keys, keyWidth);
+
+    if (!swipeWordsLoaded) {
+        swipeWordsLoaded = true;
+        const WordTrie* trie = prediction.dictionary();
+        QVector<WordTrie::Completion> completions;
+        trie->complete(WordTrie::ROOT, QStringView(), int(trie->wordCount()), completions);
+        QVector<SwipeDecoder::Word> words;
+        words.reserve(completions.size());
+        for (const WordTrie::Completion& completion : std::as_const(completions)) {
+            words.append({completion.word, completion.score});
+        }
+        swipe.setWords(std::move(words));
     }
+    if (swipe.isReady()) return;
+
+    const qint64 startNs = LatencyStats::now();
+    swipe.build();
+    qDebug() << "滑行模板:" << swipe.templateCount() << "个单词，构建耗时" << (LatencyStats::now() - startNs) / 1000000 << "ms";
+}
 
-    // 如果是扩展键，添加 KEYEVENTF_EXTENDEDKEY 标志
-    // 这对于像右 Ctrl、右 Alt、方向键、数字小键盘 Enter 等键至关重要。
-    if (isExtended) {
-        input.ki.dwFlags |= KEYEVENTF_EXTENDEDKEY;
+// --- prepareTouchModel: 用预测词典的全部单词训练概率触摸定位的字符语言模型 ---
+void VirtualKeyboardWidget::prepareTouchModel() {
+    if (!prediction.isLoaded() || touchModel.isTrained()) return;
+    const qint64 startNs = LatencyStats::now();
+    const WordTrie* trie = prediction.dictionary();
+    QVector<WordTrie::Completion> completions;
+    trie->complete(WordTrie::ROOT, QStringView(), int(trie->wordCount()), completions);
+    QVector<TouchLanguageModel::Word> words;
+    words.reserve(completions.size());
+    for (const WordTrie::Completion& completion : std::as_const(completions)) {
+        words.append({completion.word, completion.score});
     }
+    touchModel.train(words);
+    qDebug() << "触摸定位语言模型:" << words.size() << "个单词，训练耗时" << (LatencyStats::now() - startNs) / 1000000 << "ms";
+}
 
-    // 调用包装函数发送输入事件
-    sendInputWrapper(input, vkCode, press); // 传递 vkCode/press 用于日志记录
-#else
-    // 在非 Windows 平台提供警告
-    Q_UNUSED(vkCode); Q_UNUSED(scanCode); Q_UNUSED(press); Q_UNUSED(isExtended); // 抑制未使用变量警告
-    qWarning("键盘模拟功能仅在 Windows 平台可用。");
-#endif
+// --- onGestureFinished: 输入最可能的单词和一个空格，其他候选显示在建议栏中 ---
+void VirtualKeyboardWidget::onGestureFinished(const QVector<QPointF>& path) {
+    if (pinyinMode) return; // 拼音模式下不解码滑行
+    prepareSwipeDecoder();
+    QVector<SwipeDecoder::Candidate> candidates;
+    const qint64 startNs = LatencyStats::now();
+    swipe.decode(path, PredictionEngine::MAX_SUGGESTIONS + 1, candidates);
+    VK_LOG_DEBUG("滑行: {} 个点, {} 个候选, 解码耗时 {} ns", path.size(), candidates.size(), LatencyStats::now() - startNs);
+    if (candidates.isEmpty()) return;
+
+    // 大小写锁定时整词大写 (Shift 是按住生效的，滑行时无法同时按住)
+    const auto cased = [this](const QString& word) { return capsLockActive ? word.toUpper() : word; };
+    swipeCommitted = cased(candidates.first().word) + QLatin1Char(' ');
+    swipeAlternatives.clear();
+    for (int i = 1; i < candidates.size(); ++i) swipeAlternatives.append(cased(candidates[i].word));
+    commitText(swipeCommitted);
+    prediction.commitWord();
+    touchModel.appendChar(QLatin1Char(' '));
+    scheduleSuggestionRefresh();
 }
 
-// --- sendInputWrapper: SendInput API 的包装，带日志 ---
-void VirtualKeyboardWidget::sendInputWrapper(INPUT input, int vkCodeForLog, bool pressForLog) {
-#ifdef _WIN32 // 只在 Windows 下有效
-    // --- 获取并记录前台窗口信息以供调试 ---
-    HWND fgWin = GetForegroundWindow(); // 获取当前接收输入的窗口句柄
-    QString windowTitle = "N/A";
-    DWORD processId = 0;
-    if (fgWin) {
-        wchar_t titleBuffer[256];
-        // 获取窗口标题
-        if (GetWindowTextW(fgWin, titleBuffer, 256) > 0) {
-            windowTitle = QString::fromWCharArray(titleBuffer);
-        } else {
-            windowTitle = "<无标题>";
+// --- commitText: 文本作为一批事件入队，后端一次提交，不会与其他按键交错 ---
+void VirtualKeyboardWidget::commitText(const QString& text) {
+    if (text.isEmpty()) return;
+    QVector<KeyEvent> events;
+    events.reserve(text.size() * 4);
+    appendTextEvents(text, events);
+    keyInjector.postBatch(events.constData(), events.size());
+}
+
+// --- appendBackspaces: 退格的按下 + 释放 ---
+void VirtualKeyboardWidget::appendBackspaces(int count, QVector<KeyEvent>& events) {
+    const quint16 backspaceScanCode = 0x0E;
+    for (int i = 0; i < count; ++i) {
+        events.append(KeyEvent::key(VK_BACK, backspaceScanCode, true, false));
+        events.append(KeyEvent::key(VK_BACK, backspaceScanCode, false, false));
+    }
+}
+
+// --- appendTextEvents: 文本 -> 按键事件 ---
+// Shift 只在需要的状态改变时按下或松开: 连续的大写字母和符号共用一次 Shift，
+// 每批结束 (以及 Unicode 字符之前) 都把 Shift 恢复为当前 (粘滞) 状态，各批之间不会留下按住的 Shift；
+// 布局中没有的字符 (如汉字)，以及 VK 码在主机布局上不产生该字符的键上的字符，逐个 UTF-16 代码单元用 Unicode 事件输入。"\r\n" 按一个回车输入
+void VirtualKeyboardWidget::appendTextEvents(const QString& text, QVector<KeyEvent>& events,
+                                             int maxBatchEvents, QVector<BulkTyper::Batch>* batches) const {
+    const quint16 shiftScanCode = 0x2A; // 左 Shift 的扫描码
+    bool shiftDown = shiftActive;       // 已生成的事件结束时 Shift 的状态
+    int batchStart = events.size();
+    int characters = 0;
+    const auto restoreShift = [&]() {
+        if (shiftDown == shiftActive) return;
+        events.append(KeyEvent::key(VK_LSHIFT, shiftScanCode, shiftActive, false));
+        shiftDown = shiftActive;
+    };
+    const auto closeBatch = [&]() {
+        restoreShift();
+        if (batches && events.size() > batchStart) {
+            batches->append({ int(events.size()), characters });
+            batchStart = events.size();
         }
-        // 获取窗口所属进程 ID
-        GetWindowThreadProcessId(fgWin, &processId);
-    } else {
-        windowTitle = "<无前台窗口>";
-    }
-    // 记录尝试：正在向哪个窗口发送什么按键事件？
-    qDebug() << "  尝试 SendInput:" << (pressForLog ? "按下" : "释放")
-             << "VK:" << Qt::hex << vkCodeForLog << Qt::dec
-             << "标志:" << Qt::hex << input.ki.dwFlags << Qt::dec
-             << "-> 目标窗口:" << windowTitle << "(PID:" << processId << ")";
-    // --- 结束前台窗口日志记录 ---
-
-    // 调用 SendInput 函数
-    UINT result = SendInput(1, &input, sizeof(INPUT)); // 发送 1 个 INPUT 事件
-
-    // 检查 SendInput 是否失败
-    if (result != 1) {
-        DWORD errorCode = GetLastError(); // 获取错误码
-        qWarning() << "  SendInput 失败! Result:" << result << " 错误码:" << errorCode;
-        // 常见的错误码:
-        // 5: ERROR_ACCESS_DENIED - 通常由于 UIPI (用户界面特权隔离)。
-        //    目标窗口比此键盘应用具有更高的权限。
-        //    解决方案：如果目标是提升权限的应用，以管理员身份运行虚拟键盘。
-        // 87: ERROR_INVALID_PARAMETER - 检查 INPUT 结构体标志 (dwFlags)。
-        // 1400: ERROR_INVALID_WINDOW_HANDLE - 此处不太可能，因为 SendInput 针对焦点，而非句柄。
-        // 为“访问被拒绝”提供具体反馈
-        if (errorCode == 5) {
-            qWarning() << "  >> 访问被拒绝 (错误 5): 目标窗口可能具有更高权限 (例如，以管理员身份运行)。尝试以管理员身份运行此键盘。";
+    };
+
+    syncHostKeyText(); // hostTextMismatch 对应当前布局和主机布局
+    for (int i = 0; i < text.size(); ++i) {
+        QChar ch = text.at(i);
+        if (ch == QLatin1Char('\r')) {
+            if (i + 1 < text.size() && text.at(i + 1) == QLatin1Char('\n')) continue;
+            ch = QLatin1Char('\n');
         }
-    } else {
-        // qDebug() << "  SendInput OK."; // 可选：记录成功日志
+        // 一个字符最多 5 个事件 (恢复 Shift + 代理对的 4 个 Unicode 事件)，放不下时先结束当前批次
+        if (batches && events.size() - batchStart + 5 > maxBatchEvents) closeBatch();
+        ++characters;
+
+        // 布局中没有的字符，以及按键的 VK 码在主机布局上不产生该字符时 (例如美式主机上的俄语布局)，用 Unicode 事件输入
+        const CharKey charKey = keyTable.keyForChar(ch);
+        const bool hostTyped = charKey.keyId >= 0 && !(hostTextMismatch.value(charKey.keyId) & (charKey.shifted ? 0x02 : 0x01));
+        if (!hostTyped) {
+            restoreShift();
+            events.append(KeyEvent::unicode(ch.unicode(), true));
+            events.append(KeyEvent::unicode(ch.unicode(), false));
+            if (ch.isHighSurrogate() && i + 1 < text.size() && text.at(i + 1).isLowSurrogate()) {
+                const char16_t low = text.at(++i).unicode();
+                events.append(KeyEvent::unicode(low, true));
+                events.append(KeyEvent::unicode(low, false));
+            }
+            continue;
+        }
+        const KeyEntry& key = keyTable.entry(charKey.keyId);
+        const bool needShift = charKey.letter ? (charKey.shifted != capsLockActive) : charKey.shifted;
+        if (needShift != shiftDown) {
+            events.append(KeyEvent::key(VK_LSHIFT, shiftScanCode, needShift, false));
+            shiftDown = needShift;
+        }
+        events.append(KeyEvent::key(key.vkCode, key.scanCode, true, key.isExtended()));
+        events.append(KeyEvent::key(key.vkCode, key.scanCode, false, key.isExtended()));
     }
-#else
-    Q_UNUSED(input); // 抑制未使用变量警告
-    Q_UNUSED(vkCodeForLog);
-    Q_UNUSED(pressForLog);
-#endif
+    closeBatch();
+}
+
+// --- typeText: 批量输入文本 ---
+// 文本先整体编码为事件，再由 bulkTyper 按批次和间隔交给注入线程
+bool VirtualKeyboardWidget::typeText(const QString& text) {
+    if (text.isEmpty() || bulkTyper.isRunning()) return false;
+    // 拼音组字和滑行候选都以光标位置为前提，批量输入后不再有效
+    if (pinyin.isComposing()) {
+        commitText(pinyin.composition());
+        pinyin.reset();
+    }
+    swipeCommitted.clear();
+    swipeAlternatives.clear();
+    prediction.reset();
+    touchModel.reset();
+    scheduleSuggestionRefresh();
+
+    QVector<KeyEvent> events;
+    QVector<BulkTyper::Batch> batches;
+    events.reserve(text.size() * 2 + 16);
+    appendTextEvents(text, events, qBound(8, bulkTypingOptions.batchEvents, BulkTyper::MAX_BATCH_EVENTS), &batches);
+    qDebug() << "批量输入:" << text.size() << "个字符," << events.size() << "个事件," << batches.size() << "批";
+    // 按钮文字先改为停止: 注入线程未运行时 start 会同步完成并立即发出 finished
+    if (bulkTypeButton) bulkTypeButton->setText("停止输入");
+    return bulkTyper.start(std::move(events), std::move(batches), bulkTypingOptions);
+}
+
+// --- typeClipboard: 输入剪贴板文本，正在输入时取消 ---
+void VirtualKeyboardWidget::typeClipboard() {
+    if (bulkTyper.isRunning()) {
+        bulkTyper.cancel();
+        return;
+    }
+    const QString text = QGuiApplication::clipboard()->text();
+    if (text.isEmpty()) {
+        qDebug() << "剪贴板中没有文本";
+        return;
+    }
+    typeText(text);
+}
+
+// --- onBulkTypingFinished: 记录实际速度和后端报告丢失的事件 ---
+void VirtualKeyboardWidget::onBulkTypingFinished(const BulkTypingReport& report) {
+    const QString summary = QString("%1 个字符 / %2 个事件, %3 ms, %4 字符/秒, 丢失 %5 个事件%6")
+            .arg(report.characters).arg(report.events).arg(report.elapsedNs / 1000000)
+            .arg(report.charactersPerSecond(), 0, 'f', 0).arg(report.droppedEvents)
+            .arg(report.cancelled ? ", 已取消" : "");
+    if (report.droppedEvents > 0) qWarning().noquote() << "批量输入:" << summary;
+    else qDebug().noquote() << "批量输入:" << summary;
+    if (bulkTypeButton) {
+        bulkTypeButton->setText("输入剪贴板");
+        bulkTypeButton->setToolTip("上次: " + summary);
+    }
+    emit bulkTypingFinished(report);
+}
+
+// --- toggleMacroRecording: 空闲 -> 录制 -> 等待绑定键 -> 空闲 (等待时再次点击取消) ---
+void VirtualKeyboardWidget::toggleMacroRecording() {
+    switch (macroState) {
+        case MacroState::Idle:
+            macros.startRecording(modifierStateBits());
+            macroState = MacroState::Recording;
+            break;
+        case MacroState::Recording:
+            macros.stopRecording();
+            macroState = MacroState::AwaitingKey;
+            break;
+        case MacroState::AwaitingKey:
+            macroState = MacroState::Idle;
+            break;
+    }
+    updateMacroButton();
+}
+
+// --- bindMacro: 绑定刚录制的宏 (没有录制任何事件时解除绑定) 并保存 ---
+void VirtualKeyboardWidget::bindMacro(int keyId) {
+    const int steps = macros.recordedSteps();
+    macros.bindRecording(keyId, keyTable.entry(keyId));
+    macroState = MacroState::Idle;
+    keyRepeater.setEnabled(keyId, !macros.isBound(keyId));
+    qDebug() << (steps > 0 ? "宏已绑定到" : "已解除宏绑定:") << keyTable.info(keyId).text << steps << "个事件";
+    if (!macroFilePath.isEmpty()) {
+        QString macroError;
+        if (!macros.save(macroFilePath, &macroError)) qWarning() << "保存宏文件失败:" << macroError;
+    }
+    updateMacroButton();
 }
 
+// --- playMacro: 回放宏 ---
+// 间隔为 0 时整个宏 (连同补齐的修饰键) 作为一批事件提交；否则交给 macroPlayer 按每次按下分批发送
+void VirtualKeyboardWidget::playMacro(int keyId) {
+    if (macroPlayer.isRunning()) {
+        VK_LOG_DEBUG("上一个宏仍在回放，忽略 {}", keyTable.info(keyId).text);
+        return;
+    }
+    // 宏输入的内容不经过拼音和单词预测，正在组字的拼音先上屏，当前单词和滑行候选不再有效
+    if (pinyin.isComposing()) {
+        commitText(pinyin.composition());
+        pinyin.reset();
+    }
+    swipeCommitted.clear();
+    swipeAlternatives.clear();
+    prediction.reset();
+    touchModel.reset();
+    scheduleSuggestionRefresh();
+
+    QVector<KeyEvent> events;
+    events.reserve(macros.stepCount(keyId) + 16);
+    if (macroDelayMs == 0) {
+        macros.appendPlayback(keyId, modifierStateBits(), events);
+        for (KeyEvent& event : events) event.inputTimeNs = handlerInputNs;
+        keyInjector.postBatch(events.constData(), events.size());
+        VK_LOG_DEBUG("宏 {}: {} 个事件", keyTable.info(keyId).text, events.size());
+        return;
+    }
+    QVector<BulkTyper::Batch> batches;
+    macros.appendPlayback(keyId, modifierStateBits(), events, &batches);
+    BulkTypingOptions pacing;
+    pacing.intervalMs = macroDelayMs;
+    macroPlayer.start(std::move(events), std::move(batches), pacing);
+}
+
+// --- onMacroPlaybackFinished: 按间隔回放的宏结束 ---
+void VirtualKeyboardWidget::onMacroPlaybackFinished(const BulkTypingReport& report) {
+    VK_LOG_DEBUG("宏回放结束: {} 个事件, {} ms, 丢失 {} 个事件", report.events, report.elapsedNs / 1000000, report.droppedEvents);
+    if (report.droppedEvents > 0) qWarning() << "宏回放: 后端丢失了" << report.droppedEvents << "个事件";
+}
+
+// --- updateMacroButton: 按录制状态更新宏按钮 ---
+void VirtualKeyboardWidget::updateMacroButton() {
+    if (!macroButton) return;
+    switch (macroState) {
+        case MacroState::Idle:
+            macroButton->setText("录制宏");
+            macroButton->setToolTip(QString("录制一段按键并绑定到一个键上，按下该键时回放 (已绑定 %1 个宏)").arg(macros.macroCount()));
+            break;
+        case MacroState::Recording:
+            macroButton->setText("停止录制");
+            macroButton->setToolTip("正在录制按键 (照常输入)，点击停止录制");
+            break;
+        case MacroState::AwaitingKey:
+            macroButton->setText("按绑定键...");
+            macroButton->setToolTip("按下要绑定的键 (没有录制任何按键时解除该键的绑定)，点击取消");
+            break;
+    }
+}
+
+// --- opacityToAlpha: 把透明度百分比转换为 0-255 的 alpha 值 ---
+int VirtualKeyboardWidget::opacityToAlpha(int percent) {
+    // 将百分比转换为 0.0 到 1.0 的浮点数，再转换为 alpha 值
+    double opacity = static_cast<double>(percent) / 100.0;
+    return qBound(0, static_cast<int>(opacity * 255), 255);
+}
 
 // --- changeOpacity: 响应滑块改变，更新背景透明度 ---
+// 拖动滑块会连续发出大量 valueChanged，这里只记录最新值，
+// 由 opacityTimer 在下一帧统一应用，保证每帧最多重绘一次。
 void VirtualKeyboardWidget::changeOpacity(int value) {
-    // 将滑块值 (百分比) 转换为 0.0 到 1.0 的浮点数
-    double opacity = static_cast<double>(value) / 100.0;
-    // 将浮点透明度转换为 0-255 的 alpha 值
-    int alpha = qBound(0, static_cast<int>(opacity * 255), 255);
-
-    // 通过正则表达式更新 QSS 中 KeyboardHalf 背景色的 alpha 值
-    QString currentStyle = styleSheet(); // 获取当前样式表
-    // 正则表达式查找 "rgba(数字,数字,数字, 数字)" 模式
-    // \\d+ 匹配一个或多个数字, \\s* 匹配零个或多个空白符
-    // (\\d+,\\s*\\d+,\\s*\\d+,\\s*) 捕获 RGB 部分 (捕获组 1)
-    // \\d+ 匹配旧的 alpha 值
-    QRegularExpression regex("rgba\\((\\d+,\\s*\\d+,\\s*\\d+,\\s*)\\d+\\)");
-    // 用新的 alpha 值替换，保留 RGB 部分 (\1)
-    currentStyle.replace(regex, QString("rgba(\\1%1)").arg(alpha));
+    AllocStats::Scope allocScope(AllocOperation::Opacity);
+    pendingOpacityAlpha = opacityToAlpha(value);
+    if (!opacityTimer.isActive()) opacityTimer.start();
+}
 
-    // 也更新边框 alpha（如果它使用相同的模式）
-    // 更具体的边框正则表达式（如果需要）：
-    // QRegularExpression borderRegex("rgba\\((\\d+,\\s*\\d+,\\s*\\d+,\\s*)\\d+\\)(?=\\s*;\\s*\\/\\*\\s*border\\s*with\\s*alpha\\s*\\*\\/)");
-    // 简单方法：假设边框使用相同的 alpha，替换所有匹配的 rgba alpha
-    // （如果以后添加了其他 rgba 颜色，可能会影响它们，要小心）
+// --- applyPendingOpacity: 把合并后的透明度应用到背景 ---
+// 只改变绘制时使用的背景 alpha，不改写样式表，因此不会触发整棵控件树的重新 polish
+void VirtualKeyboardWidget::applyPendingOpacity() {
+    if (pendingOpacityAlpha < 0) return;
+    AllocStats::Scope allocScope(AllocOperation::Opacity);
+    const int alpha = pendingOpacityAlpha;
+    pendingOpacityAlpha = -1;
 
-    // 重新应用修改后的样式表
-    setStyleSheet(currentStyle);
+    if (keyboardCanvas) {
+        keyboardCanvas->setBackgroundAlpha(alpha);
+    } else {
+        leftKeyboardWidget->setBackgroundAlpha(alpha);
+        rightKeyboardWidget->setBackgroundAlpha(alpha);
+    }
+    if (suggestionBar) suggestionBar->setBackgroundAlpha(alpha);
 }
 
 
 // --- positionWindow: 定位窗口到屏幕底部任务栏上方 ---
 void VirtualKeyboardWidget::positionWindow() {
+    StartupTrace::Phase phase("positionWindow");
     QScreen *screen = QGuiApplication::primaryScreen(); // 获取主屏幕
     if (!screen) return; // 安全检查
 
@@ -630,7 +1697,7 @@ void VirtualKeyboardWidget::positionWindow() {
     // 计算键盘窗口期望的高度 (基于布局的建议高度，并设置一个最小值)
     int desiredHeight = outerLayout->sizeHint().height();
     // 确保高度不小于一个基于按键高度估算的最小值 (例如 6 行按键的高度 + 边距 + 滑块)
-    int minPracticalHeight = (KEY_MIN_HEIGHT + leftGridLayout->spacing()) * 6 + outerLayout->contentsMargins().top() + outerLayout->contentsMargins().bottom() + opacitySlider->height() + outerLayout->spacing();
+    int minPracticalHeight = (KEY_MIN_HEIGHT + KEY_SPACING) * 6 + outerLayout->contentsMargins().top() + outerLayout->contentsMargins().bottom() + opacitySlider->height() + outerLayout->spacing();
     desiredHeight = qMax(desiredHeight, minPracticalHeight);
 
 
@@ -640,12 +1707,19 @@ void VirtualKeyboardWidget::positionWindow() {
     int newX = availableGeometry.left();
     // 新的宽度：屏幕可用区域宽度
     int newWidth = availableGeometry.width();
+    // 小键盘模式: 窄窗口停靠在右下角 (不小于底部滑块和按钮所需的宽度)
+    if (geometryMode == GeometryMode::Numpad) {
+        newWidth = qMin(newWidth, qMax(NUMPAD_WINDOW_WIDTH, outerLayout->minimumSize().width()));
+        newX = availableGeometry.right() - newWidth + 1;
+    }
 
     // 调试输出窗口定位信息
-    qDebug() << "定位窗口: 屏幕可用区域 =" << availableGeometry << "期望高度 =" << desiredHeight << "最小实用高度 =" << minPracticalHeight;
-    qDebug() << "设置几何区域为:" << QRect(newX, newY, newWidth, desiredHeight);
+    VK_LOG_DEBUG("定位窗口: 屏幕可用区域 = {},{} {}x{} 期望高度 = {} 最小实用高度 = {}", availableGeometry.x(), availableGeometry.y(),
+                 availableGeometry.width(), availableGeometry.height(), desiredHeight, minPracticalHeight);
+    VK_LOG_DEBUG("设置几何区域为: {},{} {}x{}", newX, newY, newWidth, desiredHeight);
 
-    // 移动并调整窗口大小
+    // 移动并调整窗口大小 (分配计入 resize，包括按钮的重新布局)
+    AllocStats::Scope allocScope(AllocOperation::Resize);
     // 分开调用 move 和 resize 有时比直接调用 setGeometry更能避免 resizeEvent 的递归问题，
     // 尽管 setGeometry 也应该能工作。
     this->move(newX, newY);
@@ -653,12 +1727,22 @@ void VirtualKeyboardWidget::positionWindow() {
     // this->setGeometry(newX, newY, newWidth, desiredHeight); // 备选方案
 }
 
+// --- paintEvent: 检测首帧 ---
+// 顶层窗口先于子部件绘制；排队的调用在整帧 (包括子部件和刷新到屏幕) 完成后才执行
+void VirtualKeyboardWidget::paintEvent(QPaintEvent *event) {
+    QWidget::paintEvent(event);
+    if (firstFramePainted) return;
+    firstFramePainted = true;
+    QMetaObject::invokeMethod(this, &VirtualKeyboardWidget::firstFrameShown, Qt::QueuedConnection);
+}
+
 // --- resizeEvent: 处理窗口尺寸改变事件 ---
 void VirtualKeyboardWidget::resizeEvent(QResizeEvent *event) {
+    AllocStats::Scope allocScope(AllocOperation::Resize);
     QWidget::resizeEvent(event); // 调用基类的处理函数
     // 可选：如果你希望即使用户手动调整大小后窗口仍强制停靠底部（可能会令人烦恼），
     // 可以在这里重新调用 positionWindow()。
     // 注意避免无限递归调用（例如，通过标志或 QTimer::singleShot 延迟调用）。
     // QMetaObject::invokeMethod(this, "positionWindow", Qt::QueuedConnection);
-    qDebug() << "窗口尺寸调整为:" << event->size(); // 调试输出新的尺寸
+    VK_LOG_DEBUG("窗口尺寸调整为: {}x{}", event->size().width(), event->size().height()); // 调试输出新的尺寸
 }
\ No newline at end of file
@@ -9,14 +9,33 @@
 #include <QVBoxLayout>
 #include <QList>
 #include <QMap>
+#include <QTimer>
+#include <climits>
 #include "keyboardlayout.h" // 包含键盘布局定义
+#include "keytable.h"       // 按 id 索引的按键表
+#include "keyinjector.h"    // 按键注入线程
+#include "predictionengine.h" // 单词预测
+#include "pinyinengine.h"     // 拼音输入
+#include "swipedecoder.h"     // 滑行输入
+#include "bulktyper.h"        // 批量输入文本
+#include "macroengine.h"      // 宏录制和回放
+#include "touchdecoder.h"     // 概率触摸定位
+#include "touchtrace.h"       // 触摸轨迹记录
+#include "spellindex.h"       // 自动纠错
+#include "keyrepeater.h"      // 按键自动重复
+#include "inputtrace.h"       // 输入轨迹记录和回放
+#include "layoutset.h"        // 可切换的一组布局
+#include "keyboardgeometry.h" // 几何模式 (完整、拆分、紧凑、小键盘)
+
+class KeyboardCanvas;
+class KeyboardPanel;
+class SuggestionBar;
 
 // --- 前向声明 Windows API 类型 ---
 // 避免在头文件中包含庞大的 windows.h
 #ifdef _WIN32
 #ifndef _WINDEF_ // 简单检查是否已包含，避免重复定义
 struct HWND__; typedef HWND__* HWND;     // 窗口句柄
-struct tagINPUT; typedef tagINPUT INPUT; // SendInput 函数需要的结构体
 // 如果需要 Get/SetWindowLongPtr, 可能需要包含 windef.h 或 windows.h 的一部分
 // 或者直接定义类型
 #ifndef LONG_PTR // 通常在 basetsd.h 中定义
@@ -29,49 +48,204 @@ struct tagINPUT; typedef tagINPUT INPUT; // SendInput 函数需要的结构体
 #endif // _WINDEF_
 #endif // _WIN32
 
+// 键盘渲染模式
+enum class RenderMode {
+    Buttons, // 每个按键一个 QPushButton，由 QSS 设置样式 (默认)
+    Canvas   // 单个 KeyboardCanvas 自绘所有按键
+};
+
+// 键盘启动选项 (由命令行或环境变量决定)
+struct KeyboardOptions {
+    RenderMode renderMode = RenderMode::Buttons; // 渲染模式
+    QString injectionBackend;                    // 注入后端名称 (空表示平台默认)
+    QString layoutFile;                          // 文本布局文件 (空表示使用内置 QWERTY 布局)
+    QStringList layouts;                         // 布局切换键循环的布局 (空表示全部内置布局，见 LayoutSet::load)
+    GeometryMode geometryMode = GeometryMode::Split; // 启动时的几何模式 (布局中没有其按键时使用拆分模式)
+    QString latencyDumpPath;                     // 退出时写出延迟直方图的 JSON 文件 (空表示不写)
+    QString dictionaryFile;                      // 单词预测词典 (空表示不显示建议栏)
+    QString pinyinLexicon;                       // 拼音词库 (空表示不启用拼音输入)
+    bool swipeTyping = false;                    // 滑行输入 (需要画布模式和单词预测词典)
+    BulkTypingOptions bulkTyping;                // 批量输入文本的批次大小和间隔
+    QString macroFile;                           // 宏文件 (空表示录制的宏不保存)
+    int macroDelayMs = 0;                        // 宏回放的按键间隔 (毫秒，0 表示整个宏作为一批提交)
+    bool touchTargeting = false;                 // 概率触摸定位 (有词典时由语言模型加权)
+    QString touchTraceFile;                      // 记录触摸按下的轨迹文件 (空表示不记录，需要 touchTargeting)
+    bool autocorrect = false;                    // 空格/回车时自动纠正刚输入的单词 (需要单词预测词典)
+    QString inputTraceFile;                      // 记录按键处理函数输入的轨迹文件 (空表示不记录)
+};
+
 // 主虚拟键盘窗口类
 class VirtualKeyboardWidget : public QWidget {
 Q_OBJECT // 启用 Qt 元对象系统 (信号/槽)
+    friend class KeyboardBenchmark; // benchmarks/bench_keyboard.cpp 直接测量内部路径
+    friend class InjectionTest;     // tests/tst_injection.cpp 直接调用按下/释放处理函数
 
 public:
+    // 修饰键视觉更新统计 (用于观察每次修饰键变化触及的控件数)
+    struct ModifierVisualStats {
+        quint64 updates = 0;      // 实际执行的更新次数
+        quint64 totalTouched = 0; // 累计触及的控件数
+        int lastTouched = 0;      // 最近一次更新触及的控件数
+    };
+
     // 构造函数
-    explicit VirtualKeyboardWidget(QWidget *parent = nullptr);
-    // 析构函数 (默认实现即可)
-    ~VirtualKeyboardWidget() override = default;
+    explicit VirtualKeyboardWidget(const KeyboardOptions& options = KeyboardOptions(), QWidget *parent = nullptr);
+    // 析构函数 (排空注入队列并释放按下的键)
+    ~VirtualKeyboardWidget() override;
+
+    // 返回修饰键视觉更新统计
+    const ModifierVisualStats& modifierVisualStats() const { return visualStats; }
+    // 返回当前使用的按键注入后端
+    InjectionBackend* injectionBackend() const { return keyInjector.backend(); }
+    // 返回按下到注入的各阶段延迟直方图 (可在运行时读取)
+    const LatencyStats& latencyStats() const { return keyInjector.latency(); }
+    // 返回单词预测引擎 (未加载词典时 isLoaded() 为 false)
+    const PredictionEngine& predictionEngine() const { return prediction; }
+    // 返回自动纠错索引 (未启用或尚未打开时为 nullptr)
+    const SpellIndex* spellIndex() const { return spell.get(); }
+    // 返回拼音输入引擎 (未加载词库时 isLoaded() 为 false)
+    const PinyinEngine& pinyinEngine() const { return pinyin; }
+    // 把文本作为按键批量输入 (按 KeyboardOptions::bulkTyping 的节奏分批注入)，已在批量输入时返回 false
+    bool typeText(const QString& text);
+    bool isBulkTyping() const { return bulkTyper.isRunning(); }
+    // 返回宏引擎 (按键绑定和录制状态)
+    const MacroEngine& macroEngine() const { return macros; }
+    // 返回按 id 索引的按键表
+    const KeyTable& layoutKeys() const { return keyTable; }
+    // 切换到布局组中的第 index 个布局: 原地替换按键文本和 VK 码，不创建或销毁控件 (布局切换键调用)
+    void switchLayout(int index);
+    // 当前布局在布局组中的位置和布局组的大小
+    int activeLayoutIndex() const { return activeLayout; }
+    int layoutCount() const { return layoutSet.size(); }
+    // 切换几何模式: 使用启动时计算好的排布，按钮模式只把现有按钮重新放入网格，不创建或销毁控件；
+    // 当前布局中没有该模式的按键时忽略
+    void setGeometryMode(GeometryMode mode);
+    GeometryMode activeGeometryMode() const { return geometryMode; }
+
+    // --- 输入轨迹回放 ---
+    // 按记录调用按下/释放/重复处理函数 (回放开始后 keyRepeater 不再调度，重复只来自轨迹)；
+    // 返回处理前的修饰键状态是否与记录时一致
+    bool replayInput(const InputTrace::Record& record);
+    // 已入队的事件是否都已交给注入后端
+    bool isInjectionIdle() const { return keyInjector.injectedEvents() >= keyInjector.postedEvents(); }
+
+signals:
+    // 首帧绘制完成 (包括子部件)，只发出一次
+    void firstFrameShown();
+    // 批量输入结束 (完成或被取消)
+    void bulkTypingFinished(const BulkTypingReport& report);
 
 protected:
     // 重写窗口尺寸改变事件处理函数
     void resizeEvent(QResizeEvent *event) override;
+    // 重写绘制事件，用于检测首帧
+    void paintEvent(QPaintEvent *event) override;
+    // 记录按键控件收到输入事件的时间 (延迟统计)
+    bool eventFilter(QObject *watched, QEvent *event) override;
 
 // 私有槽函数，响应信号
 private slots:
-    void onKeyPressed();        // 按键按下时调用
-    void onKeyReleased();       // 按键释放时调用
-    void changeOpacity(int value); // 透明度滑块值改变时调用
+    void onKeyPressed(int keyId);  // 按键按下时调用 (keyId 为 keyTable 中的索引)
+    void onKeyReleased(int keyId); // 按键释放时调用
+    void onKeyRepeat(int keyId);   // 自动重复: 只发送按下事件
+    void changeOpacity(int value); // 透明度滑块值改变时调用 (只记录，合并到下一帧应用)
+    void applyPendingOpacity();    // 应用合并后的透明度
     void positionWindow();      // 定位窗口到屏幕底部
+    void refreshSuggestions();  // 把当前建议显示到建议栏 (合并同一轮事件循环中的多次按键)
+    void onSuggestionChosen(int index); // 点击建议: 把单词的剩余部分作为一批按键注入
+    void togglePinyinMode();    // 点击模式标签: 在拼音和英文之间切换
+    void prepareSwipeDecoder(); // 按画布当前的按键几何准备滑行模板 (几何没有明显变化时不重建)
+    void prepareTouchModel();   // 用预测词典训练概率触摸定位的语言模型
+    void onGestureFinished(const QVector<QPointF>& path); // 解码滑行轨迹并输入最可能的单词
+    void typeClipboard();       // 批量输入剪贴板中的文本 (正在输入时改为取消)
+    void onBulkTypingFinished(const BulkTypingReport& report); // 输出批量输入的速度和丢失的事件数
+    void toggleMacroRecording(); // 点击宏按钮: 开始录制 -> 停止录制并等待绑定键 -> 取消绑定
+    void onMacroPlaybackFinished(const BulkTypingReport& report); // 按间隔回放的宏结束
+    void cycleGeometryMode();    // 点击几何按钮: 切换到下一个可用的几何模式
 
 // 私有成员函数
 private:
     void setupUI();             // 初始化用户界面元素
+    void setupButtonKeyboard(); // 按钮模式: 创建左右键盘半区和按钮
     // 创建键盘布局 (将 KeyInfo 转换为 QPushButton)
-    void createKeyboardLayout(QWidget* parentWidget, QGridLayout* layout, const KeyboardLayout& keyRows);
+    void createKeyboardLayout(KeyboardPanel* panel, QGridLayout* layout, const KeyboardLayout& keyRows);
+    // 创建一个按键按钮并登记到 keyButtons/keyButtonsById (不放入网格)
+    QPushButton* createKeyButton(const KeyInfo& keyInfo, QWidget* parent);
+    // 把现有按钮按几何重新放入左右网格 (不需要的按钮隐藏，单区域模式隐藏右半区)
+    void arrangeButtons(const KeyboardGeometry& geometry);
+    // 当前布局在当前几何模式下的排布
+    const KeyboardGeometry& activeGeometry() const { return layoutSet.layout(activeLayout).geometry(geometryMode); }
+    // 返回修饰键分组对应的状态标志 (shiftActive 等)，非修饰键返回 nullptr
+    bool* modifierFlag(ModifierGroup group);
     void updateModifierKeysVisuals(); // 更新修饰键 (Shift, Ctrl, Alt, Caps...) 的视觉状态 (文本大小写, 按钮样式)
-    // 使用 Windows API 模拟按键事件
+    int applyKeyVisual(int keyId, quint8 stateBits); // 更新单个按键的视觉状态，返回改动的控件数
+    quint8 modifierStateBits() const; // 把修饰键标志打包为 ModifierStateBit 组合
+    void recordInput(InputTrace::Kind kind, int keyId); // 把处理函数的输入追加到输入轨迹 (打开时)
+    // 模拟按键事件 (入队到注入线程)
     void simulateKey(int vkCode, int scanCode, bool press, bool isExtended);
-    // SendInput API 的包装函数，包含日志记录
-    void sendInputWrapper(INPUT input, int vkCodeForLog, bool pressForLog);
+    // 模拟一次完整的按下+释放，作为一批事件一次提交
+    void simulateKeyTap(int vkCode, int scanCode, bool isExtended);
+    // 以 Unicode 事件按下或抬起 text 的每个 UTF-16 代码单元 (按键文本不能按 VK 码在主机布局上输入时)
+    void simulateUnicode(const QString& text, bool press);
+    // 主机布局改变 (或切换了布局) 时重新比较每个普通键的文本和它的 VK 码在主机布局上产生的字符
+    void syncHostKeyText() const;
+    // 按键在当前状态下需要以 Unicode 输入的文本 (空表示按 VK 码注入)
+    QString unicodeTextFor(int keyId) const;
+    // 按下/释放处理函数入口: 记录时间并关联正在分发的输入事件
+    void beginKeyHandler();
+    // 把按下的键交给预测引擎，并安排刷新建议栏
+    void updatePrediction(int keyId);
+    // 安排在本轮事件循环结束后刷新建议栏 (多次调用只刷新一次)
+    void scheduleSuggestionRefresh();
+    // 拼音模式下处理按下的键，返回 true 表示按键被组字吞掉 (不注入)
+    bool handlePinyinKey(int keyId);
+    // 自动纠错: 空格/回车之前纠正刚输入的单词，紧接着的退格撤销纠正 (返回 true 表示按键已处理，不注入)
+    bool handleAutocorrect(int keyId);
+    // 按词典纠正当前单词 (替换为退格 + 纠正后的单词)
+    void autocorrectWord();
+    // 打开 (必要时编译) 预测词典的纠错索引
+    void prepareAutocorrect(const QString& dictionaryPath);
+    // 提交拼音候选 (没有候选时提交拼音本身)
+    void commitPinyinCandidate(int index);
+    // 把文本作为一批事件注入
+    void commitText(const QString& text);
+    // 把刚录制的宏绑定到按键并保存宏文件
+    void bindMacro(int keyId);
+    // 回放绑定在按键上的宏 (作为一批事件，或按 macroDelayMs 的间隔分批)
+    void playMacro(int keyId);
+    // 更新宏按钮的文字和提示
+    void updateMacroButton();
+    // 把文本转换为按键事件 (按当前 Shift/CapsLock 状态补上 Shift)，布局中没有的字符用 Unicode 事件输入；
+    // batches 不为空时按 maxBatchEvents 分批，记录每批的结束位置
+    void appendTextEvents(const QString& text, QVector<KeyEvent>& events,
+                          int maxBatchEvents = INT_MAX, QVector<BulkTyper::Batch>* batches = nullptr) const;
+    // 追加 count 次退格 (按下 + 释放)
+    static void appendBackspaces(int count, QVector<KeyEvent>& events);
     // 应用窗口样式（包括WS_EX_NOACTIVATE）
     void applyWindowStyles();
+    // 把透明度百分比转换为 0-255 的 alpha 值
+    static int opacityToAlpha(int percent);
+
+    // --- 渲染模式 ---
+    RenderMode renderMode;
 
     // --- UI 元素指针 ---
     QVBoxLayout *outerLayout;       // 最外层垂直布局 (包含键盘和滑块)
-    QHBoxLayout *keyboardLayout;    // 包含左右键盘区域的水平布局
-    QWidget *leftKeyboardWidget;    // 左键盘容器 QWidget
-    QWidget *rightKeyboardWidget;   // 右键盘容器 QWidget
-    QGridLayout *leftGridLayout;    // 左键盘网格布局
-    QGridLayout *rightGridLayout;   // 右键盘网格布局
+    QHBoxLayout *keyboardLayout = nullptr;    // 包含左右键盘区域的水平布局 (按钮模式)
+    KeyboardPanel *leftKeyboardWidget = nullptr;  // 左键盘容器 (按钮模式)
+    KeyboardPanel *rightKeyboardWidget = nullptr; // 右键盘容器 (按钮模式)
+    QGridLayout *leftGridLayout = nullptr;    // 左键盘网格布局 (按钮模式)
+    QGridLayout *rightGridLayout = nullptr;   // 右键盘网格布局 (按钮模式)
+    KeyboardCanvas *keyboardCanvas = nullptr; // 自绘键盘 (画布模式)
+    SuggestionBar *suggestionBar = nullptr;   // 单词建议栏 (加载了词典时)
     QSlider *opacitySlider;         // 透明度调节滑块
+    QPushButton *bulkTypeButton = nullptr; // 批量输入剪贴板文本 (滑块右侧)
+    QPushButton *macroButton = nullptr;    // 录制宏 (批量输入按钮右侧)
+    QPushButton *geometryButton = nullptr; // 切换几何模式 (宏按钮右侧)
+    QTimer opacityTimer;            // 合并滑块事件的定时器 (每帧最多应用一次)
+    int pendingOpacityAlpha = -1;   // 等待应用的背景 alpha (-1 表示没有)
     QList<QPushButton*> keyButtons; // 存储所有按键按钮的指针，方便统一处理
+    QVector<QList<QPushButton*>> keyButtonsById; // 按键 id -> 按钮 (拆分的空格键对应两个按钮；其他模式需要的按钮预先创建并隐藏)
 
     // --- 键盘状态标志 ---
     // 这些标志跟踪修饰键的当前“按下”状态
@@ -83,11 +257,85 @@ private:
     bool capsLockActive = false;
     bool numLockActive = false;
     bool scrollLockActive = false;
+    // 最近一次应用到按键视觉上的状态位 (-1 表示尚未应用)
+    int appliedStateBits = -1;
+    QVector<quint32> keyVisitStamp; // 视觉更新时按键去重用的代号
+    quint32 keyVisitGeneration = 0;
+    ModifierVisualStats visualStats; // 修饰键视觉更新统计
+    bool firstFramePainted = false;  // 是否已经绘制过首帧
+    // --- 延迟统计 ---
+    qint64 dispatchingInputNs = 0;   // 正在分发的输入事件到达的时间 (0 表示当前没有)
+    bool dispatchingTouch = false;   // 正在分发的输入事件是触摸事件
+    qint64 handlerInputNs = 0;       // 当前处理函数对应的输入事件时间
+    bool handlerInputIsTouch = false; // 当前处理函数由触摸事件触发 (统计触摸到按下的延迟)
+    qint64 handlerEntryNs = 0;       // 当前处理函数的入口时间
+    QString latencyDumpPath;         // 退出时写出延迟直方图的文件
 
     // --- 布局数据 ---
     KeyboardLayout fullLayoutData;  // 完整的键盘布局数据
     KeyboardLayout leftLayoutData;  // 左半部分键盘布局数据
     KeyboardLayout rightLayoutData; // 右半部分键盘布局数据
+    KeyTable keyTable;              // 按 id 索引的扁平按键表 (由 fullLayoutData 构建)
+    LayoutSet layoutSet;            // 启动时生成的全部布局 (切换时把其中一个复制到上面几项，数据隐式共享)
+    int activeLayout = 0;           // 当前布局在 layoutSet 中的位置
+    GeometryMode geometryMode = GeometryMode::Split; // 当前几何模式
+    QVector<bool> consumedKeys;     // 按下时被拼音组字或宏吞掉的键 (释放时同样不注入)
+    QVector<bool> injectedDown;     // 已注入按下、尚未注入抬起的普通键/特殊键 (切换布局时按旧 VK 码抬起)
+    QVector<QString> injectedText;  // 按下时以 Unicode 输入的文本 (释放时抬起同样的字符，空表示按 VK 码注入)
+
+    // --- 主机布局 ---
+    // 布局只改变按键上的文本，VK 码由主机布局翻译: 两者不一致的键 (例如美式主机上的俄语、AZERTY 布局) 改用 Unicode 输入
+    mutable QVector<quint8> hostTextMismatch; // 按键 id -> 位 0/1: 未按/按住 Shift (字母键为小写/大写) 时文本与主机字符不一致
+    mutable quintptr hostLayoutId = 0;        // 计算 hostTextMismatch 时的主机布局
+    mutable int hostTextLayout = -1;          // 计算 hostTextMismatch 时的 activeLayout (-1 表示还没有计算)
+
+    // --- 单词预测 ---
+    PredictionEngine prediction;    // 预测引擎 (由按下的普通键驱动)
+    bool suggestionRefreshPending = false; // 已安排刷新建议栏
+
+    // --- 拼音输入 ---
+    PinyinEngine pinyin;            // 拼音引擎 (加载了词库时)
+    bool pinyinMode = false;        // 字母键进入拼音缓冲区 (而不是直接注入)
+
+    // --- 滑行输入 ---
+    SwipeDecoder swipe;             // 滑行解码器 (模板由预测词典生成)
+    bool swipeWordsLoaded = false;  // 已把词典单词交给解码器
+    QString swipeCommitted;         // 最近一次滑行输入的文本 (含空格，非空时建议栏显示其他候选)
+    QStringList swipeAlternatives;  // 最近一次滑行的其他候选
+
+    // --- 自动纠错 ---
+    bool autocorrectEnabled = false;     // 启用自动纠错 (索引在首帧之后打开)
+    std::unique_ptr<SpellIndex> spell;   // 映射的纠错索引
+    QString autocorrectOriginal;         // 最近一次纠正前的单词 (非空时下一个退格撤销纠正)
+    QString autocorrectReplacement;      // 最近一次纠正后的单词
+    QString autocorrectRejected;         // 被撤销过的单词 (小写，不再纠正)
+
+    // --- 概率触摸定位 ---
+    bool touchTargeting = false;    // 触摸按下的字母键由 TouchDecoder 选择
+    TouchLanguageModel touchModel;  // 画布和各半区共享的字符语言模型 (上下文随输入更新)
+    TouchTrace touchTrace;          // 触摸轨迹文件 (打开时记录每次解码)
+
+    // --- 按键注入 ---
+    KeyInjector keyInjector;        // 注入工作线程 (UI 线程只入队)
+    BulkTypingOptions bulkTypingOptions; // 批量输入的节奏
+    BulkTyper bulkTyper{keyInjector};    // 批量输入 (先于 keyInjector 析构)
+
+    // --- 宏 ---
+    enum class MacroState {
+        Idle,       // 绑定键播放宏
+        Recording,  // 注入的事件被录制
+        AwaitingKey // 录制结束，下一个按下的普通键/特殊键成为绑定键
+    };
+    MacroEngine macros;              // 录制的宏和按键绑定
+    MacroState macroState = MacroState::Idle;
+    QString macroFilePath;           // 宏文件 (绑定后立即保存)
+    int macroDelayMs = 0;            // 回放的按键间隔
+    BulkTyper macroPlayer{keyInjector};  // 按间隔回放宏 (先于 keyInjector 析构)
+    // --- 自动重复 ---
+    KeyRepeater keyRepeater;         // 所有按键共用的重复调度器 (策略按 id 索引)
+    // --- 输入轨迹 ---
+    InputTrace inputTrace;           // 打开时记录每次按键处理函数的输入
+    bool inputReplaying = false;     // 正在回放轨迹 (不记录，不调度自动重复)
 };
 
 #endif // VIRTUALKEYBOARD_VIRTUALKEYBOARDWIDGET_H
\ No newline at end of file
@@ -0,0 +1,330 @@
+#include "wordtrie.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+// --- 二进制格式 ---
+// [DictHeader][WordTrie::Node x nodeCount]，本机字节序
+namespace {
+
+const char DICT_MAGIC[4] = { 'V', 'K', 'D', 'T' };
+const quint32 DICT_VERSION = 1;
+
+struct DictHeader {
+    char magic[4];       // "VKDT"
+    quint32 version;     // DICT_VERSION
+    qint64 sourceMtime;  // 源文件修改时间 (毫秒，直接打开的 .vkdt 文件不检查)
+    qint64 sourceSize;   // 源文件大小
+    quint32 nodeCount;   // 节点数 (至少有根节点)
+    quint32 wordCount;   // 单词数
+};
+
+static_assert(sizeof(DictHeader) == 32, "DictHeader 大小应固定");
+static_assert(sizeof(WordTrie::Node) == 12, "WordTrie::Node 大小应固定");
+
+const DictHeader* headerOf(const uchar* data) { return reinterpret_cast<const DictHeader*>(data); }
+
+void setError(QString* errorMessage, const QString& message) {
+    if (errorMessage) *errorMessage = message;
+}
+
+// 文件开头是否为二进制词典
+bool isCompiledDictionary(const QString& path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+    char magic[4];
+    return file.read(magic, sizeof(magic)) == sizeof(magic) && std::memcmp(magic, DICT_MAGIC, sizeof(magic)) == 0;
+}
+
+// 编译时的单词条目
+struct SourceWord {
+    QString word;
+    quint16 score;
+};
+
+} // namespace
+
+// --- scoreForFrequency: 频率的对数得分 ---
+// 得分每增加 1024 频率翻倍；16 位足够覆盖 64 位计数的范围，同时能区分相近的频率
+quint16 WordTrie::scoreForFrequency(quint64 frequency) {
+    const double score = std::log2(double(frequency) + 1.0) * 1024.0;
+    return quint16(qBound(1.0, std::round(score), 65535.0));
+}
+
+// --- cachePathFor: 文本词典对应的缓存路径 ---
+// 缓存文件名包含源文件绝对路径的哈希，不同目录下的同名词典互不干扰
+QString WordTrie::cachePathFor(const QString& sourcePath) {
+    const QFileInfo sourceInfo(sourcePath);
+    const QByteArray pathHash = QCryptographicHash::hash(sourceInfo.absoluteFilePath().toUtf8(), QCryptographicHash::Sha1).toHex().left(12);
+    const QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/dictionaries");
+    return cacheDir + QLatin1Char('/') + sourceInfo.completeBaseName() + QLatin1Char('-') + QString::fromLatin1(pathHash) + QStringLiteral(".vkdt");
+}
+
+// --- compile: 把文本词典编译为前缀树 ---
+// 每行 "单词 [频率]"，# 开头的行为注释；没有频率的单词按出现顺序 (频率排名) 递减计分
+bool WordTrie::compile(const QString& sourcePath, const QString& outputPath, QString* errorMessage) {
+    QFile source(sourcePath);
+    if (!source.open(QIODevice::ReadOnly)) {
+        setError(errorMessage, QStringLiteral("无法打开词典 %1: %2").arg(sourcePath, source.errorString()));
+        return false;
+    }
+    const QFileInfo sourceInfo(source);
+
+    // --- 解析文本 ---
+    std::vector<SourceWord> words;
+    std::vector<quint64> frequencies; // 0 表示没有给出频率
+    int lineNumber = 0;
+    while (!source.atEnd()) {
+        const QByteArray line = source.readLine().trimmed();
+        ++lineNumber;
+        if (line.isEmpty() || line.startsWith('#')) continue;
+        const QList<QByteArray> fields = line.simplified().split(' ');
+        const QString word = QString::fromUtf8(fields.at(0)).toLower();
+        if (word.size() > MAX_WORD_LENGTH) continue;
+        quint64 frequency = 0;
+        if (fields.size() > 1) {
+            bool ok = false;
+            frequency = fields.at(1).toULongLong(&ok);
+            if (!ok) {
+                setError(errorMessage, QStringLiteral("%1:%2: 无法解析频率").arg(sourcePath).arg(lineNumber));
+                return false;
+            }
+        }
+        words.push_back({ word, 0 });
+        frequencies.push_back(frequency);
+    }
+    // 没有频率的单词: 按排名赋予递减的伪频率 (第一行最高)
+    for (size_t i = 0; i < words.size(); ++i) {
+        words[i].score = scoreForFrequency(frequencies[i] ? frequencies[i] : quint64(words.size() - i));
+    }
+
+    // --- 排序并合并重复单词 (保留最高得分) ---
+    std::sort(words.begin(), words.end(), [](const SourceWord& a, const SourceWord& b) {
+        return a.word < b.word || (a.word == b.word && a.score > b.score);
+    });
+    words.erase(std::unique(words.begin(), words.end(), [](const SourceWord& a, const SourceWord& b) {
+        return a.word == b.word;
+    }), words.end());
+
+    // --- 广度优先构建: 每个节点对应有序单词表中共享同一前缀的一段 ---
+    // 按层展开使同一父节点的子节点连续存放
+    struct Range {
+        int begin;
+        int end;
+        int depth;
+        quint32 node;
+    };
+    QVector<Node> nodes;
+    nodes.reserve(int(words.size()) * 2 + 1);
+    nodes.append({ 0, 0, 0, 0, 0 }); // 根节点
+    QVector<Range> queue;
+    queue.append({ 0, int(words.size()), 0, ROOT });
+    for (int head = 0; head < queue.size(); ++head) {
+        const Range range = queue.at(head);
+        int i = range.begin;
+        // 有序表中恰好在此结束的单词排在最前面 (去重后最多一个)
+        if (i < range.end && words[size_t(i)].word.size() == range.depth) {
+            nodes[int(range.node)].wordScore = words[size_t(i)].score;
+            ++i;
+        }
+        const quint32 firstChild = quint32(nodes.size());
+        while (i < range.end) {
+            const char16_t ch = words[size_t(i)].word.at(range.depth).unicode();
+            int groupEnd = i + 1;
+            while (groupEnd < range.end && words[size_t(groupEnd)].word.at(range.depth).unicode() == ch) ++groupEnd;
+            queue.append({ i, groupEnd, range.depth + 1, quint32(nodes.size()) });
+            nodes.append({ 0, 0, ch, 0, 0 });
+            i = groupEnd;
+        }
+        const quint32 childCount = quint32(nodes.size()) - firstChild;
+        if (childCount > 0xFFFF) {
+            setError(errorMessage, QStringLiteral("%1: 单个节点的分支过多").arg(sourcePath));
+            return false;
+        }
+        nodes[int(range.node)].firstChild = firstChild;
+        nodes[int(range.node)].childCount = quint16(childCount);
+    }
+
+    // --- 计算子树最高得分 (子节点下标总是大于父节点，逆序遍历即可)，再把每组子节点按最高得分降序排列 ---
+    for (int n = nodes.size() - 1; n >= 0; --n) {
+        Node& node = nodes[n];
+        quint16 best = node.wordScore;
+        for (quint32 c = 0; c < node.childCount; ++c) best = qMax(best, nodes[int(node.firstChild + c)].bestScore);
+        node.bestScore = best;
+    }
+    for (const Node& node : std::as_const(nodes)) {
+        if (node.childCount < 2) continue;
+        Node* begin = nodes.data() + node.firstChild;
+        std::stable_sort(begin, begin + node.childCount, [](const Node& a, const Node& b) { return a.bestScore > b.bestScore; });
+    }
+
+    // --- 写入文件 ---
+    DictHeader header;
+    std::memcpy(header.magic, DICT_MAGIC, sizeof(DICT_MAGIC));
+    header.version = DICT_VERSION;
+    header.sourceMtime = sourceInfo.lastModified().toMSecsSinceEpoch();
+    header.sourceSize = sourceInfo.size();
+    header.nodeCount = quint32(nodes.size());
+    header.wordCount = quint32(words.size());
+
+    QDir().mkpath(QFileInfo(outputPath).absolutePath());
+    QSaveFile output(outputPath);
+    const qint64 nodeBytes = qint64(nodes.size()) * qint64(sizeof(Node));
+    if (!output.open(QIODevice::WriteOnly) ||
+        output.write(reinterpret_cast<const char*>(&header), sizeof(header)) != qint64(sizeof(header)) ||
+        output.write(reinterpret_cast<const char*>(nodes.constData()), nodeBytes) != nodeBytes || !output.commit()) {
+        setError(errorMessage, QStringLiteral("无法写入词典 %1: %2").arg(outputPath, output.errorString()));
+        return false;
+    }
+    qDebug() << "词典已编译:" << sourcePath << "->" << outputPath << "单词数:" << header.wordCount << "节点数:" << header.nodeCount;
+    return true;
+}
+
+// --- map: 映射并校验二进制词典 ---
+bool WordTrie::map(const QString& path, QString* errorMessage) {
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        setError(errorMessage, QStringLiteral("无法打开词典 %1").arg(path));
+        return false;
+    }
+    const qint64 size = file.size();
+    if (size >= qint64(sizeof(DictHeader))) data = file.map(0, size);
+    if (!data) {
+        setError(errorMessage, QStringLiteral("无法映射词典 %1").arg(path));
+        file.close();
+        return false;
+    }
+
+    // 只检查结构完整性 (子节点范围)，源文件是否变化由调用者判断
+    const DictHeader& header = *headerOf(data);
+    bool valid = std::memcmp(header.magic, DICT_MAGIC, sizeof(DICT_MAGIC)) == 0 && header.version == DICT_VERSION &&
+                 header.nodeCount > 0 && qint64(sizeof(DictHeader)) + qint64(header.nodeCount) * qint64(sizeof(Node)) == size;
+    const Node* mapped = reinterpret_cast<const Node*>(data + sizeof(DictHeader));
+    for (quint32 i = 0; valid && i < header.nodeCount; ++i) {
+        valid = mapped[i].childCount == 0 ||
+                (mapped[i].firstChild > i && quint64(mapped[i].firstChild) + mapped[i].childCount <= header.nodeCount);
+    }
+    if (!valid) {
+        setError(errorMessage, QStringLiteral("词典 %1 已损坏或版本不符").arg(path));
+        file.unmap(const_cast<uchar*>(data));
+        data = nullptr;
+        file.close();
+        return false;
+    }
+    nodes = mapped;
+    count = header.nodeCount;
+    return true;
+}
+
+// --- open: 打开词典 (文本词典的缓存过期时重新编译) ---
+std::unique_ptr<WordTrie> WordTrie::open(const QString& path, QString* errorMessage) {
+    const QFileInfo sourceInfo(path);
+    if (!sourceInfo.isFile()) {
+        setError(errorMessage, QStringLiteral("词典不存在: %1").arg(path));
+        return nullptr;
+    }
+
+    std::unique_ptr<WordTrie> trie(new WordTrie);
+    if (isCompiledDictionary(path)) {
+        if (!trie->map(path, errorMessage)) return nullptr;
+        return trie;
+    }
+
+    const QString cachePath = cachePathFor(path);
+    bool upToDate = trie->map(cachePath, nullptr);
+    if (upToDate) {
+        const DictHeader& header = *headerOf(trie->data);
+        upToDate = header.sourceMtime == sourceInfo.lastModified().toMSecsSinceEpoch() && header.sourceSize == sourceInfo.size();
+        if (!upToDate) {
+            // 先解除映射，否则部分平台无法替换被映射的文件
+            trie->file.unmap(const_cast<uchar*>(trie->data));
+            trie->data = nullptr;
+            trie->nodes = nullptr;
+            trie->file.close();
+        }
+    }
+    if (!upToDate) {
+        if (!compile(path, cachePath, errorMessage) || !trie->map(cachePath, errorMessage)) return nullptr;
+        trie->recompiled = true;
+    }
+    return trie;
+}
+
+WordTrie::~WordTrie() {
+    if (data) file.unmap(const_cast<uchar*>(data));
+}
+
+quint32 WordTrie::wordCount() const {
+    return headerOf(data)->wordCount;
+}
+
+// --- child: 在子节点中查找字符 ---
+// 子节点按得分排序，常见字母通常排在前面，线性查找比二分查找更快
+quint32 WordTrie::child(quint32 parent, char16_t ch) const {
+    const Node& p = nodes[parent];
+    for (quint32 c = p.firstChild, end = p.firstChild + p.childCount; c < end; ++c) {
+        if (nodes[c].ch == ch) return c;
+    }
+    return NO_NODE;
+}
+
+quint32 WordTrie::find(QStringView text) const {
+    quint32 at = ROOT;
+    for (QChar ch : text) {
+        at = child(at, ch.unicode());
+        if (at == NO_NODE) break;
+    }
+    return at;
+}
+
+// --- complete: 最佳优先搜索得分最高的 k 个单词 ---
+// 队列按得分排序: 节点项的得分是其子树最高得分 (上界)，单词项的得分是精确值，
+// 因此单词项出队的顺序就是最终的降序结果，取满 k 个即可停止。
+int WordTrie::complete(quint32 at, QStringView prefix, int k, QVector<Completion>& out) const {
+    out.clear();
+    if (at == NO_NODE || k <= 0 || nodes[at].bestScore == 0) return 0;
+
+    heap.clear();
+    pathEntries.clear();
+    heap.push_back({ nodes[at].bestScore, false, at, -1 });
+    while (!heap.empty() && out.size() < k) {
+        std::pop_heap(heap.begin(), heap.end());
+        const SearchItem item = heap.back();
+        heap.pop_back();
+
+        if (item.isWord) {
+            // 沿路径回溯出后缀
+            Completion completion;
+            completion.score = item.score;
+            int length = 0;
+            for (qint32 p = item.path; p >= 0; p = pathEntries[size_t(p)].parent) ++length;
+            completion.word.resize(prefix.size() + length);
+            std::copy(prefix.begin(), prefix.end(), completion.word.begin());
+            QChar* write = completion.word.data() + prefix.size() + length;
+            for (qint32 p = item.path; p >= 0; p = pathEntries[size_t(p)].parent) *--write = QChar(pathEntries[size_t(p)].ch);
+            out.append(completion);
+            continue;
+        }
+
+        const Node& node = nodes[item.node];
+        if (node.wordScore) {
+            heap.push_back({ node.wordScore, true, item.node, item.path });
+            std::push_heap(heap.begin(), heap.end());
+        }
+        for (quint32 c = node.firstChild, end = node.firstChild + node.childCount; c < end; ++c) {
+            pathEntries.push_back({ item.path, nodes[c].ch });
+            heap.push_back({ nodes[c].bestScore, false, c, qint32(pathEntries.size() - 1) });
+            std::push_heap(heap.begin(), heap.end());
+        }
+    }
+    return out.size();
+}
@@ -0,0 +1,93 @@
+#ifndef VIRTUALKEYBOARD_WORDTRIE_H
+#define VIRTUALKEYBOARD_WORDTRIE_H
+
+#include <QFile>
+#include <QString>
+#include <QStringView>
+#include <QVector>
+#include <memory>
+#include <vector>
+
+// 内存映射的紧凑前缀树词典 (用于单词补全)
+// 文本词典 (每行 "单词 [频率]") 第一次加载时被编译为二进制缓存 (位于 CacheLocation)，
+// 之后直接映射缓存文件；也可以直接打开已编译的 .vkdt 文件。
+//
+// 二进制格式: [Header][Node x nodeCount]，节点按广度优先顺序排列，
+// 同一父节点的子节点连续存放并按子树最高得分降序排列。每个节点 12 字节，
+// 记录以该节点结尾的单词得分和子树中的最高得分，补全时按最高得分做最佳优先搜索，
+// 只访问能进入前 k 名的分支，与词典大小基本无关。
+// 单词统一以小写存储 (补全结果的大小写由调用者根据输入决定)。
+class WordTrie {
+public:
+    static constexpr quint32 ROOT = 0;              // 根节点下标
+    static constexpr quint32 NO_NODE = 0xFFFFFFFFu; // 不存在的节点
+    static constexpr int MAX_WORD_LENGTH = 48;      // 更长的单词在编译时被忽略
+
+    struct Node {
+        quint32 firstChild;  // 第一个子节点下标
+        quint16 childCount;  // 子节点数
+        char16_t ch;         // 从父节点到本节点的字符
+        quint16 wordScore;   // 以本节点结尾的单词得分 (0 表示不是单词)
+        quint16 bestScore;   // 子树 (含本节点) 中的最高单词得分
+    };
+
+    // 一个补全结果
+    struct Completion {
+        QString word;   // 完整单词 (小写)
+        int score = 0;  // 对数频率得分
+    };
+
+    // 打开词典 (文本词典必要时先编译缓存)，失败返回 nullptr
+    static std::unique_ptr<WordTrie> open(const QString& path, QString* errorMessage = nullptr);
+    // 把文本词典编译为二进制文件
+    static bool compile(const QString& sourcePath, const QString& outputPath, QString* errorMessage = nullptr);
+    // 文本词典对应的缓存路径
+    static QString cachePathFor(const QString& sourcePath);
+    // 频率 -> 16 位对数得分 (至少为 1)
+    static quint16 scoreForFrequency(quint64 frequency);
+
+    ~WordTrie();
+    WordTrie(const WordTrie&) = delete;
+    WordTrie& operator=(const WordTrie&) = delete;
+
+    quint32 nodeCount() const { return count; }
+    quint32 wordCount() const;
+    bool compiledOnOpen() const { return recompiled; } // 本次打开是否重新编译了缓存
+    const Node& node(quint32 index) const { return nodes[index]; }
+
+    // 子节点查找 (没有时返回 NO_NODE)
+    quint32 child(quint32 parent, char16_t ch) const;
+    // 从根沿 text 走到的节点 (没有时返回 NO_NODE)
+    quint32 find(QStringView text) const;
+    // 以 prefix (对应节点 at) 开头的得分最高的 k 个单词，按得分降序写入 out，返回个数
+    int complete(quint32 at, QStringView prefix, int k, QVector<Completion>& out) const;
+
+private:
+    WordTrie() = default;
+    bool map(const QString& path, QString* errorMessage); // 映射并校验二进制文件
+
+    // 最佳优先搜索的队列项: 节点 (展开子节点) 或已确定的单词
+    struct SearchItem {
+        quint16 score;
+        bool isWord;
+        quint32 node;
+        qint32 path; // 在 pathEntries 中的下标 (从前缀节点出发的路径)
+        bool operator<(const SearchItem& other) const { return score < other.score; }
+    };
+    struct PathEntry {
+        qint32 parent;
+        char16_t ch;
+    };
+
+    QFile file;
+    const uchar* data = nullptr;
+    const Node* nodes = nullptr;
+    quint32 count = 0;
+    bool recompiled = false;
+
+    // complete() 复用的临时缓冲区 (只在 UI 线程中使用)
+    mutable std::vector<SearchItem> heap;
+    mutable std::vector<PathEntry> pathEntries;
+};
+
+#endif // VIRTUALKEYBOARD_WORDTRIE_H
@@ -0,0 +1,228 @@
+#include "xtestbackend.h"
+#include "keyboardlayout.h" // VK_* 常量
+#include "asynclogger.h"
+#include "latencystats.h"
+
+#include <QChar>
+#include <QDebug>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+// X11 头文件放在 Qt 头文件之后 (X11 定义了 None、KeyPress 等宏)
+#include <X11/Xlib.h>
+#include <X11/keysym.h>
+#include <X11/extensions/XTest.h>
+
+// --- 常量定义 ---
+// 最多占用的空闲 keycode 数 (一批中不同的 Unicode 字符超过这个数时，改写之前先等待)
+const int UNICODE_KEYCODE_MAX = 32;
+// 改写一个 keycode 的映射之前，距它上一次使用至少经过的时间 (纳秒)，
+// 让目标客户端先处理完旧字符的按键事件 (它在处理 MappingNotify 之后才按需重新读取映射)
+const qint64 UNICODE_REMAP_SETTLE_NS = 20 * 1000000;
+
+// --- vkToKeySym: Windows 虚拟键码 -> X11 KeySym ---
+static KeySym vkToKeySym(int vkCode) {
+    if (vkCode >= 'A' && vkCode <= 'Z') return XK_a + (vkCode - 'A');
+    if (vkCode >= '0' && vkCode <= '9') return XK_0 + (vkCode - '0');
+    if (vkCode >= VK_F1 && vkCode <= VK_F12) return XK_F1 + (vkCode - VK_F1);
+    if (vkCode >= VK_NUMPAD0 && vkCode <= VK_NUMPAD9) return XK_KP_0 + (vkCode - VK_NUMPAD0);
+
+    switch (vkCode) {
+        case VK_SPACE: return XK_space;
+        case VK_RETURN: return XK_Return;
+        case VK_BACK: return XK_BackSpace;
+        case VK_TAB: return XK_Tab;
+        case VK_ESCAPE: return XK_Escape;
+        // 修饰键
+        case VK_SHIFT: case VK_LSHIFT: return XK_Shift_L;
+        case VK_RSHIFT: return XK_Shift_R;
+        case VK_CONTROL: case VK_LCONTROL: return XK_Control_L;
+        case VK_RCONTROL: return XK_Control_R;
+        case VK_MENU: case VK_LMENU: return XK_Alt_L;
+        case VK_RMENU: return XK_Alt_R;
+        case VK_LWIN: return XK_Super_L;
+        case VK_RWIN: return XK_Super_R;
+        case VK_APPS: return XK_Menu;
+        // 切换键
+        case VK_CAPITAL: return XK_Caps_Lock;
+        case VK_NUMLOCK: return XK_Num_Lock;
+        case VK_SCROLL: return XK_Scroll_Lock;
+        // 导航键
+        case VK_PRIOR: return XK_Prior;
+        case VK_NEXT: return XK_Next;
+        case VK_END: return XK_End;
+        case VK_HOME: return XK_Home;
+        case VK_LEFT: return XK_Left;
+        case VK_UP: return XK_Up;
+        case VK_RIGHT: return XK_Right;
+        case VK_DOWN: return XK_Down;
+        case VK_INSERT: return XK_Insert;
+        case VK_DELETE: return XK_Delete;
+        case VK_SNAPSHOT: return XK_Print;
+        case VK_PAUSE: return XK_Pause;
+        // OEM 键 (按美式布局映射)
+        case VK_OEM_3: return XK_grave;
+        case VK_OEM_MINUS: return XK_minus;
+        case VK_OEM_PLUS: return XK_equal;
+        case VK_OEM_4: return XK_bracketleft;
+        case VK_OEM_6: return XK_bracketright;
+        case VK_OEM_5: return XK_backslash;
+        case VK_OEM_1: return XK_semicolon;
+        case VK_OEM_7: return XK_apostrophe;
+        case VK_OEM_COMMA: return XK_comma;
+        case VK_OEM_PERIOD: return XK_period;
+        case VK_OEM_2: return XK_slash;
+        // 小键盘运算符 (小键盘 Enter 与主 Enter 共用 VK_RETURN，按 XK_Return 注入)
+        case VK_MULTIPLY: return XK_KP_Multiply;
+        case VK_ADD: return XK_KP_Add;
+        case VK_SUBTRACT: return XK_KP_Subtract;
+        case VK_DECIMAL: return XK_KP_Decimal;
+        case VK_DIVIDE: return XK_KP_Divide;
+        default: return NoSymbol;
+    }
+}
+
+// --- 构造函数: 连接 X 服务器并检查 XTest 扩展 ---
+XTestBackend::XTestBackend(const QByteArray& displayName) {
+    std::memset(keycodeCache, 0, sizeof(keycodeCache));
+    std::memset(keycodeResolved, 0, sizeof(keycodeResolved));
+
+    display = XOpenDisplay(displayName.isEmpty() ? nullptr : displayName.constData());
+    if (!display) {
+        qWarning() << "XTest 后端: 无法连接 X 服务器" << (displayName.isEmpty() ? qgetenv("DISPLAY") : displayName);
+        return;
+    }
+    int eventBase = 0, errorBase = 0, major = 0, minor = 0;
+    if (!XTestQueryExtension(display, &eventBase, &errorBase, &major, &minor)) {
+        qWarning() << "XTest 后端: X 服务器不支持 XTest 扩展";
+        XCloseDisplay(display);
+        display = nullptr;
+        return;
+    }
+    qDebug() << "XTest 后端: 已连接" << DisplayString(display) << "XTest 版本" << major << "." << minor;
+
+    // 找出没有绑定任何 keysym 的 keycode，输入 Unicode 字符时临时映射
+    int minKeycode = 0, maxKeycode = 0, symsPerKeycode = 0;
+    XDisplayKeycodes(display, &minKeycode, &maxKeycode);
+    KeySym* keysyms = XGetKeyboardMapping(display, minKeycode, maxKeycode - minKeycode + 1, &symsPerKeycode);
+    if (keysyms) {
+        for (int keycode = maxKeycode; keycode >= minKeycode && unicodeSlots.size() < UNICODE_KEYCODE_MAX; --keycode) {
+            bool unused = true;
+            for (int i = 0; i < symsPerKeycode && unused; ++i) unused = keysyms[(keycode - minKeycode) * symsPerKeycode + i] == NoSymbol;
+            if (!unused) continue;
+            UnicodeSlot slot;
+            slot.keycode = static_cast<unsigned char>(keycode);
+            unicodeSlots.append(slot);
+        }
+        XFree(keysyms);
+    }
+    if (unicodeSlots.isEmpty()) qWarning() << "XTest 后端: 没有空闲的 keycode，无法输入 Unicode 字符";
+}
+
+// --- 析构函数 ---
+XTestBackend::~XTestBackend() {
+    if (!display) return;
+    for (const UnicodeSlot& slot : std::as_const(unicodeSlots)) {
+        if (!slot.codePoint) continue;
+        KeySym none = NoSymbol;
+        XChangeKeyboardMapping(display, slot.keycode, 1, &none, 1); // 还原临时映射
+    }
+    XCloseDisplay(display);
+}
+
+// --- keycodeFor: VK 码 -> X keycode ---
+unsigned char XTestBackend::keycodeFor(int vkCode) {
+    if (vkCode <= 0 || vkCode > 255) return 0;
+    if (!keycodeResolved[vkCode]) {
+        const KeySym keysym = vkToKeySym(vkCode);
+        keycodeCache[vkCode] = keysym == NoSymbol ? 0 : static_cast<unsigned char>(XKeysymToKeycode(display, keysym));
+        keycodeResolved[vkCode] = true;
+    }
+    return keycodeCache[vkCode];
+}
+
+// --- send: 整批事件只刷新一次 ---
+int XTestBackend::send(const KeyEvent* events, int count) {
+    if (!display) return 0;
+    ++batchSerial;
+
+    int accepted = 0;
+    for (int i = 0; i < count; ++i) {
+        if (events[i].isUnicode()) {
+            if (sendUnicode(events[i])) ++accepted;
+            continue;
+        }
+        const unsigned char keycode = keycodeFor(events[i].vkCode);
+        if (keycode == 0) {
+            VK_LOG_WARNING("XTest 后端: 无法映射 VK {x}", events[i].vkCode);
+            continue;
+        }
+        if (XTestFakeKeyEvent(display, keycode, events[i].isDown() ? True : False, CurrentTime)) ++accepted;
+    }
+    XFlush(display); // 整批事件一次发送给 X 服务器
+    return accepted;
+}
+
+// --- sendUnicode: 通过空闲 keycode 输入一个字符 ---
+// 代理对的高代理项先暂存，收到低代理项时合成完整的码点
+bool XTestBackend::sendUnicode(const KeyEvent& event) {
+    if (unicodeSlots.isEmpty()) return false;
+    const char16_t unit = char16_t(event.scanCode);
+    if (QChar::isHighSurrogate(unit)) {
+        if (event.isDown()) pendingHighSurrogate = unit;
+        return true;
+    }
+    char32_t codePoint = unit;
+    if (QChar::isLowSurrogate(unit)) {
+        if (!pendingHighSurrogate) return false;
+        codePoint = QChar::surrogateToUcs4(char16_t(pendingHighSurrogate), unit);
+        if (!event.isDown()) pendingHighSurrogate = 0;
+    }
+
+    const unsigned char keycode = unicodeKeycodeFor(codePoint, event.isDown());
+    if (keycode == 0) return false;
+    return XTestFakeKeyEvent(display, keycode, event.isDown() ? True : False, CurrentTime);
+}
+
+// --- unicodeKeycodeFor: 字符 -> 映射了该字符的 keycode ---
+// 已映射的字符直接复用其 keycode (抬起总是发送到按下时的 keycode)；按下新字符时改写最久未用的 keycode，
+// 仍处于按下状态的 keycode 不会被改写。
+// 同一个 keycode 不会在客户端可能还没处理完旧字符时改写: 它在本批中用过时先把之前的事件刷新出去，
+// 距上次使用不足 UNICODE_REMAP_SETTLE_NS 时等待。XSync 保证服务器在之后的按键事件之前应用新映射
+unsigned char XTestBackend::unicodeKeycodeFor(char32_t codePoint, bool press) {
+    UnicodeSlot* slot = nullptr;
+    UnicodeSlot* oldest = nullptr;
+    for (UnicodeSlot& candidate : unicodeSlots) {
+        if (candidate.codePoint == codePoint) {
+            slot = &candidate;
+            break;
+        }
+        if (!candidate.down && (!oldest || candidate.lastUsedNs < oldest->lastUsedNs)) oldest = &candidate;
+    }
+
+    if (!slot) {
+        // 没有按下过的字符无需抬起
+        if (!press) return 0;
+        if (!oldest) {
+            VK_LOG_WARNING("XTest 后端: {} 个空闲 keycode 都处于按下状态，无法输入字符 {x}", unicodeSlots.size(), quint32(codePoint));
+            return 0;
+        }
+        slot = oldest;
+        if (slot->lastBatch == batchSerial) XFlush(display);
+        const qint64 waitNs = slot->lastUsedNs + UNICODE_REMAP_SETTLE_NS - LatencyStats::now();
+        if (slot->lastUsedNs && waitNs > 0) {
+            VK_LOG_DEBUG("XTest 后端: 空闲 keycode 用完，等待 {} ns 后改写 keycode {}", waitNs, int(slot->keycode));
+            std::this_thread::sleep_for(std::chrono::nanoseconds(waitNs));
+        }
+        // Latin-1 字符的 keysym 等于码点，其余使用 0x01000000 + 码点
+        KeySym keysym = codePoint < 0x100 ? KeySym(codePoint) : KeySym(0x01000000 | codePoint);
+        XChangeKeyboardMapping(display, slot->keycode, 1, &keysym, 1);
+        XSync(display, False);
+        slot->codePoint = codePoint;
+    }
+    slot->down = press;
+    slot->lastUsedNs = LatencyStats::now();
+    slot->lastBatch = batchSerial;
+    return slot->keycode;
+}
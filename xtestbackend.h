@@ -0,0 +1,57 @@
+#ifndef VIRTUALKEYBOARD_XTESTBACKEND_H
+#define VIRTUALKEYBOARD_XTESTBACKEND_H
+
+#include <QByteArray>
+#include <QVector>
+
+#include "injectionbackend.h"
+
+// 前向声明 Xlib 类型，避免在头文件中包含 X11 头文件 (其中的宏与 Qt 冲突)
+struct _XDisplay;
+
+// X11 XTest 后端 (Linux)
+// 一批事件逐个调用 XTestFakeKeyEvent，最后只 XFlush 一次，
+// 修饰键组合和按键因此在同一次请求刷新中到达 X 服务器。
+// 可以在 Xvfb 下使用 (通过 DISPLAY 或构造参数指定显示)。
+// Unicode 事件通过临时改写空闲 keycode 的映射来输入任意字符: 每个字符使用自己的 keycode，
+// 一个 keycode 只有在抬起并且一段时间内没有使用过之后才会改写为另一个字符
+// (XSync 只保证服务器已应用新映射，目标客户端可能在处理 MappingNotify 之后才按需重新读取映射)。
+class XTestBackend : public InjectionBackend {
+public:
+    // displayName 为空时使用 DISPLAY 环境变量
+    explicit XTestBackend(const QByteArray& displayName = QByteArray());
+    ~XTestBackend() override;
+
+    XTestBackend(const XTestBackend&) = delete;
+    XTestBackend& operator=(const XTestBackend&) = delete;
+
+    // 是否成功连接到 X 服务器且服务器支持 XTest 扩展
+    bool isValid() const { return display != nullptr; }
+
+    const char* name() const override { return "xtest"; }
+    int send(const KeyEvent* events, int count) override;
+
+private:
+    unsigned char keycodeFor(int vkCode); // VK 码 -> X keycode (带缓存，0 表示无法映射)
+    bool sendUnicode(const KeyEvent& event); // Unicode 事件: 把字符临时映射到空闲 keycode 再按下/释放
+    // 字符 -> 映射了该字符的 keycode (0 表示不可用): 按下时需要改写则选择最久未用且未按下的一个，抬起时只查找已映射的
+    unsigned char unicodeKeycodeFor(char32_t codePoint, bool press);
+
+    // 输入 Unicode 字符用的空闲 keycode
+    struct UnicodeSlot {
+        unsigned char keycode = 0;
+        char32_t codePoint = 0;  // 当前映射的字符 (0 表示还没有映射)
+        qint64 lastUsedNs = 0;   // 最近一次按下/释放的时间 (LatencyStats::now)
+        quint64 lastBatch = 0;   // 最近一次使用所在的批次
+        bool down = false;       // 字符处于按下状态 (抬起之前不能改写为其他字符)
+    };
+
+    _XDisplay* display = nullptr;
+    unsigned char keycodeCache[256];  // VK 码 -> keycode 缓存
+    bool keycodeResolved[256];        // 缓存项是否已解析
+    QVector<UnicodeSlot> unicodeSlots; // 没有绑定 keysym 的 keycode (为空时无法输入 Unicode 字符)
+    quint64 batchSerial = 0;          // 当前 send 调用的序号
+    char32_t pendingHighSurrogate = 0; // 等待低代理项的高代理项
+};
+
+#endif // VIRTUALKEYBOARD_XTESTBACKEND_H